@@ -0,0 +1,682 @@
+#include "../include/option_pricing.hpp"
+#include "../include/volatility.hpp"
+#include "../include/json_writer.hpp"
+#include "../include/strategy_optimizer.hpp"
+#include "../include/fourier_pricing.hpp"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+/**
+ * Микробенчмарки горячих путей DerivX.
+ *
+ *   derivx_bench [--filter=REGEX] [--min-time=SEC] [--repetitions=N] [--max-rows=N]
+ *                [--json=FILE] [--baseline=FILE] [--threshold=PCT] [--list]
+ *
+ * Каждый бенчмарк калибруется до --min-time секунд на повтор и повторяется
+ * --repetitions раз; в отчет идет медиана. --json пишет результаты в формате,
+ * совместимом с Google Benchmark (сравнение тем же compare.py). --baseline сравнивает
+ * медианы с прошлым прогоном и завершается с кодом 1, если какой-то бенчмарк
+ * стал медленнее более чем на --threshold процентов.
+ */
+
+using json = nlohmann::json;
+using namespace derivx;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * Не дает компилятору выбросить вычисление результата
+ */
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Benchmark {
+    std::string name;
+    std::function<void(Benchmark&)> setup;     // Подготовка данных (не входит в замер)
+    std::function<void(uint64_t)> body;        // Выполняет заданное число итераций
+    std::function<void()> teardown;
+    double itemsPerIteration = 0.0;
+    double bytesPerIteration = 0.0;
+};
+
+struct Options {
+    std::string filter;
+    double minTime = 0.2;
+    int repetitions = 5;
+    size_t maxRows = 1000000;
+    std::string jsonPath;
+    std::string baselinePath;
+    double threshold = 10.0;
+    bool list = false;
+};
+
+struct Result {
+    std::string name;
+    uint64_t iterations = 0;
+    double realNs = 0.0;     // Медиана, нс на итерацию
+    double cpuNs = 0.0;
+    double minNs = 0.0;
+    double maxNs = 0.0;
+    double cv = 0.0;         // Коэффициент вариации повторов
+    double itemsPerSecond = 0.0;
+    double bytesPerSecond = 0.0;
+};
+
+double threadCpuSeconds() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) * 1e-9;
+}
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    return n % 2 ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+}
+
+Result run(Benchmark& bench, const Options& options) {
+    if (bench.setup) {
+        bench.setup(bench);
+    }
+
+    // Калибровка: растим число итераций, пока замер не станет заметным
+    uint64_t iterations = 1;
+    while (true) {
+        auto start = Clock::now();
+        bench.body(iterations);
+        double elapsed = secondsSince(start);
+        if (elapsed >= options.minTime * 0.1 || iterations >= 1000000000ULL) {
+            double perIteration = elapsed / static_cast<double>(iterations);
+            iterations = static_cast<uint64_t>(std::max(1.0, std::ceil(options.minTime / std::max(perIteration, 1e-12))));
+            break;
+        }
+        iterations *= 10;
+    }
+
+    std::vector<double> realNs;
+    std::vector<double> cpuNs;
+    for (int r = 0; r < options.repetitions; ++r) {
+        double cpuStart = threadCpuSeconds();
+        auto start = Clock::now();
+        bench.body(iterations);
+        double elapsed = secondsSince(start);
+        double cpu = threadCpuSeconds() - cpuStart;
+        realNs.push_back(elapsed * 1e9 / static_cast<double>(iterations));
+        cpuNs.push_back(cpu * 1e9 / static_cast<double>(iterations));
+    }
+
+    if (bench.teardown) {
+        bench.teardown();
+    }
+
+    Result result;
+    result.name = bench.name;
+    result.iterations = iterations;
+    result.realNs = median(realNs);
+    result.cpuNs = median(cpuNs);
+    result.minNs = *std::min_element(realNs.begin(), realNs.end());
+    result.maxNs = *std::max_element(realNs.begin(), realNs.end());
+
+    double mean = 0.0;
+    for (double v : realNs) {
+        mean += v;
+    }
+    mean /= static_cast<double>(realNs.size());
+    double variance = 0.0;
+    for (double v : realNs) {
+        variance += (v - mean) * (v - mean);
+    }
+    result.cv = mean > 0.0 ? std::sqrt(variance / static_cast<double>(realNs.size())) / mean : 0.0;
+
+    if (result.realNs > 0.0) {
+        result.itemsPerSecond = bench.itemsPerIteration * 1e9 / result.realNs;
+        result.bytesPerSecond = bench.bytesPerIteration * 1e9 / result.realNs;
+    }
+    return result;
+}
+
+// ------------------------------------------------------------ Данные
+
+/**
+ * Синтетическая стратегия: чередующиеся long/short колы и путы вокруг 100
+ */
+std::vector<Option> makeStrategy(size_t legs) {
+    std::vector<Option> options(legs);
+    for (size_t i = 0; i < legs; ++i) {
+        options[i].type = i % 2 ? OptionType::PUT : OptionType::CALL;
+        options[i].position = (i / 2) % 2 ? OptionPosition::SHORT : OptionPosition::LONG;
+        options[i].strike = 80.0 + 40.0 * static_cast<double>(i) / static_cast<double>(std::max<size_t>(legs, 2) - 1);
+        options[i].premium = 2.5;
+        options[i].quantity = 1 + static_cast<int>(i % 3);
+    }
+    return options;
+}
+
+/**
+ * Минутные свечи случайного блуждания (фиксированное зерно - одинаковые данные между прогонами)
+ */
+std::vector<OHLCV> makeCandles(size_t rows) {
+    std::mt19937_64 rng(42);
+    std::normal_distribution<double> step(0.0, 0.001);
+    std::vector<OHLCV> candles(rows);
+    double price = 40000.0;
+    for (size_t i = 0; i < rows; ++i) {
+        OHLCV& candle = candles[i];
+        candle.timestamp = 1577836800 + static_cast<int64_t>(i) * 60;
+        candle.open = price;
+        price *= std::exp(step(rng));
+        candle.close = price;
+        candle.high = std::max(candle.open, candle.close) * (1.0 + std::abs(step(rng)));
+        candle.low = std::min(candle.open, candle.close) * (1.0 - std::abs(step(rng)));
+        candle.volume = 10.0 + std::abs(step(rng)) * 1e4;
+    }
+    return candles;
+}
+
+/**
+ * CSV в формате scripts/fetch_ohlcv.py: date,open,high,low,close,volume
+ */
+uint64_t writeCsv(const std::string& path, size_t rows) {
+    std::ofstream out(path, std::ios::binary);
+    out << "date,open,high,low,close,volume\n";
+    std::vector<OHLCV> candles = makeCandles(rows);
+    char line[160];
+    for (const auto& candle : candles) {
+        std::time_t time = static_cast<std::time_t>(candle.timestamp);
+        std::tm utc{};
+        gmtime_r(&time, &utc);
+        char date[24];
+        std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &utc);
+        int length = std::snprintf(line, sizeof(line), "%s,%.2f,%.2f,%.2f,%.2f,%.4f\n",
+                                   date, candle.open, candle.high, candle.low, candle.close, candle.volume);
+        out.write(line, length);
+    }
+    return static_cast<uint64_t>(out.tellp());
+}
+
+std::string rowsLabel(size_t rows) {
+    if (rows >= 1000000 && rows % 1000000 == 0) {
+        return std::to_string(rows / 1000000) + "M";
+    }
+    if (rows >= 1000 && rows % 1000 == 0) {
+        return std::to_string(rows / 1000) + "k";
+    }
+    return std::to_string(rows);
+}
+
+// ------------------------------------------------------------ Бенчмарки
+
+std::vector<Benchmark> registerBenchmarks(const Options& options, const std::string& workDir) {
+    std::vector<Benchmark> benches;
+
+    // Входы цен опционов: 1024 разных спота, чтобы расчет не сворачивался в константу
+    auto spots = std::make_shared<std::vector<double>>(1024);
+    for (size_t i = 0; i < spots->size(); ++i) {
+        (*spots)[i] = 60.0 + 80.0 * static_cast<double>(i) / 1023.0;
+    }
+
+    for (OptionType type : {OptionType::CALL, OptionType::PUT}) {
+        std::string suffix = type == OptionType::CALL ? "call" : "put";
+
+        Benchmark price;
+        price.name = "BlackScholes/" + suffix;
+        price.itemsPerIteration = 1.0;
+        price.body = [spots, type](uint64_t iterations) {
+            const std::vector<double>& s = *spots;
+            for (uint64_t i = 0; i < iterations; ++i) {
+                doNotOptimize(OptionPricing::calculateBlackScholes(type, s[i & 1023], 100.0, 0.25, 0.6, 0.05, 0.0));
+            }
+        };
+        benches.push_back(price);
+
+        Benchmark greeks;
+        greeks.name = "Greeks/" + suffix;
+        greeks.itemsPerIteration = 1.0;
+        greeks.body = [spots, type](uint64_t iterations) {
+            const std::vector<double>& s = *spots;
+            for (uint64_t i = 0; i < iterations; ++i) {
+                Greeks result = OptionPricing::calculateGreeks(type, s[i & 1023], 100.0, 0.25, 0.6, 0.05, 0.0);
+                doNotOptimize(result.delta);
+                doNotOptimize(result.vega);
+            }
+        };
+        benches.push_back(greeks);
+    }
+
+    Benchmark cdf;
+    cdf.name = "NormalCDF";
+    cdf.itemsPerIteration = 1.0;
+    cdf.body = [](uint64_t iterations) {
+        double x = -4.0;
+        for (uint64_t i = 0; i < iterations; ++i) {
+            doNotOptimize(OptionPricing::normalCDF(x));
+            x = x < 4.0 ? x + 0.001 : -4.0;
+        }
+    };
+    benches.push_back(cdf);
+
+    for (size_t legs : {1, 4, 16}) {
+        for (int points : {200, 2000, 20000}) {
+            Benchmark curve;
+            curve.name = "PayoffCurve/legs:" + std::to_string(legs) + "/points:" + std::to_string(points);
+            curve.itemsPerIteration = static_cast<double>(points);
+            auto strategy = std::make_shared<std::vector<Option>>(makeStrategy(legs));
+            curve.body = [strategy, points](uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    auto result = OptionPricing::generatePayoffCurve(*strategy, 50.0, 150.0, points);
+                    doNotOptimize(result.data());
+                }
+            };
+            benches.push_back(curve);
+        }
+    }
+
+    // Профиль греков стратегии по сетке цен (points x legs оценок за итерацию)
+    for (size_t legs : {1, 4, 16}) {
+        for (int points : {200, 2000}) {
+            Benchmark profile;
+            profile.name = "GreeksProfile/legs:" + std::to_string(legs) + "/points:" + std::to_string(points);
+            profile.itemsPerIteration = static_cast<double>(points);
+            auto strategy = std::make_shared<std::vector<Option>>(makeStrategy(legs));
+            profile.body = [strategy, points](uint64_t iterations) {
+                std::vector<double> grid(static_cast<size_t>(points));
+                for (size_t i = 0; i < grid.size(); ++i) {
+                    grid[i] = 50.0 + 100.0 * static_cast<double>(i) / static_cast<double>(points - 1);
+                }
+                std::vector<Greeks> result(grid.size());
+                MarketParams market;
+                market.volatility = 0.6;
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    OptionPricing::evaluateGreeksProfile(*strategy, market, grid.data(), grid.size(), result.data());
+                    doNotOptimize(result.data());
+                }
+            };
+            benches.push_back(profile);
+        }
+    }
+
+    // Поиск кондоров по сетке страйков (одна итерация - весь перебор, без пула)
+    for (size_t strikes : {size_t(21), size_t(41)}) {
+        Benchmark search;
+        search.name = "StrategyOptimizer/strikes:" + std::to_string(strikes);
+        OptimizerConfig config;
+        config.structures = {StrategyStructure::CONDOR, StrategyStructure::IRON_CONDOR};
+        search.itemsPerIteration = static_cast<double>(StrategyOptimizer::countCandidates(config, strikes));
+        search.body = [config, strikes](uint64_t iterations) {
+            std::mt19937_64 rng(42);
+            std::lognormal_distribution<double> returns(std::log(100.0), 0.2);
+            std::vector<double> prices(5000);
+            for (double& price : prices) {
+                price = returns(rng);
+            }
+            EmpiricalDistribution distribution(prices);
+
+            MarketParams market;
+            market.volatility = 0.3;
+            std::vector<double> grid(strikes);
+            std::vector<double> logMoneyness(strikes);
+            std::vector<ChainQuote> quotes(strikes);
+            for (size_t i = 0; i < strikes; ++i) {
+                grid[i] = 70.0 + 60.0 * static_cast<double>(i) / static_cast<double>(strikes - 1);
+                logMoneyness[i] = std::log(market.spotPrice / grid[i]);
+            }
+            OptionPricing::calculateChain(market, grid.data(), logMoneyness.data(), strikes, quotes.data());
+            for (uint64_t i = 0; i < iterations; ++i) {
+                auto result = StrategyOptimizer::optimize(config, quotes.data(), strikes, distribution, nullptr);
+                doNotOptimize(result.best.data());
+            }
+        };
+        benches.push_back(search);
+    }
+
+    // Цепочка Heston: одно преобразование на экспирацию, 1 и 50 страйков стоят почти одинаково
+    for (const char* method : {"cos", "fft"}) {
+        for (size_t strikes : {size_t(1), size_t(50)}) {
+            Benchmark chain;
+            chain.name = std::string("FourierChain/") + method + "/strikes:" + std::to_string(strikes);
+            chain.itemsPerIteration = static_cast<double>(strikes);
+            FourierMethod parsed;
+            FourierPricing::parseMethod(method, parsed);
+            chain.body = [parsed, strikes](uint64_t iterations) {
+                FourierModel model;
+                model.type = FourierModelType::HESTON;
+                MarketParams market;
+                market.timeToExpiration = 0.25;
+                std::vector<double> grid(strikes);
+                for (size_t i = 0; i < strikes; ++i) {
+                    grid[i] = strikes == 1 ? 100.0 : 70.0 + 60.0 * static_cast<double>(i) / static_cast<double>(strikes - 1);
+                }
+                std::vector<double> calls(strikes);
+                std::vector<double> puts(strikes);
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    FourierPricing::priceChain(model, market, grid.data(), strikes, parsed, calls.data(), puts.data());
+                    doNotOptimize(calls.data());
+                }
+            };
+            benches.push_back(chain);
+        }
+    }
+
+    // Чтение CSV: файлы создаются перед замером и удаляются после
+    for (size_t rows : {size_t(10000), size_t(100000), size_t(1000000), size_t(10000000)}) {
+        if (rows > options.maxRows) {
+            continue;
+        }
+        Benchmark load;
+        load.name = "LoadCSV/rows:" + rowsLabel(rows);
+        load.itemsPerIteration = static_cast<double>(rows);
+        std::string path = workDir + "/ohlcv_" + std::to_string(rows) + ".csv";
+        load.setup = [path, rows](Benchmark& self) {
+            self.bytesPerIteration = static_cast<double>(writeCsv(path, rows));
+        };
+        load.body = [path](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                auto candles = VolatilityCalculator::loadOHLCVFromCSV(path);
+                doNotOptimize(candles.data());
+            }
+        };
+        load.teardown = [path]() {
+            std::error_code ignored;
+            std::filesystem::remove(path, ignored);
+        };
+        benches.push_back(load);
+    }
+
+    // Оценки волатильности по окну последних свечей
+    auto candles = std::make_shared<std::vector<OHLCV>>();
+    for (int period : {30, 365, 100000}) {
+        Benchmark historical;
+        historical.name = "HistoricalVolatility/period:" + std::to_string(period);
+        historical.itemsPerIteration = static_cast<double>(period);
+        historical.setup = [candles](Benchmark&) {
+            if (candles->empty()) {
+                *candles = makeCandles(100000);
+            }
+        };
+        historical.body = [candles, period](uint64_t iterations) {
+            OHLCVView view(*candles);
+            for (uint64_t i = 0; i < iterations; ++i) {
+                doNotOptimize(VolatilityCalculator::calculateHistoricalVolatility(view, period));
+            }
+        };
+        benches.push_back(historical);
+
+        Benchmark parkinson = historical;
+        parkinson.name = "ParkinsonVolatility/period:" + std::to_string(period);
+        parkinson.body = [candles, period](uint64_t iterations) {
+            OHLCVView view(*candles);
+            for (uint64_t i = 0; i < iterations; ++i) {
+                doNotOptimize(VolatilityCalculator::calculateParkinsonVolatility(view, period));
+            }
+        };
+        benches.push_back(parkinson);
+    }
+
+    // Сериализация кривой PNL: потоковый JsonWriter (как в ответе) и DOM nlohmann для сравнения
+    for (int points : {200, 2000, 20000}) {
+        auto curve = std::make_shared<std::vector<std::pair<double, double>>>(
+            OptionPricing::generatePayoffCurve(makeStrategy(4), 50.0, 150.0, points));
+        Benchmark writer;
+        writer.name = "CurveJson/writer/points:" + std::to_string(points);
+        writer.itemsPerIteration = static_cast<double>(points);
+        writer.body = [curve](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                JsonWriter out(curve->size() * 48 + 96);
+                out.beginObject();
+                out.key("curve");
+                out.beginArray();
+                for (const auto& point : *curve) {
+                    out.beginObject();
+                    out.key("pnl");
+                    out.value(point.second);
+                    out.key("price");
+                    out.value(point.first);
+                    out.endObject();
+                }
+                out.endArray();
+                out.key("maxPrice");
+                out.value(150.0);
+                out.key("minPrice");
+                out.value(50.0);
+                out.key("numPoints");
+                out.value(curve->size());
+                out.endObject();
+                std::string body = out.release();
+                doNotOptimize(body.data());
+            }
+        };
+        benches.push_back(writer);
+
+        Benchmark dom;
+        dom.name = "CurveJson/nlohmann/points:" + std::to_string(points);
+        dom.itemsPerIteration = static_cast<double>(points);
+        dom.body = [curve](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                json response;
+                json points = json::array();
+                for (const auto& point : *curve) {
+                    points.push_back({{"price", point.first}, {"pnl", point.second}});
+                }
+                response["curve"] = std::move(points);
+                response["maxPrice"] = 150.0;
+                response["minPrice"] = 50.0;
+                response["numPoints"] = curve->size();
+                std::string body = response.dump();
+                doNotOptimize(body.data());
+            }
+        };
+        benches.push_back(dom);
+    }
+
+    return benches;
+}
+
+// ------------------------------------------------------------ Вывод
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto valueOf = [&](const char* prefix) -> const char* {
+            size_t length = std::strlen(prefix);
+            return arg.compare(0, length, prefix) == 0 ? argv[i] + length : nullptr;
+        };
+        const char* value = nullptr;
+        if ((value = valueOf("--filter="))) {
+            options.filter = value;
+        } else if ((value = valueOf("--min-time="))) {
+            options.minTime = std::max(std::atof(value), 0.001);
+        } else if ((value = valueOf("--repetitions="))) {
+            options.repetitions = std::max(std::atoi(value), 1);
+        } else if ((value = valueOf("--max-rows="))) {
+            options.maxRows = static_cast<size_t>(std::strtoull(value, nullptr, 10));
+        } else if ((value = valueOf("--json="))) {
+            options.jsonPath = value;
+        } else if ((value = valueOf("--baseline="))) {
+            options.baselinePath = value;
+        } else if ((value = valueOf("--threshold="))) {
+            options.threshold = std::atof(value);
+        } else if (arg == "--list") {
+            options.list = true;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+json context() {
+    char host[256] = {0};
+    gethostname(host, sizeof(host) - 1);
+
+    std::time_t now = std::time(nullptr);
+    std::tm local{};
+    localtime_r(&now, &local);
+    char date[40];
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", &local);
+
+    json result;
+    result["date"] = date;
+    result["host_name"] = host;
+    result["num_cpus"] = std::thread::hardware_concurrency();
+#ifdef NDEBUG
+    result["library_build_type"] = "release";
+#else
+    result["library_build_type"] = "debug";
+#endif
+#ifdef __VERSION__
+    result["compiler"] = __VERSION__;
+#endif
+    return result;
+}
+
+json toJson(const Result& result, int repetitions) {
+    json entry;
+    entry["name"] = result.name;
+    entry["run_name"] = result.name;
+    entry["run_type"] = "aggregate";
+    entry["aggregate_name"] = "median";
+    entry["repetitions"] = repetitions;
+    entry["iterations"] = result.iterations;
+    entry["real_time"] = result.realNs;
+    entry["cpu_time"] = result.cpuNs;
+    entry["time_unit"] = "ns";
+    entry["real_time_min"] = result.minNs;
+    entry["real_time_max"] = result.maxNs;
+    entry["cv"] = result.cv;
+    if (result.itemsPerSecond > 0.0) {
+        entry["items_per_second"] = result.itemsPerSecond;
+    }
+    if (result.bytesPerSecond > 0.0) {
+        entry["bytes_per_second"] = result.bytesPerSecond;
+    }
+    return entry;
+}
+
+std::string formatRate(double perSecond, const char* unit) {
+    const char* prefixes[] = {"", "k", "M", "G"};
+    int index = 0;
+    while (perSecond >= 1000.0 && index < 3) {
+        perSecond /= 1000.0;
+        ++index;
+    }
+    char buffer[48];
+    std::snprintf(buffer, sizeof(buffer), "%.3g %s%s/s", perSecond, prefixes[index], unit);
+    return buffer;
+}
+
+/**
+ * Сравнение с прошлым прогоном: false, если есть регрессии сверх порога
+ */
+bool compareWithBaseline(const std::vector<Result>& results, const Options& options) {
+    std::ifstream file(options.baselinePath);
+    if (!file) {
+        std::cerr << "Cannot open baseline: " << options.baselinePath << std::endl;
+        return false;
+    }
+    json baseline = json::parse(file);
+    std::map<std::string, double> previous;
+    for (const auto& entry : baseline.value("benchmarks", json::array())) {
+        if (entry.value("aggregate_name", "median") == "median") {
+            previous[entry.value("name", "")] = entry.value("real_time", 0.0);
+        }
+    }
+
+    bool ok = true;
+    std::printf("\n%-48s %14s %14s %9s\n", "Compared to baseline", "baseline ns", "current ns", "change");
+    for (const auto& result : results) {
+        auto it = previous.find(result.name);
+        if (it == previous.end() || it->second <= 0.0) {
+            continue;
+        }
+        double change = (result.realNs - it->second) / it->second * 100.0;
+        bool regressed = change > options.threshold;
+        ok = ok && !regressed;
+        std::printf("%-48s %14.1f %14.1f %+8.1f%%%s\n", result.name.c_str(), it->second, result.realNs, change,
+                    regressed ? "  REGRESSION" : "");
+    }
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 2;
+    }
+
+    std::string workDir = (std::filesystem::temp_directory_path() /
+                           ("derivx_bench_" + std::to_string(::getpid()))).string();
+    std::filesystem::create_directories(workDir);
+
+    std::vector<Benchmark> benches = registerBenchmarks(options, workDir);
+    std::regex filter(options.filter.empty() ? std::string(".*") : options.filter);
+
+    std::vector<Result> results;
+    if (!options.list) {
+        std::printf("%-48s %14s %14s %12s %6s  %s\n", "Benchmark", "Time ns", "CPU ns", "Iterations", "CV", "Rate");
+    }
+    for (auto& bench : benches) {
+        if (!std::regex_search(bench.name, filter)) {
+            continue;
+        }
+        if (options.list) {
+            std::printf("%s\n", bench.name.c_str());
+            continue;
+        }
+
+        Result result = run(bench, options);
+        std::string rate = result.bytesPerSecond > 0.0 ? formatRate(result.bytesPerSecond, "B")
+                                                       : formatRate(result.itemsPerSecond, "items");
+        std::printf("%-48s %14.1f %14.1f %12llu %5.1f%%  %s\n", result.name.c_str(), result.realNs, result.cpuNs,
+                    static_cast<unsigned long long>(result.iterations), result.cv * 100.0, rate.c_str());
+        std::fflush(stdout);
+        results.push_back(result);
+    }
+
+    std::error_code ignored;
+    std::filesystem::remove_all(workDir, ignored);
+
+    if (!options.jsonPath.empty()) {
+        json report;
+        report["context"] = context();
+        report["benchmarks"] = json::array();
+        for (const auto& result : results) {
+            report["benchmarks"].push_back(toJson(result, options.repetitions));
+        }
+        std::ofstream out(options.jsonPath);
+        out << report.dump(2) << '\n';
+    }
+
+    if (!options.baselinePath.empty() && !compareWithBaseline(results, options)) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,752 @@
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * Нагрузочный генератор для derivx_api.
+ *
+ *   derivx_loadgen [--host=127.0.0.1] [--port=8080] [--connections=16] [--duration=10] [--warmup=2]
+ *                  [--rate=RPS] [--mix=option:1,greeks:1,strategy:2,ohlcv:2] [--legs=4]
+ *                  [--limits=100,1000,5000] [--symbols=4] [--rows=20000] [--seed=1]
+ *                  [--data-dir=DIR] [--generate-only] [--server=PATH] [--json=FILE]
+ *
+ * Каждое соединение - keep-alive HTTP/1.1 в своем потоке, следующий запрос
+ * отправляется после ответа на предыдущий (замкнутый цикл).
+ *
+ * Без --rate число запросов в полете равно --connections (фиксированная конкурентность).
+ * С --rate запросы планируются по расписанию с суммарной частотой RPS; задержка
+ * считается от запланированного, а не фактического момента отправки
+ * (коррекция coordinated omission, как в wrk2): если сервер тормозит и
+ * запросы уходят с опозданием, ожидание в очереди клиента тоже попадает в задержку.
+ *
+ * Данные: --data-dir (по умолчанию временный каталог) заполняется детерминированными
+ * CSV для символов LOADGEN_0_USDT, LOADGEN_1_USDT, ... . С --server=./derivx_api
+ * генератор сам запускает сервер на этих данных и останавливает его после прогона;
+ * с --generate-only только создает данные (сервер запускается вручную: derivx_api DIR).
+ */
+
+using json = nlohmann::json;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+enum RequestKind { OPTION, GREEKS, STRATEGY, OHLCV, PRICE, VOLATILITY, KIND_COUNT };
+
+const char* kindNames[KIND_COUNT] = {"option", "greeks", "strategy", "ohlcv", "price", "volatility"};
+
+struct Options {
+    std::string host = "127.0.0.1";
+    int port = 8080;
+    int connections = 16;
+    double duration = 10.0;
+    double warmup = 2.0;
+    double rate = 0.0;               // 0 - фиксированная конкурентность
+    double weights[KIND_COUNT] = {1.0, 1.0, 2.0, 2.0, 0.0, 0.0};
+    int legs = 4;
+    std::vector<int> limits = {100, 1000, 5000};
+    int symbols = 4;
+    size_t rows = 20000;
+    uint64_t seed = 1;
+    std::string dataDir;
+    bool generateOnly = false;
+    std::string server;
+    std::string jsonPath;
+};
+
+/**
+ * Логарифмически-линейная гистограмма задержек в наносекундах:
+ * 128 частей на степень двойки, погрешность квантилей не более 0.8%
+ */
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BITS = 7;
+    static constexpr uint64_t SUB_BUCKETS = uint64_t(1) << SUB_BITS;
+    static constexpr int MAX_EXPONENT = 42;   // ~73 минуты
+
+    LatencyHistogram() : counts_((MAX_EXPONENT - SUB_BITS + 1) * SUB_BUCKETS, 0) {}
+
+    void record(uint64_t nanos) {
+        counts_[index(nanos)]++;
+        count_++;
+        sum_ += static_cast<double>(nanos);
+        max_ = std::max(max_, nanos);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < counts_.size(); ++i) {
+            counts_[i] += other.counts_[i];
+        }
+        count_ += other.count_;
+        sum_ += other.sum_;
+        max_ = std::max(max_, other.max_);
+    }
+
+    uint64_t count() const { return count_; }
+    uint64_t max() const { return max_; }
+    double mean() const { return count_ > 0 ? sum_ / static_cast<double>(count_) : 0.0; }
+
+    /**
+     * Значение квантиля q (верхняя граница корзины, но не больше максимума)
+     */
+    uint64_t quantile(double q) const {
+        if (count_ == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(std::ceil(q * static_cast<double>(count_)));
+        rank = std::max<uint64_t>(rank, 1);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts_.size(); ++i) {
+            seen += counts_[i];
+            if (seen >= rank) {
+                return std::min(upperBound(i), max_);
+            }
+        }
+        return max_;
+    }
+
+private:
+    std::vector<uint64_t> counts_;
+    uint64_t count_ = 0;
+    double sum_ = 0.0;
+    uint64_t max_ = 0;
+
+    static size_t index(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<size_t>(value);
+        }
+        int exponent = 63 - __builtin_clzll(value);
+        if (exponent >= MAX_EXPONENT) {
+            return (MAX_EXPONENT - SUB_BITS + 1) * SUB_BUCKETS - 1;
+        }
+        uint64_t sub = (value >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1);
+        return static_cast<size_t>((exponent - SUB_BITS + 1) * SUB_BUCKETS + sub);
+    }
+
+    static uint64_t upperBound(size_t index) {
+        if (index < SUB_BUCKETS) {
+            return index;
+        }
+        int exponent = static_cast<int>(index / SUB_BUCKETS) + SUB_BITS - 1;
+        uint64_t sub = index % SUB_BUCKETS;
+        return ((SUB_BUCKETS + sub + 1) << (exponent - SUB_BITS)) - 1;
+    }
+};
+
+/**
+ * Статистика одного соединения (пишется только его потоком)
+ */
+struct ConnectionStats {
+    LatencyHistogram latency[KIND_COUNT];      // С коррекцией (от запланированного времени)
+    LatencyHistogram service[KIND_COUNT];      // От фактической отправки до ответа
+    uint64_t completed[KIND_COUNT] = {0};
+    uint64_t failed[KIND_COUNT] = {0};         // Статус не 2xx/304 или {"error": ...} в теле
+    uint64_t transportErrors = 0;              // Обрывы и переподключения
+    uint64_t bytesReceived = 0;
+};
+
+// ------------------------------------------------------------ HTTP клиент
+
+/**
+ * Keep-alive соединение с минимальным разбором ответа HTTP/1.1
+ * (Content-Length или chunked)
+ */
+class HttpConnection {
+public:
+    HttpConnection(const std::string& host, int port) : host_(host), port_(port) {}
+    ~HttpConnection() { close(); }
+
+    HttpConnection(const HttpConnection&) = delete;
+    HttpConnection& operator=(const HttpConnection&) = delete;
+
+    bool connect() {
+        close();
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* result = nullptr;
+        if (getaddrinfo(host_.c_str(), std::to_string(port_).c_str(), &hints, &result) != 0) {
+            return false;
+        }
+        for (addrinfo* it = result; it != nullptr; it = it->ai_next) {
+            fd_ = ::socket(it->ai_family, it->ai_socktype, it->ai_protocol);
+            if (fd_ < 0) {
+                continue;
+            }
+            if (::connect(fd_, it->ai_addr, it->ai_addrlen) == 0) {
+                int one = 1;
+                setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                break;
+            }
+            ::close(fd_);
+            fd_ = -1;
+        }
+        freeaddrinfo(result);
+        buffer_.clear();
+        return fd_ >= 0;
+    }
+
+    void close() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    bool connected() const { return fd_ >= 0; }
+
+    /**
+     * Отправка запроса и чтение ответа целиком; false - ошибка соединения
+     */
+    bool roundTrip(const std::string& request, int& status, std::string& body) {
+        if (!sendAll(request)) {
+            return false;
+        }
+
+        size_t headerEnd;
+        while ((headerEnd = buffer_.find("\r\n\r\n")) == std::string::npos) {
+            if (!receive()) {
+                return false;
+            }
+        }
+        std::string headers = buffer_.substr(0, headerEnd + 2);
+        buffer_.erase(0, headerEnd + 4);
+
+        if (std::sscanf(headers.c_str(), "HTTP/%*d.%*d %d", &status) != 1) {
+            return false;
+        }
+        std::string lower = headers;
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+        keepAlive_ = lower.find("connection: close") == std::string::npos;
+
+        body.clear();
+        if (lower.find("transfer-encoding: chunked") != std::string::npos) {
+            return readChunked(body);
+        }
+        size_t length = 0;
+        size_t pos = lower.find("content-length:");
+        if (pos != std::string::npos) {
+            length = static_cast<size_t>(std::strtoull(lower.c_str() + pos + 15, nullptr, 10));
+        }
+        while (buffer_.size() < length) {
+            if (!receive()) {
+                return false;
+            }
+        }
+        body = buffer_.substr(0, length);
+        buffer_.erase(0, length);
+        if (!keepAlive_) {
+            close();
+        }
+        return true;
+    }
+
+private:
+    std::string host_;
+    int port_;
+    int fd_ = -1;
+    std::string buffer_;
+    bool keepAlive_ = true;
+
+    bool sendAll(const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = ::send(fd_, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                return false;
+            }
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    bool receive() {
+        char chunk[16384];
+        ssize_t n = ::recv(fd_, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            return false;
+        }
+        buffer_.append(chunk, static_cast<size_t>(n));
+        return true;
+    }
+
+    bool readChunked(std::string& body) {
+        while (true) {
+            size_t lineEnd;
+            while ((lineEnd = buffer_.find("\r\n")) == std::string::npos) {
+                if (!receive()) {
+                    return false;
+                }
+            }
+            size_t size = static_cast<size_t>(std::strtoull(buffer_.c_str(), nullptr, 16));
+            buffer_.erase(0, lineEnd + 2);
+            while (buffer_.size() < size + 2) {
+                if (!receive()) {
+                    return false;
+                }
+            }
+            body.append(buffer_, 0, size);
+            buffer_.erase(0, size + 2);
+            if (size == 0) {
+                return true;
+            }
+        }
+    }
+};
+
+// ------------------------------------------------------------ Запросы
+
+std::string symbolName(int index) {
+    return "LOADGEN_" + std::to_string(index) + "_USDT";
+}
+
+std::string httpRequest(const Options& options, const char* method, const std::string& path, const std::string& body) {
+    std::string request = std::string(method) + " " + path + " HTTP/1.1\r\n";
+    request += "Host: " + options.host + ":" + std::to_string(options.port) + "\r\n";
+    request += "Connection: keep-alive\r\n";
+    if (!body.empty()) {
+        request += "Content-Type: application/json\r\n";
+    }
+    request += "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n";
+    request += body;
+    return request;
+}
+
+/**
+ * Заранее подготовленные запросы каждого вида: генерация не влияет на замер
+ */
+std::vector<std::vector<std::string>> buildRequests(const Options& options) {
+    std::vector<std::vector<std::string>> requests(KIND_COUNT);
+    std::mt19937_64 rng(options.seed);
+    std::uniform_real_distribution<double> spot(80.0, 120.0);
+    std::uniform_real_distribution<double> vol(30.0, 90.0);
+
+    for (int i = 0; i < 64; ++i) {
+        json option;
+        option["type"] = i % 2 ? "put" : "call";
+        option["spotPrice"] = spot(rng);
+        option["strike"] = 100.0;
+        option["timeToExpiration"] = 7.0 + i;
+        option["volatility"] = vol(rng);
+        option["riskFreeRate"] = 5.0;
+        requests[OPTION].push_back(httpRequest(options, "POST", "/api/calculate-option", option.dump()));
+        requests[GREEKS].push_back(httpRequest(options, "POST", "/api/calculate-greeks", option.dump()));
+
+        json strategy;
+        strategy["options"] = json::array();
+        for (int leg = 0; leg < options.legs; ++leg) {
+            json item;
+            item["type"] = leg % 2 ? "put" : "call";
+            item["position"] = (leg / 2) % 2 ? "short" : "long";
+            item["strike"] = 80.0 + 40.0 * leg / std::max(options.legs - 1, 1);
+            item["premium"] = 2.5;
+            item["quantity"] = 1;
+            strategy["options"].push_back(item);
+        }
+        strategy["numPoints"] = 200;
+        requests[STRATEGY].push_back(httpRequest(options, "POST", "/api/calculate-strategy", strategy.dump()));
+    }
+
+    for (int s = 0; s < options.symbols; ++s) {
+        std::string symbol = symbolName(s);
+        for (int limit : options.limits) {
+            requests[OHLCV].push_back(httpRequest(options, "GET",
+                "/api/ohlcv/" + symbol + "?limit=" + std::to_string(limit), ""));
+        }
+        requests[PRICE].push_back(httpRequest(options, "GET", "/api/price/" + symbol, ""));
+        requests[VOLATILITY].push_back(httpRequest(options, "GET", "/api/volatility/" + symbol, ""));
+    }
+    return requests;
+}
+
+// ------------------------------------------------------------ Данные
+
+/**
+ * Детерминированные часовые свечи случайного блуждания для каждого символа
+ */
+void generateData(const Options& options) {
+    std::filesystem::create_directories(options.dataDir);
+    for (int s = 0; s < options.symbols; ++s) {
+        std::ofstream out(options.dataDir + "/" + symbolName(s) + "_ohlcv.csv", std::ios::binary);
+        out << "date,open,high,low,close,volume\n";
+        std::mt19937_64 rng(options.seed * 1000003 + static_cast<uint64_t>(s));
+        std::normal_distribution<double> step(0.0, 0.01);
+        double price = 100.0 * (s + 1);
+        char line[160];
+        for (size_t i = 0; i < options.rows; ++i) {
+            std::time_t time = static_cast<std::time_t>(1577836800 + static_cast<int64_t>(i) * 3600);
+            std::tm utc{};
+            gmtime_r(&time, &utc);
+            char date[24];
+            std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &utc);
+            double open = price;
+            price *= std::exp(step(rng));
+            double high = std::max(open, price) * (1.0 + std::abs(step(rng)) * 0.5);
+            double low = std::min(open, price) * (1.0 - std::abs(step(rng)) * 0.5);
+            int length = std::snprintf(line, sizeof(line), "%s,%.4f,%.4f,%.4f,%.4f,%.2f\n",
+                                       date, open, high, low, price, 100.0 + std::abs(step(rng)) * 1e4);
+            out.write(line, length);
+        }
+    }
+}
+
+// ------------------------------------------------------------ Прогон
+
+struct RunState {
+    std::atomic<bool> stop{false};
+    Clock::time_point start;
+    Clock::time_point measureFrom;   // Конец прогрева
+};
+
+void runConnection(int id, const Options& options, const std::vector<std::vector<std::string>>& requests,
+                   RunState& state, ConnectionStats& stats) {
+    std::mt19937_64 rng(options.seed + static_cast<uint64_t>(id) * 7919);
+    std::discrete_distribution<int> pickKind(std::begin(options.weights), std::end(options.weights));
+
+    HttpConnection connection(options.host, options.port);
+
+    // Расписание соединения при --rate: равномерные интервалы со сдвигом между соединениями
+    double interval = options.rate > 0.0 ? options.connections / options.rate : 0.0;
+    auto intervalDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(interval));
+    Clock::time_point next = state.start + intervalDuration * id / std::max(options.connections, 1);
+
+    std::string body;
+    while (!state.stop.load(std::memory_order_relaxed)) {
+        if (!connection.connected() && !connection.connect()) {
+            stats.transportErrors++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+
+        Clock::time_point intended = Clock::now();
+        if (interval > 0.0) {
+            intended = next;
+            next += intervalDuration;
+            std::this_thread::sleep_until(intended);
+        }
+
+        int kind = pickKind(rng);
+        const std::vector<std::string>& pool = requests[kind];
+        const std::string& request = pool[rng() % pool.size()];
+
+        Clock::time_point sent = Clock::now();
+        int status = 0;
+        bool ok = connection.roundTrip(request, status, body);
+        Clock::time_point done = Clock::now();
+
+        if (!ok) {
+            stats.transportErrors++;
+            connection.close();
+            continue;
+        }
+        if (done < state.measureFrom) {
+            continue;
+        }
+
+        stats.completed[kind]++;
+        stats.bytesReceived += body.size();
+        if ((status < 200 || status >= 300) && status != 304) {
+            stats.failed[kind]++;
+        } else if (body.compare(0, 8, "{\"error\"") == 0) {
+            stats.failed[kind]++;
+        }
+        stats.latency[kind].record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(done - intended).count()));
+        stats.service[kind].record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(done - sent).count()));
+    }
+}
+
+bool waitForServer(const Options& options, double timeoutSeconds) {
+    auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(timeoutSeconds));
+    std::string request = httpRequest(options, "GET", "/api/health", "");
+    while (Clock::now() < deadline) {
+        HttpConnection connection(options.host, options.port);
+        int status = 0;
+        std::string body;
+        if (connection.connect() && connection.roundTrip(request, status, body) && status == 200) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    return false;
+}
+
+pid_t spawnServer(const Options& options) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        // Сервер завершается по Enter в stdin: подставляем канал, в который никто не пишет.
+        // Останавливается сигналом SIGTERM после прогона.
+        FILE* devNull = std::fopen("/dev/null", "w");
+        if (devNull != nullptr) {
+            dup2(fileno(devNull), STDOUT_FILENO);
+        }
+        int pipeFds[2];
+        if (pipe(pipeFds) == 0) {
+            dup2(pipeFds[0], STDIN_FILENO);
+        }
+        execl(options.server.c_str(), options.server.c_str(), options.dataDir.c_str(), static_cast<char*>(nullptr));
+        std::perror("execl");
+        _exit(127);
+    }
+    return pid;
+}
+
+// ------------------------------------------------------------ Отчет
+
+double millis(uint64_t nanos) {
+    return static_cast<double>(nanos) / 1e6;
+}
+
+json histogramJson(const LatencyHistogram& histogram) {
+    json result;
+    result["count"] = histogram.count();
+    result["mean_ms"] = histogram.mean() / 1e6;
+    result["p50_ms"] = millis(histogram.quantile(0.5));
+    result["p90_ms"] = millis(histogram.quantile(0.9));
+    result["p99_ms"] = millis(histogram.quantile(0.99));
+    result["p999_ms"] = millis(histogram.quantile(0.999));
+    result["p9999_ms"] = millis(histogram.quantile(0.9999));
+    result["max_ms"] = millis(histogram.max());
+    return result;
+}
+
+void printRow(const char* name, const LatencyHistogram& histogram, uint64_t failed, double seconds) {
+    std::printf("%-12s %10llu %8llu %10.1f %9.3f %9.3f %9.3f %9.3f %9.3f\n", name,
+                static_cast<unsigned long long>(histogram.count()), static_cast<unsigned long long>(failed),
+                static_cast<double>(histogram.count()) / seconds,
+                millis(histogram.quantile(0.5)), millis(histogram.quantile(0.9)), millis(histogram.quantile(0.99)),
+                millis(histogram.quantile(0.999)), millis(histogram.max()));
+}
+
+bool parseMix(const std::string& text, Options& options) {
+    std::fill(std::begin(options.weights), std::end(options.weights), 0.0);
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        size_t colon = item.find(':');
+        std::string name = item.substr(0, colon);
+        double weight = colon == std::string::npos ? 1.0 : std::atof(item.c_str() + colon + 1);
+        auto it = std::find_if(std::begin(kindNames), std::end(kindNames),
+                               [&](const char* kind) { return name == kind; });
+        if (it == std::end(kindNames) || weight < 0.0) {
+            std::cerr << "Unknown mix entry: " << item << std::endl;
+            return false;
+        }
+        options.weights[it - std::begin(kindNames)] = weight;
+    }
+    return std::any_of(std::begin(options.weights), std::end(options.weights), [](double w) { return w > 0.0; });
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto valueOf = [&](const char* prefix) -> const char* {
+            size_t length = std::strlen(prefix);
+            return arg.compare(0, length, prefix) == 0 ? argv[i] + length : nullptr;
+        };
+        const char* value = nullptr;
+        if ((value = valueOf("--host="))) {
+            options.host = value;
+        } else if ((value = valueOf("--port="))) {
+            options.port = std::atoi(value);
+        } else if ((value = valueOf("--connections="))) {
+            options.connections = std::max(std::atoi(value), 1);
+        } else if ((value = valueOf("--duration="))) {
+            options.duration = std::max(std::atof(value), 0.1);
+        } else if ((value = valueOf("--warmup="))) {
+            options.warmup = std::max(std::atof(value), 0.0);
+        } else if ((value = valueOf("--rate="))) {
+            options.rate = std::max(std::atof(value), 0.0);
+        } else if ((value = valueOf("--mix="))) {
+            if (!parseMix(value, options)) {
+                return false;
+            }
+        } else if ((value = valueOf("--legs="))) {
+            options.legs = std::max(std::atoi(value), 1);
+        } else if ((value = valueOf("--limits="))) {
+            options.limits.clear();
+            std::stringstream stream(value);
+            std::string item;
+            while (std::getline(stream, item, ',')) {
+                options.limits.push_back(std::max(std::atoi(item.c_str()), 1));
+            }
+        } else if ((value = valueOf("--symbols="))) {
+            options.symbols = std::max(std::atoi(value), 1);
+        } else if ((value = valueOf("--rows="))) {
+            options.rows = std::max<size_t>(std::strtoull(value, nullptr, 10), 2);
+        } else if ((value = valueOf("--seed="))) {
+            options.seed = std::strtoull(value, nullptr, 10);
+        } else if ((value = valueOf("--data-dir="))) {
+            options.dataDir = value;
+        } else if (arg == "--generate-only") {
+            options.generateOnly = true;
+        } else if ((value = valueOf("--server="))) {
+            options.server = value;
+        } else if ((value = valueOf("--json="))) {
+            options.jsonPath = value;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+    if (options.limits.empty()) {
+        options.limits.push_back(100);
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 2;
+    }
+
+    bool ownDataDir = options.dataDir.empty() && !options.generateOnly;
+    if (options.dataDir.empty()) {
+        std::string pattern = (std::filesystem::temp_directory_path() / "derivx_loadgen_XXXXXX").string();
+        if (mkdtemp(pattern.data()) == nullptr) {
+            std::perror("mkdtemp");
+            return 1;
+        }
+        options.dataDir = pattern;
+    }
+    generateData(options);
+    std::cout << "Data directory: " << options.dataDir << " (" << options.symbols << " symbols x "
+              << options.rows << " candles)" << std::endl;
+    if (options.generateOnly) {
+        return 0;
+    }
+
+    pid_t server = 0;
+    if (!options.server.empty()) {
+        server = spawnServer(options);
+    }
+    if (!waitForServer(options, server > 0 ? 30.0 : 2.0)) {
+        std::cerr << "Server is not reachable at " << options.host << ":" << options.port << std::endl;
+        if (server > 0) {
+            kill(server, SIGTERM);
+            waitpid(server, nullptr, 0);
+        }
+        return 1;
+    }
+
+    auto requests = buildRequests(options);
+    std::vector<ConnectionStats> stats(static_cast<size_t>(options.connections));
+    RunState state;
+    state.start = Clock::now();
+    state.measureFrom = state.start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.warmup));
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < options.connections; ++i) {
+        threads.emplace_back(runConnection, i, std::cref(options), std::cref(requests), std::ref(state), std::ref(stats[i]));
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.warmup + options.duration));
+    state.stop.store(true);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - state.measureFrom).count();
+
+    if (server > 0) {
+        kill(server, SIGTERM);
+        waitpid(server, nullptr, 0);
+    }
+    if (ownDataDir) {
+        std::error_code ignored;
+        std::filesystem::remove_all(options.dataDir, ignored);
+    }
+
+    // Сводка по видам запросов и общая
+    LatencyHistogram total;
+    LatencyHistogram totalService;
+    LatencyHistogram byKind[KIND_COUNT];
+    LatencyHistogram serviceByKind[KIND_COUNT];
+    uint64_t failed[KIND_COUNT] = {0};
+    uint64_t totalFailed = 0;
+    uint64_t transportErrors = 0;
+    uint64_t bytes = 0;
+    for (const auto& connection : stats) {
+        for (int k = 0; k < KIND_COUNT; ++k) {
+            byKind[k].merge(connection.latency[k]);
+            serviceByKind[k].merge(connection.service[k]);
+            total.merge(connection.latency[k]);
+            totalService.merge(connection.service[k]);
+            failed[k] += connection.failed[k];
+            totalFailed += connection.failed[k];
+        }
+        transportErrors += connection.transportErrors;
+        bytes += connection.bytesReceived;
+    }
+
+    std::printf("\n%s, %d connections, %.1f s measured%s\n",
+                options.rate > 0.0 ? "Fixed rate" : "Fixed concurrency", options.connections, seconds,
+                options.rate > 0.0 ? " (latency corrected for coordinated omission)" : "");
+    if (options.rate > 0.0) {
+        std::printf("Target rate: %.1f req/s\n", options.rate);
+    }
+    std::printf("%-12s %10s %8s %10s %9s %9s %9s %9s %9s\n",
+                "endpoint", "requests", "errors", "req/s", "p50 ms", "p90 ms", "p99 ms", "p99.9 ms", "max ms");
+    for (int k = 0; k < KIND_COUNT; ++k) {
+        if (byKind[k].count() > 0) {
+            printRow(kindNames[k], byKind[k], failed[k], seconds);
+        }
+    }
+    printRow("total", total, totalFailed, seconds);
+    if (options.rate > 0.0) {
+        printRow("service", totalService, totalFailed, seconds);
+    }
+    std::printf("Throughput: %.1f req/s, %.2f MB/s received, transport errors: %llu\n",
+                static_cast<double>(total.count()) / seconds, static_cast<double>(bytes) / seconds / 1e6,
+                static_cast<unsigned long long>(transportErrors));
+
+    if (!options.jsonPath.empty()) {
+        json report;
+        report["mode"] = options.rate > 0.0 ? "rate" : "concurrency";
+        report["connections"] = options.connections;
+        report["targetRate"] = options.rate;
+        report["seconds"] = seconds;
+        report["requests"] = total.count();
+        report["errors"] = totalFailed;
+        report["transportErrors"] = transportErrors;
+        report["throughput"] = static_cast<double>(total.count()) / seconds;
+        report["bytesPerSecond"] = static_cast<double>(bytes) / seconds;
+        report["latency"] = histogramJson(total);
+        report["serviceTime"] = histogramJson(totalService);
+        for (int k = 0; k < KIND_COUNT; ++k) {
+            if (byKind[k].count() > 0) {
+                json& endpoint = report["endpoints"][kindNames[k]];
+                endpoint["errors"] = failed[k];
+                endpoint["latency"] = histogramJson(byKind[k]);
+                endpoint["serviceTime"] = histogramJson(serviceByKind[k]);
+            }
+        }
+        std::ofstream out(options.jsonPath);
+        out << report.dump(2) << '\n';
+    }
+
+    return total.count() > 0 ? 0 : 1;
+}
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+
+namespace derivx {
+
+/**
+ * Полоса обработки: легкие запросы не ждут за тяжелыми
+ */
+enum class AdmissionLane {
+    INTERACTIVE,   // Цены, греки, данные символов - приоритетная очередь пула
+    HEAVY          // Большие кривые PNL, пакеты - ограниченный бюджет
+};
+
+/**
+ * Оценка стоимости запроса в условных единицах (~ микросекунды расчета).
+ * units == 0 - служебный запрос, допускается без учета.
+ */
+struct RequestCost {
+    AdmissionLane lane = AdmissionLane::INTERACTIVE;
+    uint64_t units = 0;
+};
+
+/**
+ * Параметры допуска запросов
+ */
+struct AdmissionConfig {
+    uint64_t heavyThreshold = 2000;                     // Стоимость, с которой запрос тяжелый
+    uint64_t heavyBudget = 2000000;                     // Суммарная стоимость тяжелых запросов в очереди и в работе
+    size_t heavyLimit = 64;                             // Тяжелых запросов в очереди и в работе
+    size_t interactiveLimit = 4096;                     // Легких запросов в очереди и в работе
+    std::chrono::milliseconds interactiveDeadline{2000};
+    std::chrono::milliseconds heavyDeadline{10000};
+};
+
+/**
+ * Счетчики полосы
+ */
+struct AdmissionLaneStats {
+    uint64_t admitted = 0;
+    uint64_t rejected = 0;
+    uint64_t inFlight = 0;        // Запросов в очереди и в работе
+    uint64_t inFlightUnits = 0;   // Их суммарная оценка
+};
+
+struct AdmissionStats {
+    AdmissionLaneStats interactive;
+    AdmissionLaneStats heavy;
+    uint64_t deadlineExceeded = 0;
+};
+
+/**
+ * Запрос не уложился в срок или клиент отключился
+ */
+class DeadlineExceeded : public std::runtime_error {
+public:
+    DeadlineExceeded() : std::runtime_error("Deadline exceeded") {}
+};
+
+/**
+ * Срок выполнения запроса и кооперативная отмена.
+ *
+ * Длинные циклы (кривая PNL, пакеты) периодически вызывают check():
+ * после истечения срока или cancel() расчет прерывается исключением
+ * DeadlineExceeded. Срок активен в потоке через DeadlineScope; части
+ * parallelFor на других потоках получают указатель явно.
+ */
+class RequestDeadline {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit RequestDeadline(Clock::time_point expiresAt) : expiresAt_(expiresAt) {}
+
+    RequestDeadline(const RequestDeadline&) = delete;
+    RequestDeadline& operator=(const RequestDeadline&) = delete;
+
+    /**
+     * Отмена (клиент отключился); безопасна из любого потока
+     */
+    void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+
+    bool expired() const {
+        return cancelled_.load(std::memory_order_relaxed) || Clock::now() >= expiresAt_;
+    }
+
+    void check() const {
+        if (expired()) {
+            throw DeadlineExceeded();
+        }
+    }
+
+    Clock::time_point expiresAt() const { return expiresAt_; }
+
+    /**
+     * Срок запроса, активного в текущем потоке (nullptr - без срока)
+     */
+    static const RequestDeadline* current();
+
+private:
+    Clock::time_point expiresAt_;
+    std::atomic<bool> cancelled_{false};
+};
+
+using RequestDeadlinePtr = std::shared_ptr<RequestDeadline>;
+
+/**
+ * Делает срок текущим для потока на время своей жизни
+ */
+class DeadlineScope {
+public:
+    explicit DeadlineScope(const RequestDeadline* deadline);
+    ~DeadlineScope();
+
+    DeadlineScope(const DeadlineScope&) = delete;
+    DeadlineScope& operator=(const DeadlineScope&) = delete;
+
+private:
+    const RequestDeadline* previous_;
+};
+
+class AdmissionController;
+
+/**
+ * Место запроса в полосе; освобождается при уничтожении (после ответа)
+ */
+class AdmissionTicket {
+public:
+    AdmissionTicket() = default;
+    ~AdmissionTicket() { release(); }
+
+    AdmissionTicket(AdmissionTicket&& other) noexcept { *this = std::move(other); }
+    AdmissionTicket& operator=(AdmissionTicket&& other) noexcept;
+
+    AdmissionTicket(const AdmissionTicket&) = delete;
+    AdmissionTicket& operator=(const AdmissionTicket&) = delete;
+
+    bool admitted() const { return admitted_; }
+    void release();
+
+private:
+    friend class AdmissionController;
+
+    AdmissionController* controller_ = nullptr;
+    RequestCost cost_;
+    bool admitted_ = false;
+};
+
+/**
+ * Допуск запросов под нагрузкой.
+ *
+ * Стоимость оценивается по пути и тексту запроса без полного разбора JSON.
+ * В каждой полосе ограничено число запросов в очереди и в работе (у тяжелой -
+ * еще и их суммарная стоимость); сверх лимита запрос сразу отклоняется
+ * ответом 503 с Retry-After, а не ждет в очереди, так что задержка допущенных
+ * запросов остается предсказуемой. Один запрос дороже всего бюджета
+ * допускается, только когда полоса пуста.
+ */
+class AdmissionController {
+public:
+    explicit AdmissionController(const AdmissionConfig& config = AdmissionConfig());
+
+    /**
+     * Оценка стоимости: path - путь без query, query - строка после '?'
+     */
+    RequestCost estimate(const std::string& method, const std::string& path,
+                         const std::string& query, const std::string& body) const;
+
+    /**
+     * Попытка занять место в полосе; !ticket.admitted() - отклонить запрос
+     */
+    AdmissionTicket tryAdmit(const RequestCost& cost);
+
+    /**
+     * Срок запроса: срок полосы от started, но не дольше запрошенного клиентом
+     * (clientTimeoutMs > 0, заголовок X-Request-Timeout-Ms)
+     */
+    RequestDeadlinePtr deadlineFor(const RequestCost& cost, RequestDeadline::Clock::time_point started,
+                                   int64_t clientTimeoutMs = 0) const;
+
+    /**
+     * Через сколько секунд повторить отклоненный запрос: оценка времени
+     * разбора текущей очереди полосы по наблюдаемой скорости (1..60)
+     */
+    uint32_t retryAfterSeconds(AdmissionLane lane);
+
+    void recordDeadlineExceeded() { deadlineExceeded_.fetch_add(1, std::memory_order_relaxed); }
+
+    AdmissionStats stats() const;
+
+    /**
+     * Значение заголовка X-Request-Timeout-Ms (0 - нет или некорректно)
+     */
+    static int64_t parseTimeoutHeader(const std::string* value);
+
+private:
+    friend class AdmissionTicket;
+
+    struct Lane {
+        std::atomic<uint64_t> admitted{0};
+        std::atomic<uint64_t> rejected{0};
+        std::atomic<uint64_t> inFlight{0};
+        std::atomic<uint64_t> inFlightUnits{0};
+        std::atomic<uint64_t> completedUnits{0};
+
+        // Скорость разбора очереди (единиц в секунду), обновляется при отказах
+        std::mutex rateMutex;
+        RequestDeadline::Clock::time_point sampledAt;
+        uint64_t sampledUnits = 0;
+        double unitsPerSecond = 0.0;
+    };
+
+    AdmissionConfig config_;
+    Lane interactive_;
+    Lane heavy_;
+    std::atomic<uint64_t> deadlineExceeded_{0};
+
+    Lane& lane(AdmissionLane lane) { return lane == AdmissionLane::HEAVY ? heavy_ : interactive_; }
+    void release(const RequestCost& cost);
+};
+
+} // namespace derivx
@@ -2,12 +2,122 @@
 
 #include "option_pricing.hpp"
 #include "volatility.hpp"
+#include "symbol_cache.hpp"
+#include "compute_pool.hpp"
+#include "response_format.hpp"
+#include "strategy_stream.hpp"
+#include "http_cache.hpp"
+#include "admission.hpp"
+#include "request_arena.hpp"
 #include <string>
 #include <vector>
+#include <mutex>
+#include <filesystem>
 #include <map>
+#include <unordered_map>
 
 namespace derivx {
 
+/**
+ * Максимальное число свечей в одном ответе /api/ohlcv
+ */
+constexpr int MAX_OHLCV_LIMIT = 5000;
+
+/**
+ * Границы кривой /api/calculate-strategy: точек и ног стратегии
+ */
+constexpr int MAX_PAYOFF_POINTS = 100000;
+constexpr size_t MAX_STRATEGY_LEGS = 64;
+
+/**
+ * Максимальное число операций в одном запросе /api/batch
+ */
+constexpr size_t MAX_BATCH_ITEMS = 64;
+
+/**
+ * Границы цепочки опционов /api/option-chain: страйков и экспираций
+ */
+constexpr size_t MAX_CHAIN_STRIKES = 500;
+constexpr size_t MAX_CHAIN_EXPIRIES = 32;
+
+/**
+ * Границы /api/backtest: символов в запросе и сделок в ответе с includeTrades
+ */
+constexpr size_t MAX_BACKTEST_SYMBOLS = 16;
+constexpr size_t MAX_BACKTEST_TRADES = 5000;
+
+/**
+ * Границы /api/optimize-strategy: страйков сетки, комбинаций и лучших в ответе
+ */
+constexpr size_t MAX_OPTIMIZER_STRIKES = 101;
+constexpr uint64_t MAX_OPTIMIZER_CANDIDATES = 20000000;
+constexpr size_t MAX_OPTIMIZER_TOP = 50;
+
+/**
+ * Границы /api/model-chain: котировок калибровки и стартов оптимизатора
+ */
+constexpr size_t MAX_CALIBRATION_QUOTES = 500;
+constexpr size_t MAX_CALIBRATION_STARTS = 16;
+
+/**
+ * Снимки OHLCV данных, закрепленные на время пакетного запроса (символ -> данные)
+ */
+using SeriesSnapshots = std::unordered_map<std::string, OHLCVSeriesPtr>;
+
+/**
+ * Параметры запроса OHLCV данных
+ */
+struct OHLCVQuery {
+    int limit = 100;
+    bool hasFrom = false;
+    int64_t from = 0;      // Unix время, включительно
+    bool hasTo = false;
+    int64_t to = 0;        // Unix время, включительно
+    std::string cursor;    // Непрозрачный курсор из nextCursor/prevCursor предыдущего ответа
+    int maxPoints = 0;     // > 0: агрегировать все окно до maxPoints свечей (limit не применяется)
+};
+
+/**
+ * Параметры цепочки опционов.
+ * Страйки - явный список или сетка minStrike..maxStrike из numStrikes точек;
+ * relative - значения заданы в долях текущей цены символа.
+ */
+struct OptionChainQuery {
+    std::vector<double> strikes;                       // Пусто - сетка
+    double minStrike = 0.8;
+    double maxStrike = 1.2;
+    int numStrikes = 21;
+    bool relative = true;
+    std::vector<double> expiries{7, 14, 30, 60, 90};   // Дни до экспирации
+    bool hasVolatility = false;
+    double volatility = 0.0;                           // Проценты; без нее - историческая волатильность
+    double riskFreeRate = 5.0;                         // Проценты
+    double dividendYield = 0.0;                        // Проценты
+};
+
+/**
+ * GET эндпоинты, ответ которых зависит только от данных символа
+ */
+enum class DataEndpoint {
+    PRICE,
+    VOLATILITY,
+    OHLCV,
+    OPTION_CHAIN
+};
+
+/**
+ * Условный GET запрос к данным символа
+ */
+struct ConditionalGet {
+    DataEndpoint endpoint = DataEndpoint::PRICE;
+    std::string symbol;
+    OHLCVQuery query;                                // Только для OHLCV
+    OptionChainQuery chain;                          // Только для OPTION_CHAIN
+    ResponseFormat format = ResponseFormat::JSON;
+    std::string ifNoneMatch;                         // Заголовок If-None-Match
+    std::string ifModifiedSince;                     // Заголовок If-Modified-Since
+};
+
 /**
  * Класс для обработки REST API запросов
  */
@@ -16,8 +126,25 @@ public:
     /**
      * Инициализация API handler
      * @param dataDir Путь к директории с OHLCV данными
+     * @param cacheConfig Параметры кэша символов (бюджет памяти, TTL пустых записей)
      */
-    void initialize(const std::string& dataDir);
+    void initialize(const std::string& dataDir,
+                    const SymbolCacheConfig& cacheConfig = SymbolCacheConfig());
+    
+    /**
+     * Бюджет кэша сериализованных ответов в байтах (0 - не хранить тела)
+     */
+    void setResponseCacheBudget(size_t budgetBytes) { responseCache_.setBudget(budgetBytes); }
+    
+    /**
+     * Пул для параллельных расчетов внутри запроса (nullptr - считать в текущем потоке)
+     */
+    void setComputePool(ComputePool* pool) { computePool_ = pool; }
+    
+    /**
+     * Допуск запросов сервера (для метрик полос; nullptr - не выводить)
+     */
+    void setAdmission(const AdmissionController* admission) { admission_ = admission; }
     
     /**
      * Обработка запроса на расчет цены опциона
@@ -25,9 +152,15 @@ public:
     std::string handleCalculateOption(const std::string& requestBody);
     
     /**
-     * Обработка запроса на расчет PNL стратегии
+     * Обработка запроса на расчет PNL стратегии.
+     * С "profile": true в каждой точке кривой - суммарные греки стратегии
+     * (timeToExpiration в днях, volatility, riskFreeRate, dividendYield в процентах).
+     * С "analysis": true - ожидаемый PNL, вероятность прибыли, VaR и expected shortfall
+     * на экспирации по логнормальному распределению и (с symbol) по историческим доходностям.
+     * @param format Формат ответа (JSON, CBOR, MessagePack или упакованные колонки price/pnl[/греки])
      */
-    std::string handleCalculateStrategy(const std::string& requestBody);
+    std::string handleCalculateStrategy(const std::string& requestBody,
+                                        ResponseFormat format = ResponseFormat::JSON);
     
     /**
      * Обработка запроса на расчет греков
@@ -36,27 +169,202 @@ public:
     
     /**
      * Обработка запроса на получение волатильности
+     * @param snapshots Данные, уже загруженные пакетным запросом (nullptr - из кэша)
      */
-    std::string handleGetVolatility(const std::string& symbol);
+    std::string handleGetVolatility(const std::string& symbol, const SeriesSnapshots* snapshots = nullptr);
     
     /**
      * Обработка запроса на получение текущей цены
      */
-    std::string handleGetCurrentPrice(const std::string& symbol);
+    std::string handleGetCurrentPrice(const std::string& symbol, const SeriesSnapshots* snapshots = nullptr);
+    
+    /**
+     * Обработка запроса на получение OHLCV данных.
+     * Без from/cursor возвращает последние limit свечей окна, иначе страницу
+     * начиная с from. Стоимость O(log n + k) по числу свечей в ответе.
+     * С maxPoints все окно [from, to] агрегируется без постраничного разбиения.
+     * Упакованный формат содержит колонки timestamp/open/high/low/close/volume без курсоров.
+     */
+    std::string handleGetOHLCV(const std::string& symbol, const OHLCVQuery& query = OHLCVQuery(),
+                               ResponseFormat format = ResponseFormat::JSON,
+                               const SeriesSnapshots* snapshots = nullptr);
+    
+    /**
+     * Цепочка опционов символа: call и put с греками для каждого страйка
+     * и экспирации. Цена - последняя свеча, волатильность - историческая
+     * за 30 свечей (или из запроса). Величины экспирации считаются один раз,
+     * страйки - общим проходом (OptionPricing::calculateChain).
+     */
+    std::string handleGetOptionChain(const std::string& symbol, const OptionChainQuery& query,
+                                     ResponseFormat format = ResponseFormat::JSON,
+                                     const SeriesSnapshots* snapshots = nullptr);
     
     /**
-     * Обработка запроса на получение OHLCV данных
+     * Пакетный запрос: {"requests": [{"op": "price", "symbol": "BTC_USDT"},
+     * {"op": "calculate-greeks", "body": {...}}, ...]}.
+     * Операции выполняются параллельно на пуле расчетов, данные каждого символа
+     * загружаются один раз на весь пакет. Результаты - в порядке запросов.
      */
-    std::string handleGetOHLCV(const std::string& symbol, int limit = 100);
+    std::string handleBatch(const std::string& requestBody);
+    
+    /**
+     * Бэктест шаблона стратегии по истории символов:
+     * {"symbols": [...], "legs": [{"type", "position", "moneyness", "quantity"}],
+     *  "timeToExpiration": дни, "rollEvery": дни, "volatilityPeriod", "riskFreeRate",
+     *  "dividendYield", "from", "to", "includeTrades"}.
+     * На каждую дату входа ноги оцениваются по Black-Scholes со скользящей
+     * исторической волатильностью, на экспирации - по calculatePayoff.
+     * Окна всех символов считаются параллельно на пуле расчетов.
+     */
+    std::string handleBacktest(const std::string& requestBody);
+    
+    /**
+     * Поиск стратегии по сетке страйков:
+     * {"symbol", "timeToExpiration": дни, "structures": [...], "minStrike", "maxStrike"
+     *  (доли текущей цены), "numStrikes", "volatility", "riskFreeRate", "dividendYield",
+     *  "maxLoss", "budget", "deltaNeutral", "deltaTolerance",
+     *  "objective": "expectedPnl" | "probabilityOfProfit", "topN", "allowReverse"}.
+     * Премии - по Black-Scholes (цепочка страйков), PNL на экспирации
+     * интегрируется по историческим доходностям символа за срок экспирации.
+     */
+    std::string handleOptimizeStrategy(const std::string& requestBody);
+    
+    /**
+     * Цепочка опционов по модели Heston, Merton или Kou:
+     * {"symbol", "model", "method": "cos" | "fft", "params": {...}, "calibrate":
+     *  "history" | "quotes" | "none", "quotes": [{"strike", "timeToExpiration": дни,
+     *  "price", "type"}], "starts", "strikes" | "minStrike", "maxStrike" (доли текущей
+     *  цены), "numStrikes", "expiries": [дни], "volatility", "riskFreeRate", "dividendYield"}.
+     * Параметры калибруются по истории символа или по котировкам (старты - на пуле
+     * расчетов), затем вся сетка страйков экспирации оценивается одним преобразованием.
+     */
+    std::string handleModelChain(const std::string& requestBody);
+    
+    /**
+     * Условный GET цены, волатильности, OHLCV или цепочки опционов.
+     * ETag строится из версии снимка символа и параметров запроса; при совпадении
+     * If-None-Match (или If-Modified-Since без него) возвращается notModified.
+     * Тела ответов последней версии данных переиспользуются без повторной сериализации.
+     */
+    CachedResponse handleConditionalGet(const ConditionalGet& request);
+    
+    /**
+     * Счетчики кэша символов (попадания, промахи, вытеснения, объем) и кэша ответов
+     */
+    std::string handleGetCacheStats();
+    
+    /**
+     * Метрики сервиса в текстовом формате Prometheus: задержки эндпоинтов,
+     * чтение данных, кэши, очередь пула расчетов и SSE подписки
+     */
+    std::string handleGetMetrics();
+    
+    /**
+     * Подписка на переоценку стратегии при новых свечах символа.
+     * Стратегия - тело как у /calculate-strategy плюс timeToExpiration,
+     * riskFreeRate, dividendYield, volatility (без нее - историческая).
+     * Исключение - нет данных или стратегия некорректна.
+     */
+    StreamSubscriberPtr subscribeStrategy(const std::string& symbol, const std::string& strategy);
+    
+    /**
+     * Проверка файлов символов с подписками; при новой свече стратегии
+     * пересчитываются (по одному разу на тему) и рассылаются подписчикам.
+     * Возвращает число обновившихся символов.
+     */
+    size_t pollStrategyStreams();
+    
+    StrategyStreamStats strategyStreamStats() const { return strategyStreams_.stats(); }
+    
+    /**
+     * Проверка файла данных символа: если файл изменился и в нем появилась
+     * новая или обновленная последняя свеча, кэш перечитывается и возвращается
+     * новый снимок, иначе nullptr.
+     */
+    OHLCVSeriesPtr refreshSymbol(const std::string& symbol);
+    
+    /**
+     * Разбор query параметров /api/ohlcv: limit, from, to, maxPoints, cursor.
+     * Значения параметров - уже URL-декодированные строки.
+     * @return Текст ошибки или пустая строка
+     */
+    static std::string parseOHLCVQuery(const std::map<std::string, std::string>& params, OHLCVQuery& query);
+    
+    /**
+     * Разбор query параметров /api/option-chain: strikes (через запятую) или
+     * minStrike, maxStrike, numStrikes; relative; expiries (дни через запятую);
+     * volatility, riskFreeRate, dividendYield (проценты).
+     * Значения параметров - уже URL-декодированные строки.
+     * @return Текст ошибки или пустая строка
+     */
+    static std::string parseOptionChainQuery(const std::map<std::string, std::string>& params,
+                                             OptionChainQuery& query);
+    
+    /**
+     * Ряд метрик эндпоинта по пути запроса (регистрируется при первом вызове).
+     * Неизвестные пути попадают в "other", чтобы число рядов не зависело от клиентов.
+     */
+    static size_t metricsEndpoint(const std::string& path);
 
 private:
     std::string dataDirectory_;
-    std::map<std::string, std::vector<OHLCV>> ohlcvCache_;
+    SymbolCache ohlcvCache_;
+    ComputePool* computePool_ = nullptr;
+    const AdmissionController* admission_ = nullptr;
+    
+    /**
+     * Время изменения и размер файла данных при последней проверке
+     */
+    struct FileStamp {
+        bool known = false;
+        std::filesystem::file_time_type modified;
+        uintmax_t size = 0;
+    };
+    std::mutex fileStampsMutex_;
+    std::unordered_map<std::string, FileStamp> fileStamps_;
+    
+    ResponseCache responseCache_;
+    
+    StrategyStreamHub strategyStreams_{[this](const std::string& strategy, const OHLCVSeries& series) {
+        return evaluateStrategyMark(strategy, series.view());
+    }};
+    
+    /**
+     * Оценка стратегии по последней свече: PNL при экспирации и суммарные греки
+     */
+    StrategyMark evaluateStrategyMark(const std::string& strategy, OHLCVView data);
+    
+    /**
+     * Загрузка OHLCV данных для символа через кэш (или из snapshots, если символ там есть).
+     * Возвращает разделяемый неизменяемый снимок (никогда не nullptr).
+     */
+    OHLCVSeriesPtr loadOHLCVForSymbol(const std::string& symbol, const SeriesSnapshots* snapshots = nullptr);
+    
+    /**
+     * Кривая PNL; большие кривые считаются частями на пуле расчетов.
+     * В области ArenaScope кривая размещается в арене запроса.
+     */
+    ArenaVector<std::pair<double, double>> buildPayoffCurve(
+        const std::vector<Option>& options,
+        double minPrice,
+        double maxPrice,
+        int numPoints
+    );
+    
+    /**
+     * Суммарные греки стратегии в ценах точек кривой; большие профили
+     * считаются частями на пуле расчетов. Размещается в арене запроса.
+     */
+    ArenaVector<Greeks> buildGreeksProfile(
+        const std::vector<Option>& options,
+        const MarketParams& market,
+        const ArenaVector<std::pair<double, double>>& curve
+    );
     
     /**
-     * Загрузка OHLCV данных для символа
+     * Чтение OHLCV данных символа с диска (загрузчик для кэша)
      */
-    std::vector<OHLCV> loadOHLCVForSymbol(const std::string& symbol);
+    OHLCVSeriesPtr readOHLCVFromDisk(const std::string& symbol);
     
     /**
      * Получение пути к файлу данных для символа
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "option_pricing.hpp"
+#include "volatility.hpp"
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace derivx {
+
+/**
+ * Нога шаблона стратегии: страйк задается долей цены на дату входа
+ * (1.0 - ATM, 1.05 - на 5% выше цены)
+ */
+struct BacktestLeg {
+    OptionType type = OptionType::CALL;
+    OptionPosition position = OptionPosition::LONG;
+    double moneyness = 1.0;
+    int quantity = 1;
+};
+
+/**
+ * Параметры бэктеста шаблона стратегии
+ */
+struct BacktestConfig {
+    std::vector<BacktestLeg> legs;
+    double expiryDays = 30.0;       // Срок опционов от даты входа
+    double rollDays = 7.0;          // Интервал между входами
+    int volatilityPeriod = 30;      // Свечей в окне исторической волатильности
+    double riskFreeRate = 0.05;     // В долях
+    double dividendYield = 0.0;     // В долях
+    bool hasFrom = false;           // Границы дат входа (unix время, включительно)
+    int64_t from = 0;
+    bool hasTo = false;
+    int64_t to = 0;
+};
+
+/**
+ * Окно бэктеста: индексы свечи входа и свечи расчета (первой не раньше экспирации)
+ */
+struct BacktestWindow {
+    size_t entry = 0;
+    size_t settle = 0;
+};
+
+/**
+ * Результат одного окна: вход по Black-Scholes, расчет по payoff на экспирации
+ */
+struct BacktestTrade {
+    int64_t entryTime = 0;
+    int64_t settleTime = 0;
+    double entrySpot = 0.0;
+    double settleSpot = 0.0;
+    double volatility = 0.0;    // Историческая волатильность на дату входа (в долях)
+    double premium = 0.0;       // Чистая премия: уплаченная (> 0) или полученная (< 0)
+    double pnl = 0.0;
+};
+
+/**
+ * Распределение величины: моменты и перцентили (линейная интерполяция)
+ */
+struct DistributionStats {
+    size_t count = 0;
+    double mean = 0.0;
+    double stdDev = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    double p5 = 0.0;
+    double p25 = 0.0;
+    double p50 = 0.0;
+    double p75 = 0.0;
+    double p95 = 0.0;
+};
+
+/**
+ * Итоги бэктеста по набору сделок
+ */
+struct BacktestSummary {
+    size_t trades = 0;
+    size_t wins = 0;                // Сделок с pnl > 0
+    double winRate = 0.0;
+    double totalPnl = 0.0;
+    double maxDrawdown = 0.0;       // Наибольшее падение накопленного PNL от максимума (по датам расчета)
+    double maxDrawdownReturn = 0.0; // То же для накопленной доходности (сопоставимо между символами)
+    DistributionStats pnl;
+    DistributionStats returns;      // pnl / цена входа
+};
+
+/**
+ * Скользящая историческая волатильность по всей истории символа.
+ * Префиксные суммы доходностей считаются один раз за O(n), после чего
+ * волатильность окна, заканчивающегося любой свечой, - O(1).
+ * Значение совпадает с calculateHistoricalVolatility(свечи [0, index], period).
+ */
+class RollingVolatility {
+public:
+    explicit RollingVolatility(OHLCVView data);
+
+    /**
+     * Годовая волатильность последних period свечей, заканчивая index
+     */
+    double at(size_t index, int period) const;
+
+private:
+    // Суммы по доходностям свечей [1, k): r, r^2 и их количество
+    std::vector<double> sum_;
+    std::vector<double> sumSquares_;
+    std::vector<uint32_t> count_;
+};
+
+/**
+ * Бэктест шаблона опционной стратегии по истории OHLCV.
+ * Окна независимы, поэтому вызывающий может считать их параллельно.
+ */
+class Backtester {
+public:
+    /**
+     * Даты входа каждые rollDays начиная с первой свечи с полным окном
+     * волатильности; окна, экспирация которых позже конца истории, не включаются
+     */
+    static std::vector<BacktestWindow> scheduleWindows(OHLCVView data, const BacktestConfig& config);
+
+    /**
+     * Расчет одного окна: страйки от цены входа, премии по Black-Scholes
+     * с волатильностью на дату входа, PNL по calculatePayoff на свече расчета
+     */
+    static BacktestTrade runWindow(
+        OHLCVView data,
+        const RollingVolatility& volatility,
+        const BacktestConfig& config,
+        const BacktestWindow& window
+    );
+
+    /**
+     * Итоги по сделкам одного или нескольких символов
+     */
+    static BacktestSummary summarize(const BacktestTrade* trades, size_t count);
+
+    /**
+     * Распределение значений (values переупорядочивается)
+     */
+    static DistributionStats distribution(std::vector<double>& values);
+};
+
+} // namespace derivx
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace derivx {
+
+/**
+ * Потоковая запись CBOR (RFC 8949). Интерфейс совпадает с JsonWriter,
+ * поэтому сериализация ответа пишется один раз шаблоном по типу writer.
+ * Числа с плавающей точкой пишутся как float32, если это без потерь, иначе float64.
+ */
+class CborWriter {
+public:
+    explicit CborWriter(size_t reserveBytes = 0);
+
+    void beginObject(size_t count);
+    void endObject() {}
+    void beginArray(size_t count);
+    void endArray() {}
+
+    void key(const char* name);
+    void key(const std::string& name);
+
+    void value(double number);
+    void value(bool flag);
+    void value(const char* text);
+    void value(const std::string& text);
+    void null();
+
+    template <typename Integer,
+              typename = std::enable_if_t<std::is_integral<Integer>::value && !std::is_same<Integer, bool>::value>>
+    void value(Integer number) {
+        if constexpr (std::is_signed<Integer>::value) {
+            if (number < 0) {
+                writeHead(1, static_cast<uint64_t>(-(static_cast<int64_t>(number) + 1)));
+                return;
+            }
+        }
+        writeHead(0, static_cast<uint64_t>(number));
+    }
+
+    std::string release();
+
+private:
+    std::string out_;
+
+    void writeHead(uint8_t major, uint64_t argument);
+    void writeText(const char* text, size_t length);
+};
+
+/**
+ * Потоковая запись MessagePack. Интерфейс совпадает с JsonWriter.
+ */
+class MsgPackWriter {
+public:
+    explicit MsgPackWriter(size_t reserveBytes = 0);
+
+    void beginObject(size_t count);
+    void endObject() {}
+    void beginArray(size_t count);
+    void endArray() {}
+
+    void key(const char* name);
+    void key(const std::string& name);
+
+    void value(double number);
+    void value(bool flag);
+    void value(const char* text);
+    void value(const std::string& text);
+    void null();
+
+    template <typename Integer,
+              typename = std::enable_if_t<std::is_integral<Integer>::value && !std::is_same<Integer, bool>::value>>
+    void value(Integer number) {
+        if constexpr (std::is_signed<Integer>::value) {
+            if (number < 0) {
+                writeSigned(static_cast<int64_t>(number));
+                return;
+            }
+        }
+        writeUnsigned(static_cast<uint64_t>(number));
+    }
+
+    std::string release();
+
+private:
+    std::string out_;
+
+    void writeUnsigned(uint64_t number);
+    void writeSigned(int64_t number);
+    void writeText(const char* text, size_t length);
+    void writeBigEndian(uint64_t value, size_t bytes);
+};
+
+/**
+ * Упакованный колоночный формат для массивов чисел.
+ *
+ * Заголовок (little-endian):
+ *   "DXC1" | u8 тип (1 - float64, 2 - float32) | u8 0 | u16 колонок | u32 строк
+ *   для каждой колонки: u8 длина имени | имя
+ *   нули до выравнивания на 8 байт
+ * Далее колонки подряд, каждая - rows значений выбранного типа.
+ * В float32 Unix timestamp теряет точность - для свечей используйте float64.
+ */
+class ColumnarWriter {
+public:
+    ColumnarWriter(bool float32, size_t rows, const std::vector<std::string>& columns);
+
+    /**
+     * Запись очередной колонки: getter(i) возвращает значение строки i
+     */
+    template <typename Getter>
+    void column(Getter&& getter) {
+        if (float32_) {
+            for (size_t i = 0; i < rows_; ++i) {
+                appendFloat(static_cast<float>(getter(i)));
+            }
+        } else {
+            for (size_t i = 0; i < rows_; ++i) {
+                appendDouble(static_cast<double>(getter(i)));
+            }
+        }
+    }
+
+    std::string release();
+
+private:
+    std::string out_;
+    bool float32_;
+    size_t rows_;
+
+    void appendFloat(float value);
+    void appendDouble(double value);
+};
+
+} // namespace derivx
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+namespace derivx {
+
+/**
+ * Параметры пула расчетов
+ */
+struct ComputePoolConfig {
+    size_t workerCount = 0;   // 0 - по числу ядер
+    bool pinThreads = false;  // Привязать i-й поток к i-му ядру (только Linux)
+};
+
+/**
+ * Приоритет задачи пула
+ */
+enum class TaskPriority {
+    NORMAL,
+    HIGH     // Берется раньше всех обычных задач (легкие запросы не ждут за тяжелыми)
+};
+
+/**
+ * Планировщик CPU-задач с перехватом работы (work stealing),
+ * отделенный от I/O потоков HTTP сервера.
+ *
+ * У каждого потока своя очередь: свои задачи берутся с конца (LIFO, горячий кэш),
+ * внешние задачи - из общей очереди, при простое поток забирает задачи
+ * с начала чужих очередей. parallelFor/parallelReduce делят диапазон на части;
+ * вызывающий поток сам выполняет части, поэтому вложенный вызов из задачи пула
+ * не приводит к взаимной блокировке.
+ */
+class ComputePool {
+public:
+    using Task = std::function<void()>;
+
+    explicit ComputePool(const ComputePoolConfig& config = ComputePoolConfig());
+    ~ComputePool();
+
+    ComputePool(const ComputePool&) = delete;
+    ComputePool& operator=(const ComputePool&) = delete;
+
+    /**
+     * Постановка задачи. Исключения задачи должна обрабатывать сама задача.
+     * Задачи HIGH попадают в отдельную общую очередь, которую потоки проверяют первой.
+     */
+    void submit(Task task, TaskPriority priority = TaskPriority::NORMAL);
+
+    /**
+     * Количество рабочих потоков
+     */
+    size_t workerCount() const { return workers_.size(); }
+
+    /**
+     * Текущее количество задач, ожидающих выполнения
+     */
+    size_t queueDepth() const { return pending_.load(std::memory_order_relaxed); }
+
+    /**
+     * Параллельный цикл: fn(lo, hi) вызывается для непересекающихся частей [begin, end)
+     * размером не меньше grain. Возвращает управление после выполнения всех частей;
+     * первое исключение из fn пробрасывается вызывающему.
+     */
+    template <typename Fn>
+    void parallelFor(size_t begin, size_t end, size_t grain, Fn&& fn);
+
+    /**
+     * Параллельная свертка: map(lo, hi) -> T для каждой части, затем
+     * combine(acc, part) слева направо (результат детерминирован).
+     */
+    template <typename T, typename Map, typename Combine>
+    T parallelReduce(size_t begin, size_t end, size_t grain, T identity, Map&& map, Combine&& combine);
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    struct ForState {
+        std::function<void(size_t, size_t)> body;
+        size_t begin = 0;
+        size_t chunkSize = 1;
+        size_t chunks = 0;
+        size_t end = 0;
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::mutex errorMutex;
+        std::exception_ptr error;
+    };
+
+    std::vector<std::thread> workers_;
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    WorkerQueue injection_;
+    WorkerQueue urgent_;
+    std::atomic<size_t> urgentPending_{0};   // Без приоритетных задач очередь не блокируется
+    std::atomic<size_t> pending_{0};
+    std::atomic<bool> stopping_{false};
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+
+    void workerLoop(size_t index, bool pin);
+
+    /**
+     * Индекс текущего потока в этом пуле или -1 для внешних потоков
+     */
+    long currentWorkerIndex() const;
+
+    /**
+     * Попытка выполнить одну задачу (своя очередь, общая, перехват)
+     */
+    bool tryRunOne(long index);
+
+    /**
+     * Выполнение частей цикла текущим потоком
+     */
+    static void runChunks(ForState& state);
+
+    void runParallel(const std::shared_ptr<ForState>& state);
+};
+
+template <typename Fn>
+void ComputePool::parallelFor(size_t begin, size_t end, size_t grain, Fn&& fn) {
+    if (end <= begin) {
+        return;
+    }
+    grain = std::max<size_t>(grain, 1);
+    size_t total = end - begin;
+    if (total <= grain || workers_.size() <= 1) {
+        fn(begin, end);
+        return;
+    }
+
+    // Не больше четырех частей на поток: баланс нагрузки без лишних накладных расходов
+    size_t chunks = std::min((total + grain - 1) / grain, (workers_.size() + 1) * 4);
+
+    auto state = std::make_shared<ForState>();
+    state->body = std::forward<Fn>(fn);
+    state->begin = begin;
+    state->end = end;
+    state->chunks = chunks;
+    state->chunkSize = (total + chunks - 1) / chunks;
+    state->chunks = (total + state->chunkSize - 1) / state->chunkSize;
+
+    runParallel(state);
+}
+
+template <typename T, typename Map, typename Combine>
+T ComputePool::parallelReduce(size_t begin, size_t end, size_t grain, T identity, Map&& map, Combine&& combine) {
+    if (end <= begin) {
+        return identity;
+    }
+    grain = std::max<size_t>(grain, 1);
+    size_t target = workers_.size() * 4;
+    size_t chunkSize = std::max((end - begin + target - 1) / target, grain);
+    size_t chunks = (end - begin + chunkSize - 1) / chunkSize;
+
+    std::vector<T> partials(chunks, identity);
+    parallelFor(0, chunks, 1, [&](size_t lo, size_t hi) {
+        for (size_t c = lo; c < hi; ++c) {
+            size_t from = begin + c * chunkSize;
+            partials[c] = map(from, std::min(from + chunkSize, end));
+        }
+    });
+
+    T result = identity;
+    for (auto& part : partials) {
+        result = combine(result, part);
+    }
+    return result;
+}
+
+} // namespace derivx
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "volatility.hpp"
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <cstddef>
+
+namespace derivx {
+
+/**
+ * Прореживание данных для графиков на стороне сервера.
+ * Размер ответа ограничивается разрешением графика, а не объемом данных.
+ */
+class Downsampling {
+public:
+    /**
+     * Largest-Triangle-Three-Buckets для кривой (x возрастает).
+     * Сохраняет первую и последнюю точки и визуально значимые экстремумы.
+     * Один линейный проход; возвращает не больше maxPoints точек (при maxPoints < 3 -
+     * только концы), при maxPoints >= size - кривую без изменений.
+     */
+    static std::vector<std::pair<double, double>> largestTriangleThreeBuckets(
+        const std::vector<std::pair<double, double>>& points,
+        size_t maxPoints
+    );
+
+    /**
+     * То же без выделения памяти: выбранные точки пишутся в out
+     * (не меньше sampledCapacity(count, maxPoints) элементов), возвращается их число
+     */
+    static size_t largestTriangleThreeBuckets(
+        const std::pair<double, double>* points,
+        size_t count,
+        size_t maxPoints,
+        std::pair<double, double>* out
+    );
+
+    /**
+     * Размер результата LTTB для кривой из count точек
+     */
+    static size_t sampledCapacity(size_t count, size_t maxPoints) {
+        return std::min(maxPoints, count);
+    }
+
+    /**
+     * Агрегация свечей в не более чем maxBuckets свечей с сохранением OHLC:
+     * open первой, close последней, максимум high, минимум low, сумма volume.
+     * Дата и timestamp берутся у первой свечи корзины.
+     */
+    static std::vector<OHLCV> aggregateCandles(
+        OHLCVView candles,
+        size_t maxBuckets
+    );
+};
+
+} // namespace derivx
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "option_pricing.hpp"
+#include <complex>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace derivx {
+
+/**
+ * Модели цены с известной характеристической функцией логарифма доходности
+ */
+enum class FourierModelType {
+    HESTON,   // Стохастическая волатильность
+    MERTON,   // Диффузия с нормальными скачками
+    KOU       // Диффузия с двусторонними экспоненциальными скачками
+};
+
+/**
+ * Метод обращения характеристической функции
+ */
+enum class FourierMethod {
+    COS,          // Разложение плотности по косинусам (Fang-Oosterlee)
+    CARR_MADAN    // БПФ демпфированной цены call (Carr-Madan)
+};
+
+/**
+ * Параметры модели. Используются поля выбранного типа; волатильности и
+ * интенсивности годовые, в долях.
+ */
+struct FourierModel {
+    FourierModelType type = FourierModelType::MERTON;
+
+    // Heston: dv = kappa (theta - v) dt + xi sqrt(v) dW, corr(dW, dS) = rho
+    double v0 = 0.04;
+    double kappa = 2.0;
+    double theta = 0.04;
+    double xi = 0.5;
+    double rho = -0.7;
+
+    // Merton и Kou: диффузия sigma и скачки с интенсивностью lambda
+    double sigma = 0.2;
+    double lambda = 1.0;
+    double jumpMean = -0.05;        // Merton: среднее логарифма скачка
+    double jumpVolatility = 0.1;    // Merton: отклонение логарифма скачка
+    double upProbability = 0.4;     // Kou: доля скачков вверх
+    double upRate = 10.0;           // Kou: eta1 > 1, средний скачок вверх 1/eta1
+    double downRate = 10.0;         // Kou: eta2 > 0, средний скачок вниз 1/eta2
+
+    /**
+     * Параметры в допустимой области (eta1 > 1 нужен для конечного форварда)
+     */
+    bool valid() const;
+};
+
+/**
+ * Оценка опционов по характеристической функции: одно преобразование на
+ * экспирацию дает цены для всей сетки страйков.
+ *
+ * COS: коэффициенты плотности (N вычислений характеристической функции)
+ * считаются один раз, цена страйка - сумма N слагаемых с поворотом
+ * e^{ik*pi*x/(b-a)} по рекуррентной формуле, без тригонометрии. Put
+ * считается разложением (устойчиво), call - по паритету.
+ * Carr-Madan: одно БПФ демпфированной цены call на равномерной сетке
+ * log-страйков, цены страйков - интерполяцией, put - по паритету.
+ */
+class FourierPricing {
+public:
+    /**
+     * Риск-нейтральная характеристическая функция E[exp(iu ln(S_T / S_0))]
+     * (комплексный u для Carr-Madan)
+     */
+    static std::complex<double> characteristic(
+        const FourierModel& model,
+        std::complex<double> u,
+        double timeToExpiration,
+        double riskFreeRate,
+        double dividendYield
+    );
+
+    /**
+     * Цены call и put для count страйков одной экспирации.
+     * volatility из market не используется.
+     */
+    static void priceChain(
+        const FourierModel& model,
+        const MarketParams& market,
+        const double* strikes,
+        size_t count,
+        FourierMethod method,
+        double* calls,
+        double* puts
+    );
+
+    /**
+     * Характеристическая функция логарифма доходности за horizon лет без
+     * риск-нейтрального сноса (для сравнения с историческими доходностями)
+     */
+    static std::complex<double> centeredCharacteristic(const FourierModel& model, double u, double horizon);
+
+    static const char* modelName(FourierModelType type);
+    static bool parseModel(const std::string& name, FourierModelType& type);
+    static const char* methodName(FourierMethod method);
+    static bool parseMethod(const std::string& name, FourierMethod& method);
+};
+
+} // namespace derivx
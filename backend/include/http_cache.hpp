@@ -0,0 +1,115 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <list>
+#include <cstdint>
+#include <unordered_map>
+
+namespace derivx {
+
+/**
+ * Результат условного GET: тело (или 304) и заголовки валидации
+ */
+struct CachedResponse {
+    std::shared_ptr<const std::string> body;   // nullptr при notModified
+    std::string etag;                          // Пусто - ответ не кэшируемый
+    int64_t lastModified = 0;                  // Unix время, 0 - неизвестно
+    bool notModified = false;                  // Клиентская копия актуальна (304)
+};
+
+/**
+ * Счетчики кэша сериализованных ответов
+ */
+struct ResponseCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t notModified = 0;   // Ответов 304
+    uint64_t entries = 0;
+    uint64_t bytes = 0;
+    uint64_t budgetBytes = 0;
+};
+
+/**
+ * Кэш готовых тел ответов по ключу запроса.
+ *
+ * Для каждого ключа хранится только тело последней версии данных:
+ * запись с другой версией считается промахом и заменяется.
+ * Объем ограничен бюджетом в байтах, вытесняются давно не использованные записи (LRU).
+ */
+class ResponseCache {
+public:
+    explicit ResponseCache(size_t budgetBytes = 64 * 1024 * 1024);
+
+    ResponseCache(const ResponseCache&) = delete;
+    ResponseCache& operator=(const ResponseCache&) = delete;
+
+    /**
+     * Бюджет памяти (0 - не кэшировать тела)
+     */
+    void setBudget(size_t budgetBytes);
+
+    /**
+     * Тело для ключа и версии или nullptr
+     */
+    std::shared_ptr<const std::string> find(const std::string& key, uint64_t version);
+
+    void store(const std::string& key, uint64_t version, std::shared_ptr<const std::string> body);
+
+    void recordNotModified();
+
+    ResponseCacheStats stats() const;
+
+private:
+    struct Entry {
+        uint64_t version = 0;
+        std::shared_ptr<const std::string> body;
+        std::list<std::string>::iterator position;   // Место в порядке использования
+    };
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::list<std::string> usage_;                   // Начало - последние использованные
+    size_t budgetBytes_;
+    size_t bytes_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t notModified_ = 0;
+
+    void evictLocked();
+    static size_t entryBytes(const std::string& key, const std::string& body);
+};
+
+/**
+ * Вспомогательные функции HTTP кэширования (RFC 9110/9111)
+ */
+class HttpCaching {
+public:
+    /**
+     * 64-битный FNV-1a, seed - результат предыдущего вызова для цепочки
+     */
+    static uint64_t hash(const void* data, size_t size, uint64_t seed = 14695981039346656037ULL);
+
+    /**
+     * Сильный ETag: версия данных + хэш ключа запроса (эндпоинт, параметры, формат)
+     */
+    static std::string makeETag(uint64_t version, const std::string& requestKey);
+
+    /**
+     * Совпадение If-None-Match (список через запятую, "*", слабые W/ метки) с ETag
+     */
+    static bool etagMatches(const std::string& ifNoneMatch, const std::string& etag);
+
+    /**
+     * Дата в формате IMF-fixdate: "Sun, 06 Nov 1994 08:49:37 GMT"
+     */
+    static std::string formatHttpDate(int64_t unixTime);
+
+    /**
+     * Разбор IMF-fixdate (false - формат не распознан)
+     */
+    static bool parseHttpDate(const std::string& text, int64_t& unixTime);
+};
+
+} // namespace derivx
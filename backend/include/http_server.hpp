@@ -0,0 +1,192 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace derivx {
+
+/**
+ * Разобранный HTTP запрос
+ */
+struct HttpRequest {
+    std::string method;
+    std::string path;        // Путь без query (без URL-декодирования)
+    std::string query;       // Часть после '?' (без URL-декодирования)
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;
+    int minorVersion = 1;    // HTTP/1.x
+
+    /**
+     * Значение заголовка (имя без учета регистра), nullptr - заголовка нет
+     */
+    const std::string* header(const char* name) const;
+
+    /**
+     * Параметры query, URL-декодированные (повторяющийся параметр - последнее значение)
+     */
+    std::map<std::string, std::string> queryParams() const;
+};
+
+/**
+ * Тело ответа, которое отдается частями по мере готовности (SSE).
+ * poll() и close() вызываются из потока соединения.
+ */
+class HttpStream {
+public:
+    virtual ~HttpStream() = default;
+
+    /**
+     * Следующая порция тела в out (пусто - пока нечего отправлять).
+     * Вызывается, только когда предыдущая порция ушла клиенту.
+     * @return false - поток завершен, соединение закрывается
+     */
+    virtual bool poll(std::string& out, std::chrono::steady_clock::time_point now) = 0;
+
+    /**
+     * Клиент отключился или сервер останавливается
+     */
+    virtual void close() = 0;
+};
+
+class HttpCompletion;
+
+/**
+ * HTTP ответ обработчика
+ */
+struct HttpResponse {
+    int status = 200;
+    std::string contentType;
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;
+    std::shared_ptr<HttpStream> stream;           // Не nullptr - тело chunked из потока, body не используется
+    std::shared_ptr<HttpCompletion> completion;   // Не nullptr - ответ будет передан позже (defer)
+
+    void addHeader(std::string name, std::string value) {
+        headers.emplace_back(std::move(name), std::move(value));
+    }
+
+    /**
+     * Отложить ответ: остальные поля игнорируются, ответ передается
+     * через HttpCompletion::complete() из любого потока
+     */
+    std::shared_ptr<HttpCompletion> defer();
+};
+
+/**
+ * Отложенный ответ. Пока он не передан, следующие запросы соединения
+ * не разбираются: ответы HTTP/1.1 уходят в порядке запросов.
+ */
+class HttpCompletion {
+public:
+    /**
+     * Передача ответа; после отключения клиента или повторно - игнорируется
+     */
+    void complete(HttpResponse response);
+
+    /**
+     * Действие при отключении клиента до ответа (например, отмена расчета).
+     * Задается в обработчике до возврата управления, вызывается в потоке соединения.
+     */
+    void onCancel(std::function<void()> callback);
+
+    bool cancelled() const { return cancelled_.load(std::memory_order_acquire); }
+
+private:
+    friend class HttpServer;
+
+    std::mutex mutex_;
+    bool completed_ = false;
+    HttpResponse response_;
+    std::function<void()> notify_;     // Уведомление потока соединения (задает сервер)
+    std::function<void()> onCancel_;
+    std::atomic<bool> cancelled_{false};
+
+    // Соединение и параметры ответа (задает сервер)
+    int fd_ = -1;
+    int minorVersion_ = 1;
+    bool head_ = false;
+    bool keepAlive_ = true;
+};
+
+/**
+ * Параметры HTTP сервера
+ */
+struct HttpServerConfig {
+    std::string host = "127.0.0.1";
+    uint16_t port = 8080;
+    size_t threads = 0;                          // 0 - по числу ядер
+    size_t maxHeaderBytes = 64 * 1024;           // Больше - 431
+    size_t maxBodyBytes = 8 * 1024 * 1024;       // Больше - 413
+    std::chrono::seconds idleTimeout{60};        // Простаивающие keep-alive соединения закрываются
+    bool pinThreads = false;                     // Привязать i-й поток к i-му ядру
+};
+
+/**
+ * Счетчики HTTP сервера (суммы по потокам)
+ */
+struct HttpServerStats {
+    uint64_t accepted = 0;
+    uint64_t requests = 0;
+    uint64_t activeConnections = 0;
+    uint64_t protocolErrors = 0;   // Ответы 400/411/413/431 и закрытие соединения
+};
+
+/**
+ * Компактный HTTP/1.1 сервер на epoll (только Linux).
+ *
+ * Поток на ядро: у каждого потока свой слушающий сокет (SO_REUSEPORT,
+ * ядро распределяет соединения) и свой epoll в edge-triggered режиме,
+ * соединение живет в одном потоке, общих блокировок на пути запроса нет.
+ * Keep-alive и конвейер (pipelining): запросы из одного чтения разбираются
+ * подряд, ответы уходят одним вызовом sendmsg. Тело запроса - только
+ * Content-Length. Буферы соединений переиспользуются из пула потока.
+ *
+ * Обработчик вызывается прямо в потоке соединения и должен быть быстрым;
+ * тяжелую работу он передает в другой поток и откладывает ответ (defer).
+ * Если клиент отключился, не дождавшись отложенного ответа, вызывается onCancel.
+ */
+class HttpServer {
+public:
+    using Handler = std::function<void(const HttpRequest&, HttpResponse&)>;
+
+    HttpServer(HttpServerConfig config, Handler handler);
+    ~HttpServer();
+
+    HttpServer(const HttpServer&) = delete;
+    HttpServer& operator=(const HttpServer&) = delete;
+
+    /**
+     * Открытие сокетов и запуск потоков; std::runtime_error - адрес недоступен
+     */
+    void start();
+
+    /**
+     * Остановка: открытые соединения закрываются, потоки завершаются
+     */
+    void stop();
+
+    size_t threadCount() const { return workers_.size(); }
+
+    HttpServerStats stats() const;
+
+    /**
+     * Декодирование %XX и '+' (пробел) в компоненте URL
+     */
+    static std::string urlDecode(const std::string& text);
+
+private:
+    class Worker;
+
+    HttpServerConfig config_;
+    Handler handler_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+};
+
+} // namespace derivx
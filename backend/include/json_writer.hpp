@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <charconv>
+#include <cstddef>
+#include <type_traits>
+
+namespace derivx {
+
+/**
+ * Потоковая запись JSON напрямую в буфер, без построения nlohmann DOM.
+ *
+ * Вывод байт в байт совпадает с json::dump() без отступов: числа с плавающей
+ * точкой форматируются тем же алгоритмом, строки экранируются так же.
+ * Ключи объекта пишутся в порядке вызовов - чтобы совпасть с dump(),
+ * вызывающий код должен перечислять их по алфавиту.
+ */
+class JsonWriter {
+public:
+    /**
+     * @param reserveBytes Ожидаемый размер ответа (одно выделение памяти)
+     */
+    explicit JsonWriter(size_t reserveBytes = 0);
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+
+    /**
+     * Варианты с количеством элементов - для общего шаблона с бинарными writer-ами
+     */
+    void beginObject(size_t) { beginObject(); }
+    void beginArray(size_t) { beginArray(); }
+
+    /**
+     * Ключ следующего значения в объекте
+     */
+    void key(const char* name);
+    void key(const std::string& name);
+
+    void value(double number);
+    void value(bool flag);
+    void value(const char* text);
+    void value(const std::string& text);
+    void null();
+
+    /**
+     * Уже сериализованное JSON значение (вставляется как есть)
+     */
+    void raw(const std::string& serialized);
+
+    /**
+     * Целые числа любой разрядности
+     */
+    template <typename Integer,
+              typename = std::enable_if_t<std::is_integral<Integer>::value && !std::is_same<Integer, bool>::value>>
+    void value(Integer number) {
+        separator();
+        needComma_ = true;
+
+        char buffer[24];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+        out_.append(buffer, static_cast<size_t>(result.ptr - buffer));
+    }
+
+    /**
+     * Готовый JSON (буфер передается вызывающему без копирования)
+     */
+    std::string release();
+
+    const std::string& buffer() const { return out_; }
+
+private:
+    std::string out_;
+    bool needComma_ = false;
+
+    void separator();
+    void writeString(const char* text, size_t length);
+};
+
+} // namespace derivx
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace derivx {
+
+/**
+ * Счетчики и гистограммы сервиса для /api/metrics (формат Prometheus).
+ *
+ * Запись не берет блокировок: у каждого потока свой шард счетчиков,
+ * который пишет только этот поток (relaxed load + store, без lock-префикса),
+ * поэтому запись стоит нескольких наносекунд. Экспорт суммирует шарды.
+ *
+ * Гистограммы логарифмически-линейные (как HDR Histogram): значения до 8
+ * хранятся точно, дальше каждая степень двойки делится на 8 частей -
+ * относительная погрешность не более 12.5%.
+ */
+class Metrics {
+public:
+    static constexpr size_t MAX_ENDPOINTS = 24;
+    static constexpr size_t SUB_BUCKETS = 8;
+    static constexpr size_t MAX_EXPONENT = 31;   // Значения до 2^31 (мкс - около 35 минут)
+    static constexpr size_t BUCKETS = (MAX_EXPONENT - 2) * SUB_BUCKETS;
+
+    /**
+     * Единственный экземпляр процесса
+     */
+    static Metrics& global();
+
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    /**
+     * Идентификатор ряда эндпоинта (повторная регистрация имени возвращает тот же).
+     * Регистрировать до начала обслуживания; сверх MAX_ENDPOINTS - последний ряд.
+     */
+    size_t registerEndpoint(const std::string& name);
+
+    /**
+     * Завершенный запрос: задержка в микросекундах и признак ошибки (статус 4xx/5xx)
+     */
+    void recordRequest(size_t endpoint, uint64_t micros, bool error);
+
+    /**
+     * Ошибка, возвращенная обработчиком в теле ответа со статусом 200
+     */
+    void recordError(size_t endpoint);
+
+    /**
+     * Чтение файла данных символа (found = false - файл не найден или пуст)
+     */
+    void recordDataLoad(uint64_t micros, bool found);
+
+    /**
+     * Глубина очереди пула расчетов в момент поступления запроса
+     */
+    void recordQueueDepth(uint64_t depth);
+
+    /**
+     * Все ряды в текстовом формате Prometheus
+     */
+    std::string renderPrometheus() const;
+
+    /**
+     * Номер корзины гистограммы для значения
+     */
+    static size_t bucketIndex(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<size_t>(value);
+        }
+        size_t exponent = 63 - static_cast<size_t>(__builtin_clzll(value));
+        if (exponent >= MAX_EXPONENT) {
+            return BUCKETS - 1;   // Переполнение - в последнюю корзину
+        }
+        size_t sub = static_cast<size_t>(value >> (exponent - 3)) & (SUB_BUCKETS - 1);
+        return (exponent - 2) * SUB_BUCKETS + sub;
+    }
+
+    /**
+     * Верхняя граница корзины (не включительно)
+     */
+    static uint64_t bucketUpperBound(size_t index) {
+        if (index < SUB_BUCKETS) {
+            return index + 1;
+        }
+        size_t exponent = index / SUB_BUCKETS + 2;
+        uint64_t sub = index % SUB_BUCKETS;
+        return (SUB_BUCKETS + sub + 1) << (exponent - 3);
+    }
+
+private:
+    struct Histogram {
+        std::atomic<uint64_t> counts[BUCKETS];
+        std::atomic<uint64_t> sum;
+    };
+
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> requests[MAX_ENDPOINTS];
+        std::atomic<uint64_t> errors[MAX_ENDPOINTS];
+        Histogram latency[MAX_ENDPOINTS];
+        std::atomic<uint64_t> loads;
+        std::atomic<uint64_t> loadMisses;
+        Histogram loadTime;
+        Histogram queueDepth;
+    };
+
+    /**
+     * Сумма гистограммы по всем шардам
+     */
+    struct HistogramTotals {
+        std::vector<uint64_t> counts = std::vector<uint64_t>(BUCKETS, 0);
+        uint64_t count = 0;
+        uint64_t sum = 0;
+
+        void add(const Histogram& histogram);
+        uint64_t quantile(double q) const;
+    };
+
+    mutable std::mutex mutex_;                  // Регистрация шардов и эндпоинтов
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::vector<std::string> endpoints_;
+
+    Metrics() = default;
+
+    Shard& localShard();
+
+    static void record(Histogram& histogram, uint64_t value);
+
+    static void appendHistogram(std::string& out, const char* name, const std::string& labels,
+                                const HistogramTotals& totals, double scale);
+};
+
+} // namespace derivx
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "fourier_pricing.hpp"
+#include "compute_pool.hpp"
+#include "volatility.hpp"
+#include <vector>
+#include <cstddef>
+
+namespace derivx {
+
+/**
+ * Котировка для калибровки по ценам
+ */
+struct CalibrationQuote {
+    OptionType type = OptionType::CALL;
+    double strike = 0.0;
+    double timeToExpiration = 0.0;   // Годы
+    double price = 0.0;
+};
+
+/**
+ * Результат калибровки: лучшая модель по всем стартам
+ */
+struct CalibrationResult {
+    FourierModel model;
+    double error = 0.0;        // RMSE цен (по котировкам) или расстояние характеристических функций
+    size_t starts = 0;
+    size_t evaluations = 0;    // Вычислений целевой функции по всем стартам
+};
+
+/**
+ * Калибровка параметров FourierModel симплекс-методом Нелдера-Мида в
+ * неограниченных координатах (положительные - через exp, корреляция -
+ * через tanh, вероятность - логистической функцией). Старты из разных
+ * начальных точек независимы и выполняются параллельно на пуле расчетов;
+ * начальные точки детерминированы, поэтому результат не зависит от числа потоков.
+ */
+class ModelCalibration {
+public:
+    /**
+     * По котировкам опционов: минимум суммы квадратов отклонений цен.
+     * Котировки группируются по экспирациям - одно разложение COS на экспирацию
+     * (при немногих страйках и тысячах вычислений COS быстрее БПФ).
+     * volatility из market задает масштаб начальных точек.
+     */
+    static CalibrationResult toQuotes(
+        FourierModelType type,
+        const std::vector<CalibrationQuote>& quotes,
+        const MarketParams& market,
+        size_t starts,
+        ComputePool* pool
+    );
+
+    /**
+     * По ряду логарифмических доходностей с шагом step лет: минимум взвешенного
+     * расстояния между эмпирической и модельной характеристическими функциями
+     * доходностей за 1, 5 и 20 дней (без сноса - сравнивается форма распределения)
+     */
+    static CalibrationResult toReturns(
+        FourierModelType type,
+        const std::vector<double>& returns,
+        double step,
+        size_t starts,
+        ComputePool* pool
+    );
+
+    /**
+     * По истории цен: логарифмические доходности свечей, шаг - медиана интервалов
+     */
+    static CalibrationResult toHistory(
+        FourierModelType type,
+        OHLCVView data,
+        size_t starts,
+        ComputePool* pool
+    );
+};
+
+} // namespace derivx
@@ -63,6 +63,19 @@ struct Greeks {
     Greeks() : delta(0.0), gamma(0.0), theta(0.0), vega(0.0), rho(0.0) {}
 };
 
+/**
+ * Страйк цепочки опционов: цены и греки call и put
+ */
+struct ChainQuote {
+    double strike;
+    double callPrice;
+    double putPrice;
+    Greeks call;
+    Greeks put;
+    
+    ChainQuote() : strike(0.0), callPrice(0.0), putPrice(0.0) {}
+};
+
 /**
  * Класс для расчета цен опционов по модели Black-Scholes
  */
@@ -94,6 +107,36 @@ public:
         double q = 0.0
     );
     
+    /**
+     * Цепочка опционов одной экспирации: call и put с греками для count страйков.
+     * Величины экспирации (sqrt(T), дисконт-факторы) считаются один раз, put
+     * получается из call по паритету, на страйк - одна экспонента.
+     * logMoneyness - ln(S/K) страйков, общий для всех экспираций (nullptr - считать здесь).
+     * Результат совпадает с calculateBlackScholes/calculateGreeks.
+     */
+    static void calculateChain(
+        const MarketParams& market,
+        const double* strikes,
+        const double* logMoneyness,
+        size_t count,
+        ChainQuote* out
+    );
+    
+    /**
+     * Суммарные греки стратегии в count точках цены базового актива spots
+     * (профиль греков рядом с кривой PNL). spotPrice из market не используется.
+     * Ноги раскладываются в массивы по полям, на точку и ногу d1/d2 считаются
+     * один раз, суммы по ногам масштабируются множителями точки в конце.
+     * Результат совпадает с суммой calculateGreeks по ногам (с учетом направления и количества).
+     */
+    static void evaluateGreeksProfile(
+        const std::vector<Option>& options,
+        const MarketParams& market,
+        const double* spots,
+        size_t count,
+        Greeks* out
+    );
+    
     /**
      * Расчет payoff опциона при заданной цене базового актива
      */
@@ -119,8 +162,20 @@ public:
         double maxPrice,
         int numPoints = 200
     );
-
-private:
+    
+    /**
+     * Расчет точек [begin, end) кривой PNL с шагом step от minPrice.
+     * Части кривой независимы, поэтому их можно считать параллельно.
+     */
+    static void evaluatePayoffRange(
+        const std::vector<Option>& options,
+        double minPrice,
+        double step,
+        size_t begin,
+        size_t end,
+        std::pair<double, double>* out
+    );
+    
     /**
      * Стандартное нормальное распределение (CDF)
      */
@@ -130,7 +185,8 @@ private:
      * Стандартное нормальное распределение (PDF)
      */
     static double normalPDF(double x);
-    
+
+private:
     /**
      * Вспомогательные функции для Black-Scholes
      */
@@ -0,0 +1,288 @@
+#pragma once
+
+#include "option_pricing.hpp"
+#include "volatility.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <limits>
+#include <cstddef>
+
+namespace derivx {
+
+/**
+ * Кусочно-линейный PNL стратегии на экспирации (с учетом премий).
+ * Изломы - различные страйки по возрастанию; между изломами и на
+ * отрезке [0, первый страйк] PNL линеен, правее последнего - наклон rightSlope.
+ */
+struct PayoffShape {
+    static constexpr size_t MAX_KINKS = 64;
+
+    size_t count = 0;
+    double kinks[MAX_KINKS];
+    double values[MAX_KINKS];   // PNL в изломах
+    double valueAtZero = 0.0;   // PNL при цене 0
+    double rightSlope = 0.0;
+};
+
+/**
+ * Точка функции распределения цены на экспирации:
+ * P(S <= x) и E[S; S <= x] (частичное среднее)
+ */
+struct DistributionPoint {
+    double probability = 0.0;
+    double partialMean = 0.0;
+};
+
+/**
+ * Характеристики PNL стратегии на экспирации
+ */
+struct PayoffStats {
+    double expected = 0.0;              // Ожидаемый PNL
+    double probabilityOfProfit = 0.0;   // P(PNL > 0)
+    double maxLoss = 0.0;               // Наибольший убыток (>= 0), бесконечность - не ограничен
+    double maxProfit = 0.0;             // Наибольшая прибыль, бесконечность - не ограничена
+    double valueAtRisk = 0.0;           // Убыток, не превышаемый с вероятностью 1 - level
+    double expectedShortfall = 0.0;     // Средний убыток в худшей доле level исходов
+};
+
+/**
+ * Эмпирическое распределение цены на экспирации: текущая цена, умноженная
+ * на исторические доходности за срок до экспирации. Цены отсортированы,
+ * префиксные суммы дают вероятность и частичное среднее за O(log n).
+ */
+class EmpiricalDistribution {
+public:
+    EmpiricalDistribution() = default;
+    explicit EmpiricalDistribution(std::vector<double> prices);
+
+    /**
+     * Доходности за horizonDays по всем свечам истории (окна перекрываются);
+     * шаг свечей определяется по медиане интервалов между ними
+     */
+    static EmpiricalDistribution fromHistory(OHLCVView data, double spot, double horizonDays);
+
+    size_t size() const { return prices_.size(); }
+    bool empty() const { return prices_.empty(); }
+
+    DistributionPoint cumulative(double x) const;
+    DistributionPoint total() const;
+
+private:
+    std::vector<double> prices_;
+    std::vector<double> prefix_;   // prefix_[i] - сумма i наименьших цен
+};
+
+/**
+ * Логнормальное распределение цены на экспирации (риск-нейтральное, как в
+ * Black-Scholes): P(S <= x) = N(-d2), E[S; S <= x] = F * N(-d1), F - форвард
+ */
+class LognormalDistribution {
+public:
+    LognormalDistribution(double spot, double volatility, double timeToExpiration,
+                          double riskFreeRate, double dividendYield);
+
+    double forward() const { return forward_; }
+
+    DistributionPoint cumulative(double x) const;
+    DistributionPoint total() const;
+
+private:
+    double forward_;
+    double deviation_;   // sigma * sqrt(T)
+};
+
+/**
+ * Точный расчет ожидаемого PNL и вероятности прибыли для кусочно-линейного
+ * PNL: на каждом линейном участке a + b*S вклад равен a*dP + b*dM, где dP и
+ * dM - приращения вероятности и частичного среднего распределения.
+ */
+class PayoffAnalysis {
+public:
+    /**
+     * PNL стратегии как набор изломов (count <= PayoffShape::MAX_KINKS ног)
+     */
+    static void buildShape(const Option* options, size_t count, PayoffShape& shape);
+
+    /**
+     * Наибольшие убыток и прибыль при цене от 0 до бесконечности
+     */
+    static void bounds(const PayoffShape& shape, PayoffStats& stats);
+
+    /**
+     * Ожидаемый PNL и вероятность прибыли. Distribution - тип с методами
+     * cumulative(x) и total() -> DistributionPoint.
+     * Если ожидаемый PNL меньше expectedFloor или вероятность заведомо
+     * меньше probabilityFloor, расчет прерывается и возвращается false
+     * (отсечение заведомо худших кандидатов).
+     */
+    template <typename Distribution>
+    static bool integrate(const PayoffShape& shape, const Distribution& distribution, PayoffStats& stats,
+                          double expectedFloor = -std::numeric_limits<double>::infinity(),
+                          double probabilityFloor = -std::numeric_limits<double>::infinity());
+
+    /**
+     * Хвост PNL: P(PNL <= threshold) и E[PNL; PNL <= threshold]
+     */
+    template <typename Distribution>
+    static DistributionPoint pnlBelow(const PayoffShape& shape, const Distribution& distribution, double threshold);
+
+    /**
+     * VaR и expected shortfall уровня level (доля худших исходов, 0 < level < 1).
+     * Квантиль PNL ищется делением отрезка по pnlBelow, хвост за ним - точно.
+     */
+    template <typename Distribution>
+    static void shortfall(const PayoffShape& shape, const Distribution& distribution, double level, PayoffStats& stats);
+};
+
+template <typename Distribution>
+bool PayoffAnalysis::integrate(const PayoffShape& shape, const Distribution& distribution, PayoffStats& stats,
+                               double expectedFloor, double probabilityFloor) {
+    DistributionPoint atKinks[PayoffShape::MAX_KINKS];
+    for (size_t i = 0; i < shape.count; ++i) {
+        atKinks[i] = distribution.cumulative(shape.kinks[i]);
+    }
+    const DistributionPoint end = distribution.total();
+
+    // Участок i: от излома i-1 (или 0) до излома i (или бесконечности)
+    auto segment = [&](size_t i, double& lo, double& fLo, DistributionPoint& from, DistributionPoint& to, double& slope) {
+        lo = i == 0 ? 0.0 : shape.kinks[i - 1];
+        fLo = i == 0 ? shape.valueAtZero : shape.values[i - 1];
+        from = i == 0 ? DistributionPoint() : atKinks[i - 1];
+        to = i < shape.count ? atKinks[i] : end;
+        slope = i < shape.count ? (shape.values[i] - fLo) / (shape.kinks[i] - lo) : shape.rightSlope;
+    };
+
+    double expected = 0.0;
+    for (size_t i = 0; i <= shape.count; ++i) {
+        double lo, fLo, slope;
+        DistributionPoint from, to;
+        segment(i, lo, fLo, from, to, slope);
+        double intercept = fLo - slope * lo;
+        expected += intercept * (to.probability - from.probability) + slope * (to.partialMean - from.partialMean);
+    }
+    stats.expected = expected;
+    if (expected < expectedFloor) {
+        return false;
+    }
+
+    // Вероятность прибыли: участки, где PNL > 0 целиком, и части участков
+    // со сменой знака (граница - точка безубыточности, ищется только для них)
+    double probability = 0.0;
+    double crossing = 0.0;
+    for (size_t i = 0; i <= shape.count; ++i) {
+        double fLo = i == 0 ? shape.valueAtZero : shape.values[i - 1];
+        double fHi = i < shape.count ? shape.values[i] : (shape.rightSlope > 0 ? 1.0 : shape.rightSlope < 0 ? -1.0 : fLo);
+        double mass = (i < shape.count ? atKinks[i] : end).probability - (i == 0 ? 0.0 : atKinks[i - 1].probability);
+        if (fLo > 0 && fHi > 0) {
+            probability += mass;
+        } else if (fLo > 0 || fHi > 0) {
+            crossing += mass;
+        }
+    }
+    if (probability + crossing < probabilityFloor) {
+        return false;
+    }
+    if (crossing > 0) {
+        for (size_t i = 0; i <= shape.count; ++i) {
+            double lo, fLo, slope;
+            DistributionPoint from, to;
+            segment(i, lo, fLo, from, to, slope);
+            double fHi = i < shape.count ? shape.values[i] : (slope > 0 ? 1.0 : slope < 0 ? -1.0 : fLo);
+            if ((fLo > 0) != (fHi > 0)) {
+                double breakeven = lo - fLo / slope;
+                double at = distribution.cumulative(breakeven).probability;
+                probability += fLo > 0 ? at - from.probability : to.probability - at;
+            }
+        }
+    }
+    stats.probabilityOfProfit = std::min(std::max(probability, 0.0), 1.0);
+    return true;
+}
+
+template <typename Distribution>
+DistributionPoint PayoffAnalysis::pnlBelow(const PayoffShape& shape, const Distribution& distribution,
+                                           double threshold) {
+    const double infinity = std::numeric_limits<double>::infinity();
+    auto at = [&](double x) {
+        return x == infinity ? distribution.total() : x <= 0 ? DistributionPoint() : distribution.cumulative(x);
+    };
+
+    // На участке a + b*S область PNL <= threshold - отрезок до или после пересечения
+    DistributionPoint result;
+    for (size_t i = 0; i <= shape.count; ++i) {
+        double lo = i == 0 ? 0.0 : shape.kinks[i - 1];
+        double fLo = i == 0 ? shape.valueAtZero : shape.values[i - 1];
+        double hi = i < shape.count ? shape.kinks[i] : infinity;
+        double slope = i < shape.count ? (shape.values[i] - fLo) / (hi - lo) : shape.rightSlope;
+        double intercept = fLo - slope * lo;
+
+        double from = lo;
+        double to = hi;
+        if (slope == 0) {
+            if (fLo > threshold) {
+                continue;
+            }
+        } else {
+            double crossing = (threshold - intercept) / slope;
+            if (slope > 0) {
+                to = std::min(to, crossing);
+            } else {
+                from = std::max(from, crossing);
+            }
+        }
+        if (!(from < to)) {
+            continue;
+        }
+        DistributionPoint a = at(from);
+        DistributionPoint b = at(to);
+        result.probability += b.probability - a.probability;
+        result.partialMean += intercept * (b.probability - a.probability) + slope * (b.partialMean - a.partialMean);
+    }
+    return result;
+}
+
+template <typename Distribution>
+void PayoffAnalysis::shortfall(const PayoffShape& shape, const Distribution& distribution, double level,
+                               PayoffStats& stats) {
+    stats.valueAtRisk = 0.0;
+    stats.expectedShortfall = 0.0;
+    if (!(level > 0 && level < 1) || distribution.total().probability <= 0) {
+        return;
+    }
+
+    // Отрезок [lo, hi] с P(PNL <= lo) < level <= P(PNL <= hi); при неограниченном
+    // PNL границы отодвигаются удвоением
+    double lowest = shape.valueAtZero;
+    double highest = shape.valueAtZero;
+    for (size_t k = 0; k < shape.count; ++k) {
+        lowest = std::min(lowest, shape.values[k]);
+        highest = std::max(highest, shape.values[k]);
+    }
+    double span = std::max(highest - lowest, std::max(std::fabs(highest), 1.0));
+    double lo = lowest - span;
+    double hi = highest;
+    for (int i = 0; i < 64 && pnlBelow(shape, distribution, lo).probability >= level; ++i) {
+        span *= 2.0;
+        lo = lowest - span;
+    }
+    for (int i = 0; i < 64 && pnlBelow(shape, distribution, hi).probability < level; ++i) {
+        span *= 2.0;
+        hi = highest + span;
+    }
+    for (int i = 0; i < 200 && hi - lo > 1e-12 * std::max(std::fabs(hi), 1.0); ++i) {
+        double middle = 0.5 * (lo + hi);
+        if (pnlBelow(shape, distribution, middle).probability < level) {
+            lo = middle;
+        } else {
+            hi = middle;
+        }
+    }
+
+    // Атом распределения на квантиле учитывается долей, дополняющей хвост до level
+    DistributionPoint tail = pnlBelow(shape, distribution, hi);
+    stats.valueAtRisk = -hi;
+    stats.expectedShortfall = -(tail.partialMean + hi * (level - tail.probability)) / level;
+}
+
+} // namespace derivx
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <memory_resource>
+#include <vector>
+#include <memory>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+
+namespace derivx {
+
+/**
+ * Счетчики арен запросов (суммы по потокам)
+ */
+struct RequestArenaStats {
+    uint64_t requests = 0;        // Завершенных областей ArenaScope
+    uint64_t overflows = 0;       // Из них не уместившихся в буфер арены
+    uint64_t retainedBytes = 0;   // Буферы арен, оставленные потокам
+};
+
+/**
+ * Арена запроса: монотонный буфер потока.
+ *
+ * Выделение - сдвиг указателя, освобождение отдельных блоков ничего не
+ * делает, вся память возвращается разом в конце запроса (ArenaScope).
+ * У каждого потока своя арена, буфер переиспользуется между запросами:
+ * если запросу не хватило буфера, недостающее берется из кучи, а буфер
+ * к следующему запросу увеличивается (до MAX_RETAINED_BYTES). В
+ * установившемся режиме запрос не обращается к глобальному аллокатору.
+ *
+ * Арена доступна только своему потоку; память из нее можно читать и писать
+ * из других потоков (части parallelFor), пока запрос не завершен.
+ */
+class RequestArena : public std::pmr::memory_resource {
+public:
+    static constexpr size_t INITIAL_BYTES = 64 * 1024;
+    static constexpr size_t MAX_RETAINED_BYTES = 8 * 1024 * 1024;
+
+    RequestArena() = default;
+    ~RequestArena() override;
+
+    RequestArena(const RequestArena&) = delete;
+    RequestArena& operator=(const RequestArena&) = delete;
+
+    /**
+     * Арена потока, если в нем активна область ArenaScope (иначе nullptr)
+     */
+    static RequestArena* current();
+
+    static RequestArenaStats stats();
+
+private:
+    friend class ArenaScope;
+
+    std::unique_ptr<std::byte[]> buffer_;
+    size_t capacity_ = 0;
+    size_t offset_ = 0;
+    std::vector<std::unique_ptr<std::byte[]>> overflow_;   // Блоки из кучи сверх буфера
+    size_t overflowBytes_ = 0;
+
+    void begin();
+    void end();
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+/**
+ * Область запроса: делает арену потока текущей, в конце освобождает
+ * всю ее память за O(1). Вложенная область (пакетный запрос, задача
+ * другого запроса, выполняемая потоком в ожидании parallelFor) пользуется
+ * ареной внешней и ничего не освобождает.
+ */
+class ArenaScope {
+public:
+    ArenaScope();
+    ~ArenaScope();
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+private:
+    RequestArena* owned_ = nullptr;
+};
+
+/**
+ * Аллокатор без состояния для контейнеров и дерева nlohmann::json:
+ * в области ArenaScope память берется из арены потока, вне ее - из кучи.
+ *
+ * Перед блоком хранится его источник, поэтому блок из кучи можно
+ * освободить и внутри области, а блок из арены - в любом потоке.
+ * Объекты, выделенные в арене, не должны переживать свою область.
+ */
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    ArenaAllocator() noexcept = default;
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>&) noexcept {}
+
+    T* allocate(size_t count) {
+        static_assert(alignof(T) <= HEADER, "ArenaAllocator: over-aligned type");
+        if (count > (SIZE_MAX - HEADER) / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        size_t bytes = HEADER + count * sizeof(T);
+        RequestArena* arena = RequestArena::current();
+        auto* block = static_cast<unsigned char*>(arena != nullptr ? arena->allocate(bytes, HEADER)
+                                                                   : ::operator new(bytes));
+        block[0] = arena != nullptr ? FROM_ARENA : FROM_HEAP;
+        return reinterpret_cast<T*>(block + HEADER);
+    }
+
+    void deallocate(T* pointer, size_t) noexcept {
+        unsigned char* block = reinterpret_cast<unsigned char*>(pointer) - HEADER;
+        if (block[0] == FROM_HEAP) {
+            ::operator delete(block);
+        }
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>&) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>&) const noexcept { return false; }
+
+private:
+    static constexpr size_t HEADER = alignof(std::max_align_t);
+    static constexpr unsigned char FROM_HEAP = 0;
+    static constexpr unsigned char FROM_ARENA = 1;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+} // namespace derivx
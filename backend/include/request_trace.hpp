@@ -0,0 +1,151 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+namespace derivx {
+
+/**
+ * Этап обработки запроса (время от начала запроса, микросекунды)
+ */
+struct TraceSpan {
+    const char* name;      // Строковый литерал
+    int64_t startMicros;
+    int64_t durationMicros;
+    uint32_t thread;       // Порядковый номер потока процесса
+};
+
+/**
+ * Тайминги одного запроса.
+ *
+ * Этапы пишутся из I/O потока и потока пула расчетов, поэтому добавление
+ * под мьютексом (этапов единицы, конкуренции нет).
+ */
+class RequestTrace {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit RequestTrace(std::string name);
+
+    RequestTrace(const RequestTrace&) = delete;
+    RequestTrace& operator=(const RequestTrace&) = delete;
+
+    void addStage(const char* name, Clock::time_point start, Clock::time_point end);
+
+    /**
+     * Значение заголовка Server-Timing: "parse;dur=0.120, ..., total;dur=3.512" (миллисекунды).
+     * Повторяющиеся этапы суммируются.
+     */
+    std::string serverTiming() const;
+
+    const std::string& name() const { return name_; }
+    Clock::time_point started() const { return started_; }
+    int64_t elapsedMicros() const;
+    std::vector<TraceSpan> spans() const;
+
+    /**
+     * Трассировка, активная в текущем потоке (nullptr - запрос не трассируется)
+     */
+    static RequestTrace* current();
+
+private:
+    friend class TraceScope;
+
+    std::string name_;
+    Clock::time_point started_;
+    mutable std::mutex mutex_;
+    std::vector<TraceSpan> spans_;
+};
+
+using RequestTracePtr = std::shared_ptr<RequestTrace>;
+
+/**
+ * Делает трассировку текущей для потока на время своей жизни
+ * (расчет на пуле пишет этапы в трассировку своего запроса)
+ */
+class TraceScope {
+public:
+    explicit TraceScope(RequestTrace* trace);
+    ~TraceScope();
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    RequestTrace* previous_;
+};
+
+/**
+ * Замер этапа от создания до stop() или конца области видимости.
+ * Без активной трассировки - одно чтение thread_local и ветвление.
+ */
+class TraceStage {
+public:
+    explicit TraceStage(const char* name)
+        : trace_(RequestTrace::current()), name_(name) {
+        if (trace_ != nullptr) {
+            start_ = RequestTrace::Clock::now();
+        }
+    }
+
+    ~TraceStage() { stop(); }
+
+    TraceStage(const TraceStage&) = delete;
+    TraceStage& operator=(const TraceStage&) = delete;
+
+    void stop() {
+        if (trace_ != nullptr) {
+            trace_->addStage(name_, start_, RequestTrace::Clock::now());
+            trace_ = nullptr;
+        }
+    }
+
+private:
+    RequestTrace* trace_;
+    const char* name_;
+    RequestTrace::Clock::time_point start_;
+};
+
+/**
+ * Настройки трассировки запросов
+ */
+struct RequestTracingConfig {
+    bool serverTiming = false;     // Заголовок Server-Timing в ответах
+    std::string traceFile;         // Файл Chrome trace (пусто - не писать)
+    int64_t slowMicros = 100000;   // Медленный запрос - от этой длительности
+    uint32_t sampleEvery = 1;      // Записывать каждый N-й медленный запрос
+};
+
+/**
+ * Создание трассировок и выгрузка медленных запросов в файл
+ * формата Chrome trace (открывается в chrome://tracing и Perfetto).
+ *
+ * Файл - массив событий "X" (complete event), по строке на событие;
+ * закрывающая скобка не пишется, чтобы файл можно было дописывать
+ * (формат допускает ее отсутствие).
+ */
+class RequestTracing {
+public:
+    static void configure(const RequestTracingConfig& config);
+
+    /**
+     * Новая трассировка или nullptr, если и Server-Timing, и файл выключены
+     */
+    static RequestTracePtr begin(std::string name);
+
+    static bool serverTimingEnabled();
+
+    /**
+     * Завершение запроса: медленный запрос из выборки дописывается в файл
+     */
+    static void finish(const RequestTrace& trace);
+
+private:
+    static std::string formatEvents(const RequestTrace& trace, int64_t totalMicros);
+};
+
+} // namespace derivx
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+
+namespace derivx {
+
+/**
+ * Формат тела ответа, выбирается по заголовку Accept
+ */
+enum class ResponseFormat {
+    JSON,
+    CBOR,        // application/cbor
+    MSGPACK,     // application/msgpack
+    PACKED_F64,  // application/x-derivx-f64: колонки float64 little-endian
+    PACKED_F32   // application/x-derivx-f32: колонки float32 little-endian
+};
+
+/**
+ * Согласование формата ответа и преобразование JSON в бинарные форматы
+ */
+class ResponseFormats {
+public:
+    /**
+     * Выбор формата по заголовку Accept с учетом q-значений.
+     * Упакованные колонки доступны только для эндпоинтов с массивами (allowPacked).
+     * Если подходящего формата нет - JSON.
+     */
+    static ResponseFormat negotiate(const std::string& acceptHeader, bool allowPacked);
+
+    /**
+     * MIME тип формата
+     */
+    static const char* contentType(ResponseFormat format);
+
+    /**
+     * Фактический формат готового тела: упакованный ответ всегда начинается
+     * с магии "DXC1", иначе это JSON с ошибкой
+     */
+    static ResponseFormat detect(const std::string& body, ResponseFormat requested);
+
+    /**
+     * Перекодирование JSON текста в CBOR/MessagePack (для небольших ответов).
+     * Для JSON и упакованных форматов возвращает исходный текст.
+     */
+    static std::string transcode(const std::string& jsonText, ResponseFormat format);
+
+    /**
+     * Тело - ответ с ошибкой ({"error": ...} в JSON, CBOR или MessagePack)
+     */
+    static bool isError(const std::string& body);
+
+    static bool isPacked(ResponseFormat format) {
+        return format == ResponseFormat::PACKED_F64 || format == ResponseFormat::PACKED_F32;
+    }
+};
+
+} // namespace derivx
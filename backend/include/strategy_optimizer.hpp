@@ -0,0 +1,108 @@
+#pragma once
+
+#include "option_pricing.hpp"
+#include "payoff_analysis.hpp"
+#include "compute_pool.hpp"
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace derivx {
+
+/**
+ * Структуры, перебираемые оптимизатором (прямое направление; обратное -
+ * все позиции наоборот). Страйки K1 < K2 < K3 < K4 из сетки.
+ */
+enum class StrategyStructure {
+    VERTICAL_CALL,   // long call K1, short call K2
+    VERTICAL_PUT,    // long put K2, short put K1
+    STRADDLE,        // long call K1, long put K1
+    STRANGLE,        // long put K1, long call K2
+    BUTTERFLY,       // long call K1, short 2 call K2, long call K3
+    CONDOR,          // long call K1, short call K2, short call K3, long call K4
+    IRON_CONDOR      // long put K1, short put K2, short call K3, long call K4
+};
+
+/**
+ * Критерий выбора стратегии
+ */
+enum class OptimizerObjective {
+    EXPECTED_PNL,
+    PROBABILITY_OF_PROFIT
+};
+
+/**
+ * Параметры поиска
+ */
+struct OptimizerConfig {
+    std::vector<StrategyStructure> structures;
+    bool allowReverse = true;          // Перебирать и обратные структуры
+    bool hasMaxLoss = false;
+    double maxLoss = 0.0;              // Наибольший допустимый убыток (неограниченный исключается)
+    bool hasBudget = false;
+    double budget = 0.0;               // Наибольшая уплачиваемая премия (кредит допустим всегда)
+    bool deltaNeutral = false;
+    double deltaTolerance = 0.1;       // |delta| позиции при deltaNeutral
+    OptimizerObjective objective = OptimizerObjective::EXPECTED_PNL;
+    size_t topN = 10;
+};
+
+/**
+ * Кандидат: ноги с премиями по модели, чистая премия (> 0 - уплачена),
+ * delta позиции и характеристики PNL на экспирации
+ */
+struct OptimizerCandidate {
+    StrategyStructure structure = StrategyStructure::VERTICAL_CALL;
+    bool reverse = false;
+    size_t legCount = 0;
+    Option legs[4];
+    double netPremium = 0.0;
+    double delta = 0.0;
+    PayoffStats stats;
+    double score = 0.0;
+    uint64_t order = 0;                // Порядок перебора (детерминированный выбор при равенстве)
+};
+
+/**
+ * Результат поиска: лучшие кандидаты по убыванию критерия и счетчики отсечения
+ */
+struct OptimizerResult {
+    std::vector<OptimizerCandidate> best;
+    uint64_t candidates = 0;           // Перебрано комбинаций
+    uint64_t rejectedBudget = 0;
+    uint64_t rejectedDelta = 0;
+    uint64_t rejectedLoss = 0;
+    uint64_t pruned = 0;               // Отсечено как заведомо хуже текущих лучших
+    uint64_t evaluated = 0;            // Посчитано полностью
+};
+
+/**
+ * Перебор страйков сетки для заданных структур: лучшие по ожидаемому PNL
+ * или вероятности прибыли под эмпирическим распределением символа.
+ *
+ * Цены и delta страйков берутся из цепочки (OptionPricing::calculateChain),
+ * кандидат проверяется по ограничениям от дешевых к дорогим (премия, delta,
+ * убыток по изломам PNL), затем PNL интегрируется по распределению точно.
+ * Первые страйки структур делятся между потоками пула.
+ */
+class StrategyOptimizer {
+public:
+    /**
+     * Число комбинаций для сетки из strikeCount страйков
+     */
+    static uint64_t countCandidates(const OptimizerConfig& config, size_t strikeCount);
+
+    static OptimizerResult optimize(
+        const OptimizerConfig& config,
+        const ChainQuote* quotes,
+        size_t strikeCount,
+        const EmpiricalDistribution& distribution,
+        ComputePool* pool
+    );
+
+    static const char* structureName(StrategyStructure structure);
+    static bool parseStructure(const std::string& name, StrategyStructure& structure);
+};
+
+} // namespace derivx
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "option_pricing.hpp"
+#include "volatility.hpp"
+#include "compute_pool.hpp"
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <unordered_map>
+
+namespace derivx {
+
+/**
+ * Оценка стратегии по последней свече символа
+ */
+struct StrategyMark {
+    int64_t timestamp = 0;   // Время последней свечи
+    std::string date;
+    double spotPrice = 0.0;
+    double pnl = 0.0;        // PNL при экспирации по текущей цене
+    Greeks greeks;           // Суммарные греки позиции
+};
+
+/**
+ * Подписчик потока: хранит только последнее непрочитанное событие.
+ * Если клиент читает медленнее, чем приходят обновления, промежуточные
+ * события заменяются более свежими (coalescing).
+ */
+class StreamSubscriber {
+public:
+    /**
+     * Новое событие; непрочитанное предыдущее отбрасывается (тогда возвращает true)
+     */
+    bool publish(const std::string& event);
+
+    /**
+     * Забрать ожидающее событие (false - нового нет)
+     */
+    bool take(std::string& event);
+
+    void close() { closed_.store(true, std::memory_order_release); }
+    bool closed() const { return closed_.load(std::memory_order_acquire); }
+
+private:
+    std::mutex mutex_;
+    std::string pending_;
+    bool hasPending_ = false;
+    std::atomic<bool> closed_{false};
+};
+
+using StreamSubscriberPtr = std::shared_ptr<StreamSubscriber>;
+
+/**
+ * Счетчики потоков стратегий
+ */
+struct StrategyStreamStats {
+    uint64_t topics = 0;        // Уникальные пары (символ, стратегия)
+    uint64_t subscribers = 0;
+    uint64_t evaluations = 0;   // Пересчеты стратегий (один на тему за свечу)
+    uint64_t published = 0;     // Событий, переданных подписчикам
+    uint64_t coalesced = 0;     // Событий, замененных более свежими у медленных клиентов
+};
+
+/**
+ * Рассылка переоценки стратегий при появлении новых свечей.
+ *
+ * Подписчики с одинаковым символом и стратегией (JSON сравнивается
+ * в каноническом виде) делят одну тему: при новой свече стратегия
+ * пересчитывается один раз, событие рассылается всем подписчикам темы.
+ * Событие - JSON с текущей оценкой и изменением относительно предыдущей.
+ * Отписка ленивая: закрытые и удаленные подписчики вычищаются при рассылке.
+ */
+class StrategyStreamHub {
+public:
+    /**
+     * Оценка стратегии по снимку данных; исключение - некорректная стратегия
+     */
+    using Evaluator = std::function<StrategyMark(const std::string& strategy, const OHLCVSeries& series)>;
+
+    explicit StrategyStreamHub(Evaluator evaluator);
+
+    StrategyStreamHub(const StrategyStreamHub&) = delete;
+    StrategyStreamHub& operator=(const StrategyStreamHub&) = delete;
+
+    /**
+     * Подписка на стратегию по символу. Подписчик сразу получает текущую
+     * оценку (готовую, если тема уже существует). Исключение - стратегия некорректна.
+     */
+    StreamSubscriberPtr subscribe(const std::string& symbol, const std::string& strategy,
+                                  const OHLCVSeriesPtr& series);
+
+    /**
+     * Новая версия данных символа: пересчет всех тем символа и рассылка.
+     * Темы считаются параллельно на пуле (nullptr - в текущем потоке).
+     */
+    void update(const std::string& symbol, const OHLCVSeriesPtr& series, ComputePool* pool = nullptr);
+
+    /**
+     * Символы, на которые есть подписки
+     */
+    std::vector<std::string> symbols() const;
+
+    StrategyStreamStats stats() const;
+
+private:
+    struct Topic {
+        std::string symbol;
+        std::string strategy;
+        std::mutex mutex;                                    // Оценка и рассылка темы
+        std::vector<std::weak_ptr<StreamSubscriber>> subscribers;
+        bool hasMark = false;
+        StrategyMark mark;
+        std::weak_ptr<const OHLCVSeries> source;             // Снимок, по которому посчитана оценка
+        std::string event;                                   // Последнее разосланное событие
+    };
+    using TopicPtr = std::shared_ptr<Topic>;
+
+    Evaluator evaluator_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, TopicPtr> topics_;       // Ключ: символ + каноническая стратегия
+    std::atomic<uint64_t> evaluations_{0};
+    std::atomic<uint64_t> published_{0};
+    std::atomic<uint64_t> coalesced_{0};
+
+    /**
+     * Пересчет темы по снимку (под мьютексом темы); false - снимок уже учтен
+     */
+    bool evaluateLocked(Topic& topic, const OHLCVSeriesPtr& series);
+
+    /**
+     * Вычистка ушедших подписчиков и, если send, рассылка события темы
+     * (под мьютексом темы). Возвращает число живых подписчиков.
+     */
+    size_t publishLocked(Topic& topic, bool send);
+
+    void deliver(StreamSubscriber& subscriber, const std::string& event);
+
+    static std::string formatEvent(const std::string& symbol, const StrategyMark& mark,
+                                   const StrategyMark* previous);
+};
+
+} // namespace derivx
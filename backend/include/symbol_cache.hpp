@@ -0,0 +1,188 @@
+#pragma once
+
+#include "volatility.hpp"
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <functional>
+#include <unordered_map>
+
+namespace derivx {
+
+/**
+ * Параметры кэша символов
+ */
+struct SymbolCacheConfig {
+    size_t shardCount = 16;
+    size_t memoryBudgetBytes = 0;                           // 0 - без ограничения
+    std::chrono::seconds negativeTtl = std::chrono::seconds(30); // 0 - не кэшировать пустые
+};
+
+/**
+ * Счетчики кэша (снимок на момент вызова)
+ */
+struct SymbolCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t negativeHits = 0;   // Попадания в кэшированный "символ не найден"
+    uint64_t loads = 0;
+    uint64_t loadFailures = 0;
+    uint64_t coalescedWaits = 0; // Промахи, дождавшиеся чужой загрузки
+    uint64_t evictions = 0;
+    uint64_t expirations = 0;    // Истекшие отрицательные записи
+    uint64_t bytes = 0;
+    uint64_t entries = 0;
+    uint64_t budgetBytes = 0;
+};
+
+/**
+ * Потокобезопасный шардированный кэш OHLCV снимков по символам.
+ *
+ * Читатели wait-free: каждый шард публикует неизменяемую хэш-таблицу через
+ * атомарный сырой указатель (RCU). Чтение - вход в один из двух счетчиков
+ * читателей шарда, загрузка указателя, поиск и выход: фиксированное число
+ * атомарных операций без мьютексов и повторов. Писатели копируют таблицу под
+ * мьютексом шарда, подменяют указатель и освобождают старую таблицу после
+ * grace period - когда оба счетчика хотя бы раз опустели (ждет только писатель).
+ * Возврат снимка увеличивает счетчик ссылок shared_ptr (атомарный инкремент).
+ * Одновременные промахи по одному символу объединяются (single-flight):
+ * файл читается один раз, остальные потоки ждут тот же результат.
+ *
+ * Объем кэша учитывается в байтах. При превышении бюджета записи
+ * вытесняются алгоритмом CLOCK (читатель лишь выставляет бит обращения).
+ * Пустые результаты (неизвестный символ) хранятся ограниченное время.
+ */
+class SymbolCache {
+public:
+    /**
+     * Функция загрузки снимка символа (вызывается вне блокировок)
+     */
+    using Loader = std::function<OHLCVSeriesPtr(const std::string&)>;
+
+    explicit SymbolCache(const SymbolCacheConfig& config = SymbolCacheConfig());
+
+    SymbolCache(const SymbolCache&) = delete;
+    SymbolCache& operator=(const SymbolCache&) = delete;
+
+    /**
+     * Переконфигурация с очисткой. Вызывать до начала обслуживания запросов.
+     */
+    void configure(const SymbolCacheConfig& config);
+
+    /**
+     * Установка функции загрузки. Вызывать до начала обслуживания запросов.
+     */
+    void setLoader(Loader loader);
+
+    /**
+     * Получение снимка символа; при промахе загружает его через Loader.
+     * Исключения загрузчика пробрасываются всем ожидающим потокам.
+     */
+    OHLCVSeriesPtr get(const std::string& symbol);
+
+    /**
+     * Поиск снимка без загрузки (nullptr при промахе или истекшей записи)
+     */
+    OHLCVSeriesPtr find(const std::string& symbol) const;
+
+    /**
+     * Удаление символа из кэша (следующий get перечитает файл)
+     */
+    void invalidate(const std::string& symbol);
+
+    /**
+     * Очистка всех шардов
+     */
+    void clear();
+
+    /**
+     * Текущие счетчики
+     */
+    SymbolCacheStats stats() const;
+
+    /**
+     * Оценка занимаемой снимком памяти в байтах
+     */
+    static size_t estimateBytes(const std::string& symbol, const OHLCVSeries& series);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        OHLCVSeriesPtr series;
+        size_t bytes = 0;
+        Clock::time_point expiresAt = Clock::time_point::max();
+        mutable std::atomic<bool> referenced{true};
+    };
+
+    using Map = std::unordered_map<std::string, std::shared_ptr<const Entry>>;
+
+    struct Shard {
+        // Опубликованная таблица; владеет шард, старые освобождаются в publishLocked
+        std::atomic<const Map*> snapshot{new Map()};
+        // Читатели входят в счетчик readers[epoch & 1]; писатель переключает epoch,
+        // чтобы новые читатели не задерживали ожидание старого счетчика
+        std::atomic<uint64_t> epoch{0};
+        std::atomic<uint64_t> readers[2] = {};
+        // Сериализует писателей шарда и защищает поля ниже
+        std::mutex writeMutex;
+        std::unordered_map<std::string, std::shared_future<OHLCVSeriesPtr>> inflight;
+        std::vector<std::string> clockRing;
+        size_t clockHand = 0;
+
+        ~Shard() { delete snapshot.load(std::memory_order_relaxed); }
+    };
+
+    SymbolCacheConfig config_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    size_t shardMask_ = 0;
+    Loader loader_;
+
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> entries_{0};
+    std::atomic<size_t> evictCursor_{0};
+
+    mutable std::atomic<uint64_t> hits_{0};
+    mutable std::atomic<uint64_t> misses_{0};
+    mutable std::atomic<uint64_t> negativeHits_{0};
+    std::atomic<uint64_t> loads_{0};
+    std::atomic<uint64_t> loadFailures_{0};
+    std::atomic<uint64_t> coalescedWaits_{0};
+    std::atomic<uint64_t> evictions_{0};
+    std::atomic<uint64_t> expirations_{0};
+
+    Shard& shardFor(const std::string& symbol) const;
+
+    /**
+     * Поиск живой записи в опубликованной таблице (nullptr если нет/истекла)
+     */
+    static const Entry* lookup(const Map& map, const std::string& symbol);
+
+    /**
+     * Публикация новой таблицы и освобождение старой после ухода ее читателей
+     * (вызывается под writeMutex)
+     */
+    static void publishLocked(Shard& shard, const Map* next);
+
+    /**
+     * Вставка/удаление в шарде (вызывается под writeMutex)
+     */
+    void insertLocked(Shard& shard, const std::string& symbol, OHLCVSeriesPtr series);
+    bool eraseLocked(Shard& shard, const std::string& symbol);
+
+    /**
+     * Один шаг CLOCK в шарде: true если запись вытеснена
+     */
+    bool evictOneLocked(Shard& shard);
+
+    /**
+     * Вытеснение, пока объем превышает бюджет
+     */
+    void enforceBudget();
+};
+
+} // namespace derivx
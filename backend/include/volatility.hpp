@@ -5,6 +5,9 @@
 #include <fstream>
 #include <sstream>
 #include <cmath>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
 
 namespace derivx {
 
@@ -13,6 +16,7 @@ namespace derivx {
  */
 struct OHLCV {
     std::string date;
+    int64_t timestamp;  // Unix время начала свечи (секунды, UTC)
     double open;
     double high;
     double low;
@@ -20,6 +24,54 @@ struct OHLCV {
     double volume;
 };
 
+/**
+ * Невладеющее представление непрерывного диапазона свечей.
+ * Копирование стоит два слова, данные не копируются.
+ */
+class OHLCVView {
+public:
+    OHLCVView() : data_(nullptr), size_(0) {}
+    OHLCVView(const OHLCV* data, size_t size) : data_(data), size_(size) {}
+    OHLCVView(const std::vector<OHLCV>& candles) : data_(candles.data()), size_(candles.size()) {}
+    
+    const OHLCV* begin() const { return data_; }
+    const OHLCV* end() const { return data_ + size_; }
+    const OHLCV& operator[](size_t i) const { return data_[i]; }
+    const OHLCV& front() const { return data_[0]; }
+    const OHLCV& back() const { return data_[size_ - 1]; }
+    const OHLCV* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    
+    /**
+     * Последние n элементов (или весь диапазон, если n >= size)
+     */
+    OHLCVView last(size_t n) const {
+        return n >= size_ ? *this : OHLCVView(data_ + (size_ - n), n);
+    }
+
+private:
+    const OHLCV* data_;
+    size_t size_;
+};
+
+/**
+ * Неизменяемый снимок истории символа.
+ * Разделяется между кэшем и обработчиками через shared_ptr<const OHLCVSeries>,
+ * поэтому попадание в кэш стоит одного инкремента счетчика ссылок.
+ */
+struct OHLCVSeries {
+    std::vector<OHLCV> candles;
+    uint64_t version = 0;        // Хэш состояния файла и последней свечи (основа ETag)
+    int64_t modifiedTime = 0;    // Время изменения файла (unix), 0 - неизвестно
+    
+    OHLCVView view() const { return OHLCVView(candles); }
+    bool empty() const { return candles.empty(); }
+    size_t size() const { return candles.size(); }
+};
+
+using OHLCVSeriesPtr = std::shared_ptr<const OHLCVSeries>;
+
 /**
  * Класс для расчета волатильности из OHLCV данных
  */
@@ -30,15 +82,24 @@ public:
      */
     static std::vector<OHLCV> loadOHLCVFromCSV(const std::string& filepath);
     
+    /**
+     * Разбор даты свечи в Unix время (секунды, UTC).
+     * Поддерживает "YYYY-MM-DD", "YYYY-MM-DD HH:MM[:SS]", "YYYY-MM-DDTHH:MM[:SS][Z]"
+     * и числовой timestamp в секундах или миллисекундах. Строка разбирается целиком:
+     * смещение пояса и любой другой хвост - ошибка.
+     * @return false если строку разобрать не удалось
+     */
+    static bool parseTimestamp(const std::string& text, int64_t& timestamp);
+    
     /**
      * Расчет исторической волатильности (стандартное отклонение логарифмических доходностей)
      * 
-     * @param ohlcv_data Вектор OHLCV данных
+     * @param ohlcv_data Диапазон OHLCV данных
      * @param period Период для расчета (в днях), по умолчанию 30
      * @return Годовая волатильность (в долях, не процентах)
      */
     static double calculateHistoricalVolatility(
-        const std::vector<OHLCV>& ohlcv_data,
+        OHLCVView ohlcv_data,
         int period = 30
     );
     
@@ -46,28 +107,47 @@ public:
      * Расчет волатильности по методу Паркинсона (использует high/low)
      */
     static double calculateParkinsonVolatility(
-        const std::vector<OHLCV>& ohlcv_data,
+        OHLCVView ohlcv_data,
         int period = 30
     );
     
     /**
      * Получение текущей цены из последней свечи
      */
-    static double getCurrentPrice(const std::vector<OHLCV>& ohlcv_data);
+    static double getCurrentPrice(OHLCVView ohlcv_data);
     
     /**
-     * Получение последних N свечей
+     * Получение последних N свечей (без копирования)
      */
-    static std::vector<OHLCV> getLastNCandles(
-        const std::vector<OHLCV>& ohlcv_data,
+    static OHLCVView getLastNCandles(
+        OHLCVView ohlcv_data,
         int n
     );
+    
+    /**
+     * Свечи с timestamp в [from, to] (бинарный поиск, данные отсортированы по времени)
+     */
+    static OHLCVView getCandlesInRange(
+        OHLCVView ohlcv_data,
+        int64_t from,
+        int64_t to
+    );
+    
+    /**
+     * Индекс первой свечи с timestamp >= t
+     */
+    static size_t lowerBoundByTime(OHLCVView ohlcv_data, int64_t t);
+    
+    /**
+     * Индекс первой свечи с timestamp > t
+     */
+    static size_t upperBoundByTime(OHLCVView ohlcv_data, int64_t t);
 
 private:
     /**
      * Расчет логарифмических доходностей
      */
-    static std::vector<double> calculateReturns(const std::vector<OHLCV>& ohlcv_data);
+    static std::vector<double> calculateReturns(OHLCVView ohlcv_data);
     
     /**
      * Расчет стандартного отклонения
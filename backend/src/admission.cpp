@@ -0,0 +1,396 @@
+#include "../include/admission.hpp"
+#include "../include/api_handler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace derivx {
+
+namespace {
+
+thread_local const RequestDeadline* currentDeadline = nullptr;
+
+// Начало значения после "key": в тексте JSON без разбора всего документа
+size_t jsonValueOffset(const std::string& body, const char* key) {
+    std::string needle = std::string("\"") + key + "\"";
+    size_t position = body.find(needle);
+    if (position == std::string::npos) {
+        return position;
+    }
+    position += needle.size();
+    while (position < body.size() && (body[position] == ' ' || body[position] == '\t' ||
+                                      body[position] == '\r' || body[position] == '\n' || body[position] == ':')) {
+        ++position;
+    }
+    return position;
+}
+
+double jsonNumber(const std::string& body, const char* key, double fallback) {
+    size_t position = jsonValueOffset(body, key);
+    if (position == std::string::npos) {
+        return fallback;
+    }
+    const char* begin = body.c_str() + position;
+    char* end = nullptr;
+    double value = std::strtod(begin, &end);
+    return end != begin && std::isfinite(value) ? value : fallback;
+}
+
+bool jsonFlag(const std::string& body, const char* key) {
+    size_t position = jsonValueOffset(body, key);
+    return position != std::string::npos && body.compare(position, 4, "true") == 0;
+}
+
+// Число элементов плоского массива "key": [...] (0 - нет массива)
+size_t jsonArrayLength(const std::string& body, const char* key) {
+    size_t position = jsonValueOffset(body, key);
+    if (position == std::string::npos || position >= body.size() || body[position] != '[') {
+        return 0;
+    }
+    size_t end = body.find(']', position);
+    if (end == std::string::npos || body.find_first_not_of(" \t\r\n", position + 1) == end) {
+        return 0;
+    }
+    return static_cast<size_t>(std::count(body.begin() + position, body.begin() + end, ',')) + 1;
+}
+
+size_t countOccurrences(const std::string& text, const char* needle) {
+    size_t count = 0;
+    size_t length = std::strlen(needle);
+    for (size_t position = text.find(needle); position != std::string::npos;
+         position = text.find(needle, position + length)) {
+        ++count;
+    }
+    return count;
+}
+
+// Числовой параметр query без URL-декодирования (имена и числа его не требуют)
+double queryNumber(const std::string& query, const char* key, double fallback) {
+    size_t length = std::strlen(key);
+    size_t position = 0;
+    while (position < query.size()) {
+        size_t end = query.find('&', position);
+        if (end == std::string::npos) {
+            end = query.size();
+        }
+        if (end - position > length && query.compare(position, length, key) == 0 && query[position + length] == '=') {
+            const char* begin = query.c_str() + position + length + 1;
+            char* parsedEnd = nullptr;
+            double value = std::strtod(begin, &parsedEnd);
+            return parsedEnd != begin && std::isfinite(value) ? value : fallback;
+        }
+        position = end + 1;
+    }
+    return fallback;
+}
+
+// Число элементов списка через запятую в параметре query (запятая может быть закодирована)
+size_t queryListLength(const std::string& query, const char* key, size_t fallback) {
+    size_t length = std::strlen(key);
+    size_t position = 0;
+    while (position < query.size()) {
+        size_t end = query.find('&', position);
+        if (end == std::string::npos) {
+            end = query.size();
+        }
+        if (end - position > length && query.compare(position, length, key) == 0 && query[position + length] == '=') {
+            size_t items = 1;
+            for (size_t i = position + length + 1; i < end; ++i) {
+                if (query[i] == ',' ||
+                    (query[i] == '%' && i + 2 < end && query[i + 1] == '2' && (query[i + 2] == 'C' || query[i + 2] == 'c'))) {
+                    ++items;
+                }
+            }
+            return items;
+        }
+        position = end + 1;
+    }
+    return fallback;
+}
+
+// Строковое значение "key": (пусто - нет ключа или значение не строка)
+std::string jsonString(const std::string& body, const char* key) {
+    size_t position = jsonValueOffset(body, key);
+    if (position == std::string::npos || position >= body.size() || body[position] != '"') {
+        return std::string();
+    }
+    size_t end = body.find('"', position + 1);
+    return end == std::string::npos ? std::string() : body.substr(position + 1, end - position - 1);
+}
+
+// Тексты элементов массива операций пакета: тело - массив или {"requests": [...]}
+std::vector<std::string> batchItems(const std::string& body) {
+    std::vector<std::string> items;
+    size_t position = body.find_first_not_of(" \t\r\n");
+    if (position == std::string::npos || body[position] != '[') {
+        position = jsonValueOffset(body, "requests");
+    }
+    if (position == std::string::npos || position >= body.size() || body[position] != '[') {
+        return items;
+    }
+
+    int depth = 0;
+    bool inString = false;
+    size_t itemBegin = position + 1;
+    for (size_t i = position; i < body.size(); ++i) {
+        char c = body[i];
+        if (inString) {
+            if (c == '\\') {
+                ++i;
+            } else if (c == '"') {
+                inString = false;
+            }
+        } else if (c == '"') {
+            inString = true;
+        } else if (c == '{' || c == '[') {
+            ++depth;
+        } else if (c == '}' || c == ']') {
+            if (--depth == 0) {
+                items.push_back(body.substr(itemBegin, i - itemBegin));
+                break;
+            }
+        } else if (c == ',' && depth == 1) {
+            items.push_back(body.substr(itemBegin, i - itemBegin));
+            itemBegin = i + 1;
+        }
+    }
+    if (!items.empty() && items.back().find_first_not_of(" \t\r\n") == std::string::npos) {
+        items.pop_back();   // Пустой массив
+    }
+    return items;
+}
+
+// OHLCV: maxPoints агрегирует все окно, limit - только страницу
+uint64_t ohlcvUnits(double limit, double maxPoints) {
+    double rows = std::min(std::max({limit, maxPoints, 1.0}), static_cast<double>(MAX_OHLCV_LIMIT));
+    return 10 + (maxPoints > 0 ? 500 : 0) + static_cast<uint64_t>(rows / 20.0);
+}
+
+bool startsWith(const std::string& text, const char* prefix) {
+    return text.compare(0, std::strlen(prefix), prefix) == 0;
+}
+
+} // namespace
+
+// --------------------------------------------------------- RequestDeadline
+
+const RequestDeadline* RequestDeadline::current() {
+    return currentDeadline;
+}
+
+DeadlineScope::DeadlineScope(const RequestDeadline* deadline)
+    : previous_(currentDeadline) {
+    currentDeadline = deadline;
+}
+
+DeadlineScope::~DeadlineScope() {
+    currentDeadline = previous_;
+}
+
+// --------------------------------------------------------- AdmissionTicket
+
+AdmissionTicket& AdmissionTicket::operator=(AdmissionTicket&& other) noexcept {
+    if (this != &other) {
+        release();
+        controller_ = other.controller_;
+        cost_ = other.cost_;
+        admitted_ = other.admitted_;
+        other.controller_ = nullptr;
+        other.admitted_ = false;
+    }
+    return *this;
+}
+
+void AdmissionTicket::release() {
+    if (controller_ != nullptr) {
+        controller_->release(cost_);
+        controller_ = nullptr;
+    }
+}
+
+// ----------------------------------------------------- AdmissionController
+
+AdmissionController::AdmissionController(const AdmissionConfig& config)
+    : config_(config) {}
+
+RequestCost AdmissionController::estimate(const std::string& method, const std::string& path,
+                                          const std::string& query, const std::string& body) const {
+    RequestCost cost;
+
+    if (method == "POST") {
+        if (path == "/api/calculate-option" || path == "/api/calculate-greeks") {
+            cost.units = 5;
+        } else if (path == "/api/calculate-strategy") {
+            // Кривая: точки x ноги на оценку payoff плюс сериализация точек
+            double legs = static_cast<double>(std::max<size_t>(countOccurrences(body, "\"strike\""), 1));
+            double points = std::min(std::max(jsonNumber(body, "numPoints", 200.0), 2.0),
+                                     static_cast<double>(MAX_PAYOFF_POINTS));
+            cost.units = 20 + static_cast<uint64_t>(points * (legs + 25.0) / 500.0);
+            if (jsonFlag(body, "profile")) {
+                // Греки ноги в точке - на порядок дороже payoff, точка ответа втрое больше
+                cost.units += static_cast<uint64_t>(points * (10.0 * legs + 50.0) / 500.0);
+            }
+            if (jsonFlag(body, "analysis")) {
+                // Интегралы PNL - микросекунды; с символом - чтение истории и сортировка доходностей
+                cost.units += jsonValueOffset(body, "symbol") != std::string::npos ? 500 : 20;
+            }
+        } else if (path == "/api/backtest") {
+            // Проход по истории каждого символа и окна по всем его датам входа
+            cost.units = 200 + 300 * static_cast<uint64_t>(std::max<size_t>(jsonArrayLength(body, "symbols"), 1));
+        } else if (path == "/api/optimize-strategy") {
+            // Перебор растет как четвертая степень сетки (кондоры), ~0.1 мкс на кандидата
+            double strikes = std::min(std::max(jsonNumber(body, "numStrikes", 41.0), 2.0),
+                                      static_cast<double>(MAX_OPTIMIZER_STRIKES));
+            size_t structures = jsonArrayLength(body, "structures");
+            double combinations = strikes * strikes * strikes * strikes / 12.0;
+            cost.units = 500 + static_cast<uint64_t>((structures == 0 ? 7 : structures) * combinations / 10.0);
+        } else if (path == "/api/model-chain") {
+            // Калибровка - тысячи вычислений модели на старт; цепочка - преобразование на экспирацию
+            double starts = std::min(std::max(jsonNumber(body, "starts", 4.0), 1.0),
+                                     static_cast<double>(MAX_CALIBRATION_STARTS));
+            size_t quotes = countOccurrences(body, "\"price\"");
+            size_t calibrate = jsonValueOffset(body, "calibrate");
+            bool none = calibrate != std::string::npos && body.compare(calibrate, 6, "\"none\"") == 0;
+            bool fixed = none || (calibrate == std::string::npos && quotes == 0 &&
+                                  jsonValueOffset(body, "params") != std::string::npos);
+            double calibration = fixed ? 0.0 : quotes > 0 ? 4000.0 * static_cast<double>(quotes) : 100000.0;
+            size_t expiries = jsonArrayLength(body, "expiries");
+            expiries = expiries == 0 ? 5 : expiries;
+            cost.units = 200 + static_cast<uint64_t>(starts * calibration) + 500 * static_cast<uint64_t>(expiries);
+        } else if (path == "/api/batch") {
+            // Каждая операция - по формуле своего маршрута: пакет тяжелых кривых - тяжелый запрос
+            cost.units = 50;
+            for (const std::string& item : batchItems(body)) {
+                std::string op = jsonString(item, "op");
+                if (op == "calculate-option" || op == "calculate-greeks" || op == "calculate-strategy") {
+                    cost.units += estimate(method, "/api/" + op, std::string(), item).units;
+                } else if (op == "ohlcv") {
+                    cost.units += ohlcvUnits(jsonNumber(item, "limit", 100.0), jsonNumber(item, "maxPoints", 0.0));
+                } else if (op == "price" || op == "volatility") {
+                    cost.units += 10;
+                } else {
+                    cost.units += 5;   // Статистика кэша или ошибка операции
+                }
+            }
+        }
+    } else if (method == "GET") {
+        if (startsWith(path, "/api/price/") || startsWith(path, "/api/volatility/")) {
+            cost.units = 10;
+        } else if (startsWith(path, "/api/ohlcv/")) {
+            cost.units = ohlcvUnits(queryNumber(query, "limit", 100.0), queryNumber(query, "maxPoints", 0.0));
+        } else if (startsWith(path, "/api/option-chain/")) {
+            // Котировки: страйки x экспирации, на каждую - проход расчета и сериализация
+            size_t strikes = queryListLength(query, "strikes", 0);
+            if (strikes == 0) {
+                strikes = static_cast<size_t>(std::min(std::max(queryNumber(query, "numStrikes", 21.0), 1.0),
+                                                       static_cast<double>(MAX_CHAIN_STRIKES)));
+            }
+            size_t expiries = queryListLength(query, "expiries", 5);
+            cost.units = 10 + static_cast<uint64_t>(strikes * expiries / 20);
+        } else if (startsWith(path, "/api/stream/strategy/")) {
+            cost.units = 50;
+        }
+    }
+
+    cost.lane = cost.units >= config_.heavyThreshold ? AdmissionLane::HEAVY : AdmissionLane::INTERACTIVE;
+    return cost;
+}
+
+AdmissionTicket AdmissionController::tryAdmit(const RequestCost& cost) {
+    AdmissionTicket ticket;
+    if (cost.units == 0) {
+        ticket.admitted_ = true;   // Служебный запрос - без учета
+        return ticket;
+    }
+
+    Lane& target = lane(cost.lane);
+    bool heavy = cost.lane == AdmissionLane::HEAVY;
+    uint64_t limit = heavy ? config_.heavyLimit : config_.interactiveLimit;
+
+    uint64_t count = target.inFlight.fetch_add(1, std::memory_order_acq_rel) + 1;
+    uint64_t units = target.inFlightUnits.fetch_add(cost.units, std::memory_order_acq_rel) + cost.units;
+    if (count > limit || (heavy && count > 1 && units > config_.heavyBudget)) {
+        target.inFlight.fetch_sub(1, std::memory_order_acq_rel);
+        target.inFlightUnits.fetch_sub(cost.units, std::memory_order_acq_rel);
+        target.rejected.fetch_add(1, std::memory_order_relaxed);
+        return ticket;
+    }
+
+    target.admitted.fetch_add(1, std::memory_order_relaxed);
+    ticket.controller_ = this;
+    ticket.cost_ = cost;
+    ticket.admitted_ = true;
+    return ticket;
+}
+
+void AdmissionController::release(const RequestCost& cost) {
+    Lane& target = lane(cost.lane);
+    target.inFlight.fetch_sub(1, std::memory_order_acq_rel);
+    target.inFlightUnits.fetch_sub(cost.units, std::memory_order_acq_rel);
+    target.completedUnits.fetch_add(cost.units, std::memory_order_relaxed);
+}
+
+RequestDeadlinePtr AdmissionController::deadlineFor(const RequestCost& cost,
+                                                    RequestDeadline::Clock::time_point started,
+                                                    int64_t clientTimeoutMs) const {
+    auto expiresAt = started + (cost.lane == AdmissionLane::HEAVY ? config_.heavyDeadline
+                                                                 : config_.interactiveDeadline);
+    if (clientTimeoutMs > 0) {
+        expiresAt = std::min(expiresAt, started + std::chrono::milliseconds(clientTimeoutMs));
+    }
+    return std::make_shared<RequestDeadline>(expiresAt);
+}
+
+uint32_t AdmissionController::retryAfterSeconds(AdmissionLane laneId) {
+    Lane& target = lane(laneId);
+    auto now = RequestDeadline::Clock::now();
+    uint64_t completed = target.completedUnits.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(target.rateMutex);
+    double elapsed = std::chrono::duration<double>(now - target.sampledAt).count();
+    if (target.sampledAt == RequestDeadline::Clock::time_point()) {
+        target.sampledAt = now;
+        target.sampledUnits = completed;
+    } else if (elapsed >= 1.0) {
+        double rate = static_cast<double>(completed - target.sampledUnits) / elapsed;
+        target.unitsPerSecond = target.unitsPerSecond > 0 ? 0.5 * target.unitsPerSecond + 0.5 * rate : rate;
+        target.sampledAt = now;
+        target.sampledUnits = completed;
+    }
+
+    if (target.unitsPerSecond <= 0) {
+        return 1;
+    }
+    double backlog = static_cast<double>(target.inFlightUnits.load(std::memory_order_relaxed));
+    return static_cast<uint32_t>(std::min(std::max(std::ceil(backlog / target.unitsPerSecond), 1.0), 60.0));
+}
+
+AdmissionStats AdmissionController::stats() const {
+    auto laneStats = [](const Lane& source) {
+        AdmissionLaneStats result;
+        result.admitted = source.admitted.load(std::memory_order_relaxed);
+        result.rejected = source.rejected.load(std::memory_order_relaxed);
+        result.inFlight = source.inFlight.load(std::memory_order_relaxed);
+        result.inFlightUnits = source.inFlightUnits.load(std::memory_order_relaxed);
+        return result;
+    };
+
+    AdmissionStats stats;
+    stats.interactive = laneStats(interactive_);
+    stats.heavy = laneStats(heavy_);
+    stats.deadlineExceeded = deadlineExceeded_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+int64_t AdmissionController::parseTimeoutHeader(const std::string* value) {
+    if (value == nullptr || value->empty()) {
+        return 0;
+    }
+    char* end = nullptr;
+    long long parsed = std::strtoll(value->c_str(), &end, 10);
+    return (*end == '\0' && parsed > 0) ? static_cast<int64_t>(parsed) : 0;
+}
+
+} // namespace derivx
@@ -1,15 +1,547 @@
 #include "../include/api_handler.hpp"
+#include "../include/downsampling.hpp"
+#include "../include/json_writer.hpp"
+#include "../include/binary_writer.hpp"
+#include "../include/metrics.hpp"
+#include "../include/request_trace.hpp"
+#include "../include/admission.hpp"
+#include "../include/request_arena.hpp"
+#include "../include/backtest.hpp"
+#include "../include/strategy_optimizer.hpp"
+#include "../include/payoff_analysis.hpp"
+#include "../include/fourier_pricing.hpp"
+#include "../include/model_calibration.hpp"
 #include <nlohmann/json.hpp>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
-using json = nlohmann::json;
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <filesystem>
+#include <stdexcept>
+#include <sys/stat.h>
+
+// Дерево разобранного запроса и небольшие документы ответов - в арене запроса
+using json = nlohmann::basic_json<std::map, std::vector, std::string, bool, std::int64_t, std::uint64_t, double,
+                                  derivx::ArenaAllocator>;
 
 namespace derivx {
 
-void APIHandler::initialize(const std::string& dataDir) {
+namespace {
+
+/**
+ * Кодирование небольшого документа (например, ошибки) в запрошенном формате.
+ * Для упакованных колонок ошибки отдаются в JSON.
+ */
+std::string encodeDocument(const json& document, ResponseFormat format) {
+    std::string encoded;
+    if (format == ResponseFormat::CBOR) {
+        json::to_cbor(document, encoded);
+    } else if (format == ResponseFormat::MSGPACK) {
+        json::to_msgpack(document, encoded);
+    } else {
+        encoded = document.dump();
+    }
+    return encoded;
+}
+
+/**
+ * Анализ PNL стратегии на экспирации для /calculate-strategy
+ */
+struct StrategyAnalysis {
+    double spotPrice = 0.0;
+    double volatility = 0.0;          // Годовая, доля
+    double timeToExpiration = 0.0;    // Дни
+    double shortfallLevel = 0.0;      // Доля худших исходов
+    PayoffStats lognormal;
+    bool hasEmpirical = false;
+    PayoffStats empirical;
+    size_t samples = 0;
+};
+
+/**
+ * Величина, которая может быть не ограничена (бесконечность - null)
+ */
+template <typename Writer>
+void writeBound(Writer& writer, double value) {
+    if (std::isinf(value)) {
+        writer.null();
+    } else {
+        writer.value(value);
+    }
+}
+
+/**
+ * Характеристики PNL под одним распределением (ключи по алфавиту)
+ */
+template <typename Writer>
+void writePayoffStats(Writer& writer, const PayoffStats& stats, const size_t* samples) {
+    writer.beginObject(samples != nullptr ? 5 : 4);
+    writer.key("expectedPnl");
+    writer.value(stats.expected);
+    writer.key("expectedShortfall");
+    writer.value(stats.expectedShortfall);
+    writer.key("probabilityOfProfit");
+    writer.value(stats.probabilityOfProfit);
+    if (samples != nullptr) {
+        writer.key("samples");
+        writer.value(*samples);
+    }
+    writer.key("valueAtRisk");
+    writer.value(stats.valueAtRisk);
+    writer.endObject();
+}
+
+/**
+ * Ответ /calculate-strategy (ключи по алфавиту, как в json::dump).
+ * greeks - профиль греков по точкам кривой или nullptr,
+ * analysis - анализ PNL на экспирации или nullptr.
+ */
+template <typename Writer, typename Curve>
+std::string writeStrategyResponse(
+    Writer& writer,
+    const Curve& curve,
+    const Greeks* greeks,
+    const StrategyAnalysis* analysis,
+    double minPrice,
+    double maxPrice
+) {
+    writer.beginObject(analysis != nullptr ? 5 : 4);
+    if (analysis != nullptr) {
+        writer.key("analysis");
+        writer.beginObject(analysis->hasEmpirical ? 8 : 7);
+        if (analysis->hasEmpirical) {
+            writer.key("empirical");
+            writePayoffStats(writer, analysis->empirical, &analysis->samples);
+        }
+        writer.key("lognormal");
+        writePayoffStats(writer, analysis->lognormal, nullptr);
+        writer.key("maxLoss");
+        writeBound(writer, analysis->lognormal.maxLoss);
+        writer.key("maxProfit");
+        writeBound(writer, analysis->lognormal.maxProfit);
+        writer.key("shortfallLevel");
+        writer.value(analysis->shortfallLevel * 100.0);
+        writer.key("spotPrice");
+        writer.value(analysis->spotPrice);
+        writer.key("timeToExpiration");
+        writer.value(analysis->timeToExpiration);
+        writer.key("volatility");
+        writer.value(analysis->volatility * 100.0);
+        writer.endObject();
+    }
+    writer.key("curve");
+    writer.beginArray(curve.size());
+    for (size_t i = 0; i < curve.size(); ++i) {
+        if (greeks == nullptr) {
+            writer.beginObject(2);
+            writer.key("pnl");
+            writer.value(curve[i].second);
+            writer.key("price");
+            writer.value(curve[i].first);
+            writer.endObject();
+            continue;
+        }
+        writer.beginObject(7);
+        writer.key("delta");
+        writer.value(greeks[i].delta);
+        writer.key("gamma");
+        writer.value(greeks[i].gamma);
+        writer.key("pnl");
+        writer.value(curve[i].second);
+        writer.key("price");
+        writer.value(curve[i].first);
+        writer.key("rho");
+        writer.value(greeks[i].rho);
+        writer.key("theta");
+        writer.value(greeks[i].theta);
+        writer.key("vega");
+        writer.value(greeks[i].vega);
+        writer.endObject();
+    }
+    writer.endArray();
+    writer.key("maxPrice");
+    writer.value(maxPrice);
+    writer.key("minPrice");
+    writer.value(minPrice);
+    writer.key("numPoints");
+    writer.value(curve.size());
+    writer.endObject();
+    
+    return writer.release();
+}
+
+/**
+ * Ответ /api/ohlcv (ключи по алфавиту, как в json::dump)
+ */
+template <typename Writer>
+std::string writeOHLCVResponse(
+    Writer& writer,
+    const std::string& symbol,
+    OHLCVView page,
+    const std::string& nextCursor,
+    const std::string& prevCursor
+) {
+    writer.beginObject(5);
+    writer.key("count");
+    writer.value(page.size());
+    writer.key("data");
+    writer.beginArray(page.size());
+    for (const auto& candle : page) {
+        writer.beginObject(7);
+        writer.key("close");
+        writer.value(candle.close);
+        writer.key("date");
+        writer.value(candle.date);
+        writer.key("high");
+        writer.value(candle.high);
+        writer.key("low");
+        writer.value(candle.low);
+        writer.key("open");
+        writer.value(candle.open);
+        writer.key("timestamp");
+        writer.value(candle.timestamp);
+        writer.key("volume");
+        writer.value(candle.volume);
+        writer.endObject();
+    }
+    writer.endArray();
+    writer.key("nextCursor");
+    if (!nextCursor.empty()) {
+        writer.value(nextCursor);
+    } else {
+        writer.null();
+    }
+    writer.key("prevCursor");
+    if (!prevCursor.empty()) {
+        writer.value(prevCursor);
+    } else {
+        writer.null();
+    }
+    writer.key("symbol");
+    writer.value(symbol);
+    writer.endObject();
+    
+    return writer.release();
+}
+
+/**
+ * Цена и греки одной стороны страйка цепочки
+ */
+template <typename Writer>
+void writeChainSide(Writer& writer, double price, const Greeks& greeks) {
+    writer.beginObject(6);
+    writer.key("delta");
+    writer.value(greeks.delta);
+    writer.key("gamma");
+    writer.value(greeks.gamma);
+    writer.key("price");
+    writer.value(price);
+    writer.key("rho");
+    writer.value(greeks.rho);
+    writer.key("theta");
+    writer.value(greeks.theta);
+    writer.key("vega");
+    writer.value(greeks.vega);
+    writer.endObject();
+}
+
+/**
+ * Ответ /api/option-chain (ключи по алфавиту, как в json::dump).
+ * quotes - strikeCount страйков подряд для каждой экспирации.
+ */
+template <typename Writer>
+std::string writeOptionChainResponse(
+    Writer& writer,
+    const std::string& symbol,
+    const OptionChainQuery& query,
+    const MarketParams& market,
+    const ArenaVector<double>& expiries,
+    const ArenaVector<ChainQuote>& quotes,
+    size_t strikeCount
+) {
+    writer.beginObject(6);
+    writer.key("dividendYield");
+    writer.value(market.dividendYield * 100.0);
+    writer.key("expiries");
+    writer.beginArray(expiries.size());
+    for (size_t e = 0; e < expiries.size(); ++e) {
+        writer.beginObject(2);
+        writer.key("strikes");
+        writer.beginArray(strikeCount);
+        for (size_t i = 0; i < strikeCount; ++i) {
+            const ChainQuote& quote = quotes[e * strikeCount + i];
+            writer.beginObject(3);
+            writer.key("call");
+            writeChainSide(writer, quote.callPrice, quote.call);
+            writer.key("put");
+            writeChainSide(writer, quote.putPrice, quote.put);
+            writer.key("strike");
+            writer.value(quote.strike);
+            writer.endObject();
+        }
+        writer.endArray();
+        writer.key("timeToExpiration");
+        writer.value(expiries[e]);
+        writer.endObject();
+    }
+    writer.endArray();
+    writer.key("riskFreeRate");
+    writer.value(query.riskFreeRate);
+    writer.key("spotPrice");
+    writer.value(market.spotPrice);
+    writer.key("symbol");
+    writer.value(symbol);
+    writer.key("volatility");
+    writer.value(market.volatility * 100.0);
+    writer.endObject();
+    
+    return writer.release();
+}
+
+/**
+ * Курсор страницы OHLCV: направление, время свечи и ее номер среди свечей с
+ * тем же временем ('a<ts>:<n>'). Номер делает курсор однозначным при
+ * повторяющихся timestamp.
+ */
+std::string ohlcvCursor(char direction, OHLCVView data, size_t index) {
+    int64_t timestamp = data[index].timestamp;
+    size_t offset = index - VolatilityCalculator::lowerBoundByTime(data, timestamp);
+    return direction + std::to_string(timestamp) + ":" + std::to_string(offset);
+}
+
+/**
+ * Позиция курсора в данных; без ':<n>' - первая свеча с этим временем
+ */
+bool resolveOHLCVCursor(const std::string& cursor, OHLCVView data, char& direction, size_t& index) {
+    if (cursor.size() < 2 || (cursor[0] != 'a' && cursor[0] != 'b')) {
+        return false;
+    }
+    direction = cursor[0];
+    std::string time = cursor.substr(1);
+    size_t offset = 0;
+    // Номер есть только после числового времени: даты вида "2024-01-01 10:00" тоже содержат ':'
+    size_t separator = time.rfind(':');
+    bool numbered = separator != std::string::npos && separator > 0 && separator + 1 < time.size() &&
+                    time.find_first_not_of("-0123456789") == separator &&
+                    time.find_first_not_of("0123456789", separator + 1) == std::string::npos;
+    if (numbered) {
+        offset = static_cast<size_t>(std::strtoull(time.c_str() + separator + 1, nullptr, 10));
+        time.resize(separator);
+    }
+    int64_t timestamp = 0;
+    if (!VolatilityCalculator::parseTimestamp(time, timestamp)) {
+        return false;
+    }
+    // Номер не выходит за серию свечей с этим временем (данные могли обновиться)
+    size_t first = VolatilityCalculator::lowerBoundByTime(data, timestamp);
+    size_t last = VolatilityCalculator::upperBoundByTime(data, timestamp);
+    index = first + std::min(offset, last - first);
+    return true;
+}
+
+/**
+ * Опционы стратегии из поля "options" запроса
+ */
+std::vector<Option> parseOptions(const json& request) {
+    std::vector<Option> options;
+    if (request.contains("options") && request["options"].is_array()) {
+        options.reserve(request["options"].size());
+        for (const auto& optJson : request["options"]) {
+            Option opt;
+            std::string typeStr = optJson.value("type", "call");
+            opt.type = (typeStr == "put") ? OptionType::PUT : OptionType::CALL;
+            
+            std::string posStr = optJson.value("position", "long");
+            opt.position = (posStr == "short") ? OptionPosition::SHORT : OptionPosition::LONG;
+            
+            opt.strike = optJson.value("strike", 100.0);
+            opt.premium = optJson.value("premium", 0.0);
+            opt.quantity = optJson.value("quantity", 1);
+            
+            options.push_back(opt);
+        }
+    }
+    return options;
+}
+
+/**
+ * Время из пакетного запроса: unix время числом или строкой, либо дата
+ */
+bool readBatchTime(const json& value, int64_t& timestamp) {
+    if (value.is_number_integer()) {
+        timestamp = value.get<int64_t>();
+        return true;
+    }
+    return value.is_string() && VolatilityCalculator::parseTimestamp(value.get<std::string>(), timestamp);
+}
+
+/**
+ * Распределение величины бэктеста
+ */
+json distributionJson(const DistributionStats& stats) {
+    json result;
+    result["count"] = stats.count;
+    result["mean"] = stats.mean;
+    result["stdDev"] = stats.stdDev;
+    result["min"] = stats.min;
+    result["max"] = stats.max;
+    result["p5"] = stats.p5;
+    result["p25"] = stats.p25;
+    result["p50"] = stats.p50;
+    result["p75"] = stats.p75;
+    result["p95"] = stats.p95;
+    return result;
+}
+
+/**
+ * Итоги бэктеста; PNL в деньгах есть только у итогов одного символа
+ */
+json backtestSummaryJson(const BacktestSummary& summary, bool withPnl) {
+    json result;
+    result["trades"] = summary.trades;
+    result["wins"] = summary.wins;
+    result["winRate"] = summary.winRate;
+    result["maxDrawdownReturn"] = summary.maxDrawdownReturn;
+    result["returns"] = distributionJson(summary.returns);
+    if (withPnl) {
+        result["totalPnl"] = summary.totalPnl;
+        result["maxDrawdown"] = summary.maxDrawdown;
+        result["pnl"] = distributionJson(summary.pnl);
+    }
+    return result;
+}
+
+/**
+ * Характеристика PNL: бесконечность (не ограничена) - null
+ */
+json boundJson(double value) {
+    return std::isinf(value) ? json(nullptr) : json(value);
+}
+
+/**
+ * Параметры модели выбранного типа (доли, годовые)
+ */
+json modelParamsJson(const FourierModel& model) {
+    json params;
+    switch (model.type) {
+        case FourierModelType::HESTON:
+            params["v0"] = model.v0;
+            params["kappa"] = model.kappa;
+            params["theta"] = model.theta;
+            params["xi"] = model.xi;
+            params["rho"] = model.rho;
+            break;
+        case FourierModelType::MERTON:
+            params["sigma"] = model.sigma;
+            params["lambda"] = model.lambda;
+            params["jumpMean"] = model.jumpMean;
+            params["jumpVolatility"] = model.jumpVolatility;
+            break;
+        case FourierModelType::KOU:
+            params["sigma"] = model.sigma;
+            params["lambda"] = model.lambda;
+            params["upProbability"] = model.upProbability;
+            params["upRate"] = model.upRate;
+            params["downRate"] = model.downRate;
+            break;
+    }
+    return params;
+}
+
+/**
+ * Параметры модели из запроса; отсутствующие остаются прежними
+ */
+void readModelParams(const json& params, FourierModel& model) {
+    model.v0 = params.value("v0", model.v0);
+    model.kappa = params.value("kappa", model.kappa);
+    model.theta = params.value("theta", model.theta);
+    model.xi = params.value("xi", model.xi);
+    model.rho = params.value("rho", model.rho);
+    model.sigma = params.value("sigma", model.sigma);
+    model.lambda = params.value("lambda", model.lambda);
+    model.jumpMean = params.value("jumpMean", model.jumpMean);
+    model.jumpVolatility = params.value("jumpVolatility", model.jumpVolatility);
+    model.upProbability = params.value("upProbability", model.upProbability);
+    model.upRate = params.value("upRate", model.upRate);
+    model.downRate = params.value("downRate", model.downRate);
+}
+
+/**
+ * Выполнение одной операции пакетного запроса (всегда возвращает JSON)
+ */
+std::string runBatchItem(APIHandler& handler, const json& item, const SeriesSnapshots& snapshots) {
+    json error;
+    if (!item.is_object() || !item.contains("op") || !item["op"].is_string()) {
+        error["error"] = "Invalid batch item: op is required";
+        return error.dump();
+    }
+    
+    std::string op = item["op"];
+    std::string body = item.contains("body") ? item["body"].dump() : std::string("{}");
+    std::string symbol = item.value("symbol", "");
+    
+    if (op == "calculate-option") {
+        return handler.handleCalculateOption(body);
+    }
+    if (op == "calculate-strategy") {
+        return handler.handleCalculateStrategy(body);
+    }
+    if (op == "calculate-greeks") {
+        return handler.handleCalculateGreeks(body);
+    }
+    if (op == "cache-stats") {
+        return handler.handleGetCacheStats();
+    }
+    
+    if (op != "volatility" && op != "price" && op != "ohlcv") {
+        error["error"] = "Unknown operation: " + op;
+        return error.dump();
+    }
+    if (symbol.empty()) {
+        error["error"] = "Symbol not specified";
+        return error.dump();
+    }
+    if (op == "volatility") {
+        return handler.handleGetVolatility(symbol, &snapshots);
+    }
+    if (op == "price") {
+        return handler.handleGetCurrentPrice(symbol, &snapshots);
+    }
+    
+    OHLCVQuery query;
+    query.limit = item.value("limit", query.limit);
+    query.maxPoints = item.value("maxPoints", query.maxPoints);
+    query.cursor = item.value("cursor", "");
+    if (item.contains("from")) {
+        query.hasFrom = readBatchTime(item["from"], query.from);
+        if (!query.hasFrom) {
+            error["error"] = "Invalid from: expected unix time or YYYY-MM-DD[ HH:MM:SS]";
+            return error.dump();
+        }
+    }
+    if (item.contains("to")) {
+        query.hasTo = readBatchTime(item["to"], query.to);
+        if (!query.hasTo) {
+            error["error"] = "Invalid to: expected unix time or YYYY-MM-DD[ HH:MM:SS]";
+            return error.dump();
+        }
+    }
+    return handler.handleGetOHLCV(symbol, query, ResponseFormat::JSON, &snapshots);
+}
+
+} // namespace
+
+void APIHandler::initialize(const std::string& dataDir, const SymbolCacheConfig& cacheConfig) {
     dataDirectory_ = dataDir;
-    ohlcvCache_.clear();
+    ohlcvCache_.configure(cacheConfig);
+    ohlcvCache_.setLoader([this](const std::string& symbol) {
+        return readOHLCVFromDisk(symbol);
+    });
 }
 
 std::string APIHandler::symbolToFilename(const std::string& symbol) {
@@ -23,33 +555,135 @@ std::string APIHandler::getDataFilePath(const std::string& symbol) {
     return dataDirectory_ + "/" + filename;
 }
 
-std::vector<OHLCV> APIHandler::loadOHLCVForSymbol(const std::string& symbol) {
-    // Проверяем кэш
-    auto it = ohlcvCache_.find(symbol);
-    if (it != ohlcvCache_.end()) {
-        return it->second;
+OHLCVSeriesPtr APIHandler::loadOHLCVForSymbol(const std::string& symbol, const SeriesSnapshots* snapshots) {
+    if (snapshots != nullptr) {
+        auto it = snapshots->find(symbol);
+        if (it != snapshots->end()) {
+            return it->second;
+        }
     }
     
+    // Попадание стоит только копии shared_ptr, промахи объединяются в кэше
+    return ohlcvCache_.get(symbol);
+}
+
+OHLCVSeriesPtr APIHandler::readOHLCVFromDisk(const std::string& symbol) {
+    TraceStage stage("disk");
+    auto started = std::chrono::steady_clock::now();
+    
     // Загружаем из файла
+    auto series = std::make_shared<OHLCVSeries>();
     std::string filepath = getDataFilePath(symbol);
-    std::vector<OHLCV> data = VolatilityCalculator::loadOHLCVFromCSV(filepath);
+    series->candles = VolatilityCalculator::loadOHLCVFromCSV(filepath);
     
     // Если файл не найден, пробуем альтернативные варианты имен
-    if (data.empty()) {
+    if (series->candles.empty()) {
         // Пробуем заменить _ на /
         std::string altSymbol = symbol;
         std::replace(altSymbol.begin(), altSymbol.end(), '_', '/');
-        std::string altFilepath = getDataFilePath(altSymbol);
-        data = VolatilityCalculator::loadOHLCVFromCSV(altFilepath);
+        filepath = getDataFilePath(altSymbol);
+        series->candles = VolatilityCalculator::loadOHLCVFromCSV(filepath);
+    }
+    
+    // Версия снимка: время изменения и размер файла плюс последняя свеча
+    // (перезапись файла в ту же секунду того же размера меняет последнюю свечу)
+    if (!series->candles.empty()) {
+        struct stat info;
+        uint64_t version = HttpCaching::hash(&series->candles.back().timestamp, sizeof(int64_t));
+        if (::stat(filepath.c_str(), &info) == 0) {
+            int64_t modified = static_cast<int64_t>(info.st_mtime);
+            int64_t size = static_cast<int64_t>(info.st_size);
+            series->modifiedTime = modified;
+            version = HttpCaching::hash(&modified, sizeof(modified), version);
+            version = HttpCaching::hash(&size, sizeof(size), version);
+        }
+        const OHLCV& last = series->candles.back();
+        const double values[] = {last.open, last.high, last.low, last.close, last.volume};
+        uint64_t count = series->candles.size();
+        version = HttpCaching::hash(values, sizeof(values), version);
+        series->version = HttpCaching::hash(&count, sizeof(count), version);
     }
     
-    // Кэшируем
-    ohlcvCache_[symbol] = data;
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started);
+    Metrics::global().recordDataLoad(static_cast<uint64_t>(elapsed.count()), !series->candles.empty());
     
-    return data;
+    return series;
+}
+
+ArenaVector<std::pair<double, double>> APIHandler::buildPayoffCurve(
+    const std::vector<Option>& options,
+    double minPrice,
+    double maxPrice,
+    int numPoints
+) {
+    // Меньше ~64k оценок payoff распараллеливать невыгодно
+    const size_t parallelThreshold = 1 << 16;
+    size_t points = static_cast<size_t>(std::max(numPoints, 0));
+    size_t legs = std::max<size_t>(options.size(), 1);
+    
+    ArenaVector<std::pair<double, double>> curve(points);
+    double step = points > 1 ? (maxPrice - minPrice) / (numPoints - 1) : 0.0;
+    size_t grain = std::max<size_t>(parallelThreshold / legs, 1);
+    
+    // Срок запроса проверяется между частями: после отмены кривая не досчитывается
+    const RequestDeadline* deadline = RequestDeadline::current();
+    auto evaluate = [&](size_t begin, size_t end) {
+        for (size_t lo = begin; lo < end; lo += grain) {
+            if (deadline != nullptr) {
+                deadline->check();
+            }
+            OptionPricing::evaluatePayoffRange(options, minPrice, step, lo, std::min(lo + grain, end), curve.data());
+        }
+    };
+    
+    if (computePool_ == nullptr || points * legs < parallelThreshold) {
+        evaluate(0, points);
+    } else {
+        computePool_->parallelFor(0, points, grain, evaluate);
+    }
+    
+    return curve;
+}
+
+ArenaVector<Greeks> APIHandler::buildGreeksProfile(
+    const std::vector<Option>& options,
+    const MarketParams& market,
+    const ArenaVector<std::pair<double, double>>& curve
+) {
+    // Оценка греков ноги на порядок дороже payoff: порог распараллеливания ниже
+    const size_t parallelThreshold = 1 << 12;
+    size_t points = curve.size();
+    size_t legs = std::max<size_t>(options.size(), 1);
+    
+    ArenaVector<double> spots(points);
+    for (size_t i = 0; i < points; ++i) {
+        spots[i] = curve[i].first;
+    }
+    ArenaVector<Greeks> profile(points);
+    size_t grain = std::max<size_t>(parallelThreshold / legs, 1);
+    
+    const RequestDeadline* deadline = RequestDeadline::current();
+    auto evaluate = [&](size_t begin, size_t end) {
+        for (size_t lo = begin; lo < end; lo += grain) {
+            if (deadline != nullptr) {
+                deadline->check();
+            }
+            size_t hi = std::min(lo + grain, end);
+            OptionPricing::evaluateGreeksProfile(options, market, spots.data() + lo, hi - lo, profile.data() + lo);
+        }
+    };
+    
+    if (computePool_ == nullptr || points * legs < parallelThreshold) {
+        evaluate(0, points);
+    } else {
+        computePool_->parallelFor(0, points, grain, evaluate);
+    }
+    
+    return profile;
 }
 
 std::string APIHandler::handleCalculateOption(const std::string& requestBody) {
+    ArenaScope arena;
     try {
         json request = json::parse(requestBody);
         
@@ -92,33 +726,48 @@ std::string APIHandler::handleCalculateOption(const std::string& requestBody) {
     }
 }
 
-std::string APIHandler::handleCalculateStrategy(const std::string& requestBody) {
+std::string APIHandler::handleCalculateStrategy(const std::string& requestBody, ResponseFormat format) {
+    ArenaScope arena;
     try {
+        TraceStage parseStage("parse");
         json request = json::parse(requestBody);
+        parseStage.stop();
         
         // Парсим опционы
-        std::vector<Option> options;
-        if (request.contains("options") && request["options"].is_array()) {
-            for (const auto& optJson : request["options"]) {
-                Option opt;
-                std::string typeStr = optJson.value("type", "call");
-                opt.type = (typeStr == "put") ? OptionType::PUT : OptionType::CALL;
-                
-                std::string posStr = optJson.value("position", "long");
-                opt.position = (posStr == "short") ? OptionPosition::SHORT : OptionPosition::LONG;
-                
-                opt.strike = optJson.value("strike", 100.0);
-                opt.premium = optJson.value("premium", 0.0);
-                opt.quantity = optJson.value("quantity", 1);
-                
-                options.push_back(opt);
-            }
-        }
+        TraceStage optionsStage("options");
+        std::vector<Option> options = parseOptions(request);
+        optionsStage.stop();
         
         // Параметры для графика
         double minPrice = request.value("minPrice", 0.0);
         double maxPrice = request.value("maxPrice", 200.0);
-        int numPoints = request.value("numPoints", 200);
+        int64_t requestedPoints = request.value("numPoints", int64_t(200));
+        int maxPoints = request.value("maxPoints", 0);
+        bool profile = request.value("profile", false);
+        bool analyze = request.value("analysis", false);
+        
+        if ((format == ResponseFormat::PACKED_F64 || format == ResponseFormat::PACKED_F32) && analyze) {
+            json error;
+            error["error"] = "Packed columns are not supported for strategy analysis";
+            return encodeDocument(error, format);
+        }
+        if (requestedPoints < 2 || requestedPoints > MAX_PAYOFF_POINTS) {
+            json error;
+            error["error"] = "Invalid numPoints: must be between 2 and " + std::to_string(MAX_PAYOFF_POINTS);
+            return encodeDocument(error, format);
+        }
+        int numPoints = static_cast<int>(requestedPoints);
+        if (maxPoints != 0 && (maxPoints < 3 || maxPoints > MAX_PAYOFF_POINTS)) {
+            json error;
+            error["error"] = "Invalid maxPoints: must be 0 (no downsampling) or between 3 and " +
+                             std::to_string(MAX_PAYOFF_POINTS);
+            return encodeDocument(error, format);
+        }
+        if (options.size() > MAX_STRATEGY_LEGS) {
+            json error;
+            error["error"] = "Too many options: at most " + std::to_string(MAX_STRATEGY_LEGS) + " legs per strategy";
+            return encodeDocument(error, format);
+        }
         
         // Автоматически определяем диапазон цен если не задан
         if (minPrice <= 0 || maxPrice <= minPrice) {
@@ -141,34 +790,158 @@ std::string APIHandler::handleCalculateStrategy(const std::string& requestBody)
         }
         
         // Генерируем кривую payoff
-        auto curve = OptionPricing::generatePayoffCurve(options, minPrice, maxPrice, numPoints);
+        TraceStage payoffStage("payoff");
+        auto curve = buildPayoffCurve(options, minPrice, maxPrice, numPoints);
+        payoffStage.stop();
         
-        // Формируем ответ
-        json response;
-        json curveData = json::array();
+        // Прореживание до разрешения графика
+        if (maxPoints > 0) {
+            TraceStage downsampleStage("downsample");
+            ArenaVector<std::pair<double, double>> sampled(
+                Downsampling::sampledCapacity(curve.size(), static_cast<size_t>(maxPoints)));
+            sampled.resize(Downsampling::largestTriangleThreeBuckets(
+                curve.data(), curve.size(), static_cast<size_t>(maxPoints), sampled.data()));
+            curve.swap(sampled);
+        }
         
-        for (const auto& point : curve) {
-            json pointJson;
-            pointJson["price"] = point.first;
-            pointJson["pnl"] = point.second;
-            curveData.push_back(pointJson);
+        // Профиль греков - в ценах итоговой (прореженной) кривой
+        ArenaVector<Greeks> greeks;
+        if (profile) {
+            MarketParams market;
+            market.timeToExpiration = request.value("timeToExpiration", 30.0) / 365.0;
+            market.volatility = request.value("volatility", 20.0) / 100.0;
+            market.riskFreeRate = request.value("riskFreeRate", 5.0) / 100.0;
+            market.dividendYield = request.value("dividendYield", 0.0) / 100.0;
+            if (market.timeToExpiration < 0 || market.volatility < 0) {
+                json error;
+                error["error"] = "Invalid profile parameters: timeToExpiration and volatility must not be negative";
+                return encodeDocument(error, format);
+            }
+            for (const auto& option : options) {
+                if (option.strike <= 0) {
+                    json error;
+                    error["error"] = "Invalid profile parameters: strikes must be positive";
+                    return encodeDocument(error, format);
+                }
+            }
+            TraceStage greeksStage("greeks");
+            greeks = buildGreeksProfile(options, market, curve);
         }
+        const Greeks* profileGreeks = profile ? greeks.data() : nullptr;
+        size_t pointScale = profile ? 3 : 1;
         
-        response["curve"] = curveData;
-        response["numPoints"] = curve.size();
-        response["minPrice"] = minPrice;
-        response["maxPrice"] = maxPrice;
+        // Анализ PNL на экспирации: точное интегрирование по логнормальному
+        // распределению и, если задан символ, по его историческим доходностям
+        StrategyAnalysis analysis;
+        if (analyze) {
+            // Первый участок кривой идет от нуля до меньшего страйка: нулевой страйк дает NaN
+            for (const auto& option : options) {
+                if (option.strike <= 0) {
+                    json error;
+                    error["error"] = "Invalid analysis parameters: strikes must be positive";
+                    return encodeDocument(error, format);
+                }
+            }
+            OHLCVSeriesPtr series;
+            if (request.contains("symbol")) {
+                series = loadOHLCVForSymbol(request["symbol"].get<std::string>());
+                if (series->empty()) {
+                    json error;
+                    error["error"] = "No data found for symbol: " + request["symbol"].get<std::string>();
+                    return encodeDocument(error, format);
+                }
+            }
+            analysis.spotPrice = request.contains("spotPrice") ? request["spotPrice"].get<double>()
+                : series ? VolatilityCalculator::getCurrentPrice(series->view()) : 0.0;
+            analysis.volatility = request.contains("volatility") ? request["volatility"].get<double>() / 100.0
+                : series ? VolatilityCalculator::calculateHistoricalVolatility(series->view(), 30) : 0.2;
+            analysis.timeToExpiration = request.value("timeToExpiration", 30.0);
+            analysis.shortfallLevel = request.value("shortfallLevel", 5.0) / 100.0;
+            double riskFreeRate = request.value("riskFreeRate", 5.0) / 100.0;
+            double dividendYield = request.value("dividendYield", 0.0) / 100.0;
+            if (!(analysis.spotPrice > 0) || !(analysis.timeToExpiration > 0) || analysis.volatility < 0 ||
+                !(analysis.shortfallLevel > 0 && analysis.shortfallLevel < 1)) {
+                json error;
+                error["error"] = "Invalid analysis parameters: spotPrice (or symbol) and timeToExpiration must be "
+                                 "positive, shortfallLevel between 0 and 100";
+                return encodeDocument(error, format);
+            }
+            
+            TraceStage analysisStage("analysis");
+            PayoffShape shape;
+            PayoffAnalysis::buildShape(options.data(), options.size(), shape);
+            LognormalDistribution lognormal(analysis.spotPrice, analysis.volatility, analysis.timeToExpiration / 365.0,
+                                            riskFreeRate, dividendYield);
+            PayoffAnalysis::bounds(shape, analysis.lognormal);
+            PayoffAnalysis::integrate(shape, lognormal, analysis.lognormal);
+            PayoffAnalysis::shortfall(shape, lognormal, analysis.shortfallLevel, analysis.lognormal);
+            if (series) {
+                EmpiricalDistribution empirical = EmpiricalDistribution::fromHistory(
+                    series->view(), analysis.spotPrice, analysis.timeToExpiration);
+                if (empirical.size() < 30) {
+                    json error;
+                    error["error"] = "Not enough history for timeToExpiration returns of symbol: " +
+                                     request["symbol"].get<std::string>();
+                    return encodeDocument(error, format);
+                }
+                analysis.hasEmpirical = true;
+                analysis.samples = empirical.size();
+                analysis.empirical = analysis.lognormal;
+                PayoffAnalysis::integrate(shape, empirical, analysis.empirical);
+                PayoffAnalysis::shortfall(shape, empirical, analysis.shortfallLevel, analysis.empirical);
+            }
+        }
+        const StrategyAnalysis* strategyAnalysis = analyze ? &analysis : nullptr;
         
-        return response.dump();
+        // Формируем ответ потоково в согласованном формате
+        TraceStage serializeStage("serialize");
+        switch (format) {
+            case ResponseFormat::CBOR: {
+                CborWriter writer(curve.size() * 24 * pointScale + 64);
+                return writeStrategyResponse(writer, curve, profileGreeks, strategyAnalysis, minPrice, maxPrice);
+            }
+            case ResponseFormat::MSGPACK: {
+                MsgPackWriter writer(curve.size() * 24 * pointScale + 64);
+                return writeStrategyResponse(writer, curve, profileGreeks, strategyAnalysis, minPrice, maxPrice);
+            }
+            case ResponseFormat::PACKED_F64:
+            case ResponseFormat::PACKED_F32: {
+                bool f32 = format == ResponseFormat::PACKED_F32;
+                if (!profile) {
+                    ColumnarWriter writer(f32, curve.size(), {"price", "pnl"});
+                    writer.column([&](size_t i) { return curve[i].first; });
+                    writer.column([&](size_t i) { return curve[i].second; });
+                    return writer.release();
+                }
+                ColumnarWriter writer(f32, curve.size(), {"price", "pnl", "delta", "gamma", "theta", "vega", "rho"});
+                writer.column([&](size_t i) { return curve[i].first; });
+                writer.column([&](size_t i) { return curve[i].second; });
+                writer.column([&](size_t i) { return greeks[i].delta; });
+                writer.column([&](size_t i) { return greeks[i].gamma; });
+                writer.column([&](size_t i) { return greeks[i].theta; });
+                writer.column([&](size_t i) { return greeks[i].vega; });
+                writer.column([&](size_t i) { return greeks[i].rho; });
+                return writer.release();
+            }
+            case ResponseFormat::JSON:
+            default: {
+                JsonWriter writer(curve.size() * 48 * pointScale + 96);
+                return writeStrategyResponse(writer, curve, profileGreeks, strategyAnalysis, minPrice, maxPrice);
+            }
+        }
         
+    } catch (const DeadlineExceeded&) {
+        // Отмену обрабатывает сервер (504), а не тело с ошибкой
+        throw;
     } catch (const std::exception& e) {
         json error;
         error["error"] = std::string("Invalid request: ") + e.what();
-        return error.dump();
+        return encodeDocument(error, format);
     }
 }
 
 std::string APIHandler::handleCalculateGreeks(const std::string& requestBody) {
+    ArenaScope arena;
     try {
         json request = json::parse(requestBody);
         
@@ -207,9 +980,10 @@ std::string APIHandler::handleCalculateGreeks(const std::string& requestBody) {
     }
 }
 
-std::string APIHandler::handleGetVolatility(const std::string& symbol) {
+std::string APIHandler::handleGetVolatility(const std::string& symbol, const SeriesSnapshots* snapshots) {
     try {
-        std::vector<OHLCV> data = loadOHLCVForSymbol(symbol);
+        OHLCVSeriesPtr series = loadOHLCVForSymbol(symbol, snapshots);
+        OHLCVView data = series->view();
         
         if (data.empty()) {
             json error;
@@ -236,9 +1010,10 @@ std::string APIHandler::handleGetVolatility(const std::string& symbol) {
     }
 }
 
-std::string APIHandler::handleGetCurrentPrice(const std::string& symbol) {
+std::string APIHandler::handleGetCurrentPrice(const std::string& symbol, const SeriesSnapshots* snapshots) {
     try {
-        std::vector<OHLCV> data = loadOHLCVForSymbol(symbol);
+        OHLCVSeriesPtr series = loadOHLCVForSymbol(symbol, snapshots);
+        OHLCVView data = series->view();
         
         if (data.empty()) {
             json error;
@@ -262,45 +1037,1427 @@ std::string APIHandler::handleGetCurrentPrice(const std::string& symbol) {
     }
 }
 
-std::string APIHandler::handleGetOHLCV(const std::string& symbol, int limit) {
+std::string APIHandler::handleGetOHLCV(
+    const std::string& symbol,
+    const OHLCVQuery& query,
+    ResponseFormat format,
+    const SeriesSnapshots* snapshots
+) {
+    try {
+        if (query.limit <= 0 || query.limit > MAX_OHLCV_LIMIT) {
+            json error;
+            error["error"] = "Invalid limit: must be between 1 and " + std::to_string(MAX_OHLCV_LIMIT);
+            return encodeDocument(error, format);
+        }
+        if (query.maxPoints < 0 || query.maxPoints > MAX_OHLCV_LIMIT) {
+            json error;
+            error["error"] = "Invalid maxPoints: must be between 1 and " + std::to_string(MAX_OHLCV_LIMIT);
+            return encodeDocument(error, format);
+        }
+        if (query.hasFrom && query.hasTo && query.from > query.to) {
+            json error;
+            error["error"] = "Invalid range: from must not be after to";
+            return encodeDocument(error, format);
+        }
+        
+        OHLCVSeriesPtr series = loadOHLCVForSymbol(symbol, snapshots);
+        OHLCVView data = series->view();
+        
+        if (data.empty()) {
+            json error;
+            error["error"] = "No data found for symbol: " + symbol;
+            return encodeDocument(error, format);
+        }
+        
+        // Границы окна [lo, hi) бинарным поиском по времени
+        size_t lo = query.hasFrom ? VolatilityCalculator::lowerBoundByTime(data, query.from) : 0;
+        size_t hi = query.hasTo ? VolatilityCalculator::upperBoundByTime(data, query.to) : data.size();
+        hi = std::max(lo, hi);
+        size_t limit = static_cast<size_t>(query.limit);
+        
+        // Курсор: 'a<ts>:<n>' - страница начиная со свечи, 'b<ts>:<n>' - страница перед ней
+        bool forward = query.hasFrom;
+        size_t begin = lo;
+        size_t end = hi;
+        if (!query.cursor.empty()) {
+            char direction = 'a';
+            size_t cursorIndex = 0;
+            if (!resolveOHLCVCursor(query.cursor, data, direction, cursorIndex)) {
+                json error;
+                error["error"] = "Invalid cursor";
+                return encodeDocument(error, format);
+            }
+            size_t pivot = std::min(std::max(cursorIndex, lo), hi);
+            forward = direction == 'a';
+            if (forward) {
+                begin = pivot;
+            } else {
+                end = pivot;
+            }
+        }
+        
+        // С maxPoints окно агрегируется целиком, иначе отрезаем страницу
+        std::vector<OHLCV> aggregated;
+        if (query.maxPoints == 0) {
+            if (forward) {
+                end = std::min(end, begin + limit);
+            } else {
+                begin = end - std::min(end - begin, limit);
+            }
+        }
+        
+        OHLCVView page(data.data() + begin, end - begin);
+        if (query.maxPoints > 0 && page.size() > static_cast<size_t>(query.maxPoints)) {
+            aggregated = Downsampling::aggregateCandles(page, static_cast<size_t>(query.maxPoints));
+            page = OHLCVView(aggregated);
+        }
+        
+        std::string nextCursor = end < hi ? ohlcvCursor('a', data, end) : std::string();
+        std::string prevCursor = begin > lo ? ohlcvCursor('b', data, begin) : std::string();
+        
+        // Формируем ответ потоково в согласованном формате
+        switch (format) {
+            case ResponseFormat::CBOR: {
+                CborWriter writer(page.size() * 96 + 96);
+                return writeOHLCVResponse(writer, symbol, page, nextCursor, prevCursor);
+            }
+            case ResponseFormat::MSGPACK: {
+                MsgPackWriter writer(page.size() * 96 + 96);
+                return writeOHLCVResponse(writer, symbol, page, nextCursor, prevCursor);
+            }
+            case ResponseFormat::PACKED_F64:
+            case ResponseFormat::PACKED_F32: {
+                ColumnarWriter writer(format == ResponseFormat::PACKED_F32, page.size(),
+                                      {"timestamp", "open", "high", "low", "close", "volume"});
+                writer.column([&](size_t i) { return page[i].timestamp; });
+                writer.column([&](size_t i) { return page[i].open; });
+                writer.column([&](size_t i) { return page[i].high; });
+                writer.column([&](size_t i) { return page[i].low; });
+                writer.column([&](size_t i) { return page[i].close; });
+                writer.column([&](size_t i) { return page[i].volume; });
+                return writer.release();
+            }
+            case ResponseFormat::JSON:
+            default: {
+                JsonWriter writer(page.size() * 160 + 128);
+                return writeOHLCVResponse(writer, symbol, page, nextCursor, prevCursor);
+            }
+        }
+        
+    } catch (const std::exception& e) {
+        json error;
+        error["error"] = std::string("Error: ") + e.what();
+        return encodeDocument(error, format);
+    }
+}
+
+std::string APIHandler::handleGetOptionChain(
+    const std::string& symbol,
+    const OptionChainQuery& query,
+    ResponseFormat format,
+    const SeriesSnapshots* snapshots
+) {
+    ArenaScope arena;
+    try {
+        if (format == ResponseFormat::PACKED_F64 || format == ResponseFormat::PACKED_F32) {
+            json error;
+            error["error"] = "Packed columns are not supported for option chains";
+            return encodeDocument(error, format);
+        }
+        
+        OHLCVSeriesPtr series = loadOHLCVForSymbol(symbol, snapshots);
+        OHLCVView data = series->view();
+        
+        if (data.empty()) {
+            json error;
+            error["error"] = "No data found for symbol: " + symbol;
+            return encodeDocument(error, format);
+        }
+        
+        MarketParams market;
+        market.spotPrice = VolatilityCalculator::getCurrentPrice(data);
+        market.volatility = query.hasVolatility ? query.volatility / 100.0
+                                                : VolatilityCalculator::calculateHistoricalVolatility(data, 30);
+        market.riskFreeRate = query.riskFreeRate / 100.0;
+        market.dividendYield = query.dividendYield / 100.0;
+        if (market.spotPrice <= 0) {
+            json error;
+            error["error"] = "Invalid current price for symbol: " + symbol;
+            return encodeDocument(error, format);
+        }
+        
+        // Страйки по возрастанию; ln(S/K) общий для всех экспираций
+        TraceStage chainStage("chain");
+        double scale = query.relative ? market.spotPrice : 1.0;
+        ArenaVector<double> strikes;
+        if (!query.strikes.empty()) {
+            strikes.reserve(query.strikes.size());
+            for (double strike : query.strikes) {
+                strikes.push_back(strike * scale);
+            }
+            std::sort(strikes.begin(), strikes.end());
+        } else {
+            size_t count = static_cast<size_t>(query.numStrikes);
+            strikes.reserve(count);
+            double step = count > 1 ? (query.maxStrike - query.minStrike) / static_cast<double>(count - 1) : 0.0;
+            for (size_t i = 0; i < count; ++i) {
+                strikes.push_back((query.minStrike + step * static_cast<double>(i)) * scale);
+            }
+        }
+        ArenaVector<double> logMoneyness(strikes.size());
+        for (size_t i = 0; i < strikes.size(); ++i) {
+            logMoneyness[i] = std::log(market.spotPrice / strikes[i]);
+        }
+        
+        ArenaVector<double> expiries(query.expiries.begin(), query.expiries.end());
+        std::sort(expiries.begin(), expiries.end());
+        ArenaVector<ChainQuote> quotes(expiries.size() * strikes.size());
+        for (size_t e = 0; e < expiries.size(); ++e) {
+            market.timeToExpiration = expiries[e] / 365.0;
+            OptionPricing::calculateChain(market, strikes.data(), logMoneyness.data(), strikes.size(),
+                                          quotes.data() + e * strikes.size());
+        }
+        chainStage.stop();
+        
+        TraceStage serializeStage("serialize");
+        switch (format) {
+            case ResponseFormat::CBOR: {
+                CborWriter writer(quotes.size() * 160 + 128);
+                return writeOptionChainResponse(writer, symbol, query, market, expiries, quotes, strikes.size());
+            }
+            case ResponseFormat::MSGPACK: {
+                MsgPackWriter writer(quotes.size() * 160 + 128);
+                return writeOptionChainResponse(writer, symbol, query, market, expiries, quotes, strikes.size());
+            }
+            case ResponseFormat::JSON:
+            default: {
+                JsonWriter writer(quotes.size() * 320 + 192);
+                return writeOptionChainResponse(writer, symbol, query, market, expiries, quotes, strikes.size());
+            }
+        }
+        
+    } catch (const std::exception& e) {
+        json error;
+        error["error"] = std::string("Error: ") + e.what();
+        return encodeDocument(error, format);
+    }
+}
+
+std::string APIHandler::handleBatch(const std::string& requestBody) {
+    ArenaScope arena;
+    try {
+        json request = json::parse(requestBody);
+        const json& items = request.is_array() ? request : request.at("requests");
+        
+        if (!items.is_array() || items.empty() || items.size() > MAX_BATCH_ITEMS) {
+            json error;
+            error["error"] = "Invalid batch: requests must contain 1 to " + std::to_string(MAX_BATCH_ITEMS) + " operations";
+            return error.dump();
+        }
+        
+        // Независимые части выполняются на пуле, без пула - по очереди.
+        // Срок запроса переносится в потоки пула.
+        const RequestDeadline* deadline = RequestDeadline::current();
+        auto forEach = [this, deadline](size_t count, const std::function<void(size_t)>& fn) {
+            if (computePool_ != nullptr && count > 1) {
+                computePool_->parallelFor(0, count, 1, [&fn, deadline](size_t lo, size_t hi) {
+                    DeadlineScope scope(deadline);
+                    for (size_t i = lo; i < hi; ++i) {
+                        fn(i);
+                    }
+                });
+            } else {
+                for (size_t i = 0; i < count; ++i) {
+                    fn(i);
+                }
+            }
+        };
+        
+        // Данные каждого символа загружаются один раз и закрепляются на весь пакет,
+        // чтобы вытеснение из кэша между операциями не вызвало повторного чтения
+        std::vector<std::string> symbols;
+        for (const auto& item : items) {
+            if (item.is_object() && item.contains("symbol") && item["symbol"].is_string()) {
+                std::string symbol = item["symbol"];
+                if (std::find(symbols.begin(), symbols.end(), symbol) == symbols.end()) {
+                    symbols.push_back(symbol);
+                }
+            }
+        }
+        
+        std::vector<OHLCVSeriesPtr> loaded(symbols.size());
+        forEach(symbols.size(), [&](size_t i) {
+            try {
+                loaded[i] = loadOHLCVForSymbol(symbols[i]);
+            } catch (const std::exception&) {
+                // Ошибку вернет сама операция при повторной попытке
+            }
+        });
+        
+        SeriesSnapshots snapshots;
+        for (size_t i = 0; i < symbols.size(); ++i) {
+            if (loaded[i]) {
+                snapshots.emplace(symbols[i], std::move(loaded[i]));
+            }
+        }
+        
+        std::vector<std::string> results(items.size());
+        forEach(items.size(), [&](size_t i) {
+            try {
+                if (deadline != nullptr) {
+                    deadline->check();
+                }
+                results[i] = runBatchItem(*this, items[i], snapshots);
+            } catch (const DeadlineExceeded&) {
+                throw;   // Срок истек у всего пакета, а не у операции
+            } catch (const std::exception& e) {
+                json error;
+                error["error"] = std::string("Error: ") + e.what();
+                results[i] = error.dump();
+            }
+        });
+        
+        size_t total = 32;
+        for (const auto& result : results) {
+            total += result.size() + 1;
+        }
+        
+        JsonWriter writer(total);
+        writer.beginObject();
+        writer.key("count");
+        writer.value(results.size());
+        writer.key("results");
+        writer.beginArray();
+        for (const auto& result : results) {
+            writer.raw(result);
+        }
+        writer.endArray();
+        writer.endObject();
+        
+        return writer.release();
+        
+    } catch (const DeadlineExceeded&) {
+        // Отмену обрабатывает сервер (504), а не тело с ошибкой
+        throw;
+    } catch (const std::exception& e) {
+        json error;
+        error["error"] = std::string("Invalid request: ") + e.what();
+        return error.dump();
+    }
+}
+
+std::string APIHandler::handleBacktest(const std::string& requestBody) {
+    ArenaScope arena;
+    try {
+        TraceStage parseStage("parse");
+        json request = json::parse(requestBody);
+        parseStage.stop();
+        
+        std::vector<std::string> symbols;
+        if (request.contains("symbols") && request["symbols"].is_array()) {
+            for (const auto& symbol : request["symbols"]) {
+                symbols.push_back(symbol.get<std::string>());
+            }
+        } else if (request.contains("symbol")) {
+            symbols.push_back(request["symbol"].get<std::string>());
+        }
+        if (symbols.empty() || symbols.size() > MAX_BACKTEST_SYMBOLS) {
+            json error;
+            error["error"] = "Invalid symbols: expected 1 to " + std::to_string(MAX_BACKTEST_SYMBOLS) + " symbols";
+            return error.dump();
+        }
+        
+        BacktestConfig config;
+        if (request.contains("legs") && request["legs"].is_array()) {
+            for (const auto& legJson : request["legs"]) {
+                BacktestLeg leg;
+                leg.type = legJson.value("type", "call") == "put" ? OptionType::PUT : OptionType::CALL;
+                leg.position = legJson.value("position", "long") == "short" ? OptionPosition::SHORT : OptionPosition::LONG;
+                leg.moneyness = legJson.value("moneyness", 1.0);
+                leg.quantity = legJson.value("quantity", 1);
+                if (leg.moneyness <= 0) {
+                    json error;
+                    error["error"] = "Invalid leg: moneyness must be positive";
+                    return error.dump();
+                }
+                config.legs.push_back(leg);
+            }
+        }
+        if (config.legs.empty() || config.legs.size() > MAX_STRATEGY_LEGS) {
+            json error;
+            error["error"] = "Invalid legs: expected 1 to " + std::to_string(MAX_STRATEGY_LEGS) + " legs";
+            return error.dump();
+        }
+        
+        config.expiryDays = request.value("timeToExpiration", 30.0);
+        config.rollDays = request.value("rollEvery", 7.0);
+        config.volatilityPeriod = request.value("volatilityPeriod", 30);
+        config.riskFreeRate = request.value("riskFreeRate", 5.0) / 100.0;
+        config.dividendYield = request.value("dividendYield", 0.0) / 100.0;
+        if (!(config.expiryDays > 0) || !(config.rollDays > 0) ||
+            config.volatilityPeriod < 2 || config.volatilityPeriod > 10000) {
+            json error;
+            error["error"] = "Invalid parameters: timeToExpiration and rollEvery must be positive, "
+                             "volatilityPeriod between 2 and 10000";
+            return error.dump();
+        }
+        if (request.contains("from")) {
+            config.hasFrom = readBatchTime(request["from"], config.from);
+        }
+        if (request.contains("to")) {
+            config.hasTo = readBatchTime(request["to"], config.to);
+        }
+        if ((request.contains("from") && !config.hasFrom) || (request.contains("to") && !config.hasTo)) {
+            json error;
+            error["error"] = "Invalid from/to: expected unix time or YYYY-MM-DD[ HH:MM:SS]";
+            return error.dump();
+        }
+        bool includeTrades = request.value("includeTrades", false);
+        
+        // Независимые части выполняются на пуле, без пула - по очереди.
+        // Срок запроса переносится в потоки пула.
+        const RequestDeadline* deadline = RequestDeadline::current();
+        auto forEach = [this, deadline](size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn) {
+            if (computePool_ != nullptr && count > grain) {
+                computePool_->parallelFor(0, count, grain, [&fn, deadline](size_t lo, size_t hi) {
+                    DeadlineScope scope(deadline);
+                    if (deadline != nullptr) {
+                        deadline->check();
+                    }
+                    fn(lo, hi);
+                });
+            } else if (count > 0) {
+                fn(0, count);
+            }
+        };
+        
+        // Данные, скользящая волатильность (один проход по истории) и окна каждого символа
+        struct SymbolRun {
+            OHLCVSeriesPtr series;
+            std::unique_ptr<RollingVolatility> volatility;
+            std::vector<BacktestWindow> windows;
+            std::string error;
+        };
+        std::vector<SymbolRun> runs(symbols.size());
+        TraceStage prepareStage("prepare");
+        forEach(symbols.size(), 1, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i) {
+                SymbolRun& run = runs[i];
+                try {
+                    run.series = loadOHLCVForSymbol(symbols[i]);
+                } catch (const std::exception& e) {
+                    run.error = std::string("Error: ") + e.what();
+                    continue;
+                }
+                if (run.series->empty()) {
+                    run.error = "No data found for symbol: " + symbols[i];
+                    continue;
+                }
+                run.volatility = std::make_unique<RollingVolatility>(run.series->view());
+                run.windows = Backtester::scheduleWindows(run.series->view(), config);
+            }
+        });
+        prepareStage.stop();
+        
+        // Окна всех символов - один плоский диапазон для параллельного цикла
+        std::vector<size_t> offsets(symbols.size() + 1, 0);
+        for (size_t i = 0; i < symbols.size(); ++i) {
+            offsets[i + 1] = offsets[i] + runs[i].windows.size();
+        }
+        std::vector<BacktestTrade> trades(offsets.back());
+        
+        TraceStage windowsStage("backtest");
+        forEach(trades.size(), 256, [&](size_t lo, size_t hi) {
+            size_t run = static_cast<size_t>(std::upper_bound(offsets.begin(), offsets.end(), lo) - offsets.begin()) - 1;
+            for (size_t i = lo; i < hi; ++i) {
+                while (i >= offsets[run + 1]) {
+                    ++run;
+                }
+                const SymbolRun& symbolRun = runs[run];
+                trades[i] = Backtester::runWindow(symbolRun.series->view(), *symbolRun.volatility, config,
+                                                  symbolRun.windows[i - offsets[run]]);
+            }
+        });
+        windowsStage.stop();
+        
+        std::vector<BacktestSummary> summaries(symbols.size());
+        forEach(symbols.size(), 1, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i) {
+                summaries[i] = Backtester::summarize(trades.data() + offsets[i], runs[i].windows.size());
+            }
+        });
+        BacktestSummary overall = Backtester::summarize(trades.data(), trades.size());
+        
+        TraceStage serializeStage("serialize");
+        json response;
+        response["results"] = json::array();
+        for (size_t i = 0; i < symbols.size(); ++i) {
+            json result;
+            result["symbol"] = symbols[i];
+            if (!runs[i].error.empty()) {
+                result["error"] = runs[i].error;
+                response["results"].push_back(std::move(result));
+                continue;
+            }
+            result["summary"] = backtestSummaryJson(summaries[i], true);
+            if (includeTrades) {
+                size_t count = std::min(runs[i].windows.size(), MAX_BACKTEST_TRADES);
+                json list = json::array();
+                for (size_t j = 0; j < count; ++j) {
+                    const BacktestTrade& trade = trades[offsets[i] + j];
+                    json item;
+                    item["entryTime"] = trade.entryTime;
+                    item["settleTime"] = trade.settleTime;
+                    item["entrySpot"] = trade.entrySpot;
+                    item["settleSpot"] = trade.settleSpot;
+                    item["volatility"] = trade.volatility * 100.0;
+                    item["premium"] = trade.premium;
+                    item["pnl"] = trade.pnl;
+                    list.push_back(std::move(item));
+                }
+                result["trades"] = std::move(list);
+                result["tradesTruncated"] = count < runs[i].windows.size();
+            }
+            response["results"].push_back(std::move(result));
+        }
+        response["summary"] = backtestSummaryJson(overall, false);
+        
+        return response.dump();
+        
+    } catch (const DeadlineExceeded&) {
+        // Отмену обрабатывает сервер (504), а не тело с ошибкой
+        throw;
+    } catch (const std::exception& e) {
+        json error;
+        error["error"] = std::string("Invalid request: ") + e.what();
+        return error.dump();
+    }
+}
+
+std::string APIHandler::handleOptimizeStrategy(const std::string& requestBody) {
+    ArenaScope arena;
     try {
-        std::vector<OHLCV> data = loadOHLCVForSymbol(symbol);
+        TraceStage parseStage("parse");
+        json request = json::parse(requestBody);
+        parseStage.stop();
+        
+        if (!request.contains("symbol")) {
+            json error;
+            error["error"] = "Missing required field: symbol";
+            return error.dump();
+        }
+        std::string symbol = request["symbol"].get<std::string>();
+        
+        OptimizerConfig config;
+        if (request.contains("structures") && request["structures"].is_array()) {
+            for (const auto& name : request["structures"]) {
+                StrategyStructure structure;
+                if (!StrategyOptimizer::parseStructure(name.get<std::string>(), structure)) {
+                    json error;
+                    error["error"] = "Unknown structure: " + name.get<std::string>();
+                    return error.dump();
+                }
+                config.structures.push_back(structure);
+            }
+        } else {
+            config.structures = {StrategyStructure::VERTICAL_CALL, StrategyStructure::VERTICAL_PUT,
+                                 StrategyStructure::STRADDLE, StrategyStructure::STRANGLE,
+                                 StrategyStructure::BUTTERFLY, StrategyStructure::CONDOR,
+                                 StrategyStructure::IRON_CONDOR};
+        }
+        if (config.structures.empty()) {
+            json error;
+            error["error"] = "Invalid structures: expected at least one structure";
+            return error.dump();
+        }
         
+        std::string objective = request.value("objective", "expectedPnl");
+        if (objective == "expectedPnl") {
+            config.objective = OptimizerObjective::EXPECTED_PNL;
+        } else if (objective == "probabilityOfProfit") {
+            config.objective = OptimizerObjective::PROBABILITY_OF_PROFIT;
+        } else {
+            json error;
+            error["error"] = "Invalid objective: expected expectedPnl or probabilityOfProfit";
+            return error.dump();
+        }
+        config.allowReverse = request.value("allowReverse", true);
+        config.hasMaxLoss = request.contains("maxLoss") && !request["maxLoss"].is_null();
+        config.maxLoss = config.hasMaxLoss ? request["maxLoss"].get<double>() : 0.0;
+        config.hasBudget = request.contains("budget") && !request["budget"].is_null();
+        config.budget = config.hasBudget ? request["budget"].get<double>() : 0.0;
+        config.deltaNeutral = request.value("deltaNeutral", false);
+        config.deltaTolerance = request.value("deltaTolerance", 0.1);
+        int topN = request.value("topN", 10);
+        
+        double expiryDays = request.value("timeToExpiration", 30.0);
+        double minStrike = request.value("minStrike", 0.7);
+        double maxStrike = request.value("maxStrike", 1.3);
+        int numStrikes = request.value("numStrikes", 41);
+        if (!(expiryDays > 0) || !(minStrike > 0) || !(maxStrike > minStrike) ||
+            numStrikes < 2 || static_cast<size_t>(numStrikes) > MAX_OPTIMIZER_STRIKES ||
+            topN < 1 || static_cast<size_t>(topN) > MAX_OPTIMIZER_TOP || config.deltaTolerance < 0) {
+            json error;
+            error["error"] = "Invalid parameters: timeToExpiration must be positive, 0 < minStrike < maxStrike, "
+                             "numStrikes between 2 and " + std::to_string(MAX_OPTIMIZER_STRIKES) +
+                             ", topN between 1 and " + std::to_string(MAX_OPTIMIZER_TOP);
+            return error.dump();
+        }
+        config.topN = static_cast<size_t>(topN);
+        
+        size_t strikeCount = static_cast<size_t>(numStrikes);
+        uint64_t total = StrategyOptimizer::countCandidates(config, strikeCount);
+        if (total > MAX_OPTIMIZER_CANDIDATES) {
+            json error;
+            error["error"] = "Too many candidates: " + std::to_string(total) + " (max " +
+                             std::to_string(MAX_OPTIMIZER_CANDIDATES) + "), reduce numStrikes or structures";
+            return error.dump();
+        }
+        
+        OHLCVSeriesPtr series = loadOHLCVForSymbol(symbol);
+        OHLCVView data = series->view();
         if (data.empty()) {
             json error;
             error["error"] = "No data found for symbol: " + symbol;
             return error.dump();
         }
         
-        // Берем последние N свечей
-        int n = std::min(limit, static_cast<int>(data.size()));
-        std::vector<OHLCV> recent = VolatilityCalculator::getLastNCandles(data, n);
+        MarketParams market;
+        market.spotPrice = VolatilityCalculator::getCurrentPrice(data);
+        market.volatility = request.contains("volatility")
+            ? request["volatility"].get<double>() / 100.0
+            : VolatilityCalculator::calculateHistoricalVolatility(data, 30);
+        market.timeToExpiration = expiryDays / 365.0;
+        market.riskFreeRate = request.value("riskFreeRate", 5.0) / 100.0;
+        market.dividendYield = request.value("dividendYield", 0.0) / 100.0;
+        if (market.spotPrice <= 0) {
+            json error;
+            error["error"] = "Invalid current price for symbol: " + symbol;
+            return error.dump();
+        }
         
+        // Распределение цены на экспирации и премии сетки страйков
+        TraceStage prepareStage("prepare");
+        EmpiricalDistribution distribution = EmpiricalDistribution::fromHistory(data, market.spotPrice, expiryDays);
+        if (distribution.size() < 30) {
+            json error;
+            error["error"] = "Not enough history for timeToExpiration returns of symbol: " + symbol;
+            return error.dump();
+        }
+        
+        ArenaVector<double> strikes(strikeCount);
+        ArenaVector<double> logMoneyness(strikeCount);
+        double step = (maxStrike - minStrike) / static_cast<double>(strikeCount - 1);
+        for (size_t i = 0; i < strikeCount; ++i) {
+            strikes[i] = (minStrike + step * static_cast<double>(i)) * market.spotPrice;
+            logMoneyness[i] = std::log(market.spotPrice / strikes[i]);
+        }
+        ArenaVector<ChainQuote> quotes(strikeCount);
+        OptionPricing::calculateChain(market, strikes.data(), logMoneyness.data(), strikeCount, quotes.data());
+        prepareStage.stop();
+        
+        TraceStage searchStage("search");
+        OptimizerResult result = StrategyOptimizer::optimize(config, quotes.data(), strikeCount, distribution,
+                                                             computePool_);
+        searchStage.stop();
+        
+        TraceStage serializeStage("serialize");
         json response;
-        json ohlcvArray = json::array();
+        response["symbol"] = symbol;
+        response["spotPrice"] = market.spotPrice;
+        response["volatility"] = market.volatility * 100.0;
+        response["timeToExpiration"] = expiryDays;
+        response["samples"] = distribution.size();
+        response["candidates"] = result.candidates;
+        response["rejectedBudget"] = result.rejectedBudget;
+        response["rejectedDelta"] = result.rejectedDelta;
+        response["rejectedLoss"] = result.rejectedLoss;
+        response["pruned"] = result.pruned;
+        response["evaluated"] = result.evaluated;
+        response["best"] = json::array();
+        for (const OptimizerCandidate& candidate : result.best) {
+            json item;
+            item["structure"] = StrategyOptimizer::structureName(candidate.structure);
+            item["direction"] = candidate.reverse ? "reverse" : "forward";
+            item["legs"] = json::array();
+            for (size_t i = 0; i < candidate.legCount; ++i) {
+                const Option& option = candidate.legs[i];
+                json leg;
+                leg["type"] = option.type == OptionType::CALL ? "call" : "put";
+                leg["position"] = option.position == OptionPosition::LONG ? "long" : "short";
+                leg["strike"] = option.strike;
+                leg["premium"] = option.premium;
+                leg["quantity"] = option.quantity;
+                item["legs"].push_back(std::move(leg));
+            }
+            item["netPremium"] = candidate.netPremium;
+            item["delta"] = candidate.delta;
+            item["expectedPnl"] = candidate.stats.expected;
+            item["probabilityOfProfit"] = candidate.stats.probabilityOfProfit;
+            item["maxLoss"] = boundJson(candidate.stats.maxLoss);
+            item["maxProfit"] = boundJson(candidate.stats.maxProfit);
+            response["best"].push_back(std::move(item));
+        }
+        
+        return response.dump();
+        
+    } catch (const DeadlineExceeded&) {
+        // Отмену обрабатывает сервер (504), а не тело с ошибкой
+        throw;
+    } catch (const std::exception& e) {
+        json error;
+        error["error"] = std::string("Invalid request: ") + e.what();
+        return error.dump();
+    }
+}
+
+std::string APIHandler::handleModelChain(const std::string& requestBody) {
+    ArenaScope arena;
+    try {
+        TraceStage parseStage("parse");
+        json request = json::parse(requestBody);
+        parseStage.stop();
+        
+        if (!request.contains("symbol")) {
+            json error;
+            error["error"] = "Missing required field: symbol";
+            return error.dump();
+        }
+        std::string symbol = request["symbol"].get<std::string>();
+        
+        FourierModel model;
+        FourierMethod method;
+        std::string modelName = request.value("model", "heston");
+        std::string methodName = request.value("method", "cos");
+        if (!FourierPricing::parseModel(modelName, model.type)) {
+            json error;
+            error["error"] = "Invalid model: expected heston, merton or kou";
+            return error.dump();
+        }
+        if (!FourierPricing::parseMethod(methodName, method)) {
+            json error;
+            error["error"] = "Invalid method: expected cos or fft";
+            return error.dump();
+        }
+        bool hasParams = request.contains("params") && request["params"].is_object();
+        if (hasParams) {
+            readModelParams(request["params"], model);
+        }
+        
+        // По умолчанию: котировки, если переданы; заданные параметры - как есть; иначе история
+        bool hasQuotes = request.contains("quotes") && request["quotes"].is_array();
+        std::string calibrate = request.value("calibrate", hasQuotes ? "quotes" : hasParams ? "none" : "history");
+        if (calibrate != "history" && calibrate != "quotes" && calibrate != "none") {
+            json error;
+            error["error"] = "Invalid calibrate: expected history, quotes or none";
+            return error.dump();
+        }
+        if (calibrate == "none" && !model.valid()) {
+            json error;
+            error["error"] = "Invalid params for model: " + modelName;
+            return error.dump();
+        }
+        int starts = request.value("starts", 4);
+        if (starts < 1 || static_cast<size_t>(starts) > MAX_CALIBRATION_STARTS) {
+            json error;
+            error["error"] = "Invalid starts: must be between 1 and " + std::to_string(MAX_CALIBRATION_STARTS);
+            return error.dump();
+        }
+        
+        OHLCVSeriesPtr series = loadOHLCVForSymbol(symbol);
+        OHLCVView data = series->view();
+        if (data.empty()) {
+            json error;
+            error["error"] = "No data found for symbol: " + symbol;
+            return error.dump();
+        }
+        
+        MarketParams market;
+        market.spotPrice = VolatilityCalculator::getCurrentPrice(data);
+        market.volatility = request.contains("volatility")
+            ? request["volatility"].get<double>() / 100.0
+            : VolatilityCalculator::calculateHistoricalVolatility(data, 30);
+        market.riskFreeRate = request.value("riskFreeRate", 5.0) / 100.0;
+        market.dividendYield = request.value("dividendYield", 0.0) / 100.0;
+        if (market.spotPrice <= 0) {
+            json error;
+            error["error"] = "Invalid current price for symbol: " + symbol;
+            return error.dump();
+        }
+        
+        // Сетка: явные страйки или равномерная в долях текущей цены
+        ArenaVector<double> strikes;
+        if (request.contains("strikes") && request["strikes"].is_array()) {
+            for (const auto& strike : request["strikes"]) {
+                strikes.push_back(strike.get<double>());
+            }
+        } else {
+            double minStrike = request.value("minStrike", 0.8);
+            double maxStrike = request.value("maxStrike", 1.2);
+            int numStrikes = request.value("numStrikes", 21);
+            if (!(minStrike > 0) || !(maxStrike >= minStrike) || numStrikes < 1 ||
+                static_cast<size_t>(numStrikes) > MAX_CHAIN_STRIKES) {
+                json error;
+                error["error"] = "Invalid strikes: 0 < minStrike <= maxStrike, numStrikes between 1 and " +
+                                 std::to_string(MAX_CHAIN_STRIKES);
+                return error.dump();
+            }
+            double step = numStrikes > 1 ? (maxStrike - minStrike) / static_cast<double>(numStrikes - 1) : 0.0;
+            for (int i = 0; i < numStrikes; ++i) {
+                strikes.push_back((minStrike + step * static_cast<double>(i)) * market.spotPrice);
+            }
+        }
+        ArenaVector<double> expiries;
+        if (request.contains("expiries") && request["expiries"].is_array()) {
+            for (const auto& days : request["expiries"]) {
+                expiries.push_back(days.get<double>());
+            }
+        } else {
+            expiries = {7.0, 14.0, 30.0, 60.0, 90.0};
+        }
+        bool strikesValid = !strikes.empty() && strikes.size() <= MAX_CHAIN_STRIKES;
+        for (double strike : strikes) {
+            strikesValid = strikesValid && strike > 0;
+        }
+        bool expiriesValid = !expiries.empty() && expiries.size() <= MAX_CHAIN_EXPIRIES;
+        for (double days : expiries) {
+            expiriesValid = expiriesValid && days >= 0;
+        }
+        if (!strikesValid || !expiriesValid) {
+            json error;
+            error["error"] = "Invalid grid: expected 1 to " + std::to_string(MAX_CHAIN_STRIKES) +
+                             " positive strikes and 1 to " + std::to_string(MAX_CHAIN_EXPIRIES) +
+                             " non-negative expiries";
+            return error.dump();
+        }
+        
+        std::vector<CalibrationQuote> quotes;
+        if (calibrate == "quotes") {
+            if (!hasQuotes || request["quotes"].empty() || request["quotes"].size() > MAX_CALIBRATION_QUOTES) {
+                json error;
+                error["error"] = "Invalid quotes: expected 1 to " + std::to_string(MAX_CALIBRATION_QUOTES) + " quotes";
+                return error.dump();
+            }
+            for (const auto& item : request["quotes"]) {
+                CalibrationQuote quote;
+                quote.type = item.value("type", "call") == "put" ? OptionType::PUT : OptionType::CALL;
+                quote.strike = item["strike"].get<double>();
+                quote.timeToExpiration = item["timeToExpiration"].get<double>() / 365.0;
+                quote.price = item["price"].get<double>();
+                if (!(quote.strike > 0) || !(quote.timeToExpiration > 0) || !(quote.price >= 0)) {
+                    json error;
+                    error["error"] = "Invalid quote: strike and timeToExpiration must be positive, price non-negative";
+                    return error.dump();
+                }
+                quotes.push_back(quote);
+            }
+        }
+        
+        TraceStage calibrateStage("calibrate");
+        CalibrationResult calibration;
+        if (calibrate == "history") {
+            calibration = ModelCalibration::toHistory(model.type, data, static_cast<size_t>(starts), computePool_);
+            if (calibration.starts == 0) {
+                json error;
+                error["error"] = "Not enough history to calibrate model for symbol: " + symbol;
+                return error.dump();
+            }
+            model = calibration.model;
+        } else if (calibrate == "quotes") {
+            calibration = ModelCalibration::toQuotes(model.type, quotes, market, static_cast<size_t>(starts),
+                                                     computePool_);
+            model = calibration.model;
+        }
+        calibrateStage.stop();
         
-        for (const auto& candle : recent) {
-            json candleJson;
-            candleJson["date"] = candle.date;
-            candleJson["open"] = candle.open;
-            candleJson["high"] = candle.high;
-            candleJson["low"] = candle.low;
-            candleJson["close"] = candle.close;
-            candleJson["volume"] = candle.volume;
-            ohlcvArray.push_back(candleJson);
+        // Экспирации независимы: по одному преобразованию на экспирацию, параллельно
+        TraceStage chainStage("chain");
+        size_t strikeCount = strikes.size();
+        ArenaVector<double> calls(strikeCount * expiries.size());
+        ArenaVector<double> puts(strikeCount * expiries.size());
+        const RequestDeadline* deadline = RequestDeadline::current();
+        auto priceExpiries = [&](size_t lo, size_t hi) {
+            DeadlineScope scope(deadline);
+            for (size_t e = lo; e < hi; ++e) {
+                if (deadline != nullptr) {
+                    deadline->check();
+                }
+                MarketParams at = market;
+                at.timeToExpiration = expiries[e] / 365.0;
+                FourierPricing::priceChain(model, at, strikes.data(), strikeCount, method,
+                                           calls.data() + e * strikeCount, puts.data() + e * strikeCount);
+            }
+        };
+        if (computePool_ != nullptr) {
+            computePool_->parallelFor(0, expiries.size(), 1, priceExpiries);
+        } else {
+            priceExpiries(0, expiries.size());
         }
+        chainStage.stop();
         
+        TraceStage serializeStage("serialize");
+        json response;
         response["symbol"] = symbol;
-        response["data"] = ohlcvArray;
-        response["count"] = ohlcvArray.size();
+        response["spotPrice"] = market.spotPrice;
+        response["model"] = FourierPricing::modelName(model.type);
+        response["method"] = FourierPricing::methodName(method);
+        response["params"] = modelParamsJson(model);
+        if (calibrate == "none") {
+            response["calibration"] = nullptr;
+        } else {
+            json summary;
+            summary["source"] = calibrate;
+            summary["error"] = calibration.error;
+            summary["starts"] = calibration.starts;
+            summary["evaluations"] = calibration.evaluations;
+            response["calibration"] = std::move(summary);
+        }
+        response["expiries"] = json::array();
+        for (size_t e = 0; e < expiries.size(); ++e) {
+            json expiry;
+            expiry["timeToExpiration"] = expiries[e];
+            expiry["strikes"] = json::array();
+            expiry["calls"] = json::array();
+            expiry["puts"] = json::array();
+            for (size_t i = 0; i < strikeCount; ++i) {
+                expiry["strikes"].push_back(strikes[i]);
+                expiry["calls"].push_back(calls[e * strikeCount + i]);
+                expiry["puts"].push_back(puts[e * strikeCount + i]);
+            }
+            response["expiries"].push_back(std::move(expiry));
+        }
         
         return response.dump();
         
+    } catch (const DeadlineExceeded&) {
+        // Отмену обрабатывает сервер (504), а не тело с ошибкой
+        throw;
     } catch (const std::exception& e) {
         json error;
-        error["error"] = std::string("Error: ") + e.what();
+        error["error"] = std::string("Invalid request: ") + e.what();
         return error.dump();
     }
 }
 
-} // namespace derivx
\ No newline at end of file
+StrategyMark APIHandler::evaluateStrategyMark(const std::string& strategy, OHLCVView data) {
+    if (data.empty()) {
+        throw std::invalid_argument("No data for strategy evaluation");
+    }
+    
+    ArenaScope arena;
+    json request = json::parse(strategy);
+    std::vector<Option> options = parseOptions(request);
+    if (options.empty()) {
+        throw std::invalid_argument("Strategy has no options");
+    }
+    
+    double S = VolatilityCalculator::getCurrentPrice(data);
+    double T = request.value("timeToExpiration", 30.0) / 365.0;
+    double r = request.value("riskFreeRate", 5.0) / 100.0;
+    double q = request.value("dividendYield", 0.0) / 100.0;
+    // Без явной волатильности берем историческую по тем же данным
+    double sigma = request.contains("volatility")
+        ? request["volatility"].get<double>() / 100.0
+        : VolatilityCalculator::calculateHistoricalVolatility(data, 30);
+    if (S <= 0 || T < 0 || sigma < 0) {
+        throw std::invalid_argument("Invalid strategy parameters");
+    }
+    
+    StrategyMark mark;
+    mark.timestamp = data.back().timestamp;
+    mark.date = data.back().date;
+    mark.spotPrice = S;
+    mark.pnl = OptionPricing::calculateStrategyPNL(options, S);
+    
+    // Греки позиции: сумма греков ног с учетом направления и количества
+    for (const auto& option : options) {
+        Greeks leg = OptionPricing::calculateGreeks(option.type, S, option.strike, T, sigma, r, q);
+        double weight = (option.position == OptionPosition::LONG ? 1.0 : -1.0) * option.quantity;
+        mark.greeks.delta += weight * leg.delta;
+        mark.greeks.gamma += weight * leg.gamma;
+        mark.greeks.theta += weight * leg.theta;
+        mark.greeks.vega += weight * leg.vega;
+        mark.greeks.rho += weight * leg.rho;
+    }
+    
+    return mark;
+}
+
+CachedResponse APIHandler::handleConditionalGet(const ConditionalGet& request) {
+    CachedResponse result;
+    TraceStage loadStage("load");
+    OHLCVSeriesPtr series = loadOHLCVForSymbol(request.symbol);
+    loadStage.stop();
+    SeriesSnapshots pinned{{request.symbol, series}};
+    
+    // Ключ запроса: все, от чего зависят байты ответа при той же версии данных
+    std::string key;
+    switch (request.endpoint) {
+        case DataEndpoint::PRICE:      key = "price"; break;
+        case DataEndpoint::VOLATILITY: key = "volatility"; break;
+        case DataEndpoint::OHLCV:      key = "ohlcv"; break;
+        case DataEndpoint::OPTION_CHAIN: key = "option-chain"; break;
+    }
+    key += '|' + request.symbol + '|' + std::to_string(static_cast<int>(request.format));
+    if (request.endpoint == DataEndpoint::OHLCV) {
+        const OHLCVQuery& query = request.query;
+        key += '|' + std::to_string(query.limit) + '|' + std::to_string(query.maxPoints) +
+               '|' + (query.hasFrom ? std::to_string(query.from) : std::string()) +
+               '|' + (query.hasTo ? std::to_string(query.to) : std::string()) +
+               '|' + query.cursor;
+    }
+    if (request.endpoint == DataEndpoint::OPTION_CHAIN) {
+        const OptionChainQuery& chain = request.chain;
+        char number[32];
+        auto append = [&](double value) {
+            std::snprintf(number, sizeof(number), "%.17g", value);
+            key += number;
+            key += ',';
+        };
+        key += '|';
+        for (double strike : chain.strikes) {
+            append(strike);
+        }
+        key += '|';
+        append(chain.minStrike);
+        append(chain.maxStrike);
+        key += std::to_string(chain.numStrikes) + (chain.relative ? "|r|" : "|a|");
+        for (double days : chain.expiries) {
+            append(days);
+        }
+        key += '|';
+        if (chain.hasVolatility) {
+            append(chain.volatility);
+        }
+        key += '|';
+        append(chain.riskFreeRate);
+        append(chain.dividendYield);
+    }
+    
+    auto render = [&]() -> std::string {
+        TraceStage stage("serialize");
+        switch (request.endpoint) {
+            case DataEndpoint::PRICE:
+                return ResponseFormats::transcode(handleGetCurrentPrice(request.symbol, &pinned), request.format);
+            case DataEndpoint::VOLATILITY:
+                return ResponseFormats::transcode(handleGetVolatility(request.symbol, &pinned), request.format);
+            case DataEndpoint::OPTION_CHAIN:
+                return handleGetOptionChain(request.symbol, request.chain, request.format, &pinned);
+            case DataEndpoint::OHLCV:
+            default:
+                return handleGetOHLCV(request.symbol, request.query, request.format, &pinned);
+        }
+    };
+    
+    // Нет данных - ответ с ошибкой без валидаторов
+    if (series->empty()) {
+        result.body = std::make_shared<const std::string>(render());
+        return result;
+    }
+    
+    result.etag = HttpCaching::makeETag(series->version, key);
+    result.lastModified = series->modifiedTime;
+    
+    // If-Modified-Since учитывается только без If-None-Match (RFC 9110, 13.2.2)
+    int64_t since = 0;
+    if (!request.ifNoneMatch.empty()) {
+        result.notModified = HttpCaching::etagMatches(request.ifNoneMatch, result.etag);
+    } else if (!request.ifModifiedSince.empty() && result.lastModified > 0 &&
+               HttpCaching::parseHttpDate(request.ifModifiedSince, since)) {
+        result.notModified = result.lastModified <= since;
+    }
+    if (result.notModified) {
+        responseCache_.recordNotModified();
+        return result;
+    }
+    
+    TraceStage cacheStage("cache");
+    result.body = responseCache_.find(key, series->version);
+    cacheStage.stop();
+    if (!result.body) {
+        result.body = std::make_shared<const std::string>(render());
+        responseCache_.store(key, series->version, result.body);
+    }
+    return result;
+}
+
+StreamSubscriberPtr APIHandler::subscribeStrategy(const std::string& symbol, const std::string& strategy) {
+    // Запоминаем состояние файла, чтобы опрос реагировал только на новые свечи
+    refreshSymbol(symbol);
+    return strategyStreams_.subscribe(symbol, strategy, loadOHLCVForSymbol(symbol));
+}
+
+size_t APIHandler::pollStrategyStreams() {
+    size_t updated = 0;
+    for (const auto& symbol : strategyStreams_.symbols()) {
+        OHLCVSeriesPtr series = refreshSymbol(symbol);
+        if (series) {
+            strategyStreams_.update(symbol, series, computePool_);
+            ++updated;
+        }
+    }
+    return updated;
+}
+
+OHLCVSeriesPtr APIHandler::refreshSymbol(const std::string& symbol) {
+    std::string filepath = getDataFilePath(symbol);
+    std::error_code ec;
+    auto modified = std::filesystem::last_write_time(filepath, ec);
+    if (ec) {
+        return nullptr;
+    }
+    uintmax_t size = std::filesystem::file_size(filepath, ec);
+    if (ec) {
+        return nullptr;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(fileStampsMutex_);
+        FileStamp& stamp = fileStamps_[symbol];
+        if (stamp.known && stamp.modified == modified && stamp.size == size) {
+            return nullptr;
+        }
+        stamp.known = true;
+        stamp.modified = modified;
+        stamp.size = size;
+    }
+    
+    // Файл изменился: перечитываем и сообщаем, только если сменилась последняя свеча
+    OHLCVSeriesPtr previous = ohlcvCache_.find(symbol);
+    ohlcvCache_.invalidate(symbol);
+    OHLCVSeriesPtr current = loadOHLCVForSymbol(symbol);
+    if (current->empty()) {
+        return nullptr;
+    }
+    if (previous && !previous->empty() &&
+        previous->size() == current->size() &&
+        previous->candles.back().timestamp == current->candles.back().timestamp &&
+        previous->candles.back().close == current->candles.back().close) {
+        return nullptr;
+    }
+    return current;
+}
+
+std::string APIHandler::parseOHLCVQuery(const std::map<std::string, std::string>& params, OHLCVQuery& query) {
+    std::string paramError;
+    
+    auto parseCount = [&](const char* name, int& target) {
+        auto it = params.find(name);
+        if (it == params.end()) {
+            return;
+        }
+        char* end = nullptr;
+        long parsed = std::strtol(it->second.c_str(), &end, 10);
+        if (it->second.empty() || *end != '\0' || parsed <= 0 || parsed > MAX_OHLCV_LIMIT) {
+            paramError = std::string("Invalid ") + name + ": must be between 1 and " + std::to_string(MAX_OHLCV_LIMIT);
+        } else {
+            target = static_cast<int>(parsed);
+        }
+    };
+    
+    auto parseTime = [&](const char* name, bool& has, int64_t& target) {
+        auto it = params.find(name);
+        if (it == params.end()) {
+            return;
+        }
+        has = VolatilityCalculator::parseTimestamp(it->second, target);
+        if (!has) {
+            paramError = std::string("Invalid ") + name + ": expected unix time or YYYY-MM-DD[ HH:MM:SS]";
+        }
+    };
+    
+    parseCount("limit", query.limit);
+    parseTime("from", query.hasFrom, query.from);
+    parseTime("to", query.hasTo, query.to);
+    parseCount("maxPoints", query.maxPoints);
+    
+    auto cursorIt = params.find("cursor");
+    if (cursorIt != params.end()) {
+        query.cursor = cursorIt->second;
+    }
+    return paramError;
+}
+
+std::string APIHandler::parseOptionChainQuery(const std::map<std::string, std::string>& params,
+                                              OptionChainQuery& query) {
+    std::string paramError;
+    
+    auto parseNumber = [](const std::string& text, double& target) {
+        char* end = nullptr;
+        target = std::strtod(text.c_str(), &end);
+        return !text.empty() && *end == '\0' && std::isfinite(target);
+    };
+    
+    auto parseList = [&](const char* name, std::vector<double>& target, size_t limit) {
+        auto it = params.find(name);
+        if (it == params.end()) {
+            return false;
+        }
+        target.clear();
+        std::stringstream items(it->second);
+        std::string item;
+        double number = 0.0;
+        while (std::getline(items, item, ',')) {
+            if (!parseNumber(item, number) || number <= 0) {
+                paramError = std::string("Invalid ") + name + ": expected comma-separated positive numbers";
+                return true;
+            }
+            target.push_back(number);
+        }
+        if (target.empty() || target.size() > limit) {
+            paramError = std::string("Invalid ") + name + ": expected 1 to " + std::to_string(limit) + " values";
+        }
+        return true;
+    };
+    
+    auto parseValue = [&](const char* name, double& target, double low, double high) {
+        auto it = params.find(name);
+        if (it == params.end()) {
+            return false;
+        }
+        if (!parseNumber(it->second, target) || target < low || target > high) {
+            paramError = std::string("Invalid ") + name + ": must be between " +
+                         std::to_string(static_cast<int>(low)) + " and " + std::to_string(static_cast<int>(high));
+        }
+        return true;
+    };
+    
+    // Явные страйки и границы сетки без флага relative - абсолютные цены
+    bool absolute = parseList("strikes", query.strikes, MAX_CHAIN_STRIKES);
+    absolute = parseValue("minStrike", query.minStrike, 0, 1e12) || absolute;
+    absolute = parseValue("maxStrike", query.maxStrike, 0, 1e12) || absolute;
+    query.relative = !absolute;
+    
+    auto relativeIt = params.find("relative");
+    if (relativeIt != params.end()) {
+        if (relativeIt->second == "true" || relativeIt->second == "1") {
+            query.relative = true;
+        } else if (relativeIt->second == "false" || relativeIt->second == "0") {
+            query.relative = false;
+        } else {
+            paramError = "Invalid relative: expected true or false";
+        }
+    }
+    
+    auto countIt = params.find("numStrikes");
+    if (countIt != params.end()) {
+        char* end = nullptr;
+        long parsed = std::strtol(countIt->second.c_str(), &end, 10);
+        if (countIt->second.empty() || *end != '\0' || parsed <= 0 || parsed > static_cast<long>(MAX_CHAIN_STRIKES)) {
+            paramError = "Invalid numStrikes: must be between 1 and " + std::to_string(MAX_CHAIN_STRIKES);
+        } else {
+            query.numStrikes = static_cast<int>(parsed);
+        }
+    }
+    if (query.strikes.empty() && (query.minStrike <= 0 || query.maxStrike < query.minStrike)) {
+        paramError = "Invalid strike range: expected 0 < minStrike <= maxStrike";
+    }
+    
+    parseList("expiries", query.expiries, MAX_CHAIN_EXPIRIES);
+    query.hasVolatility = parseValue("volatility", query.volatility, 0, 1000);
+    parseValue("riskFreeRate", query.riskFreeRate, -100, 100);
+    parseValue("dividendYield", query.dividendYield, -100, 100);
+    return paramError;
+}
+
+namespace {
+
+// Ряды метрик эндпоинтов: префикс пути -> имя ряда
+const std::pair<const char*, const char*> endpointNames[] = {
+    {"/api/health", "health"},
+    {"/api/calculate-option", "calculate_option"},
+    {"/api/calculate-strategy", "calculate_strategy"},
+    {"/api/calculate-greeks", "calculate_greeks"},
+    {"/api/volatility/", "volatility"},
+    {"/api/price/", "price"},
+    {"/api/ohlcv/", "ohlcv"},
+    {"/api/option-chain/", "option_chain"},
+    {"/api/cache/stats", "cache_stats"},
+    {"/api/batch", "batch"},
+    {"/api/backtest", "backtest"},
+    {"/api/optimize-strategy", "optimize_strategy"},
+    {"/api/model-chain", "model_chain"},
+    {"/api/stream/strategy/", "strategy_stream"},
+    {"/api/metrics", "metrics"},
+};
+const size_t endpointNameCount = sizeof(endpointNames) / sizeof(endpointNames[0]);
+
+} // namespace
+
+size_t APIHandler::metricsEndpoint(const std::string& path) {
+    static const std::vector<size_t> ids = [] {
+        std::vector<size_t> registered;
+        for (const auto& entry : endpointNames) {
+            registered.push_back(Metrics::global().registerEndpoint(entry.second));
+        }
+        registered.push_back(Metrics::global().registerEndpoint("root"));
+        registered.push_back(Metrics::global().registerEndpoint("other"));
+        return registered;
+    }();
+    
+    if (path.empty() || path == "/") {
+        return ids[endpointNameCount];
+    }
+    for (size_t i = 0; i < endpointNameCount; ++i) {
+        if (path.compare(0, std::strlen(endpointNames[i].first), endpointNames[i].first) == 0) {
+            return ids[i];
+        }
+    }
+    return ids[endpointNameCount + 1];
+}
+
+std::string APIHandler::handleGetCacheStats() {
+    SymbolCacheStats stats = ohlcvCache_.stats();
+    uint64_t lookups = stats.hits + stats.negativeHits + stats.misses;
+    
+    json response;
+    response["hits"] = stats.hits;
+    response["misses"] = stats.misses;
+    response["negativeHits"] = stats.negativeHits;
+    response["hitRatio"] = lookups > 0 ? static_cast<double>(stats.hits + stats.negativeHits) / lookups : 0.0;
+    response["loads"] = stats.loads;
+    response["loadFailures"] = stats.loadFailures;
+    response["coalescedWaits"] = stats.coalescedWaits;
+    response["evictions"] = stats.evictions;
+    response["expirations"] = stats.expirations;
+    response["entries"] = stats.entries;
+    response["bytes"] = stats.bytes;
+    response["budgetBytes"] = stats.budgetBytes;
+    
+    ResponseCacheStats responses = responseCache_.stats();
+    response["responses"]["hits"] = responses.hits;
+    response["responses"]["misses"] = responses.misses;
+    response["responses"]["notModified"] = responses.notModified;
+    response["responses"]["entries"] = responses.entries;
+    response["responses"]["bytes"] = responses.bytes;
+    response["responses"]["budgetBytes"] = responses.budgetBytes;
+    
+    return response.dump();
+}
+
+namespace {
+
+void appendMetric(std::string& out, const char* name, const char* type, const char* help, double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+    out += name;
+    out += ' ';
+    out += buffer;
+    out += '\n';
+}
+
+} // namespace
+
+std::string APIHandler::handleGetMetrics() {
+    std::string out = Metrics::global().renderPrometheus();
+    
+    SymbolCacheStats symbols = ohlcvCache_.stats();
+    uint64_t lookups = symbols.hits + symbols.negativeHits + symbols.misses;
+    appendMetric(out, "derivx_symbol_cache_hits_total", "counter", "Symbol cache hits",
+                 static_cast<double>(symbols.hits));
+    appendMetric(out, "derivx_symbol_cache_negative_hits_total", "counter", "Hits on cached missing symbols",
+                 static_cast<double>(symbols.negativeHits));
+    appendMetric(out, "derivx_symbol_cache_misses_total", "counter", "Symbol cache misses",
+                 static_cast<double>(symbols.misses));
+    appendMetric(out, "derivx_symbol_cache_hit_ratio", "gauge", "Share of lookups served from cache",
+                 lookups > 0 ? static_cast<double>(symbols.hits + symbols.negativeHits) / lookups : 0.0);
+    appendMetric(out, "derivx_symbol_cache_coalesced_waits_total", "counter", "Misses that waited for another load",
+                 static_cast<double>(symbols.coalescedWaits));
+    appendMetric(out, "derivx_symbol_cache_evictions_total", "counter", "Symbols evicted by memory budget",
+                 static_cast<double>(symbols.evictions));
+    appendMetric(out, "derivx_symbol_cache_entries", "gauge", "Cached symbols",
+                 static_cast<double>(symbols.entries));
+    appendMetric(out, "derivx_symbol_cache_bytes", "gauge", "Memory held by cached series",
+                 static_cast<double>(symbols.bytes));
+    
+    ResponseCacheStats responses = responseCache_.stats();
+    uint64_t responseLookups = responses.hits + responses.misses;
+    appendMetric(out, "derivx_response_cache_hits_total", "counter", "Response bodies served from cache",
+                 static_cast<double>(responses.hits));
+    appendMetric(out, "derivx_response_cache_misses_total", "counter", "Response bodies built from data",
+                 static_cast<double>(responses.misses));
+    appendMetric(out, "derivx_response_cache_hit_ratio", "gauge", "Share of bodies served from cache",
+                 responseLookups > 0 ? static_cast<double>(responses.hits) / responseLookups : 0.0);
+    appendMetric(out, "derivx_http_not_modified_total", "counter", "Responses answered with 304",
+                 static_cast<double>(responses.notModified));
+    appendMetric(out, "derivx_response_cache_bytes", "gauge", "Memory held by cached bodies",
+                 static_cast<double>(responses.bytes));
+    
+    if (computePool_ != nullptr) {
+        appendMetric(out, "derivx_compute_queue_depth", "gauge", "Tasks waiting in the compute pool",
+                     static_cast<double>(computePool_->queueDepth()));
+        appendMetric(out, "derivx_compute_workers", "gauge", "Compute pool threads",
+                     static_cast<double>(computePool_->workerCount()));
+    }
+    
+    if (admission_ != nullptr) {
+        AdmissionStats admission = admission_->stats();
+        const std::pair<const char*, const AdmissionLaneStats*> lanes[] = {
+            {"interactive", &admission.interactive},
+            {"heavy", &admission.heavy},
+        };
+        const struct {
+            const char* name;
+            const char* type;
+            const char* help;
+            uint64_t AdmissionLaneStats::*field;
+        } series[] = {
+            {"derivx_admission_admitted_total", "counter", "Requests admitted per lane", &AdmissionLaneStats::admitted},
+            {"derivx_admission_rejected_total", "counter", "Requests rejected with 503 per lane", &AdmissionLaneStats::rejected},
+            {"derivx_admission_in_flight", "gauge", "Admitted requests queued or running per lane", &AdmissionLaneStats::inFlight},
+            {"derivx_admission_in_flight_cost", "gauge", "Estimated cost of admitted requests per lane", &AdmissionLaneStats::inFlightUnits},
+        };
+        for (const auto& metric : series) {
+            out += "# HELP ";
+            out += metric.name;
+            out += ' ';
+            out += metric.help;
+            out += "\n# TYPE ";
+            out += metric.name;
+            out += ' ';
+            out += metric.type;
+            out += '\n';
+            for (const auto& lane : lanes) {
+                out += metric.name;
+                out += "{lane=\"";
+                out += lane.first;
+                out += "\"} ";
+                out += std::to_string(lane.second->*metric.field);
+                out += '\n';
+            }
+        }
+        appendMetric(out, "derivx_deadline_exceeded_total", "counter", "Requests cancelled by deadline or disconnect",
+                     static_cast<double>(admission.deadlineExceeded));
+    }
+    
+    RequestArenaStats arenas = RequestArena::stats();
+    appendMetric(out, "derivx_arena_requests_total", "counter", "Requests served from per-thread arenas",
+                 static_cast<double>(arenas.requests));
+    appendMetric(out, "derivx_arena_overflows_total", "counter", "Arena requests that spilled to the heap",
+                 static_cast<double>(arenas.overflows));
+    appendMetric(out, "derivx_arena_retained_bytes", "gauge", "Arena buffers kept by threads",
+                 static_cast<double>(arenas.retainedBytes));
+    
+    StrategyStreamStats streams = strategyStreams_.stats();
+    appendMetric(out, "derivx_stream_subscribers", "gauge", "Open strategy SSE subscriptions",
+                 static_cast<double>(streams.subscribers));
+    appendMetric(out, "derivx_stream_topics", "gauge", "Distinct strategies being streamed",
+                 static_cast<double>(streams.topics));
+    appendMetric(out, "derivx_stream_evaluations_total", "counter", "Strategy revaluations for streams",
+                 static_cast<double>(streams.evaluations));
+    appendMetric(out, "derivx_stream_events_coalesced_total", "counter", "Events replaced before delivery",
+                 static_cast<double>(streams.coalesced));
+    
+    return out;
+}
+
+} // namespace derivx
@@ -0,0 +1,199 @@
+#include "../include/backtest.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace derivx {
+
+namespace {
+
+const int64_t SECONDS_PER_DAY = 86400;
+
+/**
+ * Перцентиль отсортированных значений с линейной интерполяцией
+ */
+double percentile(const std::vector<double>& sorted, double fraction) {
+    double position = fraction * static_cast<double>(sorted.size() - 1);
+    size_t lower = static_cast<size_t>(position);
+    size_t upper = std::min(lower + 1, sorted.size() - 1);
+    double weight = position - static_cast<double>(lower);
+    return sorted[lower] + (sorted[upper] - sorted[lower]) * weight;
+}
+
+/**
+ * Наибольшее падение накопленной суммы от предыдущего максимума (начиная с нуля)
+ */
+template <typename Value>
+double maxDrawdown(const std::vector<const BacktestTrade*>& ordered, Value value) {
+    double equity = 0.0;
+    double peak = 0.0;
+    double drawdown = 0.0;
+    for (const BacktestTrade* trade : ordered) {
+        equity += value(*trade);
+        peak = std::max(peak, equity);
+        drawdown = std::max(drawdown, peak - equity);
+    }
+    return drawdown;
+}
+
+} // namespace
+
+RollingVolatility::RollingVolatility(OHLCVView data)
+    : sum_(data.size() + 1, 0.0), sumSquares_(data.size() + 1, 0.0), count_(data.size() + 1, 0) {
+    // Доходность свечи j - log(close[j] / close[j-1]); как и calculateReturns,
+    // пропускаем доходности с неположительной ценой
+    for (size_t j = 0; j < data.size(); ++j) {
+        double value = 0.0;
+        bool valid = j > 0 && data[j - 1].close > 0.0 && data[j].close > 0.0;
+        if (valid) {
+            value = std::log(data[j].close / data[j - 1].close);
+        }
+        sum_[j + 1] = sum_[j] + value;
+        sumSquares_[j + 1] = sumSquares_[j] + value * value;
+        count_[j + 1] = count_[j] + (valid ? 1 : 0);
+    }
+}
+
+double RollingVolatility::at(size_t index, int period) const {
+    // Окно - свечи [start, index], его доходности - свечей [start + 1, index]
+    size_t window = static_cast<size_t>(std::max(period, 0));
+    if (window == 0 || index + 1 >= sum_.size()) {
+        return 0.2; // Значение по умолчанию
+    }
+    size_t start = index + 1 >= window ? index + 1 - window : 0;
+    uint32_t count = count_[index + 1] - count_[start + 1];
+    if (count == 0) {
+        return 0.2; // Значение по умолчанию
+    }
+
+    double n = static_cast<double>(count);
+    double mean = (sum_[index + 1] - sum_[start + 1]) / n;
+    double variance = (sumSquares_[index + 1] - sumSquares_[start + 1]) / n - mean * mean;
+
+    // Годовая волатильность для дневных данных, как в calculateHistoricalVolatility
+    return std::sqrt(std::max(variance, 0.0)) * std::sqrt(252.0);
+}
+
+std::vector<BacktestWindow> Backtester::scheduleWindows(OHLCVView data, const BacktestConfig& config) {
+    std::vector<BacktestWindow> windows;
+    if (data.empty() || config.rollDays <= 0 || config.expiryDays <= 0) {
+        return windows;
+    }
+
+    int64_t holding = static_cast<int64_t>(std::llround(config.expiryDays * SECONDS_PER_DAY));
+    int64_t roll = std::max<int64_t>(std::llround(config.rollDays * SECONDS_PER_DAY), 1);
+
+    size_t entry = static_cast<size_t>(std::max(config.volatilityPeriod - 1, 0));
+    if (config.hasFrom) {
+        entry = std::max(entry, VolatilityCalculator::lowerBoundByTime(data, config.from));
+    }
+    size_t last = config.hasTo ? VolatilityCalculator::upperBoundByTime(data, config.to) : data.size();
+
+    while (entry < last) {
+        int64_t entryTime = data[entry].timestamp;
+        size_t settle = VolatilityCalculator::lowerBoundByTime(data, entryTime + holding);
+        if (settle >= data.size()) {
+            break;   // Экспирации этого и следующих входов еще нет в истории
+        }
+        windows.push_back({entry, settle});
+        entry = std::max(VolatilityCalculator::lowerBoundByTime(data, entryTime + roll), entry + 1);
+    }
+    return windows;
+}
+
+BacktestTrade Backtester::runWindow(
+    OHLCVView data,
+    const RollingVolatility& volatility,
+    const BacktestConfig& config,
+    const BacktestWindow& window
+) {
+    const OHLCV& entry = data[window.entry];
+    const OHLCV& settle = data[window.settle];
+
+    BacktestTrade trade;
+    trade.entryTime = entry.timestamp;
+    trade.settleTime = settle.timestamp;
+    trade.entrySpot = entry.close;
+    trade.settleSpot = settle.close;
+    trade.volatility = volatility.at(window.entry, config.volatilityPeriod);
+
+    double T = config.expiryDays / 365.0;
+    for (const BacktestLeg& leg : config.legs) {
+        Option option;
+        option.type = leg.type;
+        option.position = leg.position;
+        option.strike = entry.close * leg.moneyness;
+        option.quantity = leg.quantity;
+        option.premium = OptionPricing::calculateBlackScholes(leg.type, entry.close, option.strike, T,
+                                                              trade.volatility, config.riskFreeRate,
+                                                              config.dividendYield);
+
+        double sign = leg.position == OptionPosition::LONG ? 1.0 : -1.0;
+        trade.premium += sign * option.premium * leg.quantity;
+        trade.pnl += OptionPricing::calculatePayoff(option, settle.close);
+    }
+    return trade;
+}
+
+BacktestSummary Backtester::summarize(const BacktestTrade* trades, size_t count) {
+    BacktestSummary summary;
+    summary.trades = count;
+    if (count == 0) {
+        return summary;
+    }
+
+    std::vector<double> pnl(count);
+    std::vector<double> returns(count);
+    std::vector<const BacktestTrade*> ordered(count);
+    for (size_t i = 0; i < count; ++i) {
+        pnl[i] = trades[i].pnl;
+        returns[i] = trades[i].entrySpot > 0 ? trades[i].pnl / trades[i].entrySpot : 0.0;
+        ordered[i] = &trades[i];
+        summary.totalPnl += trades[i].pnl;
+        summary.wins += trades[i].pnl > 0 ? 1 : 0;
+    }
+    summary.winRate = static_cast<double>(summary.wins) / static_cast<double>(count);
+
+    // Просадка - по накопленному результату в порядке дат расчета
+    std::stable_sort(ordered.begin(), ordered.end(), [](const BacktestTrade* a, const BacktestTrade* b) {
+        return a->settleTime < b->settleTime;
+    });
+    summary.maxDrawdown = maxDrawdown(ordered, [](const BacktestTrade& trade) { return trade.pnl; });
+    summary.maxDrawdownReturn = maxDrawdown(ordered, [](const BacktestTrade& trade) {
+        return trade.entrySpot > 0 ? trade.pnl / trade.entrySpot : 0.0;
+    });
+
+    summary.pnl = distribution(pnl);
+    summary.returns = distribution(returns);
+    return summary;
+}
+
+DistributionStats Backtester::distribution(std::vector<double>& values) {
+    DistributionStats stats;
+    stats.count = values.size();
+    if (values.empty()) {
+        return stats;
+    }
+
+    std::sort(values.begin(), values.end());
+    double sum = 0.0;
+    for (double value : values) {
+        sum += value;
+    }
+    stats.mean = sum / static_cast<double>(values.size());
+    double variance = 0.0;
+    for (double value : values) {
+        variance += (value - stats.mean) * (value - stats.mean);
+    }
+    stats.stdDev = std::sqrt(variance / static_cast<double>(values.size()));
+
+    stats.min = values.front();
+    stats.max = values.back();
+    stats.p5 = percentile(values, 0.05);
+    stats.p25 = percentile(values, 0.25);
+    stats.p50 = percentile(values, 0.50);
+    stats.p75 = percentile(values, 0.75);
+    stats.p95 = percentile(values, 0.95);
+    return stats;
+}
+
+} // namespace derivx
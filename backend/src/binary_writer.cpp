@@ -0,0 +1,300 @@
+#include "../include/binary_writer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace derivx {
+
+namespace {
+
+// Запись беззнакового числа в big-endian (сетевой порядок CBOR/MessagePack)
+void appendBigEndian(std::string& out, uint64_t value, size_t bytes) {
+    for (size_t i = bytes; i > 0; --i) {
+        out.push_back(static_cast<char>((value >> ((i - 1) * 8)) & 0xFF));
+    }
+}
+
+// Запись беззнакового числа в little-endian (упакованный формат)
+void appendLittleEndian(std::string& out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+    }
+}
+
+uint64_t doubleBits(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+uint32_t floatBits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------- CBOR
+
+CborWriter::CborWriter(size_t reserveBytes) {
+    out_.reserve(reserveBytes);
+}
+
+void CborWriter::writeHead(uint8_t major, uint64_t argument) {
+    uint8_t type = static_cast<uint8_t>(major << 5);
+    if (argument < 24) {
+        out_.push_back(static_cast<char>(type | argument));
+    } else if (argument <= 0xFF) {
+        out_.push_back(static_cast<char>(type | 24));
+        appendBigEndian(out_, argument, 1);
+    } else if (argument <= 0xFFFF) {
+        out_.push_back(static_cast<char>(type | 25));
+        appendBigEndian(out_, argument, 2);
+    } else if (argument <= 0xFFFFFFFFULL) {
+        out_.push_back(static_cast<char>(type | 26));
+        appendBigEndian(out_, argument, 4);
+    } else {
+        out_.push_back(static_cast<char>(type | 27));
+        appendBigEndian(out_, argument, 8);
+    }
+}
+
+void CborWriter::writeText(const char* text, size_t length) {
+    writeHead(3, length);
+    out_.append(text, length);
+}
+
+void CborWriter::beginObject(size_t count) {
+    writeHead(5, count);
+}
+
+void CborWriter::beginArray(size_t count) {
+    writeHead(4, count);
+}
+
+void CborWriter::key(const char* name) {
+    writeText(name, std::strlen(name));
+}
+
+void CborWriter::key(const std::string& name) {
+    writeText(name.data(), name.size());
+}
+
+void CborWriter::value(double number) {
+    // Как и в JSON, нечисловые значения передаются как null
+    if (!std::isfinite(number)) {
+        null();
+        return;
+    }
+
+    float narrow = static_cast<float>(number);
+    if (static_cast<double>(narrow) == number) {
+        out_.push_back(static_cast<char>(0xFA));
+        appendBigEndian(out_, floatBits(narrow), 4);
+    } else {
+        out_.push_back(static_cast<char>(0xFB));
+        appendBigEndian(out_, doubleBits(number), 8);
+    }
+}
+
+void CborWriter::value(bool flag) {
+    out_.push_back(static_cast<char>(flag ? 0xF5 : 0xF4));
+}
+
+void CborWriter::value(const char* text) {
+    writeText(text, std::strlen(text));
+}
+
+void CborWriter::value(const std::string& text) {
+    writeText(text.data(), text.size());
+}
+
+void CborWriter::null() {
+    out_.push_back(static_cast<char>(0xF6));
+}
+
+std::string CborWriter::release() {
+    return std::move(out_);
+}
+
+// ---------------------------------------------------------- MessagePack
+
+MsgPackWriter::MsgPackWriter(size_t reserveBytes) {
+    out_.reserve(reserveBytes);
+}
+
+void MsgPackWriter::writeBigEndian(uint64_t value, size_t bytes) {
+    appendBigEndian(out_, value, bytes);
+}
+
+void MsgPackWriter::writeUnsigned(uint64_t number) {
+    if (number < 0x80) {
+        out_.push_back(static_cast<char>(number));
+    } else if (number <= 0xFF) {
+        out_.push_back(static_cast<char>(0xCC));
+        writeBigEndian(number, 1);
+    } else if (number <= 0xFFFF) {
+        out_.push_back(static_cast<char>(0xCD));
+        writeBigEndian(number, 2);
+    } else if (number <= 0xFFFFFFFFULL) {
+        out_.push_back(static_cast<char>(0xCE));
+        writeBigEndian(number, 4);
+    } else {
+        out_.push_back(static_cast<char>(0xCF));
+        writeBigEndian(number, 8);
+    }
+}
+
+void MsgPackWriter::writeSigned(int64_t number) {
+    if (number >= -32) {
+        out_.push_back(static_cast<char>(number));
+    } else if (number >= INT8_MIN) {
+        out_.push_back(static_cast<char>(0xD0));
+        writeBigEndian(static_cast<uint64_t>(number), 1);
+    } else if (number >= INT16_MIN) {
+        out_.push_back(static_cast<char>(0xD1));
+        writeBigEndian(static_cast<uint64_t>(number), 2);
+    } else if (number >= INT32_MIN) {
+        out_.push_back(static_cast<char>(0xD2));
+        writeBigEndian(static_cast<uint64_t>(number), 4);
+    } else {
+        out_.push_back(static_cast<char>(0xD3));
+        writeBigEndian(static_cast<uint64_t>(number), 8);
+    }
+}
+
+void MsgPackWriter::writeText(const char* text, size_t length) {
+    if (length < 32) {
+        out_.push_back(static_cast<char>(0xA0 | length));
+    } else if (length <= 0xFF) {
+        out_.push_back(static_cast<char>(0xD9));
+        writeBigEndian(length, 1);
+    } else if (length <= 0xFFFF) {
+        out_.push_back(static_cast<char>(0xDA));
+        writeBigEndian(length, 2);
+    } else {
+        out_.push_back(static_cast<char>(0xDB));
+        writeBigEndian(length, 4);
+    }
+    out_.append(text, length);
+}
+
+void MsgPackWriter::beginObject(size_t count) {
+    if (count < 16) {
+        out_.push_back(static_cast<char>(0x80 | count));
+    } else if (count <= 0xFFFF) {
+        out_.push_back(static_cast<char>(0xDE));
+        writeBigEndian(count, 2);
+    } else {
+        out_.push_back(static_cast<char>(0xDF));
+        writeBigEndian(count, 4);
+    }
+}
+
+void MsgPackWriter::beginArray(size_t count) {
+    if (count < 16) {
+        out_.push_back(static_cast<char>(0x90 | count));
+    } else if (count <= 0xFFFF) {
+        out_.push_back(static_cast<char>(0xDC));
+        writeBigEndian(count, 2);
+    } else {
+        out_.push_back(static_cast<char>(0xDD));
+        writeBigEndian(count, 4);
+    }
+}
+
+void MsgPackWriter::key(const char* name) {
+    writeText(name, std::strlen(name));
+}
+
+void MsgPackWriter::key(const std::string& name) {
+    writeText(name.data(), name.size());
+}
+
+void MsgPackWriter::value(double number) {
+    if (!std::isfinite(number)) {
+        null();
+        return;
+    }
+
+    float narrow = static_cast<float>(number);
+    if (static_cast<double>(narrow) == number) {
+        out_.push_back(static_cast<char>(0xCA));
+        writeBigEndian(floatBits(narrow), 4);
+    } else {
+        out_.push_back(static_cast<char>(0xCB));
+        writeBigEndian(doubleBits(number), 8);
+    }
+}
+
+void MsgPackWriter::value(bool flag) {
+    out_.push_back(static_cast<char>(flag ? 0xC3 : 0xC2));
+}
+
+void MsgPackWriter::value(const char* text) {
+    writeText(text, std::strlen(text));
+}
+
+void MsgPackWriter::value(const std::string& text) {
+    writeText(text.data(), text.size());
+}
+
+void MsgPackWriter::null() {
+    out_.push_back(static_cast<char>(0xC0));
+}
+
+std::string MsgPackWriter::release() {
+    return std::move(out_);
+}
+
+// ------------------------------------------------------------- Columnar
+
+ColumnarWriter::ColumnarWriter(bool float32, size_t rows, const std::vector<std::string>& columns)
+    : float32_(float32), rows_(rows) {
+    if (columns.size() > 0xFFFF || rows > 0xFFFFFFFFULL) {
+        throw std::length_error("Packed response is too large");
+    }
+
+    size_t header = 12;
+    for (const auto& name : columns) {
+        header += 1 + std::min<size_t>(name.size(), 255);
+    }
+    size_t padded = (header + 7) / 8 * 8;
+    out_.reserve(padded + columns.size() * rows * (float32 ? 4 : 8));
+
+    out_.append("DXC1", 4);
+    out_.push_back(static_cast<char>(float32 ? 2 : 1));
+    out_.push_back('\0');
+    appendLittleEndian(out_, columns.size(), 2);
+    appendLittleEndian(out_, rows, 4);
+    for (const auto& name : columns) {
+        size_t length = std::min<size_t>(name.size(), 255);
+        out_.push_back(static_cast<char>(length));
+        out_.append(name.data(), length);
+    }
+    out_.append(padded - header, '\0');
+}
+
+void ColumnarWriter::appendFloat(float value) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    out_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+#else
+    appendLittleEndian(out_, floatBits(value), 4);
+#endif
+}
+
+void ColumnarWriter::appendDouble(double value) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    out_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+#else
+    appendLittleEndian(out_, doubleBits(value), 8);
+#endif
+}
+
+std::string ColumnarWriter::release() {
+    return std::move(out_);
+}
+
+} // namespace derivx
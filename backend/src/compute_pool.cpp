@@ -0,0 +1,207 @@
+#include "../include/compute_pool.hpp"
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace derivx {
+
+namespace {
+
+// Пул и индекс текущего рабочего потока
+thread_local const ComputePool* tlsPool = nullptr;
+thread_local long tlsWorkerIndex = -1;
+
+void pinCurrentThread(size_t cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(static_cast<int>(cpu % CPU_SETSIZE), &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)cpu;
+#endif
+}
+
+} // namespace
+
+ComputePool::ComputePool(const ComputePoolConfig& config) {
+    size_t workerCount = config.workerCount;
+    if (workerCount == 0) {
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    queues_.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+
+    workers_.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers_.emplace_back([this, i, pin = config.pinThreads]() { workerLoop(i, pin); });
+    }
+}
+
+ComputePool::~ComputePool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+long ComputePool::currentWorkerIndex() const {
+    return tlsPool == this ? tlsWorkerIndex : -1;
+}
+
+void ComputePool::submit(Task task, TaskPriority priority) {
+    // Счетчик увеличивается до публикации, чтобы не уйти в минус, если задачу заберут сразу
+    pending_.fetch_add(1, std::memory_order_acq_rel);
+
+    long index = currentWorkerIndex();
+    WorkerQueue& queue = priority == TaskPriority::HIGH ? urgent_
+                       : index >= 0 ? *queues_[static_cast<size_t>(index)] : injection_;
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+        if (&queue == &urgent_) {
+            urgentPending_.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+    }
+    wake_.notify_one();
+}
+
+bool ComputePool::tryRunOne(long index) {
+    Task task;
+
+    // 0. Приоритетная очередь, по порядку поступления
+    if (urgentPending_.load(std::memory_order_acquire) > 0) {
+        std::lock_guard<std::mutex> lock(urgent_.mutex);
+        if (!urgent_.tasks.empty()) {
+            task = std::move(urgent_.tasks.front());
+            urgent_.tasks.pop_front();
+            urgentPending_.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    // 1. Своя очередь, с конца
+    if (!task && index >= 0) {
+        WorkerQueue& own = *queues_[static_cast<size_t>(index)];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+        }
+    }
+
+    // 2. Общая очередь внешних задач
+    if (!task) {
+        std::lock_guard<std::mutex> lock(injection_.mutex);
+        if (!injection_.tasks.empty()) {
+            task = std::move(injection_.tasks.front());
+            injection_.tasks.pop_front();
+        }
+    }
+
+    // 3. Перехват с начала чужих очередей
+    if (!task) {
+        size_t count = queues_.size();
+        size_t start = index >= 0 ? static_cast<size_t>(index) + 1 : 0;
+        for (size_t i = 0; i < count && !task; ++i) {
+            WorkerQueue& victim = *queues_[(start + i) % count];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+            }
+        }
+    }
+
+    if (!task) {
+        return false;
+    }
+
+    pending_.fetch_sub(1, std::memory_order_acq_rel);
+    task();
+    return true;
+}
+
+void ComputePool::workerLoop(size_t index, bool pin) {
+    tlsPool = this;
+    tlsWorkerIndex = static_cast<long>(index);
+    if (pin) {
+        pinCurrentThread(index);
+    }
+
+    while (true) {
+        if (tryRunOne(static_cast<long>(index))) {
+            continue;
+        }
+
+        // Задача учтена, но еще не опубликована - короткое ожидание
+        if (pending_.load(std::memory_order_acquire) > 0) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        wake_.wait(lock, [this]() {
+            return stopping_.load() || pending_.load(std::memory_order_acquire) > 0;
+        });
+
+        // Дорабатываем очередь до конца, чтобы каждый запрос получил ответ
+        if (stopping_.load() && pending_.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+    }
+}
+
+void ComputePool::runChunks(ForState& state) {
+    size_t chunk;
+    while ((chunk = state.next.fetch_add(1, std::memory_order_relaxed)) < state.chunks) {
+        size_t lo = state.begin + chunk * state.chunkSize;
+        size_t hi = std::min(lo + state.chunkSize, state.end);
+        try {
+            state.body(lo, hi);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(state.errorMutex);
+            if (!state.error) {
+                state.error = std::current_exception();
+            }
+        }
+        state.done.fetch_add(1, std::memory_order_acq_rel);
+    }
+}
+
+void ComputePool::runParallel(const std::shared_ptr<ForState>& state) {
+    // Помощники держат state через shared_ptr: опоздавший помощник
+    // увидит, что частей не осталось, и не тронет body
+    size_t helpers = std::min(state->chunks - 1, workers_.size());
+    for (size_t i = 0; i < helpers; ++i) {
+        submit([state]() { runChunks(*state); });
+    }
+
+    runChunks(*state);
+
+    // Ждем чужие части; рабочий поток пула тем временем выполняет другие задачи
+    long index = currentWorkerIndex();
+    while (state->done.load(std::memory_order_acquire) < state->chunks) {
+        if (index < 0 || !tryRunOne(index)) {
+            std::this_thread::yield();
+        }
+    }
+
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+} // namespace derivx
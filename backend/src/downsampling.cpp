@@ -0,0 +1,124 @@
+#include "../include/downsampling.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace derivx {
+
+std::vector<std::pair<double, double>> Downsampling::largestTriangleThreeBuckets(
+    const std::vector<std::pair<double, double>>& points,
+    size_t maxPoints
+) {
+    std::vector<std::pair<double, double>> sampled(sampledCapacity(points.size(), maxPoints));
+    sampled.resize(largestTriangleThreeBuckets(points.data(), points.size(), maxPoints, sampled.data()));
+    return sampled;
+}
+
+size_t Downsampling::largestTriangleThreeBuckets(
+    const std::pair<double, double>* points,
+    size_t n,
+    size_t maxPoints,
+    std::pair<double, double>* out
+) {
+    if (maxPoints >= n) {
+        std::copy(points, points + n, out);
+        return n;
+    }
+    if (maxPoints < 3) {
+        // Вырожденный случай: концы кривой, но не больше maxPoints точек
+        if (maxPoints > 0) {
+            out[0] = points[0];
+        }
+        if (maxPoints > 1) {
+            out[1] = points[n - 1];
+        }
+        return maxPoints;
+    }
+
+    size_t written = 0;
+    out[written++] = points[0];
+
+    // Внутренние точки делятся на maxPoints - 2 корзины равного размера
+    const double bucketSize = static_cast<double>(n - 2) / static_cast<double>(maxPoints - 2);
+    size_t selected = 0;
+
+    for (size_t bucket = 0; bucket < maxPoints - 2; ++bucket) {
+        size_t begin = static_cast<size_t>(std::floor(bucket * bucketSize)) + 1;
+        size_t end = static_cast<size_t>(std::floor((bucket + 1) * bucketSize)) + 1;
+        end = std::min(end, n - 1);
+
+        // Средняя точка следующей корзины (для последней - последняя точка кривой)
+        size_t nextBegin = end;
+        size_t nextEnd = std::min(static_cast<size_t>(std::floor((bucket + 2) * bucketSize)) + 1, n);
+        if (bucket + 1 == maxPoints - 2) {
+            nextBegin = n - 1;
+            nextEnd = n;
+        }
+        double avgX = 0.0;
+        double avgY = 0.0;
+        for (size_t i = nextBegin; i < nextEnd; ++i) {
+            avgX += points[i].first;
+            avgY += points[i].second;
+        }
+        const double count = static_cast<double>(std::max<size_t>(nextEnd - nextBegin, 1));
+        avgX /= count;
+        avgY /= count;
+
+        // Точка корзины с наибольшей площадью треугольника (selected, i, avg)
+        const double ax = points[selected].first;
+        const double ay = points[selected].second;
+        double maxArea = -1.0;
+        size_t best = begin;
+        for (size_t i = begin; i < end; ++i) {
+            double area = std::abs((ax - avgX) * (points[i].second - ay)
+                                 - (ax - points[i].first) * (avgY - ay));
+            if (area > maxArea) {
+                maxArea = area;
+                best = i;
+            }
+        }
+
+        out[written++] = points[best];
+        selected = best;
+    }
+
+    out[written++] = points[n - 1];
+    return written;
+}
+
+std::vector<OHLCV> Downsampling::aggregateCandles(
+    OHLCVView candles,
+    size_t maxBuckets
+) {
+    const size_t n = candles.size();
+    if (maxBuckets == 0 || maxBuckets >= n) {
+        return std::vector<OHLCV>(candles.begin(), candles.end());
+    }
+
+    std::vector<OHLCV> buckets;
+    buckets.reserve(maxBuckets);
+
+    for (size_t bucket = 0; bucket < maxBuckets; ++bucket) {
+        size_t begin = bucket * n / maxBuckets;
+        size_t end = (bucket + 1) * n / maxBuckets;
+
+        OHLCV aggregated = candles[begin];
+        double high = aggregated.high;
+        double low = aggregated.low;
+        double volume = 0.0;
+        for (size_t i = begin; i < end; ++i) {
+            high = std::max(high, candles[i].high);
+            low = std::min(low, candles[i].low);
+            volume += candles[i].volume;
+        }
+
+        aggregated.high = high;
+        aggregated.low = low;
+        aggregated.close = candles[end - 1].close;
+        aggregated.volume = volume;
+        buckets.push_back(std::move(aggregated));
+    }
+
+    return buckets;
+}
+
+} // namespace derivx
@@ -0,0 +1,338 @@
+#include "../include/fourier_pricing.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace derivx {
+
+namespace {
+
+using Complex = std::complex<double>;
+
+const double PI = 3.14159265358979323846;
+const Complex I(0.0, 1.0);
+
+/**
+ * Показатель характеристической функции ln(S_T / S_0) без сноса (r - q) T:
+ * для Merton и Kou - с компенсатором, чтобы E[S_T] = S_0 e^{(r-q)T}
+ */
+Complex exponent(const FourierModel& model, Complex u, double T) {
+    Complex iu = I * u;
+    switch (model.type) {
+        case FourierModelType::HESTON: {
+            // Форма Albrecher et al. ("little trap"): без разрывов ветви логарифма
+            double xi2 = model.xi * model.xi;
+            Complex beta = model.kappa - model.rho * model.xi * iu;
+            Complex d = std::sqrt(beta * beta + xi2 * (iu + u * u));
+            Complex g = (beta - d) / (beta + d);
+            Complex decay = std::exp(-d * T);
+            Complex C = model.kappa * model.theta / xi2 *
+                        ((beta - d) * T - 2.0 * std::log((1.0 - g * decay) / (1.0 - g)));
+            Complex D = (beta - d) / xi2 * (1.0 - decay) / (1.0 - g * decay);
+            return C + D * model.v0;
+        }
+        case FourierModelType::MERTON: {
+            double s2 = model.sigma * model.sigma;
+            double j2 = model.jumpVolatility * model.jumpVolatility;
+            double compensator = std::exp(model.jumpMean + 0.5 * j2) - 1.0;
+            Complex jumps = std::exp(iu * model.jumpMean - 0.5 * j2 * u * u) - 1.0;
+            return T * (iu * (-0.5 * s2 - model.lambda * compensator) - 0.5 * s2 * u * u + model.lambda * jumps);
+        }
+        case FourierModelType::KOU:
+        default: {
+            double s2 = model.sigma * model.sigma;
+            double p = model.upProbability;
+            double eta1 = model.upRate;
+            double eta2 = model.downRate;
+            double compensator = p * eta1 / (eta1 - 1.0) + (1.0 - p) * eta2 / (eta2 + 1.0) - 1.0;
+            Complex jumps = p * eta1 / (eta1 - iu) + (1.0 - p) * eta2 / (eta2 + iu) - 1.0;
+            return T * (iu * (-0.5 * s2 - model.lambda * compensator) - 0.5 * s2 * u * u + model.lambda * jumps);
+        }
+    }
+}
+
+/**
+ * Кумулянты ln(S_T / S_0) по характеристической функции в малых точках:
+ * ln phi(h) ~ i c1 h - c2 h^2 / 2 + c4 h^4 / 24. c4 - оценка по точкам h и 2h
+ * в масштабе отклонения (нужна только для ширины отрезка COS).
+ */
+void cumulants(const FourierModel& model, double T, double drift, double& c1, double& c2, double& c4) {
+    const double h = 1e-3;
+    Complex value = exponent(model, Complex(h, 0.0), T);
+    c1 = value.imag() / h + drift;
+    c2 = std::max(-2.0 * value.real() / (h * h), 1e-12);
+
+    double scaled = 0.2 / std::sqrt(c2);
+    double near = exponent(model, Complex(scaled, 0.0), T).real();
+    double far = exponent(model, Complex(2.0 * scaled, 0.0), T).real();
+    c4 = std::max(2.0 * (far - 4.0 * near) / std::pow(scaled, 4.0), 0.0);
+}
+
+/**
+ * COS: put-коэффициенты (chi - psi по Fang-Oosterlee) для выплаты K (1 - e^y)^+ на [a, 0]
+ */
+void putCoefficients(double a, double b, size_t terms, std::vector<double>& coefficients) {
+    coefficients.resize(terms);
+    double width = b - a;
+    for (size_t k = 0; k < terms; ++k) {
+        double w = static_cast<double>(k) * PI / width;
+        // chi_k(a, 0) = int_a^0 e^y cos(w (y - a)) dy
+        double chi = (std::cos(-w * a) - std::exp(a) + w * std::sin(-w * a)) / (1.0 + w * w);
+        // psi_k(a, 0) = int_a^0 cos(w (y - a)) dy
+        double psi = k == 0 ? -a : std::sin(-w * a) / w;
+        coefficients[k] = 2.0 / width * (psi - chi);
+    }
+}
+
+void priceCos(const FourierModel& model, const MarketParams& market, const double* strikes, size_t count,
+              double* puts) {
+    double T = market.timeToExpiration;
+    double drift = (market.riskFreeRate - market.dividendYield) * T;
+    double c1, c2, c4;
+    cumulants(model, T, drift, c1, c2, c4);
+
+    // Отрезок для y = ln(S_T / K) общий для всех страйков: +-L sqrt(c2 + sqrt(c4))
+    // вокруг среднего (тяжелые хвосты расширяют отрезок), сдвинутый на крайние ln(S / K)
+    double lowX = 0.0;
+    double highX = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        double x = std::log(market.spotPrice / strikes[i]);
+        lowX = std::min(lowX, x);
+        highX = std::max(highX, x);
+    }
+    const double L = 12.0;
+    double deviation = std::sqrt(c2);
+    double reach = L * std::sqrt(c2 + std::sqrt(c4));
+    double a = lowX + c1 - reach;
+    double b = highX + c1 + reach;
+
+    // Число слагаемых растет с шириной отрезка относительно отклонения
+    size_t terms = static_cast<size_t>(std::min(std::max(6.0 * (b - a) / deviation, 128.0), 8192.0));
+
+    std::vector<double> coefficients;
+    putCoefficients(a, b, terms, coefficients);
+
+    // weights[k] = phi(w_k) e^{-i w_k a} V_k (первое слагаемое с весом 1/2)
+    std::vector<Complex> weights(terms);
+    double width = b - a;
+    for (size_t k = 0; k < terms; ++k) {
+        double w = static_cast<double>(k) * PI / width;
+        Complex phi = std::exp(exponent(model, Complex(w, 0.0), T) + I * w * drift);
+        weights[k] = phi * std::exp(-I * w * a) * coefficients[k];
+    }
+    weights[0] *= 0.5;
+
+    // Цена страйка: K e^{-rT} Re sum weights[k] z^k, z = e^{i pi x / (b - a)}
+    double discount = std::exp(-market.riskFreeRate * T);
+    for (size_t i = 0; i < count; ++i) {
+        double x = std::log(market.spotPrice / strikes[i]);
+        Complex z = std::exp(I * (PI * x / width));
+        Complex power(1.0, 0.0);
+        double sum = 0.0;
+        for (size_t k = 0; k < terms; ++k) {
+            sum += weights[k].real() * power.real() - weights[k].imag() * power.imag();
+            power *= z;
+        }
+        puts[i] = std::max(strikes[i] * discount * sum, 0.0);
+    }
+}
+
+/**
+ * Итеративное БПФ по основанию 2 (размер - степень двойки)
+ */
+void fft(std::vector<Complex>& data) {
+    size_t n = data.size();
+    for (size_t i = 1, j = 0; i < n; ++i) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(data[i], data[j]);
+        }
+    }
+    for (size_t length = 2; length <= n; length <<= 1) {
+        Complex step = std::exp(Complex(0.0, -2.0 * PI / static_cast<double>(length)));
+        for (size_t start = 0; start < n; start += length) {
+            Complex twiddle(1.0, 0.0);
+            for (size_t k = 0; k < length / 2; ++k) {
+                Complex even = data[start + k];
+                Complex odd = data[start + k + length / 2] * twiddle;
+                data[start + k] = even + odd;
+                data[start + k + length / 2] = even - odd;
+                twiddle *= step;
+            }
+        }
+    }
+}
+
+void priceCarrMadan(const FourierModel& model, const MarketParams& market, const double* strikes, size_t count,
+                    double* calls) {
+    double T = market.timeToExpiration;
+    double drift = (market.riskFreeRate - market.dividendYield) * T;
+    double discount = std::exp(-market.riskFreeRate * T);
+
+    // Демпфирование alpha: E[S_T^{alpha + 1}] должен быть конечен (у Kou - alpha + 1 < eta1)
+    double alpha = 0.75;
+    if (model.type == FourierModelType::KOU) {
+        alpha = std::min(alpha, 0.5 * (model.upRate - 1.0));
+    }
+
+    // Сетка: шаг по частоте eta, по log-страйку (относительно спота) lambda = 2 pi / (N eta)
+    const size_t N = 4096;
+    const double eta = 0.1;
+    double lambda = 2.0 * PI / (static_cast<double>(N) * eta);
+    double half = 0.5 * static_cast<double>(N) * lambda;
+
+    std::vector<Complex> data(N);
+    for (size_t j = 0; j < N; ++j) {
+        double v = eta * static_cast<double>(j);
+        Complex u(v, -(alpha + 1.0));
+        Complex phi = std::exp(exponent(model, u, T) + I * u * drift);
+        Complex psi = discount * phi / (alpha * alpha + alpha - v * v + I * (2.0 * alpha + 1.0) * v);
+        // Веса Симпсона
+        double simpson = (3.0 + ((j & 1) ? 1.0 : -1.0) - (j == 0 ? 1.0 : 0.0)) / 3.0;
+        data[j] = std::exp(I * (half * v)) * psi * (eta * simpson);
+    }
+    fft(data);
+
+    // Цена call в узле u: S e^{-alpha k_u} / pi * Re(...), k_u = -half + lambda u (ln(K / S));
+    // между узлами - кубическая интерполяция по четырем соседним
+    auto node = [&](size_t u) {
+        double ku = -half + lambda * static_cast<double>(u);
+        return std::exp(-alpha * ku) / PI * data[u].real();
+    };
+    for (size_t i = 0; i < count; ++i) {
+        double k = std::log(strikes[i] / market.spotPrice);
+        double position = (k + half) / lambda;
+        size_t lower = static_cast<size_t>(std::min(std::max(std::floor(position), 1.0), static_cast<double>(N - 3)));
+        double t = position - static_cast<double>(lower);
+        double p0 = node(lower - 1);
+        double p1 = node(lower);
+        double p2 = node(lower + 1);
+        double p3 = node(lower + 2);
+        double value = p1 + t * (-p0 / 3.0 - p1 / 2.0 + p2 - p3 / 6.0) + t * t * ((p0 + p2) / 2.0 - p1) +
+                       t * t * t * ((p3 - p0) / 6.0 + (p1 - p2) / 2.0);
+        calls[i] = std::max(market.spotPrice * value, 0.0);
+    }
+}
+
+} // namespace
+
+bool FourierModel::valid() const {
+    switch (type) {
+        case FourierModelType::HESTON:
+            return v0 >= 0 && kappa > 0 && theta >= 0 && xi > 0 && rho > -1 && rho < 1;
+        case FourierModelType::MERTON:
+            return sigma >= 0 && lambda >= 0 && jumpVolatility >= 0 && std::isfinite(jumpMean);
+        case FourierModelType::KOU:
+            return sigma >= 0 && lambda >= 0 && upProbability >= 0 && upProbability <= 1 &&
+                   upRate > 1 && downRate > 0;
+    }
+    return false;
+}
+
+std::complex<double> FourierPricing::characteristic(
+    const FourierModel& model,
+    std::complex<double> u,
+    double timeToExpiration,
+    double riskFreeRate,
+    double dividendYield
+) {
+    double drift = (riskFreeRate - dividendYield) * timeToExpiration;
+    return std::exp(exponent(model, u, timeToExpiration) + I * u * drift);
+}
+
+std::complex<double> FourierPricing::centeredCharacteristic(const FourierModel& model, double u, double horizon) {
+    // Снос убирается вместе с первым кумулянтом: сравнивается только форма распределения
+    double c1, c2, c4;
+    cumulants(model, horizon, 0.0, c1, c2, c4);
+    return std::exp(exponent(model, Complex(u, 0.0), horizon) - I * (u * c1));
+}
+
+void FourierPricing::priceChain(
+    const FourierModel& model,
+    const MarketParams& market,
+    const double* strikes,
+    size_t count,
+    FourierMethod method,
+    double* calls,
+    double* puts
+) {
+    if (!model.valid()) {
+        throw std::invalid_argument("Invalid model parameters");
+    }
+    if (count == 0) {
+        return;
+    }
+
+    // Паритет: C - P = S e^{-qT} - K e^{-rT}
+    double T = market.timeToExpiration;
+    double forwardValue = market.spotPrice * std::exp(-market.dividendYield * T);
+    double discount = std::exp(-market.riskFreeRate * T);
+    if (T <= 0.0) {
+        for (size_t i = 0; i < count; ++i) {
+            calls[i] = std::max(market.spotPrice - strikes[i], 0.0);
+            puts[i] = std::max(strikes[i] - market.spotPrice, 0.0);
+        }
+        return;
+    }
+
+    // Цены ограничены границами без арбитража: при экстремальных параметрах
+    // (дисперсия в десятки единиц) погрешность обращения больше самой цены
+    if (method == FourierMethod::COS) {
+        priceCos(model, market, strikes, count, puts);
+        for (size_t i = 0; i < count; ++i) {
+            double strikeValue = strikes[i] * discount;
+            puts[i] = std::min(std::max(puts[i], strikeValue - forwardValue), strikeValue);
+            calls[i] = std::max(puts[i] + forwardValue - strikeValue, 0.0);
+        }
+    } else {
+        priceCarrMadan(model, market, strikes, count, calls);
+        for (size_t i = 0; i < count; ++i) {
+            double strikeValue = strikes[i] * discount;
+            calls[i] = std::min(std::max(calls[i], forwardValue - strikeValue), forwardValue);
+            puts[i] = std::max(calls[i] - forwardValue + strikeValue, 0.0);
+        }
+    }
+}
+
+const char* FourierPricing::modelName(FourierModelType type) {
+    switch (type) {
+        case FourierModelType::HESTON: return "heston";
+        case FourierModelType::MERTON: return "merton";
+        case FourierModelType::KOU: return "kou";
+    }
+    return "merton";
+}
+
+bool FourierPricing::parseModel(const std::string& name, FourierModelType& type) {
+    if (name == "heston") {
+        type = FourierModelType::HESTON;
+    } else if (name == "merton") {
+        type = FourierModelType::MERTON;
+    } else if (name == "kou") {
+        type = FourierModelType::KOU;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* FourierPricing::methodName(FourierMethod method) {
+    return method == FourierMethod::COS ? "cos" : "fft";
+}
+
+bool FourierPricing::parseMethod(const std::string& name, FourierMethod& method) {
+    if (name == "cos") {
+        method = FourierMethod::COS;
+    } else if (name == "fft") {
+        method = FourierMethod::CARR_MADAN;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+} // namespace derivx
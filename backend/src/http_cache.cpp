@@ -0,0 +1,182 @@
+#include "../include/http_cache.hpp"
+#include "../include/volatility.hpp"
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+namespace derivx {
+
+// ------------------------------------------------------------ ResponseCache
+
+ResponseCache::ResponseCache(size_t budgetBytes)
+    : budgetBytes_(budgetBytes) {
+}
+
+void ResponseCache::setBudget(size_t budgetBytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    budgetBytes_ = budgetBytes;
+    evictLocked();
+}
+
+size_t ResponseCache::entryBytes(const std::string& key, const std::string& body) {
+    // Ключ хранится дважды (таблица и список) плюс служебные структуры
+    return body.size() + key.size() * 2 + 128;
+}
+
+std::shared_ptr<const std::string> ResponseCache::find(const std::string& key, uint64_t version) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end() || it->second.version != version) {
+        misses_++;
+        return nullptr;
+    }
+    usage_.splice(usage_.begin(), usage_, it->second.position);
+    hits_++;
+    return it->second.body;
+}
+
+void ResponseCache::store(const std::string& key, uint64_t version, std::shared_ptr<const std::string> body) {
+    if (!body) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t bytes = entryBytes(key, *body);
+    if (bytes > budgetBytes_) {
+        return;
+    }
+
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+        // Тело прежней версии больше не нужно
+        bytes_ -= entryBytes(key, *it->second.body);
+        it->second.version = version;
+        it->second.body = std::move(body);
+        usage_.splice(usage_.begin(), usage_, it->second.position);
+    } else {
+        usage_.push_front(key);
+        Entry& entry = entries_[key];
+        entry.version = version;
+        entry.body = std::move(body);
+        entry.position = usage_.begin();
+    }
+    bytes_ += bytes;
+    evictLocked();
+}
+
+void ResponseCache::evictLocked() {
+    while (bytes_ > budgetBytes_ && !usage_.empty()) {
+        auto it = entries_.find(usage_.back());
+        bytes_ -= entryBytes(it->first, *it->second.body);
+        entries_.erase(it);
+        usage_.pop_back();
+    }
+}
+
+void ResponseCache::recordNotModified() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    notModified_++;
+}
+
+ResponseCacheStats ResponseCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ResponseCacheStats result;
+    result.hits = hits_;
+    result.misses = misses_;
+    result.notModified = notModified_;
+    result.entries = entries_.size();
+    result.bytes = bytes_;
+    result.budgetBytes = budgetBytes_;
+    return result;
+}
+
+// ------------------------------------------------------------- HttpCaching
+
+uint64_t HttpCaching::hash(const void* data, size_t size, uint64_t seed) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t result = seed;
+    for (size_t i = 0; i < size; ++i) {
+        result ^= bytes[i];
+        result *= 1099511628211ULL;
+    }
+    return result;
+}
+
+std::string HttpCaching::makeETag(uint64_t version, const std::string& requestKey) {
+    char buffer[48];
+    std::snprintf(buffer, sizeof(buffer), "\"%016llx-%016llx\"",
+                  static_cast<unsigned long long>(version),
+                  static_cast<unsigned long long>(hash(requestKey.data(), requestKey.size())));
+    return buffer;
+}
+
+bool HttpCaching::etagMatches(const std::string& ifNoneMatch, const std::string& etag) {
+    // Для If-None-Match сравнение слабое: W/"x" совпадает с "x"
+    size_t pos = 0;
+    while (pos < ifNoneMatch.size()) {
+        size_t comma = ifNoneMatch.find(',', pos);
+        if (comma == std::string::npos) {
+            comma = ifNoneMatch.size();
+        }
+        size_t begin = ifNoneMatch.find_first_not_of(" \t", pos);
+        size_t end = ifNoneMatch.find_last_not_of(" \t", comma - 1);
+        pos = comma + 1;
+        if (begin == std::string::npos || begin >= comma || end < begin) {
+            continue;
+        }
+
+        std::string tag = ifNoneMatch.substr(begin, end - begin + 1);
+        if (tag == "*") {
+            return true;
+        }
+        if (tag.compare(0, 2, "W/") == 0) {
+            tag.erase(0, 2);
+        }
+        if (tag == etag) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string HttpCaching::formatHttpDate(int64_t unixTime) {
+    static const char* days[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+    static const char* months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                   "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+    std::time_t time = static_cast<std::time_t>(unixTime);
+    std::tm utc{};
+    gmtime_r(&time, &utc);
+
+    char buffer[40];
+    std::snprintf(buffer, sizeof(buffer), "%s, %02d %s %04d %02d:%02d:%02d GMT",
+                  days[utc.tm_wday], utc.tm_mday, months[utc.tm_mon], utc.tm_year + 1900,
+                  utc.tm_hour, utc.tm_min, utc.tm_sec);
+    return buffer;
+}
+
+bool HttpCaching::parseHttpDate(const std::string& text, int64_t& unixTime) {
+    static const char* months = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+    char weekday[4] = {0};
+    char month[4] = {0};
+    int day = 0, year = 0, hour = 0, minute = 0, second = 0;
+    if (std::sscanf(text.c_str(), "%3s, %d %3s %d %d:%d:%d GMT",
+                    weekday, &day, month, &year, &hour, &minute, &second) != 7) {
+        return false;
+    }
+
+    const char* found = std::strstr(months, month);
+    if (found == nullptr || std::strlen(month) != 3 || (found - months) % 3 != 0) {
+        return false;
+    }
+    int monthIndex = static_cast<int>(found - months) / 3 + 1;
+
+    // Разбор календарной даты - тот же, что и для дат в CSV
+    char normalized[32];
+    std::snprintf(normalized, sizeof(normalized), "%04d-%02d-%02d %02d:%02d:%02d",
+                  year, monthIndex, day, hour, minute, second);
+    return VolatilityCalculator::parseTimestamp(normalized, unixTime);
+}
+
+} // namespace derivx
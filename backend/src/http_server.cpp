@@ -0,0 +1,1080 @@
+#include "../include/http_server.hpp"
+#include "../include/http_cache.hpp"
+#include "../include/json_writer.hpp"
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <strings.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+namespace derivx {
+
+namespace {
+
+constexpr size_t READ_CHUNK = 16 * 1024;
+constexpr size_t PROCESS_THRESHOLD = 4 * READ_CHUNK;   // Разбор, не дочитывая сокет до конца
+constexpr size_t OUTPUT_HIGH_WATER = 1024 * 1024;      // Больше неотправленного - разбор на паузе
+constexpr size_t DIRECT_WRITE_BYTES = 16 * 1024;       // Тело от этого размера уходит без копирования
+constexpr size_t POOLED_BUFFER_LIMIT = 256 * 1024;     // Большие буферы в пул не возвращаются
+constexpr size_t BUFFER_POOL_SIZE = 1024;
+constexpr int MAX_EVENTS = 256;
+constexpr auto STREAM_TICK = std::chrono::milliseconds(50);
+constexpr auto SWEEP_INTERVAL = std::chrono::seconds(1);
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * Непрерывный буфер с позициями чтения и записи.
+ * Место в начале освобождается сдвигом, только когда не хватает места в конце.
+ */
+class Buffer {
+public:
+    const char* data() const { return storage_.data() + begin_; }
+    size_t size() const { return end_ - begin_; }
+    bool empty() const { return begin_ == end_; }
+    size_t capacity() const { return storage_.size(); }
+
+    void consume(size_t count) {
+        begin_ += count;
+        if (begin_ == end_) {
+            begin_ = end_ = 0;
+        }
+    }
+
+    char* prepare(size_t count) {
+        if (storage_.size() - end_ < count) {
+            if (begin_ > 0) {
+                std::memmove(storage_.data(), storage_.data() + begin_, end_ - begin_);
+                end_ -= begin_;
+                begin_ = 0;
+            }
+            if (storage_.size() - end_ < count) {
+                storage_.resize(std::max(storage_.size() * 2, end_ + count));
+            }
+        }
+        return storage_.data() + end_;
+    }
+
+    void commit(size_t count) { end_ += count; }
+
+    void append(const char* text, size_t count) {
+        if (count > 0) {
+            std::memcpy(prepare(count), text, count);
+            commit(count);
+        }
+    }
+
+    void append(const std::string& text) { append(text.data(), text.size()); }
+
+    void clear() { begin_ = end_ = 0; }
+
+private:
+    std::vector<char> storage_;
+    size_t begin_ = 0;
+    size_t end_ = 0;
+};
+
+using BufferPtr = std::unique_ptr<Buffer>;
+
+/**
+ * Соединение принадлежит одному потоку; индекс в таблице - дескриптор
+ */
+struct Connection {
+    int fd = -1;
+    BufferPtr in;
+    BufferPtr out;
+    size_t headerScanned = 0;     // Сколько байт начала входного буфера уже проверено на конец заголовков
+    bool continueSent = false;    // Отправлен 100 Continue для текущего запроса
+    bool closeAfterFlush = false;
+    bool paused = false;          // Разбор остановлен до отправки накопленных ответов
+    bool failed = false;          // Ошибка записи - закрыть при первой возможности
+    std::shared_ptr<HttpStream> stream;
+    bool streamChunked = false;
+    std::shared_ptr<HttpCompletion> pending;   // Отложенный ответ на текущий запрос
+    Clock::time_point lastActive;
+};
+
+/**
+ * Параметры ответа, зависящие от запроса
+ */
+struct ReplyContext {
+    int minorVersion = 1;
+    bool head = false;
+    bool keepAlive = true;
+};
+
+const char* reasonPhrase(int status) {
+    switch (status) {
+        case 100: return "Continue";
+        case 200: return "OK";
+        case 204: return "No Content";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 408: return "Request Timeout";
+        case 411: return "Length Required";
+        case 413: return "Payload Too Large";
+        case 429: return "Too Many Requests";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        case 503: return "Service Unavailable";
+        case 504: return "Gateway Timeout";
+        default: return "Unknown";
+    }
+}
+
+// Поиск лексемы в списке через запятую (Connection: keep-alive, Upgrade)
+bool hasToken(const std::string& list, const char* token) {
+    size_t length = std::strlen(token);
+    size_t position = 0;
+    while (position < list.size()) {
+        while (position < list.size() && (list[position] == ' ' || list[position] == '\t' || list[position] == ',')) {
+            ++position;
+        }
+        size_t end = list.find(',', position);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        size_t last = end;
+        while (last > position && (list[last - 1] == ' ' || list[last - 1] == '\t')) {
+            --last;
+        }
+        if (last - position == length && strncasecmp(list.data() + position, token, length) == 0) {
+            return true;
+        }
+        position = end + 1;
+    }
+    return false;
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+void pinCurrentThread(size_t cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(static_cast<int>(cpu % CPU_SETSIZE), &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+std::string errorBody(const std::string& message) {
+    JsonWriter writer(message.size() + 16);
+    writer.beginObject();
+    writer.key("error");
+    writer.value(message);
+    writer.endObject();
+    return writer.release();
+}
+
+} // namespace
+
+// ------------------------------------------------------------- HttpRequest
+
+const std::string* HttpRequest::header(const char* name) const {
+    for (const auto& entry : headers) {
+        if (strcasecmp(entry.first.c_str(), name) == 0) {
+            return &entry.second;
+        }
+    }
+    return nullptr;
+}
+
+std::map<std::string, std::string> HttpRequest::queryParams() const {
+    std::map<std::string, std::string> params;
+    size_t position = 0;
+    while (position < query.size()) {
+        size_t end = query.find('&', position);
+        if (end == std::string::npos) {
+            end = query.size();
+        }
+        size_t equals = query.find('=', position);
+        if (equals > end) {
+            equals = end;
+        }
+        if (equals > position) {
+            std::string value = equals < end ? query.substr(equals + 1, end - equals - 1) : std::string();
+            params[HttpServer::urlDecode(query.substr(position, equals - position))] = HttpServer::urlDecode(value);
+        }
+        position = end + 1;
+    }
+    return params;
+}
+
+// ---------------------------------------------------------- HttpCompletion
+
+std::shared_ptr<HttpCompletion> HttpResponse::defer() {
+    completion = std::make_shared<HttpCompletion>();
+    return completion;
+}
+
+void HttpCompletion::complete(HttpResponse response) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (completed_ || cancelled_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    response_ = std::move(response);
+    completed_ = true;
+    // Под мьютексом: отключение клиента не может освободить поток соединения посреди уведомления
+    if (notify_) {
+        notify_();
+        notify_ = nullptr;
+    }
+}
+
+void HttpCompletion::onCancel(std::function<void()> callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    onCancel_ = std::move(callback);
+}
+
+// ------------------------------------------------------------------ Worker
+
+class HttpServer::Worker {
+public:
+    Worker(HttpServer& server, size_t index) : server_(server), index_(index) {}
+
+    ~Worker() {
+        if (thread_.joinable()) {
+            stop();
+        }
+        closeFd(listenFd_);
+        closeFd(eventFd_);
+        closeFd(epollFd_);
+    }
+
+    void open();
+    void start() { thread_ = std::thread([this]() { run(); }); }
+
+    void stop() {
+        stopping_.store(true, std::memory_order_release);
+        uint64_t one = 1;
+        ssize_t written = ::write(eventFd_, &one, sizeof(one));
+        (void)written;
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    std::atomic<uint64_t> accepted{0};
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> active{0};
+    std::atomic<uint64_t> protocolErrors{0};
+
+private:
+    HttpServer& server_;
+    size_t index_;
+    int listenFd_ = -1;
+    int epollFd_ = -1;
+    int eventFd_ = -1;
+    std::thread thread_;
+    std::atomic<bool> stopping_{false};
+
+    // Отложенные ответы, готовые к отправке (пишутся из других потоков)
+    std::mutex readyMutex_;
+    std::vector<std::shared_ptr<HttpCompletion>> ready_;
+
+    std::vector<std::unique_ptr<Connection>> connections_;   // Индекс - дескриптор
+    std::vector<Connection*> streaming_;
+    std::vector<BufferPtr> bufferPool_;
+
+    HttpRequest request_;     // Переиспользуется между запросами потока
+    std::string head_;
+    std::string chunk_;
+    time_t dateSecond_ = 0;
+    std::string date_;
+
+    static void closeFd(int& fd) {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    void run();
+    void acceptAll();
+    void onEvent(Connection& connection, uint32_t events);
+    void onReadable(Connection& connection);
+    void processInput(Connection& connection);
+    bool parseHead(Connection& connection, const char* data, size_t headerBytes, size_t& contentLength);
+    void dispatch(Connection& connection, bool keepAlive);
+    void writeResponse(Connection& connection, HttpResponse& response, const ReplyContext& context);
+    void notifyReady(const std::shared_ptr<HttpCompletion>& completion);
+    void deliverReady();
+    void sendError(Connection& connection, int status, const char* message);
+    bool flush(Connection& connection);
+    void pollStreams(Clock::time_point now);
+    void sweepIdle(Clock::time_point now);
+    void closeConnection(Connection& connection);
+
+    BufferPtr acquireBuffer();
+    void releaseBuffer(BufferPtr buffer);
+    const std::string& date();
+};
+
+void HttpServer::Worker::open() {
+    const HttpServerConfig& config = server_.config_;
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICSERV;
+    addrinfo* addresses = nullptr;
+    std::string port = std::to_string(config.port);
+    int resolved = ::getaddrinfo(config.host.empty() ? nullptr : config.host.c_str(), port.c_str(), &hints, &addresses);
+    if (resolved != 0) {
+        throw std::runtime_error("Cannot resolve " + config.host + ": " + gai_strerror(resolved));
+    }
+
+    int lastError = 0;
+    for (addrinfo* address = addresses; address != nullptr && listenFd_ < 0; address = address->ai_next) {
+        int fd = ::socket(address->ai_family, address->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, address->ai_protocol);
+        if (fd < 0) {
+            lastError = errno;
+            continue;
+        }
+        int one = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+        if (::bind(fd, address->ai_addr, address->ai_addrlen) == 0 && ::listen(fd, SOMAXCONN) == 0) {
+            listenFd_ = fd;
+        } else {
+            lastError = errno;
+            ::close(fd);
+        }
+    }
+    ::freeaddrinfo(addresses);
+    if (listenFd_ < 0) {
+        throw std::runtime_error("Cannot listen on " + config.host + ":" + port + ": " + std::strerror(lastError));
+    }
+
+    epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    eventFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd_ < 0 || eventFd_ < 0) {
+        throw std::runtime_error(std::string("Cannot create epoll: ") + std::strerror(errno));
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLET;
+    event.data.fd = listenFd_;
+    ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &event);
+    event.events = EPOLLIN;
+    event.data.fd = eventFd_;
+    ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, eventFd_, &event);
+}
+
+void HttpServer::Worker::run() {
+    if (server_.config_.pinThreads) {
+        pinCurrentThread(index_);
+    }
+
+    epoll_event events[MAX_EVENTS];
+    auto nextStreamTick = Clock::now() + STREAM_TICK;
+    auto nextSweep = Clock::now() + SWEEP_INTERVAL;
+    bool running = true;
+
+    while (running) {
+        int timeout = streaming_.empty() ? 1000 : static_cast<int>(STREAM_TICK.count());
+        int count = ::epoll_wait(epollFd_, events, MAX_EVENTS, timeout);
+        if (count < 0 && errno != EINTR) {
+            break;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == eventFd_) {
+                uint64_t counter = 0;
+                ssize_t drained = ::read(eventFd_, &counter, sizeof(counter));
+                (void)drained;
+                running = !stopping_.load(std::memory_order_acquire);
+                deliverReady();
+            } else if (fd == listenFd_) {
+                acceptAll();
+            } else if (static_cast<size_t>(fd) < connections_.size() && connections_[fd]) {
+                onEvent(*connections_[fd], events[i].events);
+            }
+        }
+
+        auto now = Clock::now();
+        if (!streaming_.empty() && now >= nextStreamTick) {
+            nextStreamTick = now + STREAM_TICK;
+            pollStreams(now);
+        }
+        if (now >= nextSweep) {
+            nextSweep = now + SWEEP_INTERVAL;
+            sweepIdle(now);
+        }
+    }
+
+    for (auto& connection : connections_) {
+        if (connection) {
+            closeConnection(*connection);
+        }
+    }
+}
+
+void HttpServer::Worker::acceptAll() {
+    while (true) {
+        int fd = ::accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            // EAGAIN - очередь пуста; EMFILE/ENFILE - соединения ждут в очереди ядра
+            return;
+        }
+
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        if (static_cast<size_t>(fd) >= connections_.size()) {
+            connections_.resize(std::max(connections_.size() * 2, static_cast<size_t>(fd) + 1));
+        }
+        auto connection = std::make_unique<Connection>();
+        connection->fd = fd;
+        connection->in = acquireBuffer();
+        connection->out = acquireBuffer();
+        connection->lastActive = Clock::now();
+
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.fd = fd;
+        if (::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+            releaseBuffer(std::move(connection->in));
+            releaseBuffer(std::move(connection->out));
+            ::close(fd);
+            continue;
+        }
+        connections_[fd] = std::move(connection);
+        accepted.fetch_add(1, std::memory_order_relaxed);
+        active.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void HttpServer::Worker::onEvent(Connection& connection, uint32_t events) {
+    if (connection.pending) {
+        // Ждем отложенный ответ; закрытие со стороны клиента - отмена запроса
+        if (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+            closeConnection(connection);
+        } else if ((events & EPOLLOUT) && !connection.out->empty()) {
+            flush(connection);
+        }
+        return;
+    }
+
+    bool readable = (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0;
+    if (!connection.out->empty() && !flush(connection)) {
+        return;
+    }
+    if (connection.paused) {
+        if (!connection.out->empty()) {
+            return;   // Ждем EPOLLOUT
+        }
+        // Ответы ушли: дочитываем сокет и продолжаем разбор
+        connection.paused = false;
+        readable = true;
+    }
+    if (readable) {
+        onReadable(connection);
+    }
+}
+
+void HttpServer::Worker::onReadable(Connection& connection) {
+    while (true) {
+        // На паузе непрочитанное остается в сокете (TCP backpressure)
+        bool eof = false;
+        while (true) {
+            char* target = connection.in->prepare(READ_CHUNK);
+            ssize_t received = ::recv(connection.fd, target, READ_CHUNK, 0);
+            if (received > 0) {
+                connection.lastActive = Clock::now();
+                if (connection.stream) {
+                    // Поток SSE: входящие данные не ожидаются
+                    continue;
+                }
+                connection.in->commit(static_cast<size_t>(received));
+                if (connection.in->size() >= PROCESS_THRESHOLD) {
+                    processInput(connection);
+                    if (connection.paused || connection.pending || connection.closeAfterFlush || connection.failed) {
+                        break;
+                    }
+                }
+                continue;
+            }
+            if (received == 0) {
+                eof = true;
+            } else if (errno == EINTR) {
+                continue;
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                closeConnection(connection);
+                return;
+            }
+            break;
+        }
+
+        if (eof && connection.stream) {
+            closeConnection(connection);
+            return;
+        }
+        processInput(connection);
+        if (eof && !connection.paused) {
+            // Клиент закрыл запись: дописываем ответы на полученные запросы и закрываем.
+            // На паузе конец потока будет прочитан снова после отправки ответов.
+            connection.closeAfterFlush = true;
+        }
+        if (connection.failed) {
+            closeConnection(connection);
+            return;
+        }
+        if (!flush(connection) || !connection.paused || !connection.out->empty()) {
+            return;
+        }
+        // Ответы ушли без EAGAIN: EPOLLOUT больше не придет, а данные запросов уже
+        // прочитаны или ждут в сокете без нового фронта EPOLLIN - продолжаем сами
+        connection.paused = false;
+    }
+}
+
+void HttpServer::Worker::processInput(Connection& connection) {
+    const HttpServerConfig& config = server_.config_;
+    Buffer& in = *connection.in;
+
+    while (!in.empty() && !connection.closeAfterFlush && !connection.failed && !connection.stream &&
+           !connection.pending) {
+        if (connection.out->size() >= OUTPUT_HIGH_WATER) {
+            connection.paused = true;
+            return;
+        }
+
+        const char* data = in.data();
+        size_t size = in.size();
+        size_t scanFrom = connection.headerScanned > 3 ? connection.headerScanned - 3 : 0;
+        const void* terminator = ::memmem(data + scanFrom, size - scanFrom, "\r\n\r\n", 4);
+        if (terminator == nullptr) {
+            connection.headerScanned = size;
+            if (size > config.maxHeaderBytes) {
+                sendError(connection, 431, "Request headers too large");
+            }
+            return;
+        }
+        size_t headerBytes = static_cast<const char*>(terminator) - data + 4;
+        if (headerBytes > config.maxHeaderBytes) {
+            sendError(connection, 431, "Request headers too large");
+            return;
+        }
+
+        size_t contentLength = 0;
+        if (!parseHead(connection, data, headerBytes, contentLength)) {
+            return;
+        }
+
+        if (size - headerBytes < contentLength) {
+            // Тело еще не пришло; заголовки разберутся заново вместе с ним
+            const std::string* expect = request_.header("Expect");
+            if (expect != nullptr && !connection.continueSent && request_.minorVersion >= 1 &&
+                strcasecmp(expect->c_str(), "100-continue") == 0) {
+                static const char continueLine[] = "HTTP/1.1 100 Continue\r\n\r\n";
+                connection.out->append(continueLine, sizeof(continueLine) - 1);
+                connection.continueSent = true;
+            }
+            connection.headerScanned = headerBytes - 4;
+            return;
+        }
+
+        request_.body.assign(data + headerBytes, contentLength);
+        in.consume(headerBytes + contentLength);
+        connection.headerScanned = 0;
+        connection.continueSent = false;
+
+        // HTTP/1.1 - keep-alive по умолчанию, HTTP/1.0 - только по запросу клиента
+        bool keepAlive = request_.minorVersion >= 1;
+        const std::string* connectionHeader = request_.header("Connection");
+        if (connectionHeader != nullptr) {
+            if (hasToken(*connectionHeader, "close")) {
+                keepAlive = false;
+            } else if (hasToken(*connectionHeader, "keep-alive")) {
+                keepAlive = true;
+            }
+        }
+
+        dispatch(connection, keepAlive);
+    }
+}
+
+bool HttpServer::Worker::parseHead(Connection& connection, const char* data, size_t headerBytes, size_t& contentLength) {
+    const char* end = data + headerBytes - 2;   // Последний CRLF заголовков
+    const char* lineEnd = static_cast<const char*>(::memmem(data, end - data, "\r\n", 2));
+
+    // Строка запроса: METHOD SP target SP HTTP/1.x
+    const char* methodEnd = static_cast<const char*>(std::memchr(data, ' ', lineEnd - data));
+    const char* targetEnd = methodEnd != nullptr
+        ? static_cast<const char*>(std::memchr(methodEnd + 1, ' ', lineEnd - methodEnd - 1)) : nullptr;
+    if (methodEnd == nullptr || methodEnd == data || targetEnd == nullptr || targetEnd == methodEnd + 1 ||
+        lineEnd - targetEnd != 9 || std::memcmp(targetEnd + 1, "HTTP/1.", 7) != 0 ||
+        (targetEnd[8] != '0' && targetEnd[8] != '1')) {
+        sendError(connection, 400, "Malformed request line");
+        return false;
+    }
+
+    request_.method.assign(data, methodEnd);
+    request_.minorVersion = targetEnd[8] - '0';
+
+    // Абсолютная форма (http://host/path) сводится к пути
+    const char* target = methodEnd + 1;
+    if (*target != '/' && *target != '*') {
+        const char* scheme = static_cast<const char*>(::memmem(target, targetEnd - target, "://", 3));
+        const char* slash = scheme != nullptr
+            ? static_cast<const char*>(std::memchr(scheme + 3, '/', targetEnd - scheme - 3)) : nullptr;
+        target = slash != nullptr ? slash : targetEnd;
+    }
+    const char* fragment = static_cast<const char*>(std::memchr(target, '#', targetEnd - target));
+    const char* targetStop = fragment != nullptr ? fragment : targetEnd;
+    const char* question = static_cast<const char*>(std::memchr(target, '?', targetStop - target));
+    if (question != nullptr) {
+        request_.path.assign(target, question);
+        request_.query.assign(question + 1, targetStop);
+    } else {
+        request_.path.assign(target, targetStop);
+        request_.query.clear();
+    }
+    if (request_.path.empty()) {
+        request_.path = "/";
+    }
+
+    request_.headers.clear();
+    bool hasLength = false;
+    const char* line = lineEnd + 2;
+    while (line < end) {
+        const char* next = static_cast<const char*>(::memmem(line, end + 2 - line, "\r\n", 2));
+        const char* colon = static_cast<const char*>(std::memchr(line, ':', next - line));
+        if (colon == nullptr || colon == line || *line == ' ' || *line == '\t' ||
+            colon[-1] == ' ' || colon[-1] == '\t') {
+            sendError(connection, 400, "Malformed header");
+            return false;
+        }
+        const char* valueBegin = colon + 1;
+        const char* valueEnd = next;
+        while (valueBegin < valueEnd && (*valueBegin == ' ' || *valueBegin == '\t')) {
+            ++valueBegin;
+        }
+        while (valueEnd > valueBegin && (valueEnd[-1] == ' ' || valueEnd[-1] == '\t')) {
+            --valueEnd;
+        }
+        request_.headers.emplace_back(std::string(line, colon), std::string(valueBegin, valueEnd));
+        const auto& header = request_.headers.back();
+
+        if (strcasecmp(header.first.c_str(), "Content-Length") == 0) {
+            size_t parsed = 0;
+            bool valid = !header.second.empty() && header.second.size() <= 18;
+            for (char c : header.second) {
+                valid = valid && c >= '0' && c <= '9';
+                parsed = parsed * 10 + static_cast<size_t>(c - '0');
+            }
+            if (!valid || (hasLength && parsed != contentLength)) {
+                sendError(connection, 400, "Invalid Content-Length");
+                return false;
+            }
+            hasLength = true;
+            contentLength = parsed;
+        } else if (strcasecmp(header.first.c_str(), "Transfer-Encoding") == 0) {
+            // Тела chunked не поддерживаются: клиенты API передают Content-Length
+            sendError(connection, 411, "Content-Length required");
+            return false;
+        }
+        line = next + 2;
+    }
+
+    if (contentLength > server_.config_.maxBodyBytes) {
+        sendError(connection, 413, "Request body too large");
+        return false;
+    }
+    return true;
+}
+
+void HttpServer::Worker::dispatch(Connection& connection, bool keepAlive) {
+    HttpResponse response;
+    try {
+        server_.handler_(request_, response);
+    } catch (const std::exception& e) {
+        response = HttpResponse();
+        response.status = 500;
+        response.contentType = "application/json";
+        response.body = errorBody(e.what());
+    }
+    requests.fetch_add(1, std::memory_order_relaxed);
+
+    ReplyContext context;
+    context.minorVersion = request_.minorVersion;
+    context.head = request_.method == "HEAD";
+    context.keepAlive = keepAlive;
+
+    if (response.completion) {
+        std::shared_ptr<HttpCompletion> completion = std::move(response.completion);
+        std::unique_lock<std::mutex> lock(completion->mutex_);
+        if (!completion->completed_) {
+            // Ответ придет позже; соединение ждет его, не разбирая следующие запросы
+            completion->fd_ = connection.fd;
+            completion->minorVersion_ = context.minorVersion;
+            completion->head_ = context.head;
+            completion->keepAlive_ = context.keepAlive;
+            completion->notify_ = [this, completion]() { notifyReady(completion); };
+            connection.pending = completion;
+            return;
+        }
+        // Ответ готов еще до возврата из обработчика
+        response = std::move(completion->response_);
+    }
+    writeResponse(connection, response, context);
+}
+
+void HttpServer::Worker::notifyReady(const std::shared_ptr<HttpCompletion>& completion) {
+    {
+        std::lock_guard<std::mutex> lock(readyMutex_);
+        ready_.push_back(completion);
+    }
+    uint64_t one = 1;
+    ssize_t written = ::write(eventFd_, &one, sizeof(one));
+    (void)written;
+}
+
+void HttpServer::Worker::deliverReady() {
+    std::vector<std::shared_ptr<HttpCompletion>> ready;
+    {
+        std::lock_guard<std::mutex> lock(readyMutex_);
+        ready.swap(ready_);
+    }
+
+    for (const auto& completion : ready) {
+        int fd = completion->fd_;
+        if (fd < 0 || static_cast<size_t>(fd) >= connections_.size() || !connections_[fd] ||
+            connections_[fd]->pending != completion) {
+            continue;   // Соединение уже закрыто
+        }
+        Connection& connection = *connections_[fd];
+        connection.pending.reset();
+
+        HttpResponse response;
+        ReplyContext context;
+        {
+            std::lock_guard<std::mutex> lock(completion->mutex_);
+            response = std::move(completion->response_);
+            context.minorVersion = completion->minorVersion_;
+            context.head = completion->head_;
+            context.keepAlive = completion->keepAlive_;
+        }
+        writeResponse(connection, response, context);
+        if (connection.failed) {
+            closeConnection(connection);
+            continue;
+        }
+        // Продолжаем конвейер: дочитываем сокет, разбираем следующие запросы, отправляем
+        onReadable(connection);
+    }
+}
+
+void HttpServer::Worker::writeResponse(Connection& connection, HttpResponse& response, const ReplyContext& context) {
+    const bool http11 = context.minorVersion >= 1;
+    bool keepAlive = context.keepAlive;
+    const bool bodyAllowed = response.status >= 200 && response.status != 204 && response.status != 304;
+    const bool streaming = response.stream != nullptr && response.status == 200;
+    if (streaming && !http11) {
+        keepAlive = false;   // HTTP/1.0: конец потока - закрытие соединения
+    }
+
+    head_.clear();
+    head_ += http11 ? "HTTP/1.1 " : "HTTP/1.0 ";
+    head_ += std::to_string(response.status);
+    head_ += ' ';
+    head_ += reasonPhrase(response.status);
+    head_ += "\r\nServer: derivx\r\nDate: ";
+    head_ += date();
+    head_ += "\r\n";
+    if (!response.contentType.empty()) {
+        head_ += "Content-Type: ";
+        head_ += response.contentType;
+        head_ += "\r\n";
+    }
+    for (const auto& header : response.headers) {
+        head_ += header.first;
+        head_ += ": ";
+        head_ += header.second;
+        head_ += "\r\n";
+    }
+    if (streaming) {
+        if (http11) {
+            head_ += "Transfer-Encoding: chunked\r\n";
+        }
+    } else if (bodyAllowed) {
+        head_ += "Content-Length: ";
+        head_ += std::to_string(response.body.size());
+        head_ += "\r\n";
+    }
+    if (!keepAlive) {
+        head_ += "Connection: close\r\n";
+    } else if (!http11) {
+        head_ += "Connection: keep-alive\r\n";
+    }
+    head_ += "\r\n";
+
+    if (streaming) {
+        connection.out->append(head_);
+        connection.stream = std::move(response.stream);
+        connection.streamChunked = http11;
+        streaming_.push_back(&connection);
+        return;
+    }
+    if (response.stream) {
+        response.stream->close();
+    }
+
+    const bool sendBody = bodyAllowed && !context.head;
+    if (!keepAlive) {
+        connection.closeAfterFlush = true;
+    }
+
+    if (sendBody && connection.out->empty() && response.body.size() >= DIRECT_WRITE_BYTES) {
+        // Большое тело: заголовок и тело одним sendmsg без копирования, в буфер - только остаток
+        iovec parts[2];
+        parts[0].iov_base = const_cast<char*>(head_.data());
+        parts[0].iov_len = head_.size();
+        parts[1].iov_base = const_cast<char*>(response.body.data());
+        parts[1].iov_len = response.body.size();
+        msghdr message{};
+        message.msg_iov = parts;
+        message.msg_iovlen = 2;
+
+        ssize_t sent;
+        do {
+            sent = ::sendmsg(connection.fd, &message, MSG_NOSIGNAL);
+        } while (sent < 0 && errno == EINTR);
+        if (sent < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                connection.failed = true;
+                return;
+            }
+            sent = 0;
+        }
+        size_t written = static_cast<size_t>(sent);
+        if (written < head_.size()) {
+            connection.out->append(head_.data() + written, head_.size() - written);
+            written = 0;
+        } else {
+            written -= head_.size();
+        }
+        connection.out->append(response.body.data() + written, response.body.size() - written);
+        return;
+    }
+
+    connection.out->append(head_);
+    if (sendBody) {
+        connection.out->append(response.body);
+    }
+}
+
+void HttpServer::Worker::sendError(Connection& connection, int status, const char* message) {
+    protocolErrors.fetch_add(1, std::memory_order_relaxed);
+    HttpResponse response;
+    response.status = status;
+    response.contentType = "application/json";
+    response.body = errorBody(message);
+    // Заголовки запроса могли не разобраться - отвечаем как HTTP/1.1 и закрываем соединение
+    ReplyContext context;
+    context.keepAlive = false;
+    writeResponse(connection, response, context);
+}
+
+bool HttpServer::Worker::flush(Connection& connection) {
+    Buffer& out = *connection.out;
+    while (!out.empty()) {
+        ssize_t sent = ::send(connection.fd, out.data(), out.size(), MSG_NOSIGNAL);
+        if (sent > 0) {
+            out.consume(static_cast<size_t>(sent));
+            connection.lastActive = Clock::now();
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true;   // Продолжим по EPOLLOUT
+        } else {
+            closeConnection(connection);
+            return false;
+        }
+    }
+    if (connection.closeAfterFlush && !connection.stream) {
+        closeConnection(connection);
+        return false;
+    }
+    return true;
+}
+
+void HttpServer::Worker::pollStreams(Clock::time_point now) {
+    // Копия: закрытие соединения меняет streaming_
+    std::vector<Connection*> streams = streaming_;
+    for (Connection* connection : streams) {
+        if (!connection->out->empty()) {
+            continue;   // Клиент не забрал предыдущую порцию
+        }
+        chunk_.clear();
+        bool alive = connection->stream->poll(chunk_, now);
+        if (!chunk_.empty()) {
+            if (connection->streamChunked) {
+                char size[24];
+                int length = std::snprintf(size, sizeof(size), "%zx\r\n", chunk_.size());
+                connection->out->append(size, static_cast<size_t>(length));
+                chunk_ += "\r\n";
+            }
+            connection->out->append(chunk_);
+        }
+        if (!alive) {
+            if (connection->streamChunked) {
+                connection->out->append("0\r\n\r\n", 5);
+            }
+            connection->stream->close();
+            connection->stream.reset();
+            streaming_.erase(std::find(streaming_.begin(), streaming_.end(), connection));
+            connection->closeAfterFlush = true;
+        }
+        flush(*connection);
+    }
+}
+
+void HttpServer::Worker::sweepIdle(Clock::time_point now) {
+    auto idleTimeout = server_.config_.idleTimeout;
+    for (auto& connection : connections_) {
+        if (connection && !connection->stream && now - connection->lastActive > idleTimeout) {
+            closeConnection(*connection);
+        }
+    }
+}
+
+void HttpServer::Worker::closeConnection(Connection& connection) {
+    int fd = connection.fd;
+    if (connection.stream) {
+        connection.stream->close();
+        streaming_.erase(std::find(streaming_.begin(), streaming_.end(), &connection));
+    }
+    if (connection.pending) {
+        // Клиент не дождался ответа: уведомления больше не нужны, обработчик отменяет работу
+        std::function<void()> onCancel;
+        {
+            std::lock_guard<std::mutex> lock(connection.pending->mutex_);
+            connection.pending->cancelled_.store(true, std::memory_order_release);
+            connection.pending->notify_ = nullptr;
+            onCancel = std::move(connection.pending->onCancel_);
+        }
+        if (onCancel) {
+            onCancel();
+        }
+        connection.pending.reset();
+    }
+    releaseBuffer(std::move(connection.in));
+    releaseBuffer(std::move(connection.out));
+    ::close(fd);   // Дескриптор удаляется из epoll вместе с закрытием
+    connections_[fd].reset();
+    active.fetch_sub(1, std::memory_order_relaxed);
+}
+
+BufferPtr HttpServer::Worker::acquireBuffer() {
+    if (bufferPool_.empty()) {
+        return std::make_unique<Buffer>();
+    }
+    BufferPtr buffer = std::move(bufferPool_.back());
+    bufferPool_.pop_back();
+    return buffer;
+}
+
+void HttpServer::Worker::releaseBuffer(BufferPtr buffer) {
+    if (buffer && buffer->capacity() <= POOLED_BUFFER_LIMIT && bufferPool_.size() < BUFFER_POOL_SIZE) {
+        buffer->clear();
+        bufferPool_.push_back(std::move(buffer));
+    }
+}
+
+const std::string& HttpServer::Worker::date() {
+    time_t now = std::time(nullptr);
+    if (now != dateSecond_) {
+        dateSecond_ = now;
+        date_ = HttpCaching::formatHttpDate(static_cast<int64_t>(now));
+    }
+    return date_;
+}
+
+// -------------------------------------------------------------- HttpServer
+
+HttpServer::HttpServer(HttpServerConfig config, Handler handler)
+    : config_(std::move(config)), handler_(std::move(handler)) {}
+
+HttpServer::~HttpServer() {
+    stop();
+}
+
+void HttpServer::start() {
+    size_t threads = config_.threads;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (size_t i = 0; i < threads; ++i) {
+        workers.push_back(std::make_unique<Worker>(*this, i));
+        workers.back()->open();
+    }
+    workers_ = std::move(workers);
+    for (auto& worker : workers_) {
+        worker->start();
+    }
+}
+
+void HttpServer::stop() {
+    for (auto& worker : workers_) {
+        worker->stop();
+    }
+    workers_.clear();
+}
+
+HttpServerStats HttpServer::stats() const {
+    HttpServerStats stats;
+    for (const auto& worker : workers_) {
+        stats.accepted += worker->accepted.load(std::memory_order_relaxed);
+        stats.requests += worker->requests.load(std::memory_order_relaxed);
+        stats.activeConnections += worker->active.load(std::memory_order_relaxed);
+        stats.protocolErrors += worker->protocolErrors.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+std::string HttpServer::urlDecode(const std::string& text) {
+    std::string decoded;
+    decoded.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        if (c == '+') {
+            decoded += ' ';
+        } else if (c == '%' && i + 2 < text.size() && hexValue(text[i + 1]) >= 0 && hexValue(text[i + 2]) >= 0) {
+            decoded += static_cast<char>(hexValue(text[i + 1]) * 16 + hexValue(text[i + 2]));
+            i += 2;
+        } else {
+            decoded += c;
+        }
+    }
+    return decoded;
+}
+
+} // namespace derivx
@@ -0,0 +1,142 @@
+#include "../include/json_writer.hpp"
+#include <nlohmann/json.hpp>
+#include <cmath>
+#include <cstring>
+
+namespace derivx {
+
+JsonWriter::JsonWriter(size_t reserveBytes) {
+    out_.reserve(reserveBytes);
+}
+
+void JsonWriter::separator() {
+    if (needComma_) {
+        out_.push_back(',');
+    }
+}
+
+void JsonWriter::beginObject() {
+    separator();
+    out_.push_back('{');
+    needComma_ = false;
+}
+
+void JsonWriter::endObject() {
+    out_.push_back('}');
+    needComma_ = true;
+}
+
+void JsonWriter::beginArray() {
+    separator();
+    out_.push_back('[');
+    needComma_ = false;
+}
+
+void JsonWriter::endArray() {
+    out_.push_back(']');
+    needComma_ = true;
+}
+
+void JsonWriter::key(const char* name) {
+    separator();
+    writeString(name, std::strlen(name));
+    out_.push_back(':');
+    needComma_ = false;
+}
+
+void JsonWriter::key(const std::string& name) {
+    separator();
+    writeString(name.data(), name.size());
+    out_.push_back(':');
+    needComma_ = false;
+}
+
+void JsonWriter::value(double number) {
+    separator();
+    needComma_ = true;
+
+    if (!std::isfinite(number)) {
+        out_.append("null", 4);
+        return;
+    }
+
+    // Тот же grisu2, что и в json::dump(): std::to_chars дает другую
+    // кратчайшую запись примерно для 0.2% значений
+    char buffer[64];
+    char* end = nlohmann::detail::to_chars(buffer, buffer + sizeof(buffer), number);
+    out_.append(buffer, static_cast<size_t>(end - buffer));
+}
+
+void JsonWriter::value(bool flag) {
+    separator();
+    needComma_ = true;
+    if (flag) {
+        out_.append("true", 4);
+    } else {
+        out_.append("false", 5);
+    }
+}
+
+void JsonWriter::value(const char* text) {
+    separator();
+    needComma_ = true;
+    writeString(text, std::strlen(text));
+}
+
+void JsonWriter::value(const std::string& text) {
+    separator();
+    needComma_ = true;
+    writeString(text.data(), text.size());
+}
+
+void JsonWriter::null() {
+    separator();
+    needComma_ = true;
+    out_.append("null", 4);
+}
+
+void JsonWriter::raw(const std::string& serialized) {
+    separator();
+    needComma_ = true;
+    out_.append(serialized);
+}
+
+void JsonWriter::writeString(const char* text, size_t length) {
+    static const char hex[] = "0123456789abcdef";
+
+    out_.push_back('"');
+    size_t plainStart = 0;
+    for (size_t i = 0; i < length; ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        out_.append(text + plainStart, i - plainStart);
+        plainStart = i + 1;
+
+        switch (c) {
+            case '"':  out_.append("\\\"", 2); break;
+            case '\\': out_.append("\\\\", 2); break;
+            case '\b': out_.append("\\b", 2); break;
+            case '\f': out_.append("\\f", 2); break;
+            case '\n': out_.append("\\n", 2); break;
+            case '\r': out_.append("\\r", 2); break;
+            case '\t': out_.append("\\t", 2); break;
+            default: {
+                char escaped[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0x0F]};
+                out_.append(escaped, 6);
+                break;
+            }
+        }
+    }
+    out_.append(text + plainStart, length - plainStart);
+    out_.push_back('"');
+}
+
+std::string JsonWriter::release() {
+    needComma_ = false;
+    return std::move(out_);
+}
+
+} // namespace derivx
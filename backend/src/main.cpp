@@ -1,9 +1,25 @@
 #include <iostream>
 #include <string>
 #include <fstream>
+#include <cstdlib>
+#include <memory>
+#include <functional>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
 #include <cpprest/http_listener.h>
 #include <cpprest/json.h>
+#include <cpprest/producerconsumerstream.h>
 #include "../include/api_handler.hpp"
+#include "../include/compute_pool.hpp"
+#include "../include/response_format.hpp"
+#include "../include/metrics.hpp"
+#include "../include/request_trace.hpp"
+#include "../include/admission.hpp"
 using namespace web;
 using namespace web::http;
 using namespace web::http::experimental::listener;
@@ -14,11 +30,67 @@ const string DATA_DIR = "../data";
 
 derivx::APIHandler apiHandler;
 
+// Пул для расчетов; I/O потоки cpprest только разбирают запрос и отвечают
+unique_ptr<derivx::ComputePool> computePool;
+
+// Допуск запросов: оценка стоимости, лимиты полос, сроки
+unique_ptr<derivx::AdmissionController> admission;
+
+// Cache-Control для ответов с ETag (DERIVX_HTTP_MAX_AGE_SEC)
+string cacheControl = "public, max-age=5";
+
+// Открытое SSE соединение: подписка и буфер, из которого cpprest отправляет тело
+struct StreamConnection {
+    derivx::StreamSubscriberPtr subscriber;
+    concurrency::streams::producer_consumer_buffer<uint8_t> buffer;
+    chrono::steady_clock::time_point lastWrite = chrono::steady_clock::now();
+};
+
+mutex streamConnectionsMutex;
+vector<shared_ptr<StreamConnection>> streamConnections;
+atomic<bool> streamPumpRunning{false};
+atomic<bool> streamPollInFlight{false};
+thread streamPump;
+
 // CORS headers
 void addCorsHeaders(http_response& response) {
     response.headers().add(U("Access-Control-Allow-Origin"), U("*"));
     response.headers().add(U("Access-Control-Allow-Methods"), U("GET, POST, OPTIONS"));
-    response.headers().add(U("Access-Control-Allow-Headers"), U("Content-Type"));
+    response.headers().add(U("Access-Control-Allow-Headers"), U("Content-Type, If-None-Match, If-Modified-Since, X-Request-Timeout-Ms"));
+    response.headers().add(U("Access-Control-Expose-Headers"), U("ETag, Last-Modified, Server-Timing, Retry-After"));
+}
+
+// Ряд метрик по пути запроса
+size_t endpointMetric(const utility::string_t& path) {
+    return derivx::APIHandler::metricsEndpoint(utility::conversions::to_utf8string(path));
+}
+
+// Учет запроса в метриках: глубина очереди пула при поступлении,
+// задержка до отправки ответа и статус 4xx/5xx
+void observeRequest(const http_request& request) {
+    size_t endpoint = endpointMetric(request.relative_uri().path());
+    auto started = chrono::steady_clock::now();
+    if (computePool) {
+        derivx::Metrics::global().recordQueueDepth(computePool->queueDepth());
+    }
+    
+    request.get_response().then([endpoint, started](pplx::task<http_response> replied) {
+        bool error = true;
+        try {
+            error = replied.get().status_code() >= 400;
+        } catch (const exception&) {
+            // Ответ не отправлен - считаем ошибкой
+        }
+        auto elapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - started);
+        derivx::Metrics::global().recordRequest(endpoint, static_cast<uint64_t>(elapsed.count()), error);
+    });
+}
+
+// Ошибка в теле ответа со статусом 200 ({"error": ...} от обработчика)
+void observeErrorBody(const http_request& request, const string& body) {
+    if (derivx::ResponseFormats::isError(body)) {
+        derivx::Metrics::global().recordError(endpointMetric(request.relative_uri().path()));
+    }
 }
 
 // Health check endpoint
@@ -35,73 +107,450 @@ void handleHealth(http_request request) {
     request.reply(response);
 }
 
-// Calculate option price
-void handleCalculateOption(http_request request) {
-    http_response response(status_codes::OK);
-    addCorsHeaders(response);
-    
-    request.extract_string()
-        .then([&response](utility::string_t body) {
+// Формат ответа по заголовку Accept (JSON по умолчанию)
+derivx::ResponseFormat requestFormat(const http_request& request, bool allowPacked) {
+    auto acceptIt = request.headers().find(U("Accept"));
+    if (acceptIt == request.headers().end()) {
+        return derivx::ResponseFormat::JSON;
+    }
+    return derivx::ResponseFormats::negotiate(utility::conversions::to_utf8string(acceptIt->second), allowPacked);
+}
+
+// Допущенный запрос: место в полосе (до конца расчета) и срок
+struct AdmittedRequest {
+    derivx::AdmissionLane lane = derivx::AdmissionLane::INTERACTIVE;
+    derivx::AdmissionTicket ticket;
+    derivx::RequestDeadlinePtr deadline;
+};
+
+using AdmittedRequestPtr = shared_ptr<AdmittedRequest>;
+
+// Допуск запроса по оценке стоимости; nullptr - полоса заполнена, клиенту уже ушел 503 с Retry-After.
+// cpprest не сообщает об отключении клиента - расчет ограничен только сроком.
+AdmittedRequestPtr admitRequest(const http_request& request, const string& body) {
+    auto started = chrono::steady_clock::now();
+    derivx::RequestCost cost = admission->estimate(
+        utility::conversions::to_utf8string(request.method()),
+        utility::conversions::to_utf8string(request.relative_uri().path()),
+        utility::conversions::to_utf8string(request.relative_uri().query()), body);
+
+    auto admitted = make_shared<AdmittedRequest>();
+    admitted->lane = cost.lane;
+    admitted->ticket = admission->tryAdmit(cost);
+    if (!admitted->ticket.admitted()) {
+        http_response response(status_codes::ServiceUnavailable);
+        addCorsHeaders(response);
+        response.headers().add(U("Retry-After"),
+                               utility::conversions::to_string_t(to_string(admission->retryAfterSeconds(cost.lane))));
+        json::value errorJson;
+        errorJson[U("error")] = json::value::string(U("Server overloaded, retry later"));
+        response.set_body(errorJson);
+        request.reply(response);
+        return nullptr;
+    }
+
+    string timeout;
+    auto timeoutIt = request.headers().find(U("X-Request-Timeout-Ms"));
+    if (timeoutIt != request.headers().end()) {
+        timeout = utility::conversions::to_utf8string(timeoutIt->second);
+    }
+    admitted->deadline = admission->deadlineFor(cost, started, derivx::AdmissionController::parseTimeoutHeader(&timeout));
+    return admitted;
+}
+
+// Выполнение расчета на compute пуле; результат доступен как pplx::task.
+// Трассировка запроса (если есть) активна в потоке пула на время расчета.
+// Легкие допущенные запросы идут в приоритетную очередь пула; срок запроса
+// активен на время расчета, место в полосе освобождается по его завершении.
+template <typename Compute>
+auto runOnComputePool(Compute compute, derivx::RequestTracePtr trace = nullptr,
+                      AdmittedRequestPtr admitted = nullptr) -> pplx::task<decltype(compute())> {
+    pplx::task_completion_event<decltype(compute())> completion;
+    auto submitted = trace ? chrono::steady_clock::now() : chrono::steady_clock::time_point();
+    derivx::TaskPriority priority = admitted && admitted->lane == derivx::AdmissionLane::INTERACTIVE
+        ? derivx::TaskPriority::HIGH : derivx::TaskPriority::NORMAL;
+    computePool->submit([completion, compute, trace, submitted, admitted]() {
+        derivx::TraceScope scope(trace.get());
+        derivx::DeadlineScope deadlineScope(admitted ? admitted->deadline.get() : nullptr);
+        if (trace) {
+            trace->addStage("queue", submitted, chrono::steady_clock::now());
+        }
+        try {
+            if (admitted) {
+                admitted->deadline->check();
+            }
+            auto result = compute();
+            if (admitted) {
+                admitted->ticket.release();
+            }
+            completion.set(std::move(result));
+        } catch (...) {
+            if (admitted) {
+                admitted->ticket.release();
+            }
+            completion.set_exception(current_exception());
+        }
+    }, priority);
+    return pplx::create_task(completion);
+}
+
+// Тело ответа {"error": ...} с кодом ошибки расчета: 504 - истек срок запроса
+void setComputeError(http_response& response, const exception& error) {
+    if (dynamic_cast<const derivx::DeadlineExceeded*>(&error) != nullptr) {
+        admission->recordDeadlineExceeded();
+        response.set_status_code(status_codes::GatewayTimeout);
+    } else {
+        response.set_status_code(status_codes::BadRequest);
+    }
+    json::value errorJson;
+    errorJson[U("error")] = json::value::string(utility::conversions::to_string_t(error.what()));
+    response.set_body(errorJson);
+}
+
+// Тело ответа в согласованном формате; ошибки упакованных форматов приходят в JSON
+void setEncodedBody(http_response& response, string body, derivx::ResponseFormat format) {
+    derivx::ResponseFormat actual = derivx::ResponseFormats::detect(body, format);
+    if (actual == derivx::ResponseFormat::JSON) {
+        response.set_body(std::move(body), "application/json");
+    } else {
+        response.set_body(vector<unsigned char>(body.begin(), body.end()));
+        response.headers().set_content_type(
+            utility::conversions::to_string_t(derivx::ResponseFormats::contentType(actual)));
+    }
+}
+
+// Отправка ответа с этапами трассировки: Server-Timing в заголовке,
+// время отправки и выгрузка медленного запроса после завершения
+pplx::task<void> replyTraced(const http_request& request, http_response& response,
+                             const derivx::RequestTracePtr& trace) {
+    if (!trace) {
+        return request.reply(response);
+    }
+    if (derivx::RequestTracing::serverTimingEnabled()) {
+        response.headers().add(U("Server-Timing"), utility::conversions::to_string_t(trace->serverTiming()));
+    }
+    auto replyStarted = chrono::steady_clock::now();
+    return request.reply(response).then([trace, replyStarted](pplx::task<void> replied) {
+        trace->addStage("reply", replyStarted, chrono::steady_clock::now());
+        derivx::RequestTracing::finish(*trace);
+        replied.get();
+    });
+}
+
+// Трассировка запроса вида "POST /api/calculate-strategy" (nullptr - выключена)
+derivx::RequestTracePtr beginTrace(const http_request& request) {
+    return derivx::RequestTracing::begin(
+        utility::conversions::to_utf8string(request.method() + U(" ") + request.relative_uri().path()));
+}
+
+// Отправка результата расчета клиенту, когда он будет готов.
+// Тело уже закодировано в format; ошибки упакованных форматов приходят в JSON.
+void replyWhenReady(http_request request, pplx::task<string> resultTask,
+                    derivx::ResponseFormat format = derivx::ResponseFormat::JSON,
+                    derivx::RequestTracePtr trace = nullptr) {
+    resultTask
+        .then([request, format, trace](pplx::task<string> completed) {
+            http_response response(status_codes::OK);
+            addCorsHeaders(response);
+            response.headers().add(U("Vary"), U("Accept"));
+            
             try {
-                string result = apiHandler.handleCalculateOption(utility::conversions::to_utf8string(body));
-                response.set_body(utility::conversions::to_string_t(result));
-                response.headers().set_content_type(U("application/json"));
+                string body = completed.get();
+                observeErrorBody(request, body);
+                derivx::TraceScope scope(trace.get());
+                derivx::TraceStage stage("encode");
+                setEncodedBody(response, std::move(body), format);
             } catch (const exception& e) {
-                response.set_status_code(status_codes::BadRequest);
-                json::value errorJson;
-                errorJson[U("error")] = json::value::string(utility::conversions::to_string_t(e.what()));
-                response.set_body(errorJson);
+                setComputeError(response, e);
             }
+            
+            return replyTraced(request, response, trace);
         })
-        .wait();
-    
-    request.reply(response);
+        .then([](pplx::task<void> replied) {
+            // Клиент мог закрыть соединение - ошибку отправки только наблюдаем
+            try {
+                replied.get();
+            } catch (const exception& e) {
+                cerr << "Reply failed: " << e.what() << endl;
+            }
+        });
 }
 
-// Calculate strategy PNL
-void handleCalculateStrategy(http_request request) {
-    http_response response(status_codes::OK);
-    addCorsHeaders(response);
+// Условный GET данных символа: ETag, Last-Modified, Cache-Control и 304 Not Modified
+void replyConditional(http_request request, derivx::ConditionalGet conditional) {
+    auto ifNoneMatch = request.headers().find(U("If-None-Match"));
+    if (ifNoneMatch != request.headers().end()) {
+        conditional.ifNoneMatch = utility::conversions::to_utf8string(ifNoneMatch->second);
+    }
+    auto ifModifiedSince = request.headers().find(U("If-Modified-Since"));
+    if (ifModifiedSince != request.headers().end()) {
+        conditional.ifModifiedSince = utility::conversions::to_utf8string(ifModifiedSince->second);
+    }
     
-    request.extract_string()
-        .then([&response](utility::string_t body) {
+    AdmittedRequestPtr admitted = admitRequest(request, string());
+    if (!admitted) {
+        return;
+    }
+    
+    derivx::ResponseFormat format = conditional.format;
+    derivx::RequestTracePtr trace = beginTrace(request);
+    runOnComputePool([conditional]() {
+            return apiHandler.handleConditionalGet(conditional);
+        }, trace, admitted)
+        .then([request, format, trace](pplx::task<derivx::CachedResponse> completed) {
+            http_response response(status_codes::OK);
+            addCorsHeaders(response);
+            response.headers().add(U("Vary"), U("Accept"));
+            
+            try {
+                derivx::CachedResponse cached = completed.get();
+                if (!cached.etag.empty()) {
+                    response.headers().add(U("ETag"), utility::conversions::to_string_t(cached.etag));
+                    response.headers().add(U("Cache-Control"), utility::conversions::to_string_t(cacheControl));
+                    if (cached.lastModified > 0) {
+                        response.headers().add(U("Last-Modified"), utility::conversions::to_string_t(
+                            derivx::HttpCaching::formatHttpDate(cached.lastModified)));
+                    }
+                }
+                if (cached.notModified) {
+                    response.set_status_code(status_codes::NotModified);
+                } else {
+                    observeErrorBody(request, *cached.body);
+                    derivx::TraceScope scope(trace.get());
+                    derivx::TraceStage stage("encode");
+                    setEncodedBody(response, *cached.body, format);
+                }
+            } catch (const exception& e) {
+                setComputeError(response, e);
+            }
+            
+            return replyTraced(request, response, trace);
+        })
+        .then([](pplx::task<void> replied) {
+            try {
+                replied.get();
+            } catch (const exception& e) {
+                cerr << "Reply failed: " << e.what() << endl;
+            }
+        });
+}
+
+// POST обработчик: тело читается асинхронно, после допуска расчет уходит на compute пул
+void handleComputePost(http_request request, function<string(const string&)> compute,
+                       derivx::ResponseFormat format = derivx::ResponseFormat::JSON) {
+    derivx::RequestTracePtr trace = beginTrace(request);
+    request.extract_utf8string()
+        .then([request, compute, format, trace](string body) {
+            if (trace) {
+                trace->addStage("body", trace->started(), chrono::steady_clock::now());
+            }
+            AdmittedRequestPtr admitted = admitRequest(request, body);
+            if (!admitted) {
+                return;
+            }
+            replyWhenReady(request, runOnComputePool([compute, body]() {
+                return compute(body);
+            }, trace, admitted), format, trace);
+        })
+        .then([request](pplx::task<void> read) {
             try {
-                string result = apiHandler.handleCalculateStrategy(utility::conversions::to_utf8string(body));
-                response.set_body(utility::conversions::to_string_t(result));
-                response.headers().set_content_type(U("application/json"));
+                read.get();
             } catch (const exception& e) {
-                response.set_status_code(status_codes::BadRequest);
+                http_response response(status_codes::BadRequest);
+                addCorsHeaders(response);
                 json::value errorJson;
                 errorJson[U("error")] = json::value::string(utility::conversions::to_string_t(e.what()));
                 response.set_body(errorJson);
+                request.reply(response);
             }
-        })
-        .wait();
-    
-    request.reply(response);
+        });
+}
+
+// Calculate option price
+void handleCalculateOption(http_request request) {
+    auto format = requestFormat(request, false);
+    handleComputePost(request, [format](const string& body) {
+        return derivx::ResponseFormats::transcode(apiHandler.handleCalculateOption(body), format);
+    }, format);
+}
+
+// Calculate strategy PNL
+void handleCalculateStrategy(http_request request) {
+    auto format = requestFormat(request, true);
+    handleComputePost(request, [format](const string& body) {
+        return apiHandler.handleCalculateStrategy(body, format);
+    }, format);
 }
 
 // Calculate Greeks
 void handleCalculateGreeks(http_request request) {
+    auto format = requestFormat(request, false);
+    handleComputePost(request, [format](const string& body) {
+        return derivx::ResponseFormats::transcode(apiHandler.handleCalculateGreeks(body), format);
+    }, format);
+}
+
+// Batch of operations in one round trip
+void handleBatch(http_request request) {
+    auto format = requestFormat(request, false);
+    handleComputePost(request, [format](const string& body) {
+        return derivx::ResponseFormats::transcode(apiHandler.handleBatch(body), format);
+    }, format);
+}
+
+// Backtest of a strategy template over symbol history
+void handleBacktest(http_request request) {
+    auto format = requestFormat(request, false);
+    handleComputePost(request, [format](const string& body) {
+        return derivx::ResponseFormats::transcode(apiHandler.handleBacktest(body), format);
+    }, format);
+}
+
+// Strategy search over a strike grid
+void handleOptimizeStrategy(http_request request) {
+    auto format = requestFormat(request, false);
+    handleComputePost(request, [format](const string& body) {
+        return derivx::ResponseFormats::transcode(apiHandler.handleOptimizeStrategy(body), format);
+    }, format);
+}
+
+// Option chain from a calibrated Heston / jump-diffusion model
+void handleModelChain(http_request request) {
+    auto format = requestFormat(request, false);
+    handleComputePost(request, [format](const string& body) {
+        return derivx::ResponseFormats::transcode(apiHandler.handleModelChain(body), format);
+    }, format);
+}
+
+// Subscribe to strategy revaluation (Server-Sent Events)
+void handleStrategyStream(http_request request) {
     http_response response(status_codes::OK);
     addCorsHeaders(response);
     
-    request.extract_string()
-        .then([&response](utility::string_t body) {
+    auto pathParts = uri::split_path(request.relative_uri().path());
+    auto query = uri::split_query(request.relative_uri().query());
+    auto strategyIt = query.find(U("strategy"));
+    
+    if (pathParts.size() < 4 || strategyIt == query.end()) {
+        response.set_status_code(status_codes::BadRequest);
+        json::value errorJson;
+        errorJson[U("error")] = json::value::string(U("Usage: /api/stream/strategy/{symbol}?strategy={json}"));
+        response.set_body(errorJson);
+        request.reply(response);
+        return;
+    }
+    
+    string symbol = utility::conversions::to_utf8string(pathParts[3]);
+    string strategy = utility::conversions::to_utf8string(uri::decode(strategyIt->second));
+    cout << "Strategy stream for symbol: " << symbol << endl;
+    
+    // Первичная оценка может читать файл - выполняем на пуле
+    computePool->submit([request, response, symbol, strategy]() mutable {
+        auto connection = make_shared<StreamConnection>();
+        try {
+            connection->subscriber = apiHandler.subscribeStrategy(symbol, strategy);
+        } catch (const exception& e) {
+            response.set_status_code(status_codes::BadRequest);
+            json::value errorJson;
+            errorJson[U("error")] = json::value::string(utility::conversions::to_string_t(e.what()));
+            response.set_body(errorJson);
+            request.reply(response);
+            return;
+        }
+        
+        response.headers().add(U("Cache-Control"), U("no-cache"));
+        response.set_body(connection->buffer.create_istream(), U("text/event-stream"));
+        {
+            lock_guard<mutex> lock(streamConnectionsMutex);
+            streamConnections.push_back(connection);
+        }
+        
+        // Ответ завершается, когда клиент отключился или поток закрыт сервером
+        request.reply(response).then([connection](pplx::task<void> replied) {
             try {
-                string result = apiHandler.handleCalculateGreeks(utility::conversions::to_utf8string(body));
-                response.set_body(utility::conversions::to_string_t(result));
-                response.headers().set_content_type(U("application/json"));
-            } catch (const exception& e) {
-                response.set_status_code(status_codes::BadRequest);
-                json::value errorJson;
-                errorJson[U("error")] = json::value::string(utility::conversions::to_string_t(e.what()));
-                response.set_body(errorJson);
+                replied.get();
+            } catch (const exception&) {
             }
-        })
-        .wait();
+            connection->subscriber->close();
+        });
+    });
+}
+
+// Отправка ожидающего события. Пока клиент не забрал предыдущие данные,
+// новое событие ждет в подписке и может быть заменено более свежим.
+void flushStreamConnection(StreamConnection& connection, chrono::steady_clock::time_point now) {
+    const auto keepAliveInterval = chrono::seconds(15);
+    if (connection.buffer.in_avail() > 0) {
+        return;
+    }
     
-    request.reply(response);
+    string event;
+    string frame;
+    if (connection.subscriber->take(event)) {
+        frame = "event: strategy\ndata: " + event + "\n\n";
+    } else if (now - connection.lastWrite >= keepAliveInterval) {
+        frame = ": keepalive\n\n";
+    } else {
+        return;
+    }
+    
+    connection.buffer.putn_nocopy(reinterpret_cast<const uint8_t*>(frame.data()), frame.size()).wait();
+    connection.lastWrite = now;
+}
+
+// Поток SSE: периодический опрос файлов символов и отправка событий клиентам
+void runStreamPump(chrono::milliseconds pollInterval) {
+    const auto flushInterval = chrono::milliseconds(50);
+    auto nextPoll = chrono::steady_clock::now();
+    
+    while (streamPumpRunning.load()) {
+        auto now = chrono::steady_clock::now();
+        
+        // Пересчет идет на пуле; следующий опрос - только после завершения предыдущего
+        if (now >= nextPoll && !streamPollInFlight.exchange(true)) {
+            nextPoll = now + pollInterval;
+            computePool->submit([]() {
+                try {
+                    apiHandler.pollStrategyStreams();
+                } catch (const exception& e) {
+                    cerr << "Strategy stream poll failed: " << e.what() << endl;
+                }
+                streamPollInFlight.store(false);
+            });
+        }
+        
+        vector<shared_ptr<StreamConnection>> connections;
+        {
+            lock_guard<mutex> lock(streamConnectionsMutex);
+            connections = streamConnections;
+        }
+        for (const auto& connection : connections) {
+            if (connection->subscriber->closed()) {
+                connection->buffer.close(ios_base::out).wait();
+            } else {
+                flushStreamConnection(*connection, now);
+            }
+        }
+        {
+            lock_guard<mutex> lock(streamConnectionsMutex);
+            streamConnections.erase(
+                remove_if(streamConnections.begin(), streamConnections.end(),
+                          [](const shared_ptr<StreamConnection>& connection) {
+                              return connection->subscriber->closed();
+                          }),
+                streamConnections.end());
+        }
+        
+        this_thread::sleep_for(flushInterval);
+    }
+    
+    // Остановка сервера: завершаем все потоки
+    lock_guard<mutex> lock(streamConnectionsMutex);
+    for (const auto& connection : streamConnections) {
+        connection->subscriber->close();
+        connection->buffer.close(ios_base::out).wait();
+    }
+    streamConnections.clear();
 }
 
 // Get volatility for symbol
@@ -125,11 +574,11 @@ void handleGetVolatility(http_request request) {
     string symbol = utility::conversions::to_utf8string(pathParts[2]);
     cout << "Getting volatility for symbol: " << symbol << endl;
     
-    string result = apiHandler.handleGetVolatility(symbol);
-    
-    response.set_body(utility::conversions::to_string_t(result));
-    response.headers().set_content_type(U("application/json"));
-    request.reply(response);
+    derivx::ConditionalGet conditional;
+    conditional.endpoint = derivx::DataEndpoint::VOLATILITY;
+    conditional.symbol = symbol;
+    conditional.format = requestFormat(request, false);
+    replyConditional(request, conditional);
 }
 
 // Get current price for symbol
@@ -152,11 +601,11 @@ void handleGetCurrentPrice(http_request request) {
     string symbol = utility::conversions::to_utf8string(pathParts[2]);
     cout << "Getting current price for symbol: " << symbol << endl;
     
-    string result = apiHandler.handleGetCurrentPrice(symbol);
-    
-    response.set_body(utility::conversions::to_string_t(result));
-    response.headers().set_content_type(U("application/json"));
-    request.reply(response);
+    derivx::ConditionalGet conditional;
+    conditional.endpoint = derivx::DataEndpoint::PRICE;
+    conditional.symbol = symbol;
+    conditional.format = requestFormat(request, false);
+    replyConditional(request, conditional);
 }
 
 // Get OHLCV data
@@ -178,22 +627,111 @@ void handleGetOHLCV(http_request request) {
     
     string symbol = utility::conversions::to_utf8string(pathParts[2]);
     
-    // Получаем limit из query параметров
-    int limit = 100;
-    auto query = uri::split_query(request.relative_uri().query());
-    if (query.find(U("limit")) != query.end()) {
-        limit = stoi(utility::conversions::to_utf8string(query[U("limit")]));
+    // Разбираем query параметры: limit, from, to, maxPoints, cursor
+    map<string, string> params;
+    for (const auto& param : uri::split_query(request.relative_uri().query())) {
+        params[utility::conversions::to_utf8string(param.first)] =
+            utility::conversions::to_utf8string(uri::decode(param.second));
     }
+    derivx::OHLCVQuery ohlcvQuery;
+    string paramError = derivx::APIHandler::parseOHLCVQuery(params, ohlcvQuery);
     
-    cout << "Getting OHLCV data for symbol: " << symbol << " (limit: " << limit << ")" << endl;
+    if (!paramError.empty()) {
+        response.set_status_code(status_codes::BadRequest);
+        json::value errorJson;
+        errorJson[U("error")] = json::value::string(utility::conversions::to_string_t(paramError));
+        response.set_body(errorJson);
+        request.reply(response);
+        return;
+    }
+    
+    cout << "Getting OHLCV data for symbol: " << symbol << " (limit: " << ohlcvQuery.limit << ")" << endl;
+    
+    derivx::ConditionalGet conditional;
+    conditional.endpoint = derivx::DataEndpoint::OHLCV;
+    conditional.symbol = symbol;
+    conditional.query = ohlcvQuery;
+    conditional.format = requestFormat(request, true);
+    replyConditional(request, conditional);
+}
+
+// Цепочка опционов символа
+void handleGetOptionChain(http_request request) {
+    http_response response(status_codes::OK);
+    addCorsHeaders(response);
+    
+    auto path = request.relative_uri().path();
+    auto pathParts = uri::split_path(path);
     
-    string result = apiHandler.handleGetOHLCV(symbol, limit);
+    if (pathParts.size() < 3) {
+        response.set_status_code(status_codes::BadRequest);
+        json::value errorJson;
+        errorJson[U("error")] = json::value::string(U("Symbol not specified"));
+        response.set_body(errorJson);
+        request.reply(response);
+        return;
+    }
+    
+    string symbol = utility::conversions::to_utf8string(pathParts[2]);
+    
+    // Разбираем query параметры: strikes или minStrike/maxStrike/numStrikes, relative, expiries, ...
+    map<string, string> params;
+    for (const auto& param : uri::split_query(request.relative_uri().query())) {
+        params[utility::conversions::to_utf8string(param.first)] =
+            utility::conversions::to_utf8string(uri::decode(param.second));
+    }
+    derivx::ConditionalGet conditional;
+    string paramError = derivx::APIHandler::parseOptionChainQuery(params, conditional.chain);
+    
+    if (!paramError.empty()) {
+        response.set_status_code(status_codes::BadRequest);
+        json::value errorJson;
+        errorJson[U("error")] = json::value::string(utility::conversions::to_string_t(paramError));
+        response.set_body(errorJson);
+        request.reply(response);
+        return;
+    }
+    
+    conditional.endpoint = derivx::DataEndpoint::OPTION_CHAIN;
+    conditional.symbol = symbol;
+    conditional.format = requestFormat(request, false);
+    replyConditional(request, conditional);
+}
+
+// Get symbol cache counters
+void handleGetCacheStats(http_request request) {
+    http_response response(status_codes::OK);
+    addCorsHeaders(response);
+    
+    string result = apiHandler.handleGetCacheStats();
     
     response.set_body(utility::conversions::to_string_t(result));
     response.headers().set_content_type(U("application/json"));
     request.reply(response);
 }
 
+// Метрики в текстовом формате Prometheus
+void handleGetMetrics(http_request request) {
+    http_response response(status_codes::OK);
+    addCorsHeaders(response);
+    
+    string result = apiHandler.handleGetMetrics();
+    
+    response.set_body(std::move(result), "text/plain; version=0.0.4; charset=utf-8");
+    request.reply(response);
+}
+
+// Чтение целочисленной переменной окружения (с значением по умолчанию)
+long long readEnvInt(const char* name, long long defaultValue) {
+    const char* value = getenv(name);
+    if (value == nullptr || *value == '\0') {
+        return defaultValue;
+    }
+    char* end = nullptr;
+    long long parsed = strtoll(value, &end, 10);
+    return (end != value && *end == '\0' && parsed >= 0) ? parsed : defaultValue;
+}
+
 // Handle OPTIONS requests for CORS
 void handleOptions(http_request request) {
     http_response response(status_codes::OK);
@@ -219,6 +757,14 @@ void handleRoot(http_request request) {
     endpoints[U("getVolatility")] = json::value::string(U("GET /api/volatility/{symbol}"));
     endpoints[U("getPrice")] = json::value::string(U("GET /api/price/{symbol}"));
     endpoints[U("getOHLCV")] = json::value::string(U("GET /api/ohlcv/{symbol}"));
+    endpoints[U("getOptionChain")] = json::value::string(U("GET /api/option-chain/{symbol}"));
+    endpoints[U("cacheStats")] = json::value::string(U("GET /api/cache/stats"));
+    endpoints[U("batch")] = json::value::string(U("POST /api/batch"));
+    endpoints[U("backtest")] = json::value::string(U("POST /api/backtest"));
+    endpoints[U("optimizeStrategy")] = json::value::string(U("POST /api/optimize-strategy"));
+    endpoints[U("modelChain")] = json::value::string(U("POST /api/model-chain"));
+    endpoints[U("strategyStream")] = json::value::string(U("GET /api/stream/strategy/{symbol}?strategy={json}"));
+    endpoints[U("metrics")] = json::value::string(U("GET /api/metrics"));
     
     apiInfo[U("endpoints")] = endpoints;
     apiInfo[U("note")] = json::value::string(U("Use BTC_USDT or BTC/USDT format for symbols"));
@@ -237,8 +783,60 @@ int main(int argc, char* argv[]) {
         dataDir = argv[1];
     }
     
-    apiHandler.initialize(dataDir);
+    // Параметры кэша символов: DERIVX_CACHE_BUDGET_MB (0 - без ограничения),
+    // DERIVX_NEGATIVE_TTL_SEC (время жизни записи "символ не найден")
+    derivx::SymbolCacheConfig cacheConfig;
+    cacheConfig.memoryBudgetBytes = static_cast<size_t>(readEnvInt("DERIVX_CACHE_BUDGET_MB", 0)) * 1024 * 1024;
+    cacheConfig.negativeTtl = chrono::seconds(readEnvInt("DERIVX_NEGATIVE_TTL_SEC", 30));
+    
+    apiHandler.initialize(dataDir, cacheConfig);
+    
+    // DERIVX_RESPONSE_CACHE_MB: память под готовые ответы GET эндпоинтов данных,
+    // DERIVX_HTTP_MAX_AGE_SEC: сколько клиент может не перепроверять ответ (0 - всегда по ETag)
+    apiHandler.setResponseCacheBudget(static_cast<size_t>(readEnvInt("DERIVX_RESPONSE_CACHE_MB", 64)) * 1024 * 1024);
+    long long maxAge = readEnvInt("DERIVX_HTTP_MAX_AGE_SEC", 5);
+    cacheControl = maxAge > 0 ? "public, max-age=" + to_string(maxAge) : "no-cache";
+    
+    // DERIVX_SERVER_TIMING=1: этапы обработки в заголовке Server-Timing,
+    // DERIVX_TRACE_FILE: файл Chrome trace для запросов дольше DERIVX_TRACE_SLOW_MS
+    // (каждый DERIVX_TRACE_SAMPLE-й из них)
+    derivx::RequestTracingConfig tracingConfig;
+    tracingConfig.serverTiming = readEnvInt("DERIVX_SERVER_TIMING", 0) != 0;
+    const char* traceFile = getenv("DERIVX_TRACE_FILE");
+    tracingConfig.traceFile = traceFile != nullptr ? traceFile : "";
+    tracingConfig.slowMicros = readEnvInt("DERIVX_TRACE_SLOW_MS", 100) * 1000;
+    tracingConfig.sampleEvery = static_cast<uint32_t>(max<long long>(readEnvInt("DERIVX_TRACE_SAMPLE", 1), 1));
+    derivx::RequestTracing::configure(tracingConfig);
+    
+    // DERIVX_COMPUTE_THREADS: размер пула расчетов (0 - по числу ядер),
+    // DERIVX_PIN_THREADS=1: привязка потоков пула к ядрам
+    derivx::ComputePoolConfig poolConfig;
+    poolConfig.workerCount = static_cast<size_t>(readEnvInt("DERIVX_COMPUTE_THREADS", 0));
+    poolConfig.pinThreads = readEnvInt("DERIVX_PIN_THREADS", 0) != 0;
+    computePool = make_unique<derivx::ComputePool>(poolConfig);
+    apiHandler.setComputePool(computePool.get());
+    
+    // Допуск запросов: DERIVX_HEAVY_COST (стоимость, с которой запрос тяжелый),
+    // DERIVX_HEAVY_BUDGET (суммарная стоимость тяжелых запросов в работе),
+    // DERIVX_HEAVY_LIMIT, DERIVX_INTERACTIVE_LIMIT (запросов полосы в работе),
+    // DERIVX_INTERACTIVE_DEADLINE_MS, DERIVX_HEAVY_DEADLINE_MS (сроки полос)
+    derivx::AdmissionConfig admissionConfig;
+    admissionConfig.heavyThreshold = static_cast<uint64_t>(readEnvInt("DERIVX_HEAVY_COST", 2000));
+    admissionConfig.heavyBudget = static_cast<uint64_t>(readEnvInt("DERIVX_HEAVY_BUDGET", 2000000));
+    admissionConfig.heavyLimit = static_cast<size_t>(max<long long>(readEnvInt("DERIVX_HEAVY_LIMIT", 64), 1));
+    admissionConfig.interactiveLimit = static_cast<size_t>(max<long long>(readEnvInt("DERIVX_INTERACTIVE_LIMIT", 4096), 1));
+    admissionConfig.interactiveDeadline = chrono::milliseconds(readEnvInt("DERIVX_INTERACTIVE_DEADLINE_MS", 2000));
+    admissionConfig.heavyDeadline = chrono::milliseconds(readEnvInt("DERIVX_HEAVY_DEADLINE_MS", 10000));
+    admission = make_unique<derivx::AdmissionController>(admissionConfig);
+    apiHandler.setAdmission(admission.get());
+    
+    // DERIVX_STREAM_POLL_MS: как часто проверять файлы символов с SSE подписками
+    auto streamPollInterval = chrono::milliseconds(max<long long>(readEnvInt("DERIVX_STREAM_POLL_MS", 1000), 50));
+    streamPumpRunning.store(true);
+    streamPump = thread(runStreamPump, streamPollInterval);
     cout << "Data directory: " << dataDir << endl;
+    cout << "Cache budget: " << (cacheConfig.memoryBudgetBytes / (1024 * 1024)) << " MB (0 = unlimited)" << endl;
+    cout << "Compute threads: " << computePool->workerCount() << endl;
     cout << "API Base URL: " << API_BASE_URL << endl;
     
     // Создание HTTP listener
@@ -246,6 +844,7 @@ int main(int argc, char* argv[]) {
     
     // Регистрация обработчиков
     listener.support(methods::GET, [](http_request request) {
+        observeRequest(request);
         auto path = request.relative_uri().path();
         
         if (path == U("/") || path == U("")) {
@@ -258,12 +857,21 @@ int main(int argc, char* argv[]) {
             handleGetCurrentPrice(request);
         } else if (path.find(U("/api/ohlcv/")) == 0) {
             handleGetOHLCV(request);
+        } else if (path.find(U("/api/option-chain/")) == 0) {
+            handleGetOptionChain(request);
+        } else if (path == U("/api/cache/stats")) {
+            handleGetCacheStats(request);
+        } else if (path.find(U("/api/stream/strategy/")) == 0) {
+            handleStrategyStream(request);
+        } else if (path == U("/api/metrics")) {
+            handleGetMetrics(request);
         } else {
             request.reply(status_codes::NotFound);
         }
     });
     
     listener.support(methods::POST, [](http_request request) {
+        observeRequest(request);
         auto path = request.relative_uri().path();
         
         if (path == U("/api/calculate-option")) {
@@ -272,6 +880,14 @@ int main(int argc, char* argv[]) {
             handleCalculateStrategy(request);
         } else if (path == U("/api/calculate-greeks")) {
             handleCalculateGreeks(request);
+        } else if (path == U("/api/batch")) {
+            handleBatch(request);
+        } else if (path == U("/api/backtest")) {
+            handleBacktest(request);
+        } else if (path == U("/api/optimize-strategy")) {
+            handleOptimizeStrategy(request);
+        } else if (path == U("/api/model-chain")) {
+            handleModelChain(request);
         } else {
             request.reply(status_codes::NotFound);
         }
@@ -291,6 +907,14 @@ int main(int argc, char* argv[]) {
                 cout << "  GET  /api/volatility/{symbol}" << endl;
                 cout << "  GET  /api/price/{symbol}" << endl;
                 cout << "  GET  /api/ohlcv/{symbol}" << endl;
+                cout << "  GET  /api/option-chain/{symbol}" << endl;
+                cout << "  GET  /api/cache/stats" << endl;
+                cout << "  POST /api/batch" << endl;
+                cout << "  POST /api/backtest" << endl;
+                cout << "  POST /api/optimize-strategy" << endl;
+                cout << "  POST /api/model-chain" << endl;
+                cout << "  GET  /api/stream/strategy/{symbol}" << endl;
+                cout << "  GET  /api/metrics" << endl;
             })
             .wait();
         
@@ -298,10 +922,18 @@ int main(int argc, char* argv[]) {
         string line;
         getline(cin, line);
         
+        streamPumpRunning.store(false);
+        streamPump.join();
         listener.close().wait();
+        apiHandler.setComputePool(nullptr);
+        computePool.reset();
         
     } catch (const exception& e) {
         cerr << "Error: " << e.what() << endl;
+        streamPumpRunning.store(false);
+        if (streamPump.joinable()) {
+            streamPump.join();
+        }
         return 1;
     }
     
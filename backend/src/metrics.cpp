@@ -0,0 +1,242 @@
+#include "../include/metrics.hpp"
+#include <cstdio>
+
+namespace derivx {
+
+namespace {
+
+// Шард пишет только поток-владелец: обычный инкремент без атомарного RMW
+inline void bump(std::atomic<uint64_t>& counter, uint64_t value = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+thread_local void* tlsShard = nullptr;
+
+void appendNumber(std::string& out, double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+    out += buffer;
+}
+
+void appendSample(std::string& out, const char* name, const std::string& labels, double value) {
+    out += name;
+    if (!labels.empty()) {
+        out += '{';
+        out += labels;
+        out += '}';
+    }
+    out += ' ';
+    appendNumber(out, value);
+    out += '\n';
+}
+
+void appendHeader(std::string& out, const char* name, const char* type, const char* help) {
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+} // namespace
+
+Metrics& Metrics::global() {
+    static Metrics instance;
+    return instance;
+}
+
+size_t Metrics::registerEndpoint(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < endpoints_.size(); ++i) {
+        if (endpoints_[i] == name) {
+            return i;
+        }
+    }
+    if (endpoints_.size() == MAX_ENDPOINTS) {
+        return MAX_ENDPOINTS - 1;
+    }
+    endpoints_.push_back(name);
+    return endpoints_.size() - 1;
+}
+
+Metrics::Shard& Metrics::localShard() {
+    // Metrics существует в единственном экземпляре, поэтому достаточно одного TLS указателя
+    if (tlsShard == nullptr) {
+        auto shard = std::make_unique<Shard>();
+        std::lock_guard<std::mutex> lock(mutex_);
+        tlsShard = shard.get();
+        shards_.push_back(std::move(shard));
+    }
+    return *static_cast<Shard*>(tlsShard);
+}
+
+void Metrics::record(Histogram& histogram, uint64_t value) {
+    bump(histogram.counts[bucketIndex(value)]);
+    bump(histogram.sum, value);
+}
+
+void Metrics::recordRequest(size_t endpoint, uint64_t micros, bool error) {
+    if (endpoint >= MAX_ENDPOINTS) {
+        return;
+    }
+    Shard& shard = localShard();
+    bump(shard.requests[endpoint]);
+    if (error) {
+        bump(shard.errors[endpoint]);
+    }
+    record(shard.latency[endpoint], micros);
+}
+
+void Metrics::recordError(size_t endpoint) {
+    if (endpoint >= MAX_ENDPOINTS) {
+        return;
+    }
+    bump(localShard().errors[endpoint]);
+}
+
+void Metrics::recordDataLoad(uint64_t micros, bool found) {
+    Shard& shard = localShard();
+    bump(shard.loads);
+    if (!found) {
+        bump(shard.loadMisses);
+    }
+    record(shard.loadTime, micros);
+}
+
+void Metrics::recordQueueDepth(uint64_t depth) {
+    record(localShard().queueDepth, depth);
+}
+
+void Metrics::HistogramTotals::add(const Histogram& histogram) {
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        uint64_t value = histogram.counts[i].load(std::memory_order_relaxed);
+        counts[i] += value;
+        count += value;
+    }
+    sum += histogram.sum.load(std::memory_order_relaxed);
+}
+
+uint64_t Metrics::HistogramTotals::quantile(double q) const {
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            // Наибольшее значение, попадающее в корзину
+            return bucketUpperBound(i) - 1;
+        }
+    }
+    return bucketUpperBound(BUCKETS - 1) - 1;
+}
+
+void Metrics::appendHistogram(
+    std::string& out,
+    const char* name,
+    const std::string& labels,
+    const HistogramTotals& totals,
+    double scale
+) {
+    std::string prefix = labels.empty() ? std::string() : labels + ",";
+    std::string bucketName = std::string(name) + "_bucket";
+
+    // Границы le - степени двойки: корзины HDR на них выровнены
+    uint64_t cumulative = 0;
+    size_t index = 0;
+    for (size_t exponent = 3; exponent < MAX_EXPONENT; ++exponent) {
+        uint64_t bound = uint64_t(1) << exponent;
+        while (index < BUCKETS && bucketUpperBound(index) <= bound) {
+            cumulative += totals.counts[index++];
+        }
+        std::string le;
+        appendNumber(le, static_cast<double>(bound) * scale);
+        appendSample(out, bucketName.c_str(), prefix + "le=\"" + le + "\"", static_cast<double>(cumulative));
+    }
+    appendSample(out, bucketName.c_str(), prefix + "le=\"+Inf\"", static_cast<double>(totals.count));
+    appendSample(out, (std::string(name) + "_sum").c_str(), labels, static_cast<double>(totals.sum) * scale);
+    appendSample(out, (std::string(name) + "_count").c_str(), labels, static_cast<double>(totals.count));
+}
+
+std::string Metrics::renderPrometheus() const {
+    const double micros = 1e-6;
+    const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+    std::vector<std::string> endpoints;
+    std::vector<uint64_t> requests(MAX_ENDPOINTS, 0);
+    std::vector<uint64_t> errors(MAX_ENDPOINTS, 0);
+    std::vector<HistogramTotals> latency(MAX_ENDPOINTS);
+    uint64_t loads = 0;
+    uint64_t loadMisses = 0;
+    HistogramTotals loadTime;
+    HistogramTotals queueDepth;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        endpoints = endpoints_;
+        for (const auto& shard : shards_) {
+            for (size_t i = 0; i < endpoints.size(); ++i) {
+                requests[i] += shard->requests[i].load(std::memory_order_relaxed);
+                errors[i] += shard->errors[i].load(std::memory_order_relaxed);
+                latency[i].add(shard->latency[i]);
+            }
+            loads += shard->loads.load(std::memory_order_relaxed);
+            loadMisses += shard->loadMisses.load(std::memory_order_relaxed);
+            loadTime.add(shard->loadTime);
+            queueDepth.add(shard->queueDepth);
+        }
+    }
+
+    std::string out;
+    out.reserve(4096 + endpoints.size() * 4096);
+
+    appendHeader(out, "derivx_http_requests_total", "counter", "HTTP requests by endpoint");
+    for (size_t i = 0; i < endpoints.size(); ++i) {
+        appendSample(out, "derivx_http_requests_total", "endpoint=\"" + endpoints[i] + "\"",
+                     static_cast<double>(requests[i]));
+    }
+
+    appendHeader(out, "derivx_http_request_errors_total", "counter",
+                 "Requests answered with 4xx/5xx status or an error body");
+    for (size_t i = 0; i < endpoints.size(); ++i) {
+        appendSample(out, "derivx_http_request_errors_total", "endpoint=\"" + endpoints[i] + "\"",
+                     static_cast<double>(errors[i]));
+    }
+
+    appendHeader(out, "derivx_http_request_duration_seconds", "histogram", "Request latency");
+    for (size_t i = 0; i < endpoints.size(); ++i) {
+        appendHistogram(out, "derivx_http_request_duration_seconds", "endpoint=\"" + endpoints[i] + "\"",
+                        latency[i], micros);
+    }
+
+    appendHeader(out, "derivx_http_request_duration_quantile_seconds", "gauge",
+                 "Request latency quantiles since start (12.5% precision)");
+    for (size_t i = 0; i < endpoints.size(); ++i) {
+        for (double q : quantiles) {
+            std::string label = "endpoint=\"" + endpoints[i] + "\",quantile=\"";
+            appendNumber(label, q);
+            appendSample(out, "derivx_http_request_duration_quantile_seconds", label + "\"",
+                         static_cast<double>(latency[i].quantile(q)) * micros);
+        }
+    }
+
+    appendHeader(out, "derivx_data_loads_total", "counter", "Symbol data file reads");
+    appendSample(out, "derivx_data_loads_total", "", static_cast<double>(loads));
+    appendHeader(out, "derivx_data_load_misses_total", "counter", "Reads that found no data for the symbol");
+    appendSample(out, "derivx_data_load_misses_total", "", static_cast<double>(loadMisses));
+    appendHeader(out, "derivx_data_load_duration_seconds", "histogram", "Symbol data file read and parse time");
+    appendHistogram(out, "derivx_data_load_duration_seconds", "", loadTime, micros);
+
+    appendHeader(out, "derivx_compute_queue_depth_observed", "histogram",
+                 "Compute pool queue depth seen by arriving requests");
+    appendHistogram(out, "derivx_compute_queue_depth_observed", "", queueDepth, 1.0);
+
+    return out;
+}
+
+} // namespace derivx
@@ -0,0 +1,407 @@
+#include "../include/model_calibration.hpp"
+#include "../include/admission.hpp"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <map>
+#include <random>
+
+namespace derivx {
+
+namespace {
+
+using Point = std::vector<double>;
+
+double logistic(double x) {
+    return 1.0 / (1.0 + std::exp(-x));
+}
+
+/**
+ * Неограниченные координаты -> параметры модели
+ */
+FourierModel decode(FourierModelType type, const Point& x) {
+    FourierModel model;
+    model.type = type;
+    switch (type) {
+        case FourierModelType::HESTON:
+            model.v0 = std::exp(x[0]);
+            model.kappa = std::exp(x[1]);
+            model.theta = std::exp(x[2]);
+            model.xi = std::exp(x[3]);
+            model.rho = 0.999 * std::tanh(x[4]);
+            break;
+        case FourierModelType::MERTON:
+            model.sigma = std::exp(x[0]);
+            model.lambda = std::exp(x[1]);
+            model.jumpMean = x[2];
+            model.jumpVolatility = std::exp(x[3]);
+            break;
+        case FourierModelType::KOU:
+            model.sigma = std::exp(x[0]);
+            model.lambda = std::exp(x[1]);
+            model.upProbability = logistic(x[2]);
+            model.upRate = 1.0 + std::exp(x[3]);
+            model.downRate = std::exp(x[4]);
+            break;
+    }
+    return model;
+}
+
+/**
+ * Начальная точка старта: параметры по умолчанию в масштабе дисперсии
+ * variance (годовой), старты после первого - со случайным сдвигом
+ */
+Point initialPoint(FourierModelType type, double variance, size_t start) {
+    variance = std::max(variance, 1e-4);
+    Point x;
+    switch (type) {
+        case FourierModelType::HESTON:
+            x = {std::log(variance), std::log(2.0), std::log(variance), std::log(0.5), std::atanh(-0.5)};
+            break;
+        case FourierModelType::MERTON:
+            x = {std::log(std::sqrt(0.8 * variance)), std::log(2.0), -0.02, std::log(0.1)};
+            break;
+        case FourierModelType::KOU:
+            x = {std::log(std::sqrt(0.8 * variance)), std::log(2.0), 0.0, std::log(10.0), std::log(10.0)};
+            break;
+    }
+    if (start > 0) {
+        std::mt19937_64 rng(0x5eed + start);
+        std::normal_distribution<double> shift(0.0, 0.7);
+        for (double& value : x) {
+            value += shift(rng);
+        }
+    }
+    return x;
+}
+
+/**
+ * Симплекс-метод Нелдера-Мида; срок запроса проверяется на каждой итерации
+ */
+Point minimize(const std::function<double(const Point&)>& objective, Point start, size_t maxIterations,
+               double& best, size_t& evaluations) {
+    const RequestDeadline* deadline = RequestDeadline::current();
+    size_t n = start.size();
+    std::vector<Point> simplex(n + 1, start);
+    std::vector<double> values(n + 1);
+    for (size_t i = 0; i < n; ++i) {
+        simplex[i + 1][i] += 0.5;
+    }
+    auto evaluate = [&](const Point& x) {
+        ++evaluations;
+        // Вне разумной области (параметры от e^-10 до e^4) - худшее значение: на
+        // коротких рядах иначе уходят в вырожденные пределы (kappa -> inf и т.п.)
+        for (double value : x) {
+            if (value < -10.0 || value > 4.0) {
+                return std::numeric_limits<double>::max();
+            }
+        }
+        double value = objective(x);
+        return std::isfinite(value) ? value : std::numeric_limits<double>::max();
+    };
+    for (size_t i = 0; i <= n; ++i) {
+        values[i] = evaluate(simplex[i]);
+    }
+
+    std::vector<size_t> order(n + 1);
+    for (size_t iteration = 0; iteration < maxIterations; ++iteration) {
+        if (deadline != nullptr) {
+            deadline->check();
+        }
+        for (size_t i = 0; i <= n; ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return values[a] < values[b]; });
+        size_t lowest = order[0];
+        size_t highest = order[n];
+        size_t second = order[n - 1];
+        if (values[highest] - values[lowest] <= 1e-12 * (std::fabs(values[lowest]) + 1e-20)) {
+            break;
+        }
+
+        Point centroid(n, 0.0);
+        for (size_t i = 0; i <= n; ++i) {
+            if (i != highest) {
+                for (size_t j = 0; j < n; ++j) {
+                    centroid[j] += simplex[i][j] / static_cast<double>(n);
+                }
+            }
+        }
+        auto along = [&](double t) {
+            Point x(n);
+            for (size_t j = 0; j < n; ++j) {
+                x[j] = centroid[j] + t * (simplex[highest][j] - centroid[j]);
+            }
+            return x;
+        };
+
+        Point reflected = along(-1.0);
+        double reflectedValue = evaluate(reflected);
+        if (reflectedValue < values[lowest]) {
+            Point expanded = along(-2.0);
+            double expandedValue = evaluate(expanded);
+            if (expandedValue < reflectedValue) {
+                simplex[highest] = expanded;
+                values[highest] = expandedValue;
+            } else {
+                simplex[highest] = reflected;
+                values[highest] = reflectedValue;
+            }
+        } else if (reflectedValue < values[second]) {
+            simplex[highest] = reflected;
+            values[highest] = reflectedValue;
+        } else {
+            Point contracted = reflectedValue < values[highest] ? along(-0.5) : along(0.5);
+            double contractedValue = evaluate(contracted);
+            if (contractedValue < std::min(reflectedValue, values[highest])) {
+                simplex[highest] = contracted;
+                values[highest] = contractedValue;
+            } else {
+                // Сжатие всего симплекса к лучшей вершине
+                for (size_t i = 0; i <= n; ++i) {
+                    if (i == lowest) {
+                        continue;
+                    }
+                    for (size_t j = 0; j < n; ++j) {
+                        simplex[i][j] = simplex[lowest][j] + 0.5 * (simplex[i][j] - simplex[lowest][j]);
+                    }
+                    values[i] = evaluate(simplex[i]);
+                }
+            }
+        }
+    }
+
+    size_t bestIndex = static_cast<size_t>(std::min_element(values.begin(), values.end()) - values.begin());
+    best = values[bestIndex];
+    return simplex[bestIndex];
+}
+
+/**
+ * Независимые старты (параллельно, если есть пул); лучший - с наименьшим
+ * значением, при равенстве - с меньшим номером
+ */
+CalibrationResult runStarts(FourierModelType type, double variance, size_t starts, size_t maxIterations,
+                            const std::function<double(const Point&)>& objective, ComputePool* pool) {
+    starts = std::max<size_t>(starts, 1);
+    std::vector<Point> solutions(starts);
+    std::vector<double> values(starts, std::numeric_limits<double>::max());
+    std::vector<size_t> evaluations(starts, 0);
+    const RequestDeadline* deadline = RequestDeadline::current();
+
+    auto run = [&](size_t lo, size_t hi) {
+        DeadlineScope scope(deadline);
+        for (size_t s = lo; s < hi; ++s) {
+            solutions[s] = minimize(objective, initialPoint(type, variance, s), maxIterations,
+                                    values[s], evaluations[s]);
+        }
+    };
+    if (pool != nullptr && starts > 1) {
+        pool->parallelFor(0, starts, 1, run);
+    } else {
+        run(0, starts);
+    }
+
+    CalibrationResult result;
+    size_t best = 0;
+    for (size_t s = 0; s < starts; ++s) {
+        result.evaluations += evaluations[s];
+        if (values[s] < values[best]) {
+            best = s;
+        }
+    }
+    result.model = decode(type, solutions[best]);
+    result.error = values[best];
+    result.starts = starts;
+    return result;
+}
+
+} // namespace
+
+CalibrationResult ModelCalibration::toQuotes(
+    FourierModelType type,
+    const std::vector<CalibrationQuote>& quotes,
+    const MarketParams& market,
+    size_t starts,
+    ComputePool* pool
+) {
+    // Котировки по экспирациям: на каждую - одна цепочка страйков
+    struct Expiry {
+        double timeToExpiration;
+        std::vector<double> strikes;
+        std::vector<size_t> quotes;
+    };
+    std::map<double, Expiry> grouped;
+    for (size_t i = 0; i < quotes.size(); ++i) {
+        Expiry& expiry = grouped[quotes[i].timeToExpiration];
+        expiry.timeToExpiration = quotes[i].timeToExpiration;
+        expiry.strikes.push_back(quotes[i].strike);
+        expiry.quotes.push_back(i);
+    }
+    std::vector<Expiry> expiries;
+    for (auto& entry : grouped) {
+        expiries.push_back(std::move(entry.second));
+    }
+
+    double scale = market.spotPrice > 0 ? market.spotPrice : 1.0;
+    auto objective = [&](const Point& x) {
+        FourierModel model = decode(type, x);
+        if (!model.valid()) {
+            return std::numeric_limits<double>::max();
+        }
+        double sum = 0.0;
+        std::vector<double> calls;
+        std::vector<double> puts;
+        for (const Expiry& expiry : expiries) {
+            MarketParams at = market;
+            at.timeToExpiration = expiry.timeToExpiration;
+            calls.resize(expiry.strikes.size());
+            puts.resize(expiry.strikes.size());
+            FourierPricing::priceChain(model, at, expiry.strikes.data(), expiry.strikes.size(), FourierMethod::COS,
+                                       calls.data(), puts.data());
+            for (size_t j = 0; j < expiry.quotes.size(); ++j) {
+                const CalibrationQuote& quote = quotes[expiry.quotes[j]];
+                double price = quote.type == OptionType::CALL ? calls[j] : puts[j];
+                double difference = (price - quote.price) / scale;
+                sum += difference * difference;
+            }
+        }
+        return sum;
+    };
+
+    double variance = market.volatility * market.volatility;
+    CalibrationResult result = runStarts(type, variance, starts, 400, objective, pool);
+    // RMSE в ценах
+    result.error = quotes.empty() ? 0.0 : scale * std::sqrt(result.error / static_cast<double>(quotes.size()));
+    return result;
+}
+
+CalibrationResult ModelCalibration::toReturns(
+    FourierModelType type,
+    const std::vector<double>& returns,
+    double step,
+    size_t starts,
+    ComputePool* pool
+) {
+    CalibrationResult result;
+    result.model.type = type;
+    if (returns.size() < 2 || step <= 0) {
+        return result;
+    }
+
+    // Доходности за 1, 5 и 20 дней (скользящие суммы шагов): на коротком
+    // горизонте неразличимы параметры возврата к среднему, на длинных - видны
+    const double horizonDays[] = {1.0, 5.0, 20.0};
+    const size_t frequencies = 32;
+    struct Horizon {
+        double years;
+        std::vector<double> grid;
+        std::vector<double> weights;
+        std::vector<std::complex<double>> empirical;
+    };
+    std::vector<Horizon> fitted;
+    double annualVariance = 0.0;
+
+    for (double days : horizonDays) {
+        size_t steps = static_cast<size_t>(std::max(std::llround(days / 365.0 / step), 1LL));
+        if (returns.size() < steps * 30) {
+            break;
+        }
+        std::vector<double> sums(returns.size() - steps + 1);
+        double window = 0.0;
+        for (size_t i = 0; i < returns.size(); ++i) {
+            window += returns[i];
+            if (i >= steps) {
+                window -= returns[i - steps];
+            }
+            if (i + 1 >= steps) {
+                sums[i + 1 - steps] = window;
+            }
+        }
+
+        double mean = 0.0;
+        for (double value : sums) {
+            mean += value;
+        }
+        mean /= static_cast<double>(sums.size());
+        double variance = 0.0;
+        for (double value : sums) {
+            variance += (value - mean) * (value - mean);
+        }
+        variance = std::max(variance / static_cast<double>(sums.size()), 1e-16);
+        if (fitted.empty()) {
+            annualVariance = variance / (step * static_cast<double>(steps));
+        }
+
+        // Частоты до 4/sd, гауссовы веса подавляют шумные высокие частоты
+        Horizon horizon;
+        horizon.years = step * static_cast<double>(steps);
+        double deviation = std::sqrt(variance);
+        for (size_t j = 0; j < frequencies; ++j) {
+            double u = 4.0 / deviation * static_cast<double>(j + 1) / static_cast<double>(frequencies);
+            std::complex<double> sum(0.0, 0.0);
+            for (double value : sums) {
+                double phase = u * (value - mean);
+                sum += std::complex<double>(std::cos(phase), std::sin(phase));
+            }
+            horizon.grid.push_back(u);
+            horizon.weights.push_back(std::exp(-0.25 * u * u * variance));
+            horizon.empirical.push_back(sum / static_cast<double>(sums.size()));
+        }
+        fitted.push_back(std::move(horizon));
+    }
+    if (fitted.empty()) {
+        return result;
+    }
+
+    auto objective = [&](const Point& x) {
+        FourierModel model = decode(type, x);
+        if (!model.valid()) {
+            return std::numeric_limits<double>::max();
+        }
+        double sum = 0.0;
+        for (const Horizon& horizon : fitted) {
+            for (size_t j = 0; j < horizon.grid.size(); ++j) {
+                std::complex<double> value = FourierPricing::centeredCharacteristic(model, horizon.grid[j], horizon.years);
+                sum += horizon.weights[j] * std::norm(value - horizon.empirical[j]);
+            }
+        }
+        return sum;
+    };
+
+    return runStarts(type, annualVariance, starts, 1000, objective, pool);
+}
+
+CalibrationResult ModelCalibration::toHistory(
+    FourierModelType type,
+    OHLCVView data,
+    size_t starts,
+    ComputePool* pool
+) {
+    CalibrationResult result;
+    result.model.type = type;
+    if (data.size() < 2) {
+        return result;
+    }
+
+    // Шаг свечей - медиана интервалов последних (до 1000) свечей
+    OHLCVView recent = data.last(1001);
+    std::vector<int64_t> intervals;
+    intervals.reserve(recent.size() - 1);
+    for (size_t i = 1; i < recent.size(); ++i) {
+        intervals.push_back(recent[i].timestamp - recent[i - 1].timestamp);
+    }
+    std::nth_element(intervals.begin(), intervals.begin() + intervals.size() / 2, intervals.end());
+    double step = static_cast<double>(std::max<int64_t>(intervals[intervals.size() / 2], 1)) / (365.0 * 86400.0);
+
+    std::vector<double> returns;
+    returns.reserve(data.size() - 1);
+    for (size_t i = 1; i < data.size(); ++i) {
+        if (data[i - 1].close > 0 && data[i].close > 0) {
+            returns.push_back(std::log(data[i].close / data[i - 1].close));
+        }
+    }
+    return toReturns(type, returns, step, starts, pool);
+}
+
+} // namespace derivx
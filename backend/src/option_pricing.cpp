@@ -1,7 +1,6 @@
 #include "../include/option_pricing.hpp"
 #include <algorithm>
 #include <cmath>
-#include <iostream>
 
 using namespace std;
 namespace derivx {
@@ -9,8 +8,14 @@ namespace derivx {
 // Константа для нормального распределения
 const double INV_SQRT_2PI = 1.0 / std::sqrt(2.0 * M_PI);
 
-double OptionPricing::normalCDF(double x) {
-    // Аппроксимация нормального CDF (формула Абрамовица и Стигана)
+namespace {
+
+/**
+ * Нормальный CDF по аппроксимации Абрамовица и Стигана (7.1.26) для
+ * erf(x / sqrt(2)) при уже посчитанной gaussian = exp(-x^2 / 2);
+ * абсолютная погрешность не больше 1e-7
+ */
+inline double normalCDFWithGaussian(double x, double gaussian) {
     const double a1 =  0.254829592;
     const double a2 = -0.284496736;
     const double a3 =  1.421413741;
@@ -18,16 +23,17 @@ double OptionPricing::normalCDF(double x) {
     const double a5 =  1.061405429;
     const double p  =  0.3275911;
     
-    int sign = 1;
-    if (x < 0) {
-        sign = -1;
-        x = -x;
-    }
-    
-    double t = 1.0 / (1.0 + p * x);
-    double y = 1.0 - (((((a5 * t + a4) * t) + a3) * t + a2) * t + a1) * t * std::exp(-x * x / 2.0);
+    double t = 1.0 / (1.0 + p * std::fabs(x) * M_SQRT1_2);
+    double y = 1.0 - (((((a5 * t + a4) * t) + a3) * t + a2) * t + a1) * t * gaussian;
     
-    return 0.5 * (1.0 + sign * y);
+    return 0.5 * (1.0 + (x < 0 ? -y : y));
+}
+
+} // namespace
+
+double OptionPricing::normalCDF(double x) {
+    // Аппроксимация нормального CDF (формула Абрамовица и Стигана)
+    return normalCDFWithGaussian(x, std::exp(-x * x / 2.0));
 }
 
 double OptionPricing::normalPDF(double x) {
@@ -63,8 +69,6 @@ double OptionPricing::calculateBlackScholes(
         }
     }
 
-    cout << "Volatility: " << sigma << endl;
-    
     if (sigma <= 0.0) {
         // Если волатильность нулевая, возвращаем внутреннюю стоимость
         if (type == OptionType::CALL) {
@@ -147,6 +151,164 @@ Greeks OptionPricing::calculateGreeks(
     return greeks;
 }
 
+void OptionPricing::calculateChain(
+    const MarketParams& market,
+    const double* strikes,
+    const double* logMoneyness,
+    size_t count,
+    ChainQuote* out
+) {
+    const double S = market.spotPrice;
+    const double T = market.timeToExpiration;
+    const double sigma = market.volatility;
+    const double r = market.riskFreeRate;
+    const double q = market.dividendYield;
+    
+    if (T <= 0.0 || sigma <= 0.0) {
+        // Вырожденная экспирация: внутренняя стоимость, греки не определены
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = ChainQuote();
+            out[i].strike = strikes[i];
+            out[i].callPrice = calculateBlackScholes(OptionType::CALL, S, strikes[i], T, sigma, r, q);
+            out[i].putPrice = calculateBlackScholes(OptionType::PUT, S, strikes[i], T, sigma, r, q);
+        }
+        return;
+    }
+    
+    // Общие для всех страйков экспирации величины
+    const double sqrtT = std::sqrt(T);
+    const double sigmaSqrtT = sigma * sqrtT;
+    const double drift = (r - q + 0.5 * sigma * sigma) * T;
+    const double discount = std::exp(-r * T);
+    const double dividendDiscount = std::exp(-q * T);
+    const double spotDiscounted = S * dividendDiscount;
+    const double gammaScale = dividendDiscount / (S * sigmaSqrtT);
+    const double vegaScale = spotDiscounted * sqrtT / 100.0;
+    const double decay = -spotDiscounted * sigma / (2.0 * sqrtT);
+    
+    // Один проход без ветвлений по страйкам
+    for (size_t i = 0; i < count; ++i) {
+        const double K = strikes[i];
+        const double moneyness = logMoneyness != nullptr ? logMoneyness[i] : std::log(S / K);
+        const double d1 = (moneyness + drift) / sigmaSqrtT;
+        const double d2 = d1 - sigmaSqrtT;
+        const double strikeDiscounted = K * discount;
+        
+        // exp(-d2^2/2) = exp(-d1^2/2) * S e^(-qT) / (K e^(-rT)): вторая экспонента не нужна
+        const double gaussian1 = std::exp(-0.5 * d1 * d1);
+        const double gaussian2 = gaussian1 * spotDiscounted / strikeDiscounted;
+        const double N_d1 = normalCDFWithGaussian(d1, gaussian1);
+        const double N_d2 = normalCDFWithGaussian(d2, gaussian2);
+        const double pdf_d1 = INV_SQRT_2PI * gaussian1;
+        
+        ChainQuote& quote = out[i];
+        quote.strike = K;
+        
+        // Call напрямую, put по паритету: P = C - S e^(-qT) + K e^(-rT)
+        const double call = spotDiscounted * N_d1 - strikeDiscounted * N_d2;
+        quote.callPrice = std::max(call, 0.0);
+        quote.putPrice = std::max(call - spotDiscounted + strikeDiscounted, 0.0);
+        
+        quote.call.delta = dividendDiscount * N_d1;
+        quote.put.delta = quote.call.delta - dividendDiscount;
+        
+        quote.call.gamma = gammaScale * pdf_d1;
+        quote.put.gamma = quote.call.gamma;
+        
+        const double timeDecay = decay * pdf_d1;
+        quote.call.theta = (timeDecay - r * strikeDiscounted * N_d2 + q * spotDiscounted * N_d1) / 365.0;
+        quote.put.theta = quote.call.theta + (r * strikeDiscounted - q * spotDiscounted) / 365.0;
+        
+        quote.call.vega = vegaScale * pdf_d1;
+        quote.put.vega = quote.call.vega;
+        
+        quote.call.rho = strikeDiscounted * T * N_d2 / 100.0;
+        quote.put.rho = quote.call.rho - strikeDiscounted * T / 100.0;
+    }
+}
+
+void OptionPricing::evaluateGreeksProfile(
+    const std::vector<Option>& options,
+    const MarketParams& market,
+    const double* spots,
+    size_t count,
+    Greeks* out
+) {
+    const double T = market.timeToExpiration;
+    const double sigma = market.volatility;
+    const double r = market.riskFreeRate;
+    const double q = market.dividendYield;
+    
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = Greeks();
+    }
+    if (T <= 0.0 || sigma <= 0.0) {
+        // Если время истекло или волатильность нулевая, греки не определены
+        return;
+    }
+    
+    const double sqrtT = std::sqrt(T);
+    const double sigmaSqrtT = sigma * sqrtT;
+    const double drift = (r - q + 0.5 * sigma * sigma) * T;
+    const double discount = std::exp(-r * T);
+    const double dividendDiscount = std::exp(-q * T);
+    
+    // Ноги блоками по LEG_BLOCK в массивах по полям (без выделений памяти)
+    constexpr size_t LEG_BLOCK = 64;
+    double logStrike[LEG_BLOCK];
+    double strikeDiscounted[LEG_BLOCK];
+    double weight[LEG_BLOCK];
+    
+    for (size_t first = 0; first < options.size(); first += LEG_BLOCK) {
+        const size_t legs = std::min(LEG_BLOCK, options.size() - first);
+        
+        // Put отличается от call на слагаемые паритета, не зависящие от цены:
+        // delta - e^(-qT), theta + (r K e^(-rT) - q S e^(-qT)) / 365, rho - K e^(-rT) T / 100
+        double putWeight = 0.0;
+        double putStrikeDiscounted = 0.0;
+        for (size_t j = 0; j < legs; ++j) {
+            const Option& option = options[first + j];
+            logStrike[j] = std::log(option.strike);
+            strikeDiscounted[j] = option.strike * discount;
+            weight[j] = (option.position == OptionPosition::LONG ? 1.0 : -1.0) * option.quantity;
+            if (option.type == OptionType::PUT) {
+                putWeight += weight[j];
+                putStrikeDiscounted += weight[j] * strikeDiscounted[j];
+            }
+        }
+        
+        for (size_t i = 0; i < count; ++i) {
+            const double S = spots[i];
+            const double logSpot = std::log(S);
+            const double spotDiscounted = S * dividendDiscount;
+            
+            // Взвешенные суммы по ногам: N(d1), K e^(-rT) N(d2), n(d1)
+            double sumN1 = 0.0;
+            double sumStrikeN2 = 0.0;
+            double sumPdf = 0.0;
+            for (size_t j = 0; j < legs; ++j) {
+                const double d1 = (logSpot - logStrike[j] + drift) / sigmaSqrtT;
+                const double d2 = d1 - sigmaSqrtT;
+                const double gaussian1 = std::exp(-0.5 * d1 * d1);
+                const double gaussian2 = gaussian1 * spotDiscounted / strikeDiscounted[j];
+                sumN1 += weight[j] * normalCDFWithGaussian(d1, gaussian1);
+                sumStrikeN2 += weight[j] * strikeDiscounted[j] * normalCDFWithGaussian(d2, gaussian2);
+                sumPdf += weight[j] * gaussian1;
+            }
+            sumPdf *= INV_SQRT_2PI;
+            
+            Greeks& greeks = out[i];
+            greeks.delta += dividendDiscount * (sumN1 - putWeight);
+            greeks.gamma += dividendDiscount * sumPdf / (S * sigmaSqrtT);
+            greeks.theta += (-spotDiscounted * sigma / (2.0 * sqrtT) * sumPdf
+                             - r * sumStrikeN2 + q * spotDiscounted * sumN1
+                             + r * putStrikeDiscounted - q * spotDiscounted * putWeight) / 365.0;
+            greeks.vega += spotDiscounted * sqrtT * sumPdf / 100.0;
+            greeks.rho += T * (sumStrikeN2 - putStrikeDiscounted) / 100.0;
+        }
+    }
+}
+
 double OptionPricing::calculatePayoff(const Option& option, double spotPrice) {
     double intrinsicValue = 0.0;
     
@@ -184,18 +346,26 @@ std::vector<std::pair<double, double>> OptionPricing::generatePayoffCurve(
     double maxPrice,
     int numPoints
 ) {
-    std::vector<std::pair<double, double>> curve;
-    curve.reserve(numPoints);
+    std::vector<std::pair<double, double>> curve(std::max(numPoints, 0));
     
     double step = (maxPrice - minPrice) / (numPoints - 1);
+    evaluatePayoffRange(options, minPrice, step, 0, curve.size(), curve.data());
     
-    for (int i = 0; i < numPoints; ++i) {
+    return curve;
+}
+
+void OptionPricing::evaluatePayoffRange(
+    const std::vector<Option>& options,
+    double minPrice,
+    double step,
+    size_t begin,
+    size_t end,
+    std::pair<double, double>* out
+) {
+    for (size_t i = begin; i < end; ++i) {
         double price = minPrice + i * step;
-        double pnl = calculateStrategyPNL(options, price);
-        curve.emplace_back(price, pnl);
+        out[i] = std::make_pair(price, calculateStrategyPNL(options, price));
     }
-    
-    return curve;
 }
 
 } // namespace derivx
@@ -0,0 +1,162 @@
+#include "../include/payoff_analysis.hpp"
+#include <cmath>
+#include <stdexcept>
+
+namespace derivx {
+
+EmpiricalDistribution::EmpiricalDistribution(std::vector<double> prices)
+    : prices_(std::move(prices)), prefix_(prices_.size() + 1, 0.0) {
+    std::sort(prices_.begin(), prices_.end());
+    for (size_t i = 0; i < prices_.size(); ++i) {
+        prefix_[i + 1] = prefix_[i] + prices_[i];
+    }
+}
+
+EmpiricalDistribution EmpiricalDistribution::fromHistory(OHLCVView data, double spot, double horizonDays) {
+    if (data.size() < 2 || spot <= 0 || horizonDays <= 0) {
+        return EmpiricalDistribution();
+    }
+
+    // Шаг свечей - медиана интервалов последних (до 1000) свечей
+    OHLCVView recent = data.last(1001);
+    std::vector<int64_t> intervals;
+    intervals.reserve(recent.size() - 1);
+    for (size_t i = 1; i < recent.size(); ++i) {
+        intervals.push_back(recent[i].timestamp - recent[i - 1].timestamp);
+    }
+    std::nth_element(intervals.begin(), intervals.begin() + intervals.size() / 2, intervals.end());
+    double step = static_cast<double>(std::max<int64_t>(intervals[intervals.size() / 2], 1));
+    size_t horizon = static_cast<size_t>(std::max(std::llround(horizonDays * 86400.0 / step), 1LL));
+    if (horizon >= data.size()) {
+        return EmpiricalDistribution();
+    }
+
+    std::vector<double> prices;
+    prices.reserve(data.size() - horizon);
+    for (size_t i = 0; i + horizon < data.size(); ++i) {
+        if (data[i].close > 0 && data[i + horizon].close > 0) {
+            prices.push_back(spot * (data[i + horizon].close / data[i].close));
+        }
+    }
+    return EmpiricalDistribution(std::move(prices));
+}
+
+DistributionPoint EmpiricalDistribution::cumulative(double x) const {
+    DistributionPoint point;
+    if (prices_.empty()) {
+        return point;
+    }
+    size_t below = static_cast<size_t>(std::upper_bound(prices_.begin(), prices_.end(), x) - prices_.begin());
+    double n = static_cast<double>(prices_.size());
+    point.probability = static_cast<double>(below) / n;
+    point.partialMean = prefix_[below] / n;
+    return point;
+}
+
+DistributionPoint EmpiricalDistribution::total() const {
+    DistributionPoint point;
+    if (!prices_.empty()) {
+        point.probability = 1.0;
+        point.partialMean = prefix_.back() / static_cast<double>(prices_.size());
+    }
+    return point;
+}
+
+LognormalDistribution::LognormalDistribution(double spot, double volatility, double timeToExpiration,
+                                             double riskFreeRate, double dividendYield)
+    : forward_(spot * std::exp((riskFreeRate - dividendYield) * std::max(timeToExpiration, 0.0))),
+      deviation_(std::max(volatility, 0.0) * std::sqrt(std::max(timeToExpiration, 0.0))) {}
+
+DistributionPoint LognormalDistribution::cumulative(double x) const {
+    DistributionPoint point;
+    if (x <= 0 || forward_ <= 0) {
+        return point;
+    }
+    if (deviation_ <= 0) {
+        // Без волатильности цена на экспирации равна форварду
+        if (x >= forward_) {
+            point.probability = 1.0;
+            point.partialMean = forward_;
+        }
+        return point;
+    }
+    double d1 = (std::log(forward_ / x) + 0.5 * deviation_ * deviation_) / deviation_;
+    double d2 = d1 - deviation_;
+    point.probability = OptionPricing::normalCDF(-d2);
+    point.partialMean = forward_ * OptionPricing::normalCDF(-d1);
+    return point;
+}
+
+DistributionPoint LognormalDistribution::total() const {
+    DistributionPoint point;
+    if (forward_ > 0) {
+        point.probability = 1.0;
+        point.partialMean = forward_;
+    }
+    return point;
+}
+
+void PayoffAnalysis::buildShape(const Option* options, size_t count, PayoffShape& shape) {
+    if (count > PayoffShape::MAX_KINKS) {
+        throw std::invalid_argument("Too many options for payoff analysis");
+    }
+
+    // PNL при нулевой цене и наклон левее первого страйка (его задают путы)
+    double slope = 0.0;
+    double slopeChange[PayoffShape::MAX_KINKS];
+    shape.count = 0;
+    shape.valueAtZero = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        const Option& option = options[i];
+        double weight = (option.position == OptionPosition::LONG ? 1.0 : -1.0) * option.quantity;
+        double intrinsic = option.type == OptionType::PUT ? std::max(option.strike, 0.0) : 0.0;
+        shape.valueAtZero += weight * (intrinsic - option.premium);
+        if (option.type == OptionType::PUT) {
+            slope -= weight;
+        }
+
+        // Различные страйки по возрастанию (ног немного - сортировка вставками);
+        // в страйке наклон любой ноги растет на ее вес
+        double strike = option.strike;
+        size_t position = shape.count;
+        while (position > 0 && shape.kinks[position - 1] > strike) {
+            --position;
+        }
+        if (position > 0 && shape.kinks[position - 1] == strike) {
+            slopeChange[position - 1] += weight;
+            continue;
+        }
+        for (size_t j = shape.count; j > position; --j) {
+            shape.kinks[j] = shape.kinks[j - 1];
+            slopeChange[j] = slopeChange[j - 1];
+        }
+        shape.kinks[position] = strike;
+        slopeChange[position] = weight;
+        ++shape.count;
+    }
+
+    // PNL линеен между изломами: значения в изломах - проход слева направо
+    double previous = 0.0;
+    double value = shape.valueAtZero;
+    for (size_t k = 0; k < shape.count; ++k) {
+        value += slope * (shape.kinks[k] - previous);
+        shape.values[k] = value;
+        slope += slopeChange[k];
+        previous = shape.kinks[k];
+    }
+    shape.rightSlope = slope;
+}
+
+void PayoffAnalysis::bounds(const PayoffShape& shape, PayoffStats& stats) {
+    double lowest = shape.valueAtZero;
+    double highest = shape.valueAtZero;
+    for (size_t k = 0; k < shape.count; ++k) {
+        lowest = std::min(lowest, shape.values[k]);
+        highest = std::max(highest, shape.values[k]);
+    }
+    const double infinity = std::numeric_limits<double>::infinity();
+    stats.maxLoss = shape.rightSlope < 0 ? infinity : std::max(-lowest, 0.0);
+    stats.maxProfit = shape.rightSlope > 0 ? infinity : std::max(highest, 0.0);
+}
+
+} // namespace derivx
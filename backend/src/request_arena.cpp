@@ -0,0 +1,95 @@
+#include "../include/request_arena.hpp"
+#include <atomic>
+#include <algorithm>
+
+namespace derivx {
+
+namespace {
+
+thread_local RequestArena threadArena;
+thread_local RequestArena* currentArena = nullptr;
+
+std::atomic<uint64_t> completedRequests{0};
+std::atomic<uint64_t> overflowedRequests{0};
+std::atomic<uint64_t> retainedBytes{0};
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+} // namespace
+
+RequestArena::~RequestArena() {
+    retainedBytes.fetch_sub(capacity_, std::memory_order_relaxed);
+}
+
+RequestArena* RequestArena::current() {
+    return currentArena;
+}
+
+RequestArenaStats RequestArena::stats() {
+    RequestArenaStats stats;
+    stats.requests = completedRequests.load(std::memory_order_relaxed);
+    stats.overflows = overflowedRequests.load(std::memory_order_relaxed);
+    stats.retainedBytes = retainedBytes.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void RequestArena::begin() {
+    if (!buffer_) {
+        buffer_.reset(new std::byte[INITIAL_BYTES]);
+        capacity_ = INITIAL_BYTES;
+        retainedBytes.fetch_add(capacity_, std::memory_order_relaxed);
+    }
+    offset_ = 0;
+}
+
+void RequestArena::end() {
+    offset_ = 0;
+    completedRequests.fetch_add(1, std::memory_order_relaxed);
+    if (overflow_.empty()) {
+        return;
+    }
+
+    // Запросу не хватило буфера: следующий запрос потока получит буфер под такой объем
+    overflowedRequests.fetch_add(1, std::memory_order_relaxed);
+    size_t wanted = std::min(alignUp(capacity_ + overflowBytes_, INITIAL_BYTES), MAX_RETAINED_BYTES);
+    overflow_.clear();
+    overflowBytes_ = 0;
+    if (wanted > capacity_) {
+        buffer_.reset(new std::byte[wanted]);
+        retainedBytes.fetch_add(wanted - capacity_, std::memory_order_relaxed);
+        capacity_ = wanted;
+    }
+}
+
+void* RequestArena::do_allocate(size_t bytes, size_t alignment) {
+    size_t start = alignUp(offset_, alignment);
+    if (start + bytes <= capacity_) {
+        offset_ = start + bytes;
+        return buffer_.get() + start;
+    }
+
+    // Сверх буфера - отдельный блок из кучи до конца запроса
+    // (new[] выравнивает по max_align_t, больших выравниваний аллокаторы не запрашивают)
+    overflow_.emplace_back(new std::byte[bytes]);
+    overflowBytes_ += bytes;
+    return overflow_.back().get();
+}
+
+ArenaScope::ArenaScope() {
+    if (currentArena == nullptr) {
+        threadArena.begin();
+        currentArena = &threadArena;
+        owned_ = &threadArena;
+    }
+}
+
+ArenaScope::~ArenaScope() {
+    if (owned_ != nullptr) {
+        currentArena = nullptr;
+        owned_->end();
+    }
+}
+
+} // namespace derivx
@@ -0,0 +1,194 @@
+#include "../include/request_trace.hpp"
+#include "../include/json_writer.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unistd.h>
+
+namespace derivx {
+
+namespace {
+
+thread_local RequestTrace* currentTrace = nullptr;
+
+std::atomic<bool> serverTimingOn{false};
+std::atomic<bool> traceFileOn{false};
+std::atomic<int64_t> slowThreshold{100000};
+std::atomic<uint32_t> sampleEvery{1};
+std::atomic<uint64_t> slowSeen{0};
+
+std::mutex fileMutex;
+std::string traceFilePath;
+
+uint32_t threadNumber() {
+    static std::atomic<uint32_t> nextThread{1};
+    thread_local uint32_t number = nextThread.fetch_add(1, std::memory_order_relaxed);
+    return number;
+}
+
+int64_t micros(RequestTrace::Clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
+} // namespace
+
+// ------------------------------------------------------------ RequestTrace
+
+RequestTrace::RequestTrace(std::string name)
+    : name_(std::move(name)), started_(Clock::now()) {
+    spans_.reserve(8);
+}
+
+void RequestTrace::addStage(const char* name, Clock::time_point start, Clock::time_point end) {
+    TraceSpan span{name, micros(start - started_), micros(end - start), threadNumber()};
+    std::lock_guard<std::mutex> lock(mutex_);
+    spans_.push_back(span);
+}
+
+int64_t RequestTrace::elapsedMicros() const {
+    return micros(Clock::now() - started_);
+}
+
+std::vector<TraceSpan> RequestTrace::spans() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return spans_;
+}
+
+std::string RequestTrace::serverTiming() const {
+    std::vector<std::pair<const char*, int64_t>> totals;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& span : spans_) {
+            bool merged = false;
+            for (auto& total : totals) {
+                if (std::strcmp(total.first, span.name) == 0) {
+                    total.second += span.durationMicros;
+                    merged = true;
+                    break;
+                }
+            }
+            if (!merged) {
+                totals.emplace_back(span.name, span.durationMicros);
+            }
+        }
+    }
+    totals.emplace_back("total", elapsedMicros());
+
+    std::string header;
+    char buffer[32];
+    for (const auto& total : totals) {
+        if (!header.empty()) {
+            header += ", ";
+        }
+        std::snprintf(buffer, sizeof(buffer), ";dur=%.3f", static_cast<double>(total.second) / 1000.0);
+        header += total.first;
+        header += buffer;
+    }
+    return header;
+}
+
+RequestTrace* RequestTrace::current() {
+    return currentTrace;
+}
+
+// -------------------------------------------------------------- TraceScope
+
+TraceScope::TraceScope(RequestTrace* trace)
+    : previous_(currentTrace) {
+    currentTrace = trace;
+}
+
+TraceScope::~TraceScope() {
+    currentTrace = previous_;
+}
+
+// ---------------------------------------------------------- RequestTracing
+
+void RequestTracing::configure(const RequestTracingConfig& config) {
+    {
+        std::lock_guard<std::mutex> lock(fileMutex);
+        traceFilePath = config.traceFile;
+    }
+    slowThreshold.store(config.slowMicros, std::memory_order_relaxed);
+    sampleEvery.store(config.sampleEvery > 0 ? config.sampleEvery : 1, std::memory_order_relaxed);
+    serverTimingOn.store(config.serverTiming, std::memory_order_relaxed);
+    traceFileOn.store(!config.traceFile.empty(), std::memory_order_relaxed);
+}
+
+RequestTracePtr RequestTracing::begin(std::string name) {
+    if (!serverTimingOn.load(std::memory_order_relaxed) && !traceFileOn.load(std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return std::make_shared<RequestTrace>(std::move(name));
+}
+
+bool RequestTracing::serverTimingEnabled() {
+    return serverTimingOn.load(std::memory_order_relaxed);
+}
+
+void RequestTracing::finish(const RequestTrace& trace) {
+    if (!traceFileOn.load(std::memory_order_relaxed)) {
+        return;
+    }
+    int64_t total = trace.elapsedMicros();
+    if (total < slowThreshold.load(std::memory_order_relaxed)) {
+        return;
+    }
+    if (slowSeen.fetch_add(1, std::memory_order_relaxed) % sampleEvery.load(std::memory_order_relaxed) != 0) {
+        return;
+    }
+
+    std::string events = formatEvents(trace, total);
+
+    std::lock_guard<std::mutex> lock(fileMutex);
+    std::ofstream file(traceFilePath, std::ios::app | std::ios::binary);
+    if (!file) {
+        return;
+    }
+    // Новый файл начинается с открывающей скобки массива событий
+    if (file.tellp() == 0) {
+        file << "[\n";
+    }
+    file << events;
+}
+
+std::string RequestTracing::formatEvents(const RequestTrace& trace, int64_t totalMicros) {
+    const int64_t base = micros(trace.started().time_since_epoch());
+    const int pid = static_cast<int>(::getpid());
+    std::vector<TraceSpan> spans = trace.spans();
+
+    // Запрос - родительское событие на потоке первого этапа, этапы - вложенные
+    uint32_t requestThread = spans.empty() ? threadNumber() : spans.front().thread;
+
+    std::string out;
+    auto append = [&](const std::string& name, const char* category, int64_t start, int64_t duration, uint32_t tid) {
+        JsonWriter writer(name.size() + 128);
+        writer.beginObject();
+        writer.key("cat");
+        writer.value(category);
+        writer.key("dur");
+        writer.value(duration);
+        writer.key("name");
+        writer.value(name);
+        writer.key("ph");
+        writer.value("X");
+        writer.key("pid");
+        writer.value(pid);
+        writer.key("tid");
+        writer.value(tid);
+        writer.key("ts");
+        writer.value(base + start);
+        writer.endObject();
+        out += writer.release();
+        out += ",\n";
+    };
+
+    append(trace.name(), "request", 0, totalMicros, requestThread);
+    for (const auto& span : spans) {
+        append(span.name, "stage", span.startMicros, span.durationMicros, span.thread);
+    }
+    return out;
+}
+
+} // namespace derivx
@@ -0,0 +1,131 @@
+#include "../include/response_format.hpp"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+namespace derivx {
+
+namespace {
+
+std::string trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    size_t end = text.find_last_not_of(" \t");
+    return text.substr(begin, end - begin + 1);
+}
+
+std::string toLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+bool mediaTypeToFormat(const std::string& mediaType, bool allowPacked, ResponseFormat& format) {
+    if (mediaType == "application/json" || mediaType == "application/*" || mediaType == "*/*") {
+        format = ResponseFormat::JSON;
+    } else if (mediaType == "application/cbor") {
+        format = ResponseFormat::CBOR;
+    } else if (mediaType == "application/msgpack" || mediaType == "application/x-msgpack" ||
+               mediaType == "application/vnd.msgpack") {
+        format = ResponseFormat::MSGPACK;
+    } else if (allowPacked && mediaType == "application/x-derivx-f64") {
+        format = ResponseFormat::PACKED_F64;
+    } else if (allowPacked && mediaType == "application/x-derivx-f32") {
+        format = ResponseFormat::PACKED_F32;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+ResponseFormat ResponseFormats::negotiate(const std::string& acceptHeader, bool allowPacked) {
+    ResponseFormat best = ResponseFormat::JSON;
+    double bestQuality = -1.0;
+
+    // Accept: type/subtype;q=0.8, type/subtype, ...
+    size_t pos = 0;
+    while (pos <= acceptHeader.size()) {
+        size_t comma = acceptHeader.find(',', pos);
+        if (comma == std::string::npos) {
+            comma = acceptHeader.size();
+        }
+        std::string item = acceptHeader.substr(pos, comma - pos);
+        pos = comma + 1;
+
+        size_t semicolon = item.find(';');
+        std::string mediaType = toLower(trim(item.substr(0, semicolon)));
+        double quality = 1.0;
+        while (semicolon != std::string::npos) {
+            size_t next = item.find(';', semicolon + 1);
+            std::string param = trim(item.substr(semicolon + 1, next - semicolon - 1));
+            if (param.size() > 2 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=') {
+                quality = std::strtod(param.c_str() + 2, nullptr);
+            }
+            semicolon = next;
+        }
+
+        ResponseFormat format;
+        // При равном q побеждает первый указанный тип
+        if (quality > 0.0 && quality > bestQuality && mediaTypeToFormat(mediaType, allowPacked, format)) {
+            best = format;
+            bestQuality = quality;
+        }
+    }
+
+    return best;
+}
+
+const char* ResponseFormats::contentType(ResponseFormat format) {
+    switch (format) {
+        case ResponseFormat::CBOR:       return "application/cbor";
+        case ResponseFormat::MSGPACK:    return "application/msgpack";
+        case ResponseFormat::PACKED_F64: return "application/x-derivx-f64";
+        case ResponseFormat::PACKED_F32: return "application/x-derivx-f32";
+        case ResponseFormat::JSON:
+        default:                         return "application/json";
+    }
+}
+
+ResponseFormat ResponseFormats::detect(const std::string& body, ResponseFormat requested) {
+    if (isPacked(requested) && body.compare(0, 4, "DXC1") != 0) {
+        return ResponseFormat::JSON;
+    }
+    return requested;
+}
+
+std::string ResponseFormats::transcode(const std::string& jsonText, ResponseFormat format) {
+    if (format != ResponseFormat::CBOR && format != ResponseFormat::MSGPACK) {
+        return jsonText;
+    }
+
+    nlohmann::json document = nlohmann::json::parse(jsonText);
+    std::string encoded;
+    if (format == ResponseFormat::CBOR) {
+        nlohmann::json::to_cbor(document, encoded);
+    } else {
+        nlohmann::json::to_msgpack(document, encoded);
+    }
+    return encoded;
+}
+
+bool ResponseFormats::isError(const std::string& body) {
+    if (body.compare(0, 8, "{\"error\"") == 0) {
+        return true;
+    }
+    // Ключи объекта идут по алфавиту, поэтому "error" - первый ключ:
+    // карта из 1-2 элементов, затем строка длины 5 (CBOR 0x65, MessagePack 0xA5)
+    if (body.size() < 7 || body.compare(2, 5, "error") != 0) {
+        return false;
+    }
+    unsigned char map = static_cast<unsigned char>(body[0]);
+    unsigned char key = static_cast<unsigned char>(body[1]);
+    return ((map == 0xA1 || map == 0xA2) && key == 0x65) ||
+           ((map == 0x81 || map == 0x82) && key == 0xA5);
+}
+
+} // namespace derivx
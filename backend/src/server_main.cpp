@@ -0,0 +1,547 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <csignal>
+#include <pthread.h>
+#include "../include/api_handler.hpp"
+#include "../include/compute_pool.hpp"
+#include "../include/response_format.hpp"
+#include "../include/metrics.hpp"
+#include "../include/request_trace.hpp"
+#include "../include/json_writer.hpp"
+#include "../include/http_server.hpp"
+#include "../include/admission.hpp"
+using namespace std;
+
+// Сервер DerivX на встроенном HTTP/1.1 сервере (derivx_server): те же маршруты,
+// что у derivx_api, без cpprestsdk. Обработчики выполняются в потоках epoll.
+
+const string DATA_DIR = "../data";
+
+derivx::APIHandler apiHandler;
+
+// Пул для параллельных частей расчета (большие кривые PNL, пакетные запросы)
+unique_ptr<derivx::ComputePool> computePool;
+
+// Допуск запросов: оценка стоимости, лимиты полос, сроки
+unique_ptr<derivx::AdmissionController> admission;
+
+// Cache-Control для ответов с ETag (DERIVX_HTTP_MAX_AGE_SEC)
+string cacheControl = "public, max-age=5";
+
+// CORS headers
+void addCorsHeaders(derivx::HttpResponse& response) {
+    response.addHeader("Access-Control-Allow-Origin", "*");
+    response.addHeader("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
+    response.addHeader("Access-Control-Allow-Headers", "Content-Type, If-None-Match, If-Modified-Since, X-Request-Timeout-Ms");
+    response.addHeader("Access-Control-Expose-Headers", "ETag, Last-Modified, Server-Timing, Retry-After");
+}
+
+// Ответ {"error": message}
+void setError(derivx::HttpResponse& response, int status, const string& message) {
+    derivx::JsonWriter writer(message.size() + 16);
+    writer.beginObject();
+    writer.key("error");
+    writer.value(message);
+    writer.endObject();
+    response.status = status;
+    response.contentType = "application/json";
+    response.body = writer.release();
+}
+
+// Формат ответа по заголовку Accept (JSON по умолчанию)
+derivx::ResponseFormat requestFormat(const derivx::HttpRequest& request, bool allowPacked) {
+    const string* accept = request.header("Accept");
+    if (accept == nullptr) {
+        return derivx::ResponseFormat::JSON;
+    }
+    return derivx::ResponseFormats::negotiate(*accept, allowPacked);
+}
+
+// Тело ответа в согласованном формате; ошибки упакованных форматов приходят в JSON
+void setEncodedBody(derivx::HttpResponse& response, string body, derivx::ResponseFormat format) {
+    derivx::TraceStage stage("encode");
+    derivx::ResponseFormat actual = derivx::ResponseFormats::detect(body, format);
+    response.contentType = derivx::ResponseFormats::contentType(actual);
+    response.body = std::move(body);
+    response.addHeader("Vary", "Accept");
+}
+
+// Символ из пути вида /api/price/{symbol} (пусто - не указан)
+string symbolFromPath(const string& path, size_t prefixLength) {
+    string symbol = path.substr(prefixLength);
+    size_t slash = symbol.find('/');
+    if (slash != string::npos) {
+        symbol.resize(slash);
+    }
+    return derivx::HttpServer::urlDecode(symbol);
+}
+
+// Условный GET данных символа: ETag, Last-Modified, Cache-Control и 304 Not Modified
+void replyConditional(const derivx::HttpRequest& request, derivx::HttpResponse& response,
+                      derivx::ConditionalGet conditional) {
+    if (const string* ifNoneMatch = request.header("If-None-Match")) {
+        conditional.ifNoneMatch = *ifNoneMatch;
+    }
+    if (const string* ifModifiedSince = request.header("If-Modified-Since")) {
+        conditional.ifModifiedSince = *ifModifiedSince;
+    }
+
+    derivx::CachedResponse cached = apiHandler.handleConditionalGet(conditional);
+    if (!cached.etag.empty()) {
+        response.addHeader("ETag", cached.etag);
+        response.addHeader("Cache-Control", cacheControl);
+        if (cached.lastModified > 0) {
+            response.addHeader("Last-Modified", derivx::HttpCaching::formatHttpDate(cached.lastModified));
+        }
+    }
+    if (cached.notModified) {
+        response.status = 304;
+        response.addHeader("Vary", "Accept");
+    } else {
+        setEncodedBody(response, *cached.body, conditional.format);
+    }
+}
+
+// GET /api/volatility/{symbol}, /api/price/{symbol}
+void handleSymbolData(const derivx::HttpRequest& request, derivx::HttpResponse& response,
+                      derivx::DataEndpoint endpoint, size_t prefixLength) {
+    derivx::ConditionalGet conditional;
+    conditional.endpoint = endpoint;
+    conditional.symbol = symbolFromPath(request.path, prefixLength);
+    if (conditional.symbol.empty()) {
+        setError(response, 400, "Symbol not specified");
+        return;
+    }
+    conditional.format = requestFormat(request, false);
+    replyConditional(request, response, conditional);
+}
+
+// GET /api/ohlcv/{symbol}?limit=&from=&to=&maxPoints=&cursor=
+void handleGetOHLCV(const derivx::HttpRequest& request, derivx::HttpResponse& response, size_t prefixLength) {
+    derivx::ConditionalGet conditional;
+    conditional.endpoint = derivx::DataEndpoint::OHLCV;
+    conditional.symbol = symbolFromPath(request.path, prefixLength);
+    if (conditional.symbol.empty()) {
+        setError(response, 400, "Symbol not specified");
+        return;
+    }
+
+    string paramError = derivx::APIHandler::parseOHLCVQuery(request.queryParams(), conditional.query);
+    if (!paramError.empty()) {
+        setError(response, 400, paramError);
+        return;
+    }
+
+    conditional.format = requestFormat(request, true);
+    replyConditional(request, response, conditional);
+}
+
+// GET /api/option-chain/{symbol}?strikes=|minStrike=&maxStrike=&numStrikes=&relative=&expiries=
+void handleGetOptionChain(const derivx::HttpRequest& request, derivx::HttpResponse& response, size_t prefixLength) {
+    derivx::ConditionalGet conditional;
+    conditional.endpoint = derivx::DataEndpoint::OPTION_CHAIN;
+    conditional.symbol = symbolFromPath(request.path, prefixLength);
+    if (conditional.symbol.empty()) {
+        setError(response, 400, "Symbol not specified");
+        return;
+    }
+
+    string paramError = derivx::APIHandler::parseOptionChainQuery(request.queryParams(), conditional.chain);
+    if (!paramError.empty()) {
+        setError(response, 400, paramError);
+        return;
+    }
+
+    conditional.format = requestFormat(request, false);
+    replyConditional(request, response, conditional);
+}
+
+// Событие SSE отправляется, когда клиент забрал предыдущее; пока он читает
+// медленно, новое событие ждет в подписке и может быть заменено более свежим
+class StrategyEventStream : public derivx::HttpStream {
+public:
+    explicit StrategyEventStream(derivx::StreamSubscriberPtr subscriber)
+        : subscriber_(std::move(subscriber)), lastWrite_(chrono::steady_clock::now()) {}
+
+    bool poll(string& out, chrono::steady_clock::time_point now) override {
+        const auto keepAliveInterval = chrono::seconds(15);
+        if (subscriber_->closed()) {
+            return false;
+        }
+        string event;
+        if (subscriber_->take(event)) {
+            out = "event: strategy\ndata: " + event + "\n\n";
+            lastWrite_ = now;
+        } else if (now - lastWrite_ >= keepAliveInterval) {
+            out = ": keepalive\n\n";
+            lastWrite_ = now;
+        }
+        return true;
+    }
+
+    void close() override { subscriber_->close(); }
+
+private:
+    derivx::StreamSubscriberPtr subscriber_;
+    chrono::steady_clock::time_point lastWrite_;
+};
+
+// GET /api/stream/strategy/{symbol}?strategy={json}
+void handleStrategyStream(const derivx::HttpRequest& request, derivx::HttpResponse& response, size_t prefixLength) {
+    string symbol = symbolFromPath(request.path, prefixLength);
+    auto params = request.queryParams();
+    auto strategyIt = params.find("strategy");
+    if (symbol.empty() || strategyIt == params.end()) {
+        setError(response, 400, "Usage: /api/stream/strategy/{symbol}?strategy={json}");
+        return;
+    }
+
+    try {
+        response.stream = make_shared<StrategyEventStream>(apiHandler.subscribeStrategy(symbol, strategyIt->second));
+    } catch (const exception& e) {
+        setError(response, 400, e.what());
+        return;
+    }
+    response.contentType = "text/event-stream";
+    response.addHeader("Cache-Control", "no-cache");
+}
+
+// Фиксированные ответы: описание API и health check
+const string& rootBody() {
+    static const string body = [] {
+        derivx::JsonWriter writer(1024);
+        writer.beginObject();
+        writer.key("endpoints");
+        writer.beginObject();
+        const pair<const char*, const char*> endpoints[] = {
+            {"backtest", "POST /api/backtest"},
+            {"batch", "POST /api/batch"},
+            {"cacheStats", "GET /api/cache/stats"},
+            {"calculateGreeks", "POST /api/calculate-greeks"},
+            {"calculateOption", "POST /api/calculate-option"},
+            {"calculateStrategy", "POST /api/calculate-strategy"},
+            {"getOHLCV", "GET /api/ohlcv/{symbol}"},
+            {"getOptionChain", "GET /api/option-chain/{symbol}"},
+            {"getPrice", "GET /api/price/{symbol}"},
+            {"getVolatility", "GET /api/volatility/{symbol}"},
+            {"health", "GET /api/health"},
+            {"metrics", "GET /api/metrics"},
+            {"modelChain", "POST /api/model-chain"},
+            {"optimizeStrategy", "POST /api/optimize-strategy"},
+            {"strategyStream", "GET /api/stream/strategy/{symbol}?strategy={json}"},
+        };
+        for (const auto& endpoint : endpoints) {
+            writer.key(endpoint.first);
+            writer.value(endpoint.second);
+        }
+        writer.endObject();
+        writer.key("note");
+        writer.value("Use BTC_USDT or BTC/USDT format for symbols");
+        writer.key("service");
+        writer.value("DerivX API");
+        writer.key("status");
+        writer.value("running");
+        writer.key("version");
+        writer.value("1.0.0");
+        writer.endObject();
+        return writer.release();
+    }();
+    return body;
+}
+
+const string healthBody = "{\"service\":\"DerivX API\",\"status\":\"ok\",\"version\":\"1.0.0\"}";
+
+bool startsWith(const string& path, const char* prefix, size_t& prefixLength) {
+    prefixLength = char_traits<char>::length(prefix);
+    return path.compare(0, prefixLength, prefix) == 0;
+}
+
+// Маршрутизация; ответ заполняется обработчиком
+void route(const derivx::HttpRequest& request, derivx::HttpResponse& response) {
+    const string& path = request.path;
+    size_t prefix = 0;
+
+    if (request.method == "OPTIONS") {
+        return;
+    }
+
+    if (request.method == "GET") {
+        if (path == "/") {
+            response.contentType = "application/json";
+            response.body = rootBody();
+        } else if (path == "/api/health") {
+            response.contentType = "application/json";
+            response.body = healthBody;
+        } else if (startsWith(path, "/api/volatility/", prefix)) {
+            handleSymbolData(request, response, derivx::DataEndpoint::VOLATILITY, prefix);
+        } else if (startsWith(path, "/api/price/", prefix)) {
+            handleSymbolData(request, response, derivx::DataEndpoint::PRICE, prefix);
+        } else if (startsWith(path, "/api/ohlcv/", prefix)) {
+            handleGetOHLCV(request, response, prefix);
+        } else if (startsWith(path, "/api/option-chain/", prefix)) {
+            handleGetOptionChain(request, response, prefix);
+        } else if (path == "/api/cache/stats") {
+            response.contentType = "application/json";
+            response.body = apiHandler.handleGetCacheStats();
+        } else if (startsWith(path, "/api/stream/strategy/", prefix)) {
+            handleStrategyStream(request, response, prefix);
+        } else if (path == "/api/metrics") {
+            response.contentType = "text/plain; version=0.0.4; charset=utf-8";
+            response.body = apiHandler.handleGetMetrics();
+        } else {
+            response.status = 404;
+        }
+        return;
+    }
+
+    if (request.method == "POST") {
+        if (path == "/api/calculate-option") {
+            auto format = requestFormat(request, false);
+            setEncodedBody(response, derivx::ResponseFormats::transcode(
+                apiHandler.handleCalculateOption(request.body), format), format);
+        } else if (path == "/api/calculate-strategy") {
+            auto format = requestFormat(request, true);
+            setEncodedBody(response, apiHandler.handleCalculateStrategy(request.body, format), format);
+        } else if (path == "/api/calculate-greeks") {
+            auto format = requestFormat(request, false);
+            setEncodedBody(response, derivx::ResponseFormats::transcode(
+                apiHandler.handleCalculateGreeks(request.body), format), format);
+        } else if (path == "/api/batch") {
+            auto format = requestFormat(request, false);
+            setEncodedBody(response, derivx::ResponseFormats::transcode(
+                apiHandler.handleBatch(request.body), format), format);
+        } else if (path == "/api/backtest") {
+            auto format = requestFormat(request, false);
+            setEncodedBody(response, derivx::ResponseFormats::transcode(
+                apiHandler.handleBacktest(request.body), format), format);
+        } else if (path == "/api/optimize-strategy") {
+            auto format = requestFormat(request, false);
+            setEncodedBody(response, derivx::ResponseFormats::transcode(
+                apiHandler.handleOptimizeStrategy(request.body), format), format);
+        } else if (path == "/api/model-chain") {
+            auto format = requestFormat(request, false);
+            setEncodedBody(response, derivx::ResponseFormats::transcode(
+                apiHandler.handleModelChain(request.body), format), format);
+        } else {
+            response.status = 404;
+        }
+        return;
+    }
+
+    response.status = 405;
+    response.addHeader("Allow", "GET, POST, OPTIONS");
+}
+
+// Маршрутизация со сроком запроса; срок мог истечь, пока запрос ждал в очереди пула
+void routeWithDeadline(const derivx::HttpRequest& request, derivx::HttpResponse& response,
+                       derivx::RequestTrace* trace, const derivx::RequestDeadline* deadline) {
+    derivx::TraceScope scope(trace);
+    derivx::DeadlineScope deadlineScope(deadline);
+    try {
+        deadline->check();
+        route(request, response);
+    } catch (const derivx::DeadlineExceeded& e) {
+        admission->recordDeadlineExceeded();
+        setError(response, 504, e.what());
+    } catch (const exception& e) {
+        setError(response, 400, e.what());
+    }
+}
+
+// Метрики эндпоинта и трассировка готового ответа.
+// Задержка в метриках - от разбора запроса до готового ответа (без отправки).
+void finishRequest(derivx::HttpResponse& response, size_t endpoint, chrono::steady_clock::time_point started,
+                   const derivx::RequestTracePtr& trace) {
+    if (response.status < 400 && derivx::ResponseFormats::isError(response.body)) {
+        derivx::Metrics::global().recordError(endpoint);
+    }
+    auto elapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - started);
+    derivx::Metrics::global().recordRequest(endpoint, static_cast<uint64_t>(elapsed.count()), response.status >= 400);
+
+    if (trace) {
+        if (derivx::RequestTracing::serverTimingEnabled()) {
+            response.addHeader("Server-Timing", trace->serverTiming());
+        }
+        derivx::RequestTracing::finish(*trace);
+    }
+}
+
+// Обработка запроса: допуск, CORS, метрики эндпоинта и трассировка вокруг маршрутизации.
+// Легкие запросы выполняются сразу в потоке соединения; тяжелые уходят в пул,
+// ответ на них откладывается, а отключение клиента отменяет расчет.
+void handleRequest(const derivx::HttpRequest& request, derivx::HttpResponse& response) {
+    size_t endpoint = derivx::APIHandler::metricsEndpoint(request.path);
+    auto started = chrono::steady_clock::now();
+    derivx::RequestTracePtr trace = derivx::RequestTracing::begin(request.method + " " + request.path);
+    if (computePool) {
+        derivx::Metrics::global().recordQueueDepth(computePool->queueDepth());
+    }
+
+    addCorsHeaders(response);
+
+    derivx::RequestCost cost = admission->estimate(request.method, request.path, request.query, request.body);
+    derivx::AdmissionTicket ticket = admission->tryAdmit(cost);
+    if (!ticket.admitted()) {
+        setError(response, 503, "Server overloaded, retry later");
+        response.addHeader("Retry-After", to_string(admission->retryAfterSeconds(cost.lane)));
+        finishRequest(response, endpoint, started, trace);
+        return;
+    }
+    derivx::RequestDeadlinePtr deadline = admission->deadlineFor(
+        cost, started, derivx::AdmissionController::parseTimeoutHeader(request.header("X-Request-Timeout-Ms")));
+
+    if (cost.lane == derivx::AdmissionLane::HEAVY && computePool) {
+        shared_ptr<derivx::HttpCompletion> completion = response.defer();
+        completion->onCancel([deadline]() { deadline->cancel(); });
+
+        auto pending = make_shared<derivx::HttpRequest>(request);
+        auto heldTicket = make_shared<derivx::AdmissionTicket>(std::move(ticket));
+        computePool->submit([pending, heldTicket, completion, deadline, trace, endpoint, started]() {
+            derivx::HttpResponse deferred;
+            addCorsHeaders(deferred);
+            routeWithDeadline(*pending, deferred, trace.get(), deadline.get());
+            finishRequest(deferred, endpoint, started, trace);
+            heldTicket->release();
+            completion->complete(std::move(deferred));
+        });
+        return;
+    }
+
+    routeWithDeadline(request, response, trace.get(), deadline.get());
+    finishRequest(response, endpoint, started, trace);
+}
+
+// Чтение целочисленной переменной окружения (с значением по умолчанию)
+long long readEnvInt(const char* name, long long defaultValue) {
+    const char* value = getenv(name);
+    if (value == nullptr || *value == '\0') {
+        return defaultValue;
+    }
+    char* end = nullptr;
+    long long parsed = strtoll(value, &end, 10);
+    return (end != value && *end == '\0' && parsed >= 0) ? parsed : defaultValue;
+}
+
+int main(int argc, char* argv[]) {
+    cout << "Starting DerivX server..." << endl;
+
+    // SIGINT/SIGTERM принимает main через sigwait; маска наследуется потоками
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+
+    string dataDir = DATA_DIR;
+    if (argc > 1) {
+        dataDir = argv[1];
+    }
+
+    // Параметры кэша символов: DERIVX_CACHE_BUDGET_MB (0 - без ограничения),
+    // DERIVX_NEGATIVE_TTL_SEC (время жизни записи "символ не найден")
+    derivx::SymbolCacheConfig cacheConfig;
+    cacheConfig.memoryBudgetBytes = static_cast<size_t>(readEnvInt("DERIVX_CACHE_BUDGET_MB", 0)) * 1024 * 1024;
+    cacheConfig.negativeTtl = chrono::seconds(readEnvInt("DERIVX_NEGATIVE_TTL_SEC", 30));
+
+    apiHandler.initialize(dataDir, cacheConfig);
+
+    // DERIVX_RESPONSE_CACHE_MB: память под готовые ответы GET эндпоинтов данных,
+    // DERIVX_HTTP_MAX_AGE_SEC: сколько клиент может не перепроверять ответ (0 - всегда по ETag)
+    apiHandler.setResponseCacheBudget(static_cast<size_t>(readEnvInt("DERIVX_RESPONSE_CACHE_MB", 64)) * 1024 * 1024);
+    long long maxAge = readEnvInt("DERIVX_HTTP_MAX_AGE_SEC", 5);
+    cacheControl = maxAge > 0 ? "public, max-age=" + to_string(maxAge) : "no-cache";
+
+    // Трассировка - как у derivx_api (DERIVX_SERVER_TIMING, DERIVX_TRACE_FILE,
+    // DERIVX_TRACE_SLOW_MS, DERIVX_TRACE_SAMPLE)
+    derivx::RequestTracingConfig tracingConfig;
+    tracingConfig.serverTiming = readEnvInt("DERIVX_SERVER_TIMING", 0) != 0;
+    const char* traceFile = getenv("DERIVX_TRACE_FILE");
+    tracingConfig.traceFile = traceFile != nullptr ? traceFile : "";
+    tracingConfig.slowMicros = readEnvInt("DERIVX_TRACE_SLOW_MS", 100) * 1000;
+    tracingConfig.sampleEvery = static_cast<uint32_t>(max<long long>(readEnvInt("DERIVX_TRACE_SAMPLE", 1), 1));
+    derivx::RequestTracing::configure(tracingConfig);
+
+    // DERIVX_COMPUTE_THREADS: размер пула расчетов (0 - по числу ядер),
+    // DERIVX_PIN_THREADS=1: привязка потоков пула и HTTP потоков к ядрам
+    derivx::ComputePoolConfig poolConfig;
+    poolConfig.workerCount = static_cast<size_t>(readEnvInt("DERIVX_COMPUTE_THREADS", 0));
+    poolConfig.pinThreads = readEnvInt("DERIVX_PIN_THREADS", 0) != 0;
+    computePool = make_unique<derivx::ComputePool>(poolConfig);
+    apiHandler.setComputePool(computePool.get());
+
+    // Допуск запросов: DERIVX_HEAVY_COST (стоимость, с которой запрос тяжелый),
+    // DERIVX_HEAVY_BUDGET (суммарная стоимость тяжелых запросов в работе),
+    // DERIVX_HEAVY_LIMIT, DERIVX_INTERACTIVE_LIMIT (запросов полосы в работе),
+    // DERIVX_INTERACTIVE_DEADLINE_MS, DERIVX_HEAVY_DEADLINE_MS (сроки полос)
+    derivx::AdmissionConfig admissionConfig;
+    admissionConfig.heavyThreshold = static_cast<uint64_t>(readEnvInt("DERIVX_HEAVY_COST", 2000));
+    admissionConfig.heavyBudget = static_cast<uint64_t>(readEnvInt("DERIVX_HEAVY_BUDGET", 2000000));
+    admissionConfig.heavyLimit = static_cast<size_t>(max<long long>(readEnvInt("DERIVX_HEAVY_LIMIT", 64), 1));
+    admissionConfig.interactiveLimit = static_cast<size_t>(max<long long>(readEnvInt("DERIVX_INTERACTIVE_LIMIT", 4096), 1));
+    admissionConfig.interactiveDeadline = chrono::milliseconds(readEnvInt("DERIVX_INTERACTIVE_DEADLINE_MS", 2000));
+    admissionConfig.heavyDeadline = chrono::milliseconds(readEnvInt("DERIVX_HEAVY_DEADLINE_MS", 10000));
+    admission = make_unique<derivx::AdmissionController>(admissionConfig);
+    apiHandler.setAdmission(admission.get());
+
+    // DERIVX_HTTP_HOST, DERIVX_HTTP_PORT: адрес сервера,
+    // DERIVX_HTTP_THREADS: число потоков epoll (0 - по числу ядер)
+    derivx::HttpServerConfig serverConfig;
+    const char* host = getenv("DERIVX_HTTP_HOST");
+    if (host != nullptr && *host != '\0') {
+        serverConfig.host = host;
+    }
+    serverConfig.port = static_cast<uint16_t>(readEnvInt("DERIVX_HTTP_PORT", 8080));
+    serverConfig.threads = static_cast<size_t>(readEnvInt("DERIVX_HTTP_THREADS", 0));
+    serverConfig.pinThreads = poolConfig.pinThreads;
+
+    derivx::HttpServer server(serverConfig, handleRequest);
+    try {
+        server.start();
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+
+    // DERIVX_STREAM_POLL_MS: как часто проверять файлы символов с SSE подписками
+    auto streamPollInterval = chrono::milliseconds(max<long long>(readEnvInt("DERIVX_STREAM_POLL_MS", 1000), 50));
+    atomic<bool> streamPollRunning{true};
+    thread streamPoller([&streamPollRunning, streamPollInterval]() {
+        while (streamPollRunning.load()) {
+            try {
+                apiHandler.pollStrategyStreams();
+            } catch (const exception& e) {
+                cerr << "Strategy stream poll failed: " << e.what() << endl;
+            }
+            auto wakeAt = chrono::steady_clock::now() + streamPollInterval;
+            while (streamPollRunning.load() && chrono::steady_clock::now() < wakeAt) {
+                this_thread::sleep_for(chrono::milliseconds(50));
+            }
+        }
+    });
+
+    cout << "Data directory: " << dataDir << endl;
+    cout << "Cache budget: " << (cacheConfig.memoryBudgetBytes / (1024 * 1024)) << " MB (0 = unlimited)" << endl;
+    cout << "Compute threads: " << computePool->workerCount() << endl;
+    cout << "HTTP threads: " << server.threadCount() << endl;
+    cout << "DerivX server is listening on http://" << serverConfig.host << ":" << serverConfig.port << endl;
+    cout << "Press Ctrl+C to exit..." << endl;
+
+    int received = 0;
+    sigwait(&stopSignals, &received);
+    cout << "Stopping DerivX server..." << endl;
+
+    server.stop();
+    streamPollRunning.store(false);
+    streamPoller.join();
+    apiHandler.setComputePool(nullptr);
+    computePool.reset();
+    return 0;
+}
@@ -0,0 +1,353 @@
+#include "../include/strategy_optimizer.hpp"
+#include "../include/admission.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+
+namespace derivx {
+
+namespace {
+
+struct StructureSpec {
+    StrategyStructure structure;
+    const char* name;
+    size_t strikes;   // Различных страйков в структуре
+};
+
+const StructureSpec structureSpecs[] = {
+    {StrategyStructure::VERTICAL_CALL, "vertical_call", 2},
+    {StrategyStructure::VERTICAL_PUT, "vertical_put", 2},
+    {StrategyStructure::STRADDLE, "straddle", 1},
+    {StrategyStructure::STRANGLE, "strangle", 2},
+    {StrategyStructure::BUTTERFLY, "butterfly", 3},
+    {StrategyStructure::CONDOR, "condor", 4},
+    {StrategyStructure::IRON_CONDOR, "iron_condor", 4},
+};
+
+const StructureSpec& specOf(StrategyStructure structure) {
+    for (const auto& spec : structureSpecs) {
+        if (spec.structure == structure) {
+            return spec;
+        }
+    }
+    return structureSpecs[0];
+}
+
+uint64_t choose(uint64_t n, uint64_t k) {
+    if (k > n) {
+        return 0;
+    }
+    uint64_t result = 1;
+    for (uint64_t i = 1; i <= k; ++i) {
+        result = result * (n - k + i) / i;
+    }
+    return result;
+}
+
+/**
+ * Лучшие topN кандидатов по убыванию критерия (при равенстве - по порядку перебора)
+ */
+class TopCandidates {
+public:
+    explicit TopCandidates(size_t limit) : limit_(limit) {}
+
+    // Критерий, ниже которого кандидат не попадет в лучшие
+    double floor() const {
+        return items_.size() < limit_ ? -std::numeric_limits<double>::infinity() : items_.back().score;
+    }
+
+    void offer(const OptimizerCandidate& candidate) {
+        if (limit_ == 0 || (items_.size() == limit_ && !better(candidate, items_.back()))) {
+            return;
+        }
+        auto position = std::upper_bound(items_.begin(), items_.end(), candidate, better);
+        items_.insert(position, candidate);
+        if (items_.size() > limit_) {
+            items_.pop_back();
+        }
+    }
+
+    std::vector<OptimizerCandidate>& items() { return items_; }
+
+private:
+    static bool better(const OptimizerCandidate& a, const OptimizerCandidate& b) {
+        return a.score > b.score || (a.score == b.score && a.order < b.order);
+    }
+
+    size_t limit_;
+    std::vector<OptimizerCandidate> items_;
+};
+
+/**
+ * Распределение с заранее посчитанными точками в страйках сетки: изломы PNL
+ * кандидатов - всегда страйки сетки, поиск по выборке нужен только для
+ * точек безубыточности
+ */
+class GridDistribution {
+public:
+    GridDistribution(const EmpiricalDistribution& distribution, const ChainQuote* quotes, size_t strikeCount)
+        : distribution_(distribution), strikes_(strikeCount), points_(strikeCount), total_(distribution.total()) {
+        for (size_t i = 0; i < strikeCount; ++i) {
+            strikes_[i] = quotes[i].strike;
+            points_[i] = distribution.cumulative(quotes[i].strike);
+        }
+    }
+
+    DistributionPoint cumulative(double x) const {
+        auto position = std::lower_bound(strikes_.begin(), strikes_.end(), x);
+        if (position != strikes_.end() && *position == x) {
+            return points_[static_cast<size_t>(position - strikes_.begin())];
+        }
+        return distribution_.cumulative(x);
+    }
+
+    DistributionPoint total() const { return total_; }
+
+private:
+    const EmpiricalDistribution& distribution_;
+    std::vector<double> strikes_;
+    std::vector<DistributionPoint> points_;
+    DistributionPoint total_;
+};
+
+/**
+ * Перебор кандидатов одной задачи (структура, направление, первый страйк)
+ */
+class CandidateSearch {
+public:
+    CandidateSearch(const OptimizerConfig& config, const ChainQuote* quotes, size_t strikeCount,
+                    const GridDistribution& distribution, TopCandidates& top, OptimizerResult& counters)
+        : config_(config), quotes_(quotes), strikeCount_(strikeCount), distribution_(distribution),
+          top_(top), counters_(counters) {}
+
+    void run(StrategyStructure structure, bool reverse, size_t first, uint64_t order) {
+        order_ = order;
+        const size_t n = strikeCount_;
+        const size_t i = first;
+        switch (structure) {
+            case StrategyStructure::VERTICAL_CALL:
+                for (size_t j = i + 1; j < n; ++j) {
+                    begin(structure, reverse);
+                    leg(OptionType::CALL, true, 1, i);
+                    leg(OptionType::CALL, false, 1, j);
+                    evaluate();
+                }
+                break;
+            case StrategyStructure::VERTICAL_PUT:
+                for (size_t j = i + 1; j < n; ++j) {
+                    begin(structure, reverse);
+                    leg(OptionType::PUT, false, 1, i);
+                    leg(OptionType::PUT, true, 1, j);
+                    evaluate();
+                }
+                break;
+            case StrategyStructure::STRADDLE:
+                begin(structure, reverse);
+                leg(OptionType::CALL, true, 1, i);
+                leg(OptionType::PUT, true, 1, i);
+                evaluate();
+                break;
+            case StrategyStructure::STRANGLE:
+                for (size_t j = i + 1; j < n; ++j) {
+                    begin(structure, reverse);
+                    leg(OptionType::PUT, true, 1, i);
+                    leg(OptionType::CALL, true, 1, j);
+                    evaluate();
+                }
+                break;
+            case StrategyStructure::BUTTERFLY:
+                for (size_t j = i + 1; j < n; ++j) {
+                    for (size_t k = j + 1; k < n; ++k) {
+                        begin(structure, reverse);
+                        leg(OptionType::CALL, true, 1, i);
+                        leg(OptionType::CALL, false, 2, j);
+                        leg(OptionType::CALL, true, 1, k);
+                        evaluate();
+                    }
+                }
+                break;
+            case StrategyStructure::CONDOR:
+            case StrategyStructure::IRON_CONDOR: {
+                bool iron = structure == StrategyStructure::IRON_CONDOR;
+                for (size_t j = i + 1; j < n; ++j) {
+                    for (size_t k = j + 1; k < n; ++k) {
+                        for (size_t l = k + 1; l < n; ++l) {
+                            begin(structure, reverse);
+                            leg(iron ? OptionType::PUT : OptionType::CALL, true, 1, i);
+                            leg(iron ? OptionType::PUT : OptionType::CALL, false, 1, j);
+                            leg(OptionType::CALL, false, 1, k);
+                            leg(OptionType::CALL, true, 1, l);
+                            evaluate();
+                        }
+                    }
+                }
+                break;
+            }
+        }
+    }
+
+private:
+    const OptimizerConfig& config_;
+    const ChainQuote* quotes_;
+    size_t strikeCount_;
+    const GridDistribution& distribution_;
+    TopCandidates& top_;
+    OptimizerResult& counters_;
+    OptimizerCandidate candidate_;
+    PayoffShape shape_;
+    uint64_t order_ = 0;
+
+    void begin(StrategyStructure structure, bool reverse) {
+        candidate_.structure = structure;
+        candidate_.reverse = reverse;
+        candidate_.legCount = 0;
+        candidate_.netPremium = 0.0;
+        candidate_.delta = 0.0;
+        candidate_.order = order_++;
+    }
+
+    void leg(OptionType type, bool isLong, int quantity, size_t strike) {
+        const ChainQuote& quote = quotes_[strike];
+        bool buy = isLong != candidate_.reverse;
+        Option& option = candidate_.legs[candidate_.legCount++];
+        option.type = type;
+        option.position = buy ? OptionPosition::LONG : OptionPosition::SHORT;
+        option.strike = quote.strike;
+        option.premium = type == OptionType::CALL ? quote.callPrice : quote.putPrice;
+        option.quantity = quantity;
+
+        double weight = (buy ? 1.0 : -1.0) * quantity;
+        candidate_.netPremium += weight * option.premium;
+        candidate_.delta += weight * (type == OptionType::CALL ? quote.call.delta : quote.put.delta);
+    }
+
+    void evaluate() {
+        ++counters_.candidates;
+
+        // Ограничения от дешевых к дорогим: премия, delta, убыток по изломам
+        if (config_.hasBudget && candidate_.netPremium > config_.budget) {
+            ++counters_.rejectedBudget;
+            return;
+        }
+        if (config_.deltaNeutral && std::fabs(candidate_.delta) > config_.deltaTolerance) {
+            ++counters_.rejectedDelta;
+            return;
+        }
+        PayoffAnalysis::buildShape(candidate_.legs, candidate_.legCount, shape_);
+        PayoffAnalysis::bounds(shape_, candidate_.stats);
+        if (config_.hasMaxLoss && candidate_.stats.maxLoss > config_.maxLoss) {
+            ++counters_.rejectedLoss;
+            return;
+        }
+
+        // Кандидат заведомо хуже текущих лучших отсекается: по ожидаемому PNL - до
+        // расчета вероятности, по вероятности - до поиска точек безубыточности
+        const double none = -std::numeric_limits<double>::infinity();
+        bool byExpected = config_.objective == OptimizerObjective::EXPECTED_PNL;
+        if (!PayoffAnalysis::integrate(shape_, distribution_, candidate_.stats,
+                                       byExpected ? top_.floor() : none, byExpected ? none : top_.floor())) {
+            ++counters_.pruned;
+            return;
+        }
+        ++counters_.evaluated;
+        candidate_.score = config_.objective == OptimizerObjective::EXPECTED_PNL
+            ? candidate_.stats.expected : candidate_.stats.probabilityOfProfit;
+        top_.offer(candidate_);
+    }
+};
+
+struct SearchTask {
+    StrategyStructure structure;
+    bool reverse;
+    size_t first;
+};
+
+} // namespace
+
+uint64_t StrategyOptimizer::countCandidates(const OptimizerConfig& config, size_t strikeCount) {
+    uint64_t total = 0;
+    for (StrategyStructure structure : config.structures) {
+        total += choose(strikeCount, specOf(structure).strikes);
+    }
+    return config.allowReverse ? total * 2 : total;
+}
+
+OptimizerResult StrategyOptimizer::optimize(
+    const OptimizerConfig& config,
+    const ChainQuote* quotes,
+    size_t strikeCount,
+    const EmpiricalDistribution& distribution,
+    ComputePool* pool
+) {
+    // Задача - первый страйк структуры; повторяющиеся структуры не перебираются дважды
+    std::vector<SearchTask> tasks;
+    std::vector<StrategyStructure> seen;
+    for (StrategyStructure structure : config.structures) {
+        if (std::find(seen.begin(), seen.end(), structure) != seen.end()) {
+            continue;
+        }
+        seen.push_back(structure);
+        for (int reverse = 0; reverse <= (config.allowReverse ? 1 : 0); ++reverse) {
+            for (size_t first = 0; first < strikeCount; ++first) {
+                tasks.push_back({structure, reverse != 0, first});
+            }
+        }
+    }
+
+    GridDistribution grid(distribution, quotes, strikeCount);
+    OptimizerResult result;
+    TopCandidates best(config.topN);
+    std::mutex mutex;
+    const RequestDeadline* deadline = RequestDeadline::current();
+
+    auto search = [&](size_t lo, size_t hi) {
+        DeadlineScope scope(deadline);
+        TopCandidates local(config.topN);
+        OptimizerResult counters;
+        CandidateSearch searcher(config, quotes, strikeCount, grid, local, counters);
+        for (size_t t = lo; t < hi; ++t) {
+            if (deadline != nullptr) {
+                deadline->check();
+            }
+            searcher.run(tasks[t].structure, tasks[t].reverse, tasks[t].first, static_cast<uint64_t>(t) << 40);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& candidate : local.items()) {
+            best.offer(candidate);
+        }
+        result.candidates += counters.candidates;
+        result.rejectedBudget += counters.rejectedBudget;
+        result.rejectedDelta += counters.rejectedDelta;
+        result.rejectedLoss += counters.rejectedLoss;
+        result.pruned += counters.pruned;
+        result.evaluated += counters.evaluated;
+    };
+
+    // Задачи с малым первым страйком тяжелее: части по одной задаче
+    if (pool != nullptr) {
+        pool->parallelFor(0, tasks.size(), 1, search);
+    } else {
+        search(0, tasks.size());
+    }
+
+    result.best = std::move(best.items());
+    return result;
+}
+
+const char* StrategyOptimizer::structureName(StrategyStructure structure) {
+    return specOf(structure).name;
+}
+
+bool StrategyOptimizer::parseStructure(const std::string& name, StrategyStructure& structure) {
+    for (const auto& spec : structureSpecs) {
+        if (name == spec.name) {
+            structure = spec.structure;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace derivx
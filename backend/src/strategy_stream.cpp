@@ -0,0 +1,243 @@
+#include "../include/strategy_stream.hpp"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <stdexcept>
+
+using json = nlohmann::json;
+
+namespace derivx {
+
+bool StreamSubscriber::publish(const std::string& event) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool replaced = hasPending_;
+    pending_ = event;
+    hasPending_ = true;
+    return replaced;
+}
+
+bool StreamSubscriber::take(std::string& event) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!hasPending_) {
+        return false;
+    }
+    event = std::move(pending_);
+    pending_.clear();
+    hasPending_ = false;
+    return true;
+}
+
+StrategyStreamHub::StrategyStreamHub(Evaluator evaluator)
+    : evaluator_(std::move(evaluator)) {
+}
+
+StreamSubscriberPtr StrategyStreamHub::subscribe(
+    const std::string& symbol,
+    const std::string& strategy,
+    const OHLCVSeriesPtr& series
+) {
+    if (!series || series->empty()) {
+        throw std::invalid_argument("No data found for symbol: " + symbol);
+    }
+
+    // Канонический JSON: одинаковые стратегии с разным порядком ключей делят тему
+    std::string canonical = json::parse(strategy).dump();
+    std::string key = symbol + '\n' + canonical;
+    auto subscriber = std::make_shared<StreamSubscriber>();
+
+    // Порядок блокировок: mutex_, затем мьютекс темы
+    std::unique_lock<std::mutex> lock(mutex_);
+    TopicPtr& slot = topics_[key];
+    if (!slot) {
+        slot = std::make_shared<Topic>();
+        slot->symbol = symbol;
+        slot->strategy = canonical;
+    }
+    TopicPtr topic = slot;
+    std::unique_lock<std::mutex> topicLock(topic->mutex);
+    topic->subscribers.push_back(subscriber);
+    lock.unlock();
+
+    // Первый подписчик темы считает оценку, остальные получают готовую.
+    // Если снимок новее оцененного, свежее событие получают все подписчики темы.
+    bool evaluated = false;
+    try {
+        evaluated = evaluateLocked(*topic, series);
+    } catch (...) {
+        topic->subscribers.pop_back();
+        throw;
+    }
+    if (evaluated) {
+        publishLocked(*topic, true);
+    } else {
+        deliver(*subscriber, topic->event);
+    }
+
+    return subscriber;
+}
+
+void StrategyStreamHub::update(const std::string& symbol, const OHLCVSeriesPtr& series, ComputePool* pool) {
+    if (!series || series->empty()) {
+        return;
+    }
+
+    std::vector<TopicPtr> matching;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& entry : topics_) {
+            if (entry.second->symbol == symbol) {
+                matching.push_back(entry.second);
+            }
+        }
+    }
+    if (matching.empty()) {
+        return;
+    }
+
+    std::vector<char> abandoned(matching.size(), 0);
+    auto refresh = [&](size_t i) {
+        Topic& topic = *matching[i];
+        std::lock_guard<std::mutex> topicLock(topic.mutex);
+
+        // Тему без подписчиков не пересчитываем
+        if (publishLocked(topic, false) == 0) {
+            abandoned[i] = 1;
+            return;
+        }
+        try {
+            if (evaluateLocked(topic, series)) {
+                publishLocked(topic, true);
+            }
+        } catch (const std::exception&) {
+            // Оценка не удалась - подписчики остаются с предыдущим событием
+        }
+    };
+
+    if (pool != nullptr && matching.size() > 1) {
+        pool->parallelFor(0, matching.size(), 1, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i) {
+                refresh(i);
+            }
+        });
+    } else {
+        for (size_t i = 0; i < matching.size(); ++i) {
+            refresh(i);
+        }
+    }
+
+    // Удаляем темы, от которых отписались все клиенты
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < matching.size(); ++i) {
+        if (!abandoned[i]) {
+            continue;
+        }
+        const TopicPtr& topic = matching[i];
+        std::lock_guard<std::mutex> topicLock(topic->mutex);
+        if (topic->subscribers.empty()) {
+            topics_.erase(topic->symbol + '\n' + topic->strategy);
+        }
+    }
+}
+
+std::vector<std::string> StrategyStreamHub::symbols() const {
+    std::vector<std::string> result;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : topics_) {
+        if (std::find(result.begin(), result.end(), entry.second->symbol) == result.end()) {
+            result.push_back(entry.second->symbol);
+        }
+    }
+    return result;
+}
+
+StrategyStreamStats StrategyStreamHub::stats() const {
+    StrategyStreamStats result;
+    result.evaluations = evaluations_.load(std::memory_order_relaxed);
+    result.published = published_.load(std::memory_order_relaxed);
+    result.coalesced = coalesced_.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    result.topics = topics_.size();
+    for (const auto& entry : topics_) {
+        std::lock_guard<std::mutex> topicLock(entry.second->mutex);
+        for (const auto& weak : entry.second->subscribers) {
+            if (!weak.expired()) {
+                result.subscribers++;
+            }
+        }
+    }
+    return result;
+}
+
+bool StrategyStreamHub::evaluateLocked(Topic& topic, const OHLCVSeriesPtr& series) {
+    // Тот же снимок уже оценен (например, второй подписчик на ту же стратегию)
+    if (topic.hasMark && topic.source.lock() == series) {
+        return false;
+    }
+
+    StrategyMark mark = evaluator_(topic.strategy, *series);
+    topic.event = formatEvent(topic.symbol, mark, topic.hasMark ? &topic.mark : nullptr);
+    topic.mark = mark;
+    topic.hasMark = true;
+    topic.source = series;
+    evaluations_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+size_t StrategyStreamHub::publishLocked(Topic& topic, bool send) {
+    size_t alive = 0;
+    auto it = topic.subscribers.begin();
+    while (it != topic.subscribers.end()) {
+        StreamSubscriberPtr subscriber = it->lock();
+        if (!subscriber || subscriber->closed()) {
+            it = topic.subscribers.erase(it);
+            continue;
+        }
+        if (send) {
+            deliver(*subscriber, topic.event);
+        }
+        ++alive;
+        ++it;
+    }
+    return alive;
+}
+
+void StrategyStreamHub::deliver(StreamSubscriber& subscriber, const std::string& event) {
+    published_.fetch_add(1, std::memory_order_relaxed);
+    if (subscriber.publish(event)) {
+        coalesced_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+std::string StrategyStreamHub::formatEvent(
+    const std::string& symbol,
+    const StrategyMark& mark,
+    const StrategyMark* previous
+) {
+    json event;
+    event["symbol"] = symbol;
+    event["timestamp"] = mark.timestamp;
+    event["date"] = mark.date;
+    event["spotPrice"] = mark.spotPrice;
+    event["pnl"] = mark.pnl;
+    event["greeks"]["delta"] = mark.greeks.delta;
+    event["greeks"]["gamma"] = mark.greeks.gamma;
+    event["greeks"]["theta"] = mark.greeks.theta;
+    event["greeks"]["vega"] = mark.greeks.vega;
+    event["greeks"]["rho"] = mark.greeks.rho;
+
+    // Изменение относительно предыдущей оценки (в первом событии отсутствует)
+    if (previous != nullptr) {
+        json& change = event["change"];
+        change["spotPrice"] = mark.spotPrice - previous->spotPrice;
+        change["pnl"] = mark.pnl - previous->pnl;
+        change["delta"] = mark.greeks.delta - previous->greeks.delta;
+        change["gamma"] = mark.greeks.gamma - previous->greeks.gamma;
+        change["theta"] = mark.greeks.theta - previous->greeks.theta;
+        change["vega"] = mark.greeks.vega - previous->greeks.vega;
+        change["rho"] = mark.greeks.rho - previous->greeks.rho;
+    }
+
+    return event.dump();
+}
+
+} // namespace derivx
@@ -0,0 +1,327 @@
+#include "../include/symbol_cache.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+namespace derivx {
+
+SymbolCache::SymbolCache(const SymbolCacheConfig& config) {
+    configure(config);
+}
+
+void SymbolCache::configure(const SymbolCacheConfig& config) {
+    config_ = config;
+
+    size_t count = 1;
+    while (count < config.shardCount) {
+        count <<= 1;
+    }
+
+    shards_.clear();
+    shards_.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+    shardMask_ = count - 1;
+    bytes_ = 0;
+    entries_ = 0;
+}
+
+void SymbolCache::setLoader(Loader loader) {
+    loader_ = std::move(loader);
+}
+
+size_t SymbolCache::estimateBytes(const std::string& symbol, const OHLCVSeries& series) {
+    // Служебные расходы на узел таблицы, Entry и control block shared_ptr
+    size_t bytes = sizeof(Entry) + sizeof(OHLCVSeries) + 128;
+    bytes += symbol.capacity();
+    bytes += series.candles.capacity() * sizeof(OHLCV);
+
+    // Даты длиннее SSO буфера живут в куче
+    for (const auto& candle : series.candles) {
+        if (candle.date.capacity() > 15) {
+            bytes += candle.date.capacity() + 1;
+        }
+    }
+    return bytes;
+}
+
+SymbolCache::Shard& SymbolCache::shardFor(const std::string& symbol) const {
+    return *shards_[std::hash<std::string>{}(symbol) & shardMask_];
+}
+
+const SymbolCache::Entry* SymbolCache::lookup(const Map& map, const std::string& symbol) {
+    auto it = map.find(symbol);
+    if (it == map.end()) {
+        return nullptr;
+    }
+
+    const Entry* entry = it->second.get();
+    if (entry->expiresAt != Clock::time_point::max() && Clock::now() >= entry->expiresAt) {
+        return nullptr;
+    }
+    return entry;
+}
+
+OHLCVSeriesPtr SymbolCache::find(const std::string& symbol) const {
+    Shard& shard = shardFor(symbol);
+
+    // Вход в счетчик читателей до загрузки указателя: писатель не освободит
+    // таблицу, пока счетчик, в который мы вошли, не опустеет
+    std::atomic<uint64_t>& readers = shard.readers[shard.epoch.load(std::memory_order_seq_cst) & 1];
+    readers.fetch_add(1, std::memory_order_seq_cst);
+    const Map* snapshot = shard.snapshot.load(std::memory_order_seq_cst);
+
+    OHLCVSeriesPtr series;
+    if (auto entry = lookup(*snapshot, symbol)) {
+        // Бит обращения для CLOCK; запись только при необходимости, чтобы не гонять строку кэша
+        if (!entry->referenced.load(std::memory_order_relaxed)) {
+            entry->referenced.store(true, std::memory_order_relaxed);
+        }
+        series = entry->series;
+    }
+    readers.fetch_sub(1, std::memory_order_release);
+    return series;
+}
+
+void SymbolCache::publishLocked(Shard& shard, const Map* next) {
+    const Map* previous = shard.snapshot.exchange(next, std::memory_order_seq_cst);
+
+    // Grace period: читатель, увидевший previous, вошел в один из счетчиков до
+    // подмены и остается в нем до выхода. Оба счетчика по очереди дожидаются
+    // нуля; переключение epoch направляет новых читателей в другой счетчик.
+    for (int phase = 0; phase < 2; ++phase) {
+        uint64_t drained = shard.epoch.fetch_add(1, std::memory_order_seq_cst) & 1;
+        while (shard.readers[drained].load(std::memory_order_seq_cst) != 0) {
+            std::this_thread::yield();
+        }
+    }
+    delete previous;
+}
+
+void SymbolCache::insertLocked(Shard& shard, const std::string& symbol, OHLCVSeriesPtr series) {
+    Clock::time_point now = Clock::now();
+    bool negative = series->empty();
+
+    if (negative && config_.negativeTtl.count() <= 0) {
+        eraseLocked(shard, symbol);
+        return;
+    }
+
+    auto entry = std::make_shared<Entry>();
+    entry->bytes = estimateBytes(symbol, *series);
+    entry->series = std::move(series);
+    if (negative) {
+        entry->expiresAt = now + config_.negativeTtl;
+    }
+
+    // Copy-on-write: читатели продолжают видеть старую таблицу.
+    // Заодно выбрасываем истекшие отрицательные записи шарда.
+    const Map& current = *shard.snapshot.load(std::memory_order_relaxed);
+    auto next = std::make_unique<Map>();
+    next->reserve(current.size() + 1);
+    uint64_t releasedBytes = 0;
+    uint64_t releasedEntries = 0;
+    bool replaced = false;
+
+    for (const auto& item : current) {
+        if (item.first == symbol) {
+            releasedBytes += item.second->bytes;
+            replaced = true;
+            continue;
+        }
+        if (item.second->expiresAt != Clock::time_point::max() && now >= item.second->expiresAt) {
+            releasedBytes += item.second->bytes;
+            ++releasedEntries;
+            expirations_.fetch_add(1, std::memory_order_relaxed);
+            auto ringIt = std::find(shard.clockRing.begin(), shard.clockRing.end(), item.first);
+            if (ringIt != shard.clockRing.end()) {
+                shard.clockRing.erase(ringIt);
+            }
+            continue;
+        }
+        next->emplace(item.first, item.second);
+    }
+
+    bytes_.fetch_add(entry->bytes, std::memory_order_relaxed);
+    bytes_.fetch_sub(releasedBytes, std::memory_order_relaxed);
+    entries_.fetch_sub(releasedEntries, std::memory_order_relaxed);
+    if (!replaced) {
+        entries_.fetch_add(1, std::memory_order_relaxed);
+        shard.clockRing.push_back(symbol);
+    }
+
+    next->emplace(symbol, std::move(entry));
+    publishLocked(shard, next.release());
+}
+
+bool SymbolCache::eraseLocked(Shard& shard, const std::string& symbol) {
+    const Map& current = *shard.snapshot.load(std::memory_order_relaxed);
+    auto it = current.find(symbol);
+    if (it == current.end()) {
+        return false;
+    }
+
+    bytes_.fetch_sub(it->second->bytes, std::memory_order_relaxed);
+    entries_.fetch_sub(1, std::memory_order_relaxed);
+
+    auto ringIt = std::find(shard.clockRing.begin(), shard.clockRing.end(), symbol);
+    if (ringIt != shard.clockRing.end()) {
+        // swap-remove: стрелка остается на элементе, переехавшем на это место
+        *ringIt = std::move(shard.clockRing.back());
+        shard.clockRing.pop_back();
+    }
+
+    auto next = std::make_unique<Map>(current);
+    next->erase(symbol);
+    publishLocked(shard, next.release());
+    return true;
+}
+
+bool SymbolCache::evictOneLocked(Shard& shard) {
+    // Два оборота стрелки: первый снимает биты обращения, второй гарантированно находит жертву
+    size_t steps = shard.clockRing.size() * 2;
+    Clock::time_point now = Clock::now();
+
+    for (size_t i = 0; i < steps && !shard.clockRing.empty(); ++i) {
+        if (shard.clockHand >= shard.clockRing.size()) {
+            shard.clockHand = 0;
+        }
+
+        std::string victim = shard.clockRing[shard.clockHand];
+        const Map& current = *shard.snapshot.load(std::memory_order_relaxed);
+        auto it = current.find(victim);
+        if (it == current.end()) {
+            shard.clockRing[shard.clockHand] = std::move(shard.clockRing.back());
+            shard.clockRing.pop_back();
+            continue;
+        }
+
+        const auto& entry = it->second;
+        bool expired = entry->expiresAt != Clock::time_point::max() && now >= entry->expiresAt;
+        if (!expired && entry->referenced.exchange(false, std::memory_order_relaxed)) {
+            ++shard.clockHand;
+            continue;
+        }
+
+        eraseLocked(shard, victim);
+        (expired ? expirations_ : evictions_).fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void SymbolCache::enforceBudget() {
+    if (config_.memoryBudgetBytes == 0) {
+        return;
+    }
+
+    // Обходим шарды по кругу; останавливаемся, если полный круг ничего не дал
+    size_t idle = 0;
+    while (bytes_.load(std::memory_order_relaxed) > config_.memoryBudgetBytes && idle <= shardMask_) {
+        Shard& shard = *shards_[evictCursor_.fetch_add(1, std::memory_order_relaxed) & shardMask_];
+        std::lock_guard<std::mutex> lock(shard.writeMutex);
+        idle = evictOneLocked(shard) ? 0 : idle + 1;
+    }
+}
+
+OHLCVSeriesPtr SymbolCache::get(const std::string& symbol) {
+    // Быстрый путь без блокировок
+    if (OHLCVSeriesPtr hit = find(symbol)) {
+        (hit->empty() ? negativeHits_ : hits_).fetch_add(1, std::memory_order_relaxed);
+        return hit;
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+
+    if (!loader_) {
+        throw std::logic_error("SymbolCache loader is not set");
+    }
+
+    Shard& shard = shardFor(symbol);
+    std::promise<OHLCVSeriesPtr> promise;
+
+    {
+        std::unique_lock<std::mutex> lock(shard.writeMutex);
+
+        // Повторная проверка: значение могло появиться, пока ждали мьютекс
+        if (auto entry = lookup(*shard.snapshot.load(std::memory_order_relaxed), symbol)) {
+            return entry->series;
+        }
+
+        // Загрузка уже идет в другом потоке - ждем ее результат
+        auto pending = shard.inflight.find(symbol);
+        if (pending != shard.inflight.end()) {
+            std::shared_future<OHLCVSeriesPtr> future = pending->second;
+            lock.unlock();
+            coalescedWaits_.fetch_add(1, std::memory_order_relaxed);
+            return future.get();
+        }
+
+        shard.inflight.emplace(symbol, promise.get_future().share());
+    }
+
+    // Загружаем вне блокировки, чтобы не задерживать другие символы шарда
+    OHLCVSeriesPtr series;
+    try {
+        loads_.fetch_add(1, std::memory_order_relaxed);
+        series = loader_(symbol);
+        if (!series) {
+            series = std::make_shared<const OHLCVSeries>();
+        }
+    } catch (...) {
+        loadFailures_.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(shard.writeMutex);
+            shard.inflight.erase(symbol);
+        }
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(shard.writeMutex);
+        insertLocked(shard, symbol, series);
+        shard.inflight.erase(symbol);
+    }
+    promise.set_value(series);
+
+    enforceBudget();
+    return series;
+}
+
+void SymbolCache::invalidate(const std::string& symbol) {
+    Shard& shard = shardFor(symbol);
+    std::lock_guard<std::mutex> lock(shard.writeMutex);
+    eraseLocked(shard, symbol);
+}
+
+void SymbolCache::clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->writeMutex);
+        for (const auto& item : *shard->snapshot.load(std::memory_order_relaxed)) {
+            bytes_.fetch_sub(item.second->bytes, std::memory_order_relaxed);
+            entries_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        shard->clockRing.clear();
+        shard->clockHand = 0;
+        publishLocked(*shard, new Map());
+    }
+}
+
+SymbolCacheStats SymbolCache::stats() const {
+    SymbolCacheStats s;
+    s.hits = hits_.load(std::memory_order_relaxed);
+    s.misses = misses_.load(std::memory_order_relaxed);
+    s.negativeHits = negativeHits_.load(std::memory_order_relaxed);
+    s.loads = loads_.load(std::memory_order_relaxed);
+    s.loadFailures = loadFailures_.load(std::memory_order_relaxed);
+    s.coalescedWaits = coalescedWaits_.load(std::memory_order_relaxed);
+    s.evictions = evictions_.load(std::memory_order_relaxed);
+    s.expirations = expirations_.load(std::memory_order_relaxed);
+    s.bytes = bytes_.load(std::memory_order_relaxed);
+    s.entries = entries_.load(std::memory_order_relaxed);
+    s.budgetBytes = config_.memoryBudgetBytes;
+    return s;
+}
+
+} // namespace derivx
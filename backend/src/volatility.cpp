@@ -2,9 +2,92 @@
 #include <algorithm>
 #include <numeric>
 #include <cmath>
+#include <cstdlib>
 
 namespace derivx {
 
+namespace {
+
+// Количество дней от 1970-01-01 до заданной даты (proleptic Gregorian)
+int64_t daysFromCivil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+// Разбор фиксированного количества цифр начиная с pos
+bool parseDigits(const std::string& text, size_t pos, size_t count, int& value) {
+    if (pos + count > text.size()) {
+        return false;
+    }
+    value = 0;
+    for (size_t i = pos; i < pos + count; ++i) {
+        if (text[i] < '0' || text[i] > '9') {
+            return false;
+        }
+        value = value * 10 + (text[i] - '0');
+    }
+    return true;
+}
+
+} // namespace
+
+bool VolatilityCalculator::parseTimestamp(const std::string& text, int64_t& timestamp) {
+    if (text.empty()) {
+        return false;
+    }
+    
+    // Числовой timestamp (секунды или миллисекунды)
+    if (text.find('-', 1) == std::string::npos) {
+        char* end = nullptr;
+        long long value = std::strtoll(text.c_str(), &end, 10);
+        if (end == text.c_str() || *end != '\0') {
+            return false;
+        }
+        timestamp = (value > 100000000000LL || value < -100000000000LL) ? value / 1000 : value;
+        return true;
+    }
+    
+    int year, month, day;
+    if (!parseDigits(text, 0, 4, year) || text[4] != '-' ||
+        !parseDigits(text, 5, 2, month) || text[7] != '-' ||
+        !parseDigits(text, 8, 2, day) ||
+        month < 1 || month > 12 || day < 1 || day > 31) {
+        return false;
+    }
+    
+    // Строка разбирается целиком: смещение пояса ("+03:00") и другой хвост сдвинули бы время
+    size_t length = text.size();
+    if ((length == 17 || length == 20) && text[length - 1] == 'Z') {
+        --length;   // UTC
+    }
+    if (length != 10 && length != 16 && length != 19) {
+        return false;
+    }
+    
+    int hour = 0, minute = 0, second = 0;
+    if (length > 10) {
+        if ((text[10] != ' ' && text[10] != 'T') ||
+            !parseDigits(text, 11, 2, hour) || text[13] != ':' ||
+            !parseDigits(text, 14, 2, minute)) {
+            return false;
+        }
+        if (length == 19 && (text[16] != ':' || !parseDigits(text, 17, 2, second))) {
+            return false;
+        }
+        if (hour > 23 || minute > 59 || second > 60) {
+            return false;
+        }
+    }
+    
+    timestamp = daysFromCivil(year, static_cast<unsigned>(month), static_cast<unsigned>(day)) * 86400
+              + hour * 3600 + minute * 60 + second;
+    return true;
+}
+
 std::vector<OHLCV> VolatilityCalculator::loadOHLCVFromCSV(const std::string& filepath) {
     std::vector<OHLCV> data;
     std::ifstream file(filepath);
@@ -38,6 +121,10 @@ std::vector<OHLCV> VolatilityCalculator::loadOHLCVFromCSV(const std::string& fil
         
         if (tokens.size() >= 6) {
             ohlcv.date = tokens[0];
+            // Строка без разбираемой даты не может участвовать в поиске по времени
+            if (!parseTimestamp(ohlcv.date, ohlcv.timestamp)) {
+                continue;
+            }
             ohlcv.open = std::stod(tokens[1]);
             ohlcv.high = std::stod(tokens[2]);
             ohlcv.low = std::stod(tokens[3]);
@@ -49,10 +136,17 @@ std::vector<OHLCV> VolatilityCalculator::loadOHLCVFromCSV(const std::string& fil
     }
     
     file.close();
+    
+    // Поиск по времени требует упорядоченных данных
+    auto byTime = [](const OHLCV& a, const OHLCV& b) { return a.timestamp < b.timestamp; };
+    if (!std::is_sorted(data.begin(), data.end(), byTime)) {
+        std::stable_sort(data.begin(), data.end(), byTime);
+    }
+    
     return data;
 }
 
-std::vector<double> VolatilityCalculator::calculateReturns(const std::vector<OHLCV>& ohlcv_data) {
+std::vector<double> VolatilityCalculator::calculateReturns(OHLCVView ohlcv_data) {
     std::vector<double> returns;
     
     if (ohlcv_data.size() < 2) {
@@ -90,7 +184,7 @@ double VolatilityCalculator::calculateStandardDeviation(const std::vector<double
 }
 
 double VolatilityCalculator::calculateHistoricalVolatility(
-    const std::vector<OHLCV>& ohlcv_data,
+    OHLCVView ohlcv_data,
     int period
 ) {
     if (ohlcv_data.size() < 2) {
@@ -98,11 +192,7 @@ double VolatilityCalculator::calculateHistoricalVolatility(
     }
     
     // Берем последние N свечей
-    int n = std::min(static_cast<int>(ohlcv_data.size()), period);
-    std::vector<OHLCV> recent_data(
-        ohlcv_data.end() - n,
-        ohlcv_data.end()
-    );
+    OHLCVView recent_data = ohlcv_data.last(static_cast<size_t>(std::max(period, 0)));
     
     // Рассчитываем логарифмические доходности
     std::vector<double> returns = calculateReturns(recent_data);
@@ -122,18 +212,14 @@ double VolatilityCalculator::calculateHistoricalVolatility(
 }
 
 double VolatilityCalculator::calculateParkinsonVolatility(
-    const std::vector<OHLCV>& ohlcv_data,
+    OHLCVView ohlcv_data,
     int period
 ) {
     if (ohlcv_data.size() < 1) {
         return 0.2;
     }
     
-    int n = std::min(static_cast<int>(ohlcv_data.size()), period);
-    std::vector<OHLCV> recent_data(
-        ohlcv_data.end() - n,
-        ohlcv_data.end()
-    );
+    OHLCVView recent_data = ohlcv_data.last(static_cast<size_t>(std::max(period, 0)));
     
     double sum = 0.0;
     int count = 0;
@@ -158,7 +244,7 @@ double VolatilityCalculator::calculateParkinsonVolatility(
     return dailyVolatility * std::sqrt(252.0);
 }
 
-double VolatilityCalculator::getCurrentPrice(const std::vector<OHLCV>& ohlcv_data) {
+double VolatilityCalculator::getCurrentPrice(OHLCVView ohlcv_data) {
     if (ohlcv_data.empty()) {
         return 0.0;
     }
@@ -166,18 +252,36 @@ double VolatilityCalculator::getCurrentPrice(const std::vector<OHLCV>& ohlcv_dat
     return ohlcv_data.back().close;
 }
 
-std::vector<OHLCV> VolatilityCalculator::getLastNCandles(
-    const std::vector<OHLCV>& ohlcv_data,
+OHLCVView VolatilityCalculator::getLastNCandles(
+    OHLCVView ohlcv_data,
     int n
 ) {
-    if (ohlcv_data.size() <= static_cast<size_t>(n)) {
-        return ohlcv_data;
+    return ohlcv_data.last(static_cast<size_t>(std::max(n, 0)));
+}
+
+size_t VolatilityCalculator::lowerBoundByTime(OHLCVView ohlcv_data, int64_t t) {
+    auto it = std::lower_bound(ohlcv_data.begin(), ohlcv_data.end(), t,
+        [](const OHLCV& candle, int64_t value) { return candle.timestamp < value; });
+    return static_cast<size_t>(it - ohlcv_data.begin());
+}
+
+size_t VolatilityCalculator::upperBoundByTime(OHLCVView ohlcv_data, int64_t t) {
+    auto it = std::upper_bound(ohlcv_data.begin(), ohlcv_data.end(), t,
+        [](int64_t value, const OHLCV& candle) { return value < candle.timestamp; });
+    return static_cast<size_t>(it - ohlcv_data.begin());
+}
+
+OHLCVView VolatilityCalculator::getCandlesInRange(
+    OHLCVView ohlcv_data,
+    int64_t from,
+    int64_t to
+) {
+    size_t begin = lowerBoundByTime(ohlcv_data, from);
+    size_t end = upperBoundByTime(ohlcv_data, to);
+    if (begin >= end) {
+        return OHLCVView();
     }
-    
-    return std::vector<OHLCV>(
-        ohlcv_data.end() - n,
-        ohlcv_data.end()
-    );
+    return OHLCVView(ohlcv_data.data() + begin, end - begin);
 }
 
 } // namespace derivx
@@ -0,0 +1,348 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Проверка derivx_server через сокеты (запускается ctest):
+ *
+ *   derivx_http_smoke SERVER LOADGEN
+ *
+ * Данные создает derivx_loadgen --generate-only во временном каталоге, сервер
+ * запускается на свободном порту и останавливается SIGTERM. Проверяются
+ * основные маршруты, конвейер запросов (ответы в порядке запросов, в том числе
+ * после отложенного тяжелого ответа и сверх порога паузы разбора), 411/413/431
+ * и 504 по сроку запроса.
+ */
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition)                                                              \
+    do {                                                                              \
+        if (!(condition)) {                                                           \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++failures;                                                               \
+        }                                                                             \
+    } while (0)
+
+struct Response {
+    int status = 0;
+    std::string headers;
+    std::string body;
+};
+
+/**
+ * Keep-alive соединение с сервером; ответы читаются по Content-Length
+ */
+class Connection {
+public:
+    explicit Connection(uint16_t port) {
+        fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        timeval timeout{30, 0};
+        setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        connected_ = ::connect(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    }
+
+    ~Connection() {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    bool connected() const { return connected_; }
+
+    bool send(const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t written = ::send(fd_, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (written <= 0) {
+                return false;
+            }
+            sent += static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    bool read(Response& response) {
+        size_t headerEnd;
+        while ((headerEnd = buffer_.find("\r\n\r\n")) == std::string::npos) {
+            if (!fill()) {
+                return false;
+            }
+        }
+        response.headers = buffer_.substr(0, headerEnd);
+        response.status = std::atoi(response.headers.c_str() + response.headers.find(' ') + 1);
+
+        size_t length = 0;
+        size_t field = lowercase(response.headers).find("content-length:");
+        if (field != std::string::npos) {
+            length = static_cast<size_t>(std::strtoull(response.headers.c_str() + field + 15, nullptr, 10));
+        }
+        while (buffer_.size() < headerEnd + 4 + length) {
+            if (!fill()) {
+                return false;
+            }
+        }
+        response.body = buffer_.substr(headerEnd + 4, length);
+        buffer_.erase(0, headerEnd + 4 + length);
+        return true;
+    }
+
+    // Сервер закрыл соединение (после ошибки протокола)
+    bool closedByPeer() {
+        return buffer_.empty() && !fill();
+    }
+
+private:
+    int fd_ = -1;
+    bool connected_ = false;
+    std::string buffer_;
+
+    bool fill() {
+        char chunk[16384];
+        ssize_t received = recv(fd_, chunk, sizeof(chunk), 0);
+        if (received <= 0) {
+            return false;
+        }
+        buffer_.append(chunk, static_cast<size_t>(received));
+        return true;
+    }
+
+    static std::string lowercase(std::string text) {
+        for (char& c : text) {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        return text;
+    }
+};
+
+std::string get(const std::string& path) {
+    return "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+}
+
+std::string post(const std::string& path, const std::string& body, const std::string& extraHeaders = "") {
+    return "POST " + path + " HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/json\r\n" + extraHeaders +
+           "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+Response roundTrip(uint16_t port, const std::string& request) {
+    Connection connection(port);
+    Response response;
+    if (!connection.connected() || !connection.send(request) || !connection.read(response)) {
+        response.status = -1;
+    }
+    return response;
+}
+
+uint16_t freePort() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    socklen_t length = sizeof(address);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length);
+    close(fd);
+    return ntohs(address.sin_port);
+}
+
+pid_t spawn(const std::vector<std::string>& args, bool quiet) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        if (quiet) {
+            FILE* devNull = std::fopen("/dev/null", "w");
+            if (devNull != nullptr) {
+                dup2(fileno(devNull), STDOUT_FILENO);
+            }
+        }
+        std::vector<char*> argv;
+        for (const auto& arg : args) {
+            argv.push_back(const_cast<char*>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+        execv(argv[0], argv.data());
+        std::perror("execv");
+        _exit(127);
+    }
+    return pid;
+}
+
+bool waitForServer(uint16_t port) {
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        if (roundTrip(port, get("/api/health")).status == 200) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    return false;
+}
+
+void checkRoutes(uint16_t port) {
+    Response health = roundTrip(port, get("/api/health"));
+    CHECK(health.status == 200);
+
+    Response price = roundTrip(port, get("/api/price/LOADGEN_0_USDT"));
+    CHECK(price.status == 200 && price.body.find("\"price\"") != std::string::npos);
+
+    Response ohlcv = roundTrip(port, get("/api/ohlcv/LOADGEN_0_USDT?limit=10"));
+    CHECK(ohlcv.status == 200 && ohlcv.body.find("nextCursor") != std::string::npos);
+
+    Response option = roundTrip(port, post("/api/calculate-option",
+        R"({"type":"call","strike":100,"spotPrice":100,"timeToExpiration":30,"volatility":20,"riskFreeRate":5})"));
+    CHECK(option.status == 200 && option.body.find("\"error\"") == std::string::npos);
+
+    Response missing = roundTrip(port, get("/api/no-such-route"));
+    CHECK(missing.status == 404);
+}
+
+void checkPipelining(uint16_t port) {
+    // Три запроса одной записью: ответы приходят по порядку
+    Connection connection(port);
+    CHECK(connection.connected());
+    CHECK(connection.send(get("/api/price/LOADGEN_0_USDT") + get("/api/health") +
+                          get("/api/volatility/LOADGEN_0_USDT")));
+    Response first, second, third;
+    CHECK(connection.read(first) && first.status == 200 && first.body.find("\"price\"") != std::string::npos);
+    CHECK(connection.read(second) && second.status == 200 && second.body.find("\"price\"") == std::string::npos);
+    CHECK(connection.read(third) && third.status == 200 && third.body.find("olatility") != std::string::npos);
+}
+
+void checkPipelinedOverHighWater(uint16_t port) {
+    // Ответы больше порога паузы разбора (1 МБ): после отправки накопленного
+    // разбор продолжается без новых событий сокета, ответы не теряются
+    const int requests = 600;
+    std::string batch;
+    for (int i = 0; i < requests; ++i) {
+        batch += get("/api/ohlcv/LOADGEN_0_USDT?limit=100");
+    }
+    Connection connection(port);
+    CHECK(connection.connected());
+    CHECK(connection.send(batch));
+    int received = 0;
+    size_t bytes = 0;
+    Response response;
+    while (received < requests && connection.read(response) && response.status == 200) {
+        ++received;
+        bytes += response.body.size();
+    }
+    CHECK(received == requests);
+    CHECK(bytes > 2 * 1024 * 1024);
+}
+
+void checkDeferredHeavy(uint16_t port) {
+    // Тяжелый запрос уходит в пул расчетов с отложенным ответом; следующий за ним
+    // в конвейере легкий запрос отвечается только после него
+    Connection connection(port);
+    CHECK(connection.connected());
+    CHECK(connection.send(post("/api/optimize-strategy",
+                               R"({"symbol":"LOADGEN_0_USDT","numStrikes":31,"structures":["condor"]})") +
+                          get("/api/health")));
+    Response heavy, light;
+    CHECK(connection.read(heavy) && heavy.status == 200 && heavy.body.find("\"best\"") != std::string::npos);
+    CHECK(connection.read(light) && light.status == 200 && light.body.find("\"best\"") == std::string::npos);
+
+    // Истекший срок тяжелого запроса - 504, соединение остается рабочим
+    CHECK(connection.send(post("/api/optimize-strategy", R"({"symbol":"LOADGEN_0_USDT","numStrikes":101})",
+                               "X-Request-Timeout-Ms: 1\r\n") +
+                          get("/api/health")));
+    Response expired, after;
+    CHECK(connection.read(expired) && expired.status == 504);
+    CHECK(connection.read(after) && after.status == 200);
+}
+
+void checkProtocolErrors(uint16_t port) {
+    {
+        Connection connection(port);
+        // Тела chunked не поддерживаются: сервер требует Content-Length
+        CHECK(connection.send("POST /api/calculate-option HTTP/1.1\r\nHost: localhost\r\n"
+                              "Transfer-Encoding: chunked\r\n\r\n0\r\n\r\n"));
+        Response response;
+        CHECK(connection.read(response) && response.status == 411);
+        CHECK(connection.closedByPeer());
+    }
+    {
+        Connection connection(port);
+        CHECK(connection.send("POST /api/calculate-option HTTP/1.1\r\nHost: localhost\r\n"
+                              "Content-Length: 1073741824\r\n\r\n"));
+        Response response;
+        CHECK(connection.read(response) && response.status == 413);
+        CHECK(connection.closedByPeer());
+    }
+    {
+        Connection connection(port);
+        std::string request = "GET /api/health HTTP/1.1\r\nHost: localhost\r\nX-Padding: " +
+                              std::string(128 * 1024, 'a') + "\r\n\r\n";
+        connection.send(request);
+        Response response;
+        CHECK(connection.read(response) && response.status == 431);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: %s SERVER LOADGEN\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    namespace fs = std::filesystem;
+    fs::path dataDir = fs::temp_directory_path() / ("derivx_http_smoke_" + std::to_string(getpid()));
+    pid_t generator = spawn({argv[2], "--generate-only", "--symbols=1", "--rows=5000",
+                             "--data-dir=" + dataDir.string()}, true);
+    int generatorStatus = 0;
+    waitpid(generator, &generatorStatus, 0);
+    if (!WIFEXITED(generatorStatus) || WEXITSTATUS(generatorStatus) != 0) {
+        std::fprintf(stderr, "derivx_loadgen --generate-only failed\n");
+        return EXIT_FAILURE;
+    }
+
+    uint16_t port = freePort();
+    setenv("DERIVX_HTTP_PORT", std::to_string(port).c_str(), 1);
+    setenv("DERIVX_HTTP_THREADS", "2", 1);
+    setenv("DERIVX_COMPUTE_THREADS", "2", 1);
+    pid_t server = spawn({argv[1], dataDir.string()}, true);
+
+    if (waitForServer(port)) {
+        checkRoutes(port);
+        checkPipelining(port);
+        checkPipelinedOverHighWater(port);
+        checkDeferredHeavy(port);
+        checkProtocolErrors(port);
+    } else {
+        std::fprintf(stderr, "derivx_server did not start on port %u\n", port);
+        ++failures;
+    }
+
+    kill(server, SIGTERM);
+    int serverStatus = 0;
+    waitpid(server, &serverStatus, 0);
+    CHECK(WIFEXITED(serverStatus) && WEXITSTATUS(serverStatus) == 0);
+
+    std::error_code ignored;
+    fs::remove_all(dataDir, ignored);
+
+    if (failures != 0) {
+        std::fprintf(stderr, "http_server_smoke: %d check(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    std::printf("http_server_smoke: OK\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,177 @@
+#include "../include/symbol_cache.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Нагрузочная проверка SymbolCache из многих потоков (запускается ctest,
+ * предназначена для сборки с -DENABLE_TSAN=ON):
+ *   - одновременные промахи по одному символу вызывают загрузчик ровно один раз;
+ *   - исключение загрузчика получают все ожидающие потоки;
+ *   - get/find/invalidate с вытеснением по бюджету возвращают снимок своего символа.
+ */
+
+using namespace derivx;
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition)                                                              \
+    do {                                                                              \
+        if (!(condition)) {                                                           \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++failures;                                                               \
+        }                                                                             \
+    } while (0)
+
+// Снимок символа: close первой свечи - номер символа
+OHLCVSeriesPtr makeSeries(int id, size_t candles) {
+    auto series = std::make_shared<OHLCVSeries>();
+    series->candles.resize(candles);
+    for (size_t i = 0; i < candles; ++i) {
+        series->candles[i] = OHLCV{"", static_cast<int64_t>(i) * 3600, 1.0, 1.0, 1.0, static_cast<double>(id), 1.0};
+    }
+    series->version = static_cast<uint64_t>(id);
+    return series;
+}
+
+// Запуск count потоков, стартующих одновременно
+template <typename Body>
+void runTogether(size_t count, Body body) {
+    std::atomic<size_t> ready{0};
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < count; ++t) {
+        threads.emplace_back([&, t] {
+            ready.fetch_add(1);
+            while (ready.load() < count) {
+                std::this_thread::yield();
+            }
+            body(t);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void singleFlight() {
+    const size_t threadCount = 32;
+    SymbolCache cache;
+    std::atomic<int> loaderCalls{0};
+    cache.setLoader([&](const std::string&) {
+        loaderCalls.fetch_add(1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        return makeSeries(7, 16);
+    });
+
+    for (int round = 0; round < 10; ++round) {
+        loaderCalls = 0;
+        std::vector<OHLCVSeriesPtr> results(threadCount);
+        runTogether(threadCount, [&](size_t t) { results[t] = cache.get("HOT_USDT"); });
+
+        CHECK(loaderCalls.load() == 1);
+        for (const auto& result : results) {
+            CHECK(result != nullptr && result == results[0]);
+        }
+        cache.invalidate("HOT_USDT");
+        CHECK(cache.find("HOT_USDT") == nullptr);
+    }
+
+    SymbolCacheStats stats = cache.stats();
+    CHECK(stats.loads == 10);
+    CHECK(stats.hits + stats.misses == 10 * threadCount);
+}
+
+void failurePropagation() {
+    const size_t threadCount = 16;
+    SymbolCache cache;
+    std::atomic<int> loaderCalls{0};
+    cache.setLoader([&](const std::string&) -> OHLCVSeriesPtr {
+        loaderCalls.fetch_add(1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        throw std::runtime_error("disk error");
+    });
+
+    std::atomic<size_t> thrown{0};
+    runTogether(threadCount, [&](size_t) {
+        try {
+            cache.get("BAD_USDT");
+        } catch (const std::runtime_error&) {
+            thrown.fetch_add(1);
+        }
+    });
+    CHECK(thrown.load() == threadCount);
+    CHECK(loaderCalls.load() >= 1);
+    CHECK(cache.stats().loadFailures == static_cast<uint64_t>(loaderCalls.load()));
+    CHECK(cache.find("BAD_USDT") == nullptr);
+}
+
+void mixedLoad() {
+    const size_t threadCount = 8;
+    const int symbolCount = 64;
+    const int operations = 20000;
+
+    // Бюджет на ~16 снимков: вытеснение идет постоянно
+    SymbolCacheConfig config;
+    config.shardCount = 4;
+    config.memoryBudgetBytes = 16 * SymbolCache::estimateBytes("SYM_00", *makeSeries(0, 64));
+    SymbolCache cache(config);
+    std::atomic<uint64_t> loaderCalls{0};
+    cache.setLoader([&](const std::string& symbol) {
+        loaderCalls.fetch_add(1);
+        return makeSeries(std::stoi(symbol.substr(4)), 64);
+    });
+
+    std::atomic<size_t> mismatches{0};
+    runTogether(threadCount, [&](size_t t) {
+        std::mt19937 rng(static_cast<unsigned>(t) + 1);
+        for (int i = 0; i < operations; ++i) {
+            int id = static_cast<int>(rng() % symbolCount);
+            std::string symbol = "SYM_" + std::to_string(id);
+            unsigned action = rng() % 10;
+            if (action < 6) {
+                OHLCVSeriesPtr series = cache.get(symbol);
+                if (!series || series->size() != 64 || series->candles[0].close != id) {
+                    mismatches.fetch_add(1);
+                }
+            } else if (action < 9) {
+                OHLCVSeriesPtr series = cache.find(symbol);
+                if (series && series->candles[0].close != id) {
+                    mismatches.fetch_add(1);
+                }
+            } else {
+                cache.invalidate(symbol);
+            }
+        }
+    });
+
+    SymbolCacheStats stats = cache.stats();
+    CHECK(mismatches.load() == 0);
+    CHECK(stats.loads == loaderCalls.load());
+    CHECK(stats.bytes <= config.memoryBudgetBytes);
+    CHECK(stats.evictions > 0);
+
+    cache.clear();
+    CHECK(cache.stats().bytes == 0 && cache.stats().entries == 0);
+}
+
+} // namespace
+
+int main() {
+    singleFlight();
+    failurePropagation();
+    mixedLoad();
+    if (failures != 0) {
+        std::fprintf(stderr, "symbol_cache_stress: %d check(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    std::printf("symbol_cache_stress: OK\n");
+    return EXIT_SUCCESS;
+}